@@ -0,0 +1,126 @@
+#pragma once
+
+#include "TelemetryData.h"
+#include "TelemetryPacket.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*
+	Codemasters "extradata" UDP decoding (DiRT Rally, DiRT Rally 2.0, DiRT 4,
+	GRID).
+
+	The games send an array of little-endian 32-bit floats when
+	hardware_settings_config.xml has <udp enabled="true" extradata="3" ...>;
+	extradata=3 is the 66 float (264 byte) packet with the engine and the wheel
+	speeds X1nput needs. The RPM fields are in tens of RPM.
+
+	The packet has no slip ratios. They are worked out from each wheel's speed
+	against the car's: (wheel - car) / car, scaled by kCodemastersPeakSlipRatio
+	so 1 is where a tyre starts to lose grip, like Forza's normalized ratio.
+	Slip angles and combined slip stay 0, AnalyzeWheelSlip() then grades lock-up
+	and wheelspin from the ratio alone. The g-forces become AccelerationX
+	(lateral) and AccelerationZ (longitudinal) in m/s^2, signed as the game
+	reports them. There is no car class or drivetrain, so the car preset is
+	kUnknownCarPreset.
+*/
+
+constexpr size_t kCodemastersPacketSize = 66 * sizeof(float);
+
+// Slip ratio at which a tyre gives its most grip, the 1.0 of the normalized ratio.
+constexpr float kCodemastersPeakSlipRatio = 0.15f;
+
+// Index of each field X1nput reads, in floats from the start of the packet.
+enum CodemastersField : uint8_t {
+	CodemastersField_TotalTime = 0,      // Seconds
+	CodemastersField_Speed = 7,          // m/s
+	CodemastersField_WheelSpeedRearLeft = 25,
+	CodemastersField_WheelSpeedRearRight = 26,
+	CodemastersField_WheelSpeedFrontLeft = 27,
+	CodemastersField_WheelSpeedFrontRight = 28,
+	CodemastersField_Throttle = 29,      // 0..1
+	CodemastersField_Brake = 31,         // 0..1
+	CodemastersField_Gear = 33,          // 0 neutral, 10 (or -1 on older games) reverse
+	CodemastersField_GForceLateral = 34,
+	CodemastersField_GForceLongitudinal = 35,
+	CodemastersField_EngineRate = 37,    // RPM / 10
+	CodemastersField_MaxRpm = 63,        // RPM / 10
+	CodemastersField_IdleRpm = 64,       // RPM / 10
+};
+
+struct CodemastersDecoder {
+	template <CodemastersField Field>
+	static float get(const PacketView& packet) {
+		static_assert((Field + 1) * sizeof(float) <= kCodemastersPacketSize, "field lies outside the packet");
+		return packet.read<float>(Field * sizeof(float));
+	}
+
+	// The caller guarantees packet.length() == kCodemastersPacketSize.
+	static void decode(const PacketView& packet, TelemetryData& telemetry) {
+		const float kStandardGravity = 9.80665f;
+
+		double totalTime = get<CodemastersField_TotalTime>(packet);
+		telemetry.TimestampMs = totalTime >= 0 ? static_cast<uint32_t>(static_cast<uint64_t>(totalTime * 1000.0)) : 0;
+
+		telemetry.EngineMaxRpm = get<CodemastersField_MaxRpm>(packet) * 10.f;
+		telemetry.EngineIdleRpm = get<CodemastersField_IdleRpm>(packet) * 10.f;
+		telemetry.CurrentEngineRpm = get<CodemastersField_EngineRate>(packet) * 10.f;
+		telemetry.Speed = get<CodemastersField_Speed>(packet);
+
+		// Below walking pace the ratio is all noise; the 1 m/s floor still shows a launch spinning its wheels.
+		float scale = 1.f / (std::fmax(std::fabs(telemetry.Speed), 1.f) * kCodemastersPeakSlipRatio);
+		telemetry.TireSlipRatioFrontLeft = (get<CodemastersField_WheelSpeedFrontLeft>(packet) - telemetry.Speed) * scale;
+		telemetry.TireSlipRatioFrontRight = (get<CodemastersField_WheelSpeedFrontRight>(packet) - telemetry.Speed) * scale;
+		telemetry.TireSlipRatioRearLeft = (get<CodemastersField_WheelSpeedRearLeft>(packet) - telemetry.Speed) * scale;
+		telemetry.TireSlipRatioRearRight = (get<CodemastersField_WheelSpeedRearRight>(packet) - telemetry.Speed) * scale;
+		telemetry.TireSlipAngleFrontLeft = telemetry.TireSlipAngleFrontRight = 0.f;
+		telemetry.TireSlipAngleRearLeft = telemetry.TireSlipAngleRearRight = 0.f;
+		telemetry.TireCombinedSlipFrontLeft = telemetry.TireCombinedSlipFrontRight = 0.f;
+		telemetry.TireCombinedSlipRearLeft = telemetry.TireCombinedSlipRearRight = 0.f;
+
+		telemetry.AccelerationX = get<CodemastersField_GForceLateral>(packet) * kStandardGravity;
+		telemetry.AccelerationY = 0.f;
+		telemetry.AccelerationZ = get<CodemastersField_GForceLongitudinal>(packet) * kStandardGravity;
+
+		telemetry.Throttle = get<CodemastersField_Throttle>(packet);
+		telemetry.Brake = get<CodemastersField_Brake>(packet);
+
+		// TelemetryData counts reverse as gear 0; neutral reads as first so the reverse effects stay off.
+		float gear = get<CodemastersField_Gear>(packet);
+		if (gear < 0.f || gear >= 9.5f) {
+			telemetry.Gear = 0;
+		}
+		else {
+			telemetry.Gear = static_cast<uint8_t>(std::fmax(gear + 0.5f, 1.f));
+		}
+
+		telemetry.CarOrdinal = -1;
+		telemetry.CarClass = -1;
+		telemetry.CarPerformanceIndex = 0;
+		telemetry.DrivetrainType = -1;
+		telemetry.NumCylinders = 0;
+		telemetry.CarPreset = kUnknownCarPreset;
+
+		telemetry.Source = TelemetrySource_Codemasters;
+		DeriveTelemetry(telemetry);
+	}
+};
+
+// The packet is only told apart by its length; a NaN or negative engine rate means some other 264 byte datagram.
+inline bool IsCodemastersPacket(const char* data, size_t length) {
+	if (length != kCodemastersPacketSize) {
+		return false;
+	}
+	float engineRate = CodemastersDecoder::get<CodemastersField_EngineRate>(PacketView(data, length));
+	return engineRate >= 0.f && engineRate < 10000.f;
+}
+
+// Returns false for anything that is not an extradata=3 packet.
+inline bool DecodeCodemastersPacket(const char* data, size_t length, TelemetryData& telemetry) {
+	if (!IsCodemastersPacket(data, length)) {
+		return false;
+	}
+	CodemastersDecoder::decode(PacketView(data, length), telemetry);
+	return true;
+}
@@ -0,0 +1,73 @@
+#include "CollisionDetector.h"
+#include "FastMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CollisionDetector::reset() {
+	newest = 0;
+	count = 0;
+	envelope = 0.f;
+	bias = 0.f;
+}
+
+CollisionImpulse CollisionDetector::current() const {
+	CollisionImpulse impulse;
+	impulse.Strength = envelope;
+	impulse.Left = bias < 0.f ? envelope * (1.f + bias) : envelope;
+	impulse.Right = bias > 0.f ? envelope * (1.f - bias) : envelope;
+	return impulse;
+}
+
+CollisionImpulse CollisionDetector::update(uint32_t timestampMs, float accelerationX, float accelerationY, float accelerationZ) {
+	if (count > 0) {
+		// Unsigned difference: wraps correctly, and a timestamp going backwards reads as a long gap.
+		uint32_t elapsed = timestampMs - history[newest].TimestampMs;
+		if (elapsed == 0) {
+			return current(); // The same packet again
+		}
+
+		envelope *= static_cast<float>(FastExp(-static_cast<double>(elapsed) / options.decayMs));
+		if (envelope < 0.01f) {
+			envelope = 0.f;
+		}
+
+		if (elapsed > kMaxGapMs) {
+			count = 0;
+		}
+	}
+
+	newest = (newest + 1) % kHistory;
+	history[newest] = { timestampMs, accelerationX, accelerationY, accelerationZ };
+	count = std::min(count + 1, kHistory);
+	if (count < 2) {
+		return current();
+	}
+
+	const Sample& oldest = history[(newest + kHistory + 1 - count) % kHistory];
+	const float seconds = (timestampMs - oldest.TimestampMs) * 0.001f;
+	const float jx = (accelerationX - oldest.X) / seconds;
+	const float jy = 0.5f * (accelerationY - oldest.Y) / seconds; // Vertical counts half, see CollisionDetector.h
+	const float jz = (accelerationZ - oldest.Z) / seconds;
+	const float jerk = std::sqrt(jx * jx + jy * jy + jz * jz);
+
+	const float before = oldest.X * oldest.X + oldest.Y * oldest.Y + oldest.Z * oldest.Z;
+	const float after = accelerationX * accelerationX + accelerationY * accelerationY + accelerationZ * accelerationZ;
+
+	if (jerk > options.jerkThreshold && after > before) {
+		float strength = std::min(1.f, jerk / options.fullScaleJerk);
+		if (strength > envelope) {
+			envelope = strength;
+			bias = options.sideBias * std::max(-1.f, std::min(jx / options.fullScaleJerk, 1.f));
+		}
+	}
+
+	return current();
+}
+
+void CollisionDetector::update(TelemetryData& telemetry) {
+	CollisionImpulse impulse = update(telemetry.TimestampMs, telemetry.AccelerationX, telemetry.AccelerationY, telemetry.AccelerationZ);
+	telemetry.Impact = impulse.Strength;
+	telemetry.ImpactLeft = impulse.Left;
+	telemetry.ImpactRight = impulse.Right;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "TelemetryData.h"
+
+#include <cstdint>
+
+/*
+	Streaming collision detector.
+
+	A hit shows up as a sudden change of acceleration, not as a large one: a long
+	corner holds 10-15 m/s^2 for seconds, while a wall or another car changes the
+	acceleration by that much within a packet or two. update() keeps the last few
+	acceleration vectors, takes the jerk (change of acceleration per second) on all
+	three axes across that window, and when its magnitude crosses jerkThreshold
+	starts an impulse that decays exponentially with decayMs. Vertical jerk counts
+	half: kerbs and bumps in the road flip the vertical acceleration by 10 m/s^2
+	or more several times a second, a hit pushes the car sideways or along. Only a
+	growing acceleration starts an impulse, so the spike falling away again a few
+	packets later is not taken for a second hit from the other side.
+
+	The envelope is split into a left and right share from the X (sideways)
+	component of the jerk that started it: a car pushed to the right was hit on
+	its left, so the left motor gets the full impulse and the right one less. The
+	share is the sideways jerk against fullScaleJerk, not against the whole jerk,
+	so hitting a wall at an angle reads as a side hit even though most of the jerk
+	is the car losing its speed.
+
+	Packet timestamps drive the timing, so replaying a capture at any speed gives
+	the same envelopes. Each update() is constant time and allocates nothing.
+*/
+
+struct CollisionDetectorOptions {
+	float jerkThreshold = 250.f;  // m/s^3; below this a change of acceleration is driving, not a hit
+	float fullScaleJerk = 1000.f; // m/s^3 that gives an impulse of 1
+	float decayMs = 150.f;        // Time for the impulse to fall to 1/e
+	float sideBias = 0.75f;       // 0: both motors equal, 1: a full scale side hit only drives the motor on that side
+};
+
+struct CollisionImpulse {
+	float Strength; // 0..1
+	float Left;     // Strength with the side bias applied
+	float Right;
+};
+
+class CollisionDetector {
+public:
+	explicit CollisionDetector(const CollisionDetectorOptions& options = CollisionDetectorOptions()) : options(options) { reset(); }
+
+	const CollisionDetectorOptions& getOptions() const { return options; }
+	void setOptions(const CollisionDetectorOptions& value) { options = value; }
+
+	// Forgets the history and drops any running impulse.
+	void reset();
+
+	// The envelope as of the last packet.
+	CollisionImpulse current() const;
+
+	// Feeds one packet and returns the envelope at its time.
+	CollisionImpulse update(uint32_t timestampMs, float accelerationX, float accelerationY, float accelerationZ);
+
+	// Same, reading the packet's fields and writing Impact/ImpactLeft/ImpactRight back.
+	void update(TelemetryData& telemetry);
+
+private:
+	// Jerk is measured from the oldest to the newest of these, about 50 ms at 60 packets per second.
+	static constexpr unsigned kHistory = 4;
+	// A longer gap between packets (pause, loading, a restart) starts a new history.
+	static constexpr uint32_t kMaxGapMs = 250;
+
+	struct Sample {
+		uint32_t TimestampMs;
+		float X, Y, Z;
+	};
+
+	CollisionDetectorOptions options;
+	Sample history[kHistory];
+	unsigned newest;  // Index of the latest sample in history
+	unsigned count;   // Valid samples, up to kHistory
+
+	float envelope;
+	float bias;       // Of the running impulse: > 0 hit on the left, < 0 hit on the right
+};
@@ -0,0 +1,162 @@
+#include "Config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <thread>
+
+// [Telemetry] Formats: a comma separated list of kTelemetrySourceNames, any case. Empty, or nothing known, is all of them.
+static TelemetryFormats ParseTelemetryFormats(const std::string& names) {
+	TelemetryFormats formats = 0;
+	size_t start = 0;
+	while (start <= names.size()) {
+		size_t end = std::min(names.find(',', start), names.size());
+		std::string name;
+		for (size_t i = start; i < end; ++i) {
+			if (!std::isspace(static_cast<unsigned char>(names[i]))) {
+				name += static_cast<char>(std::tolower(static_cast<unsigned char>(names[i])));
+			}
+		}
+		for (uint32_t source = TelemetrySource_None + 1; source < TelemetrySource_Count; ++source) {
+			std::string known = kTelemetrySourceNames[source];
+			std::transform(known.begin(), known.end(), known.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			if (name == known) {
+				formats |= 1u << source;
+			}
+		}
+		start = end + 1;
+	}
+	return formats != 0 ? formats : kAllTelemetryFormats;
+}
+
+// [Telemetry] Relay: comma separated "HOST:PORT" or "FROM>HOST:PORT" entries. Entries that do not parse are skipped.
+static std::vector<RelayTarget> ParseRelayTargets(const std::string& text) {
+	std::vector<RelayTarget> targets;
+	size_t start = 0;
+	while (start <= text.size()) {
+		size_t end = std::min(text.find(',', start), text.size());
+		std::string entry;
+		for (size_t i = start; i < end; ++i) {
+			if (!std::isspace(static_cast<unsigned char>(text[i]))) {
+				entry += text[i];
+			}
+		}
+		start = end + 1;
+
+		RelayTarget target;
+		size_t arrow = entry.find('>');
+		if (arrow != std::string::npos) {
+			char* portEnd = nullptr;
+			long port = std::strtol(entry.c_str(), &portEnd, 10);
+			if (portEnd != entry.c_str() + arrow || port <= 0 || port > 65535) {
+				continue;
+			}
+			target.fromPort = static_cast<uint16_t>(port);
+			entry.erase(0, arrow + 1);
+		}
+		if (!entry.empty() && ParseUdpEndpoint(entry, target.endpoint)) {
+			targets.push_back(target);
+		}
+	}
+	return targets;
+}
+
+X1nputConfig ParseConfig(const IniFile& ini) {
+	X1nputConfig config;
+	HapticsSettings haptics;
+
+	haptics.LTriggerStrength = ini.getFloat("Triggers", "LeftStrength", "0.25");
+	haptics.RTriggerStrength = ini.getFloat("Triggers", "RightStrength", "0.25");
+	config.TriggerSwap = ini.getBool("Triggers", "SwapSides", "False");
+
+	haptics.LMotorStrength = ini.getFloat("Motors", "LeftStrength", "1.0");
+	haptics.RMotorStrength = ini.getFloat("Motors", "RightStrength", "1.0");
+	config.MotorSwap = ini.getBool("Motors", "SwapSides", "False");
+
+	EffectProgram effects;
+	if (!CompileEffectGraph(ini, effects, config.EffectsError)) {
+		effects = DefaultEffectProgram();
+	}
+	EffectPresets presets(effects);
+	if (config.EffectsError.empty() && !CompileEffectPresets(ini, effects, presets, config.EffectsError)) {
+		presets = EffectPresets(effects);
+	}
+	config.Haptics = HapticsEngine(haptics, presets);
+
+	config.ReadingCacheUs = std::max(0, ini.getInt("Input", "ReadingCacheUs", 1000));
+	config.LogCacheStats = ini.getBool("Input", "LogCacheStats", "False");
+
+	config.OutputRate = static_cast<unsigned>(std::max(0, std::min(ini.getInt("Output", "UpdateRate", 0), 1000)));
+	config.Coalescing.resolution = static_cast<unsigned>(std::max(0, std::min(ini.getInt("Output", "Resolution", 100), 65535)));
+	config.Coalescing.threshold = std::max(0.f, ini.getFloat("Output", "ChangeThreshold", "0.01"));
+	config.Coalescing.maxRate = static_cast<unsigned>(std::max(0, std::min(ini.getInt("Output", "MaxSendRate", 0), 1000)));
+
+	const char* const smoothingPrefixes[2] = { "Motor", "Trigger" };
+	HapticsFilterSettings* const smoothing[2] = { &config.Smoothing.motors, &config.Smoothing.triggers };
+	for (size_t i = 0; i < 2; ++i) {
+		std::string prefix = smoothingPrefixes[i];
+		smoothing[i]->attackMs = std::max(0.f, ini.getFloat("Smoothing", (prefix + "AttackMs").c_str(), "0"));
+		smoothing[i]->releaseMs = std::max(0.f, ini.getFloat("Smoothing", (prefix + "ReleaseMs").c_str(), "0"));
+		smoothing[i]->smoothingMs = std::max(0.f, ini.getFloat("Smoothing", (prefix + "SmoothingMs").c_str(), "0"));
+		smoothing[i]->slewRate = std::max(0.f, ini.getFloat("Smoothing", (prefix + "SlewRate").c_str(), "0"));
+	}
+
+	config.Telemetry.port = static_cast<uint16_t>(ini.getInt("Telemetry", "Port", kDefaultTelemetryPort));
+	config.Telemetry.capturePath = ini.getString("Telemetry", "CaptureFile", "");
+	config.Telemetry.replayPath = ini.getString("Telemetry", "ReplayFile", "");
+	config.Telemetry.replayPacing = ini.getBool("Telemetry", "ReplayRealTime", "True") ? ReplayPacing::Original : ReplayPacing::AsFastAsPossible;
+	config.Telemetry.formats = ParseTelemetryFormats(ini.getString("Telemetry", "Formats", ""));
+	config.Telemetry.relay = ParseRelayTargets(ini.getString("Telemetry", "Relay", ""));
+
+	CollisionDetectorOptions& collision = config.Telemetry.collision;
+	collision.jerkThreshold = ini.getFloat("Collision", "JerkThreshold", "250");
+	collision.fullScaleJerk = std::max({ 1.f, collision.jerkThreshold, ini.getFloat("Collision", "FullScaleJerk", "1000") });
+	collision.decayMs = std::max(1.f, ini.getFloat("Collision", "DecayMs", "150"));
+	collision.sideBias = std::max(0.f, std::min(ini.getFloat("Collision", "SideBias", "0.75"), 1.f));
+
+	TelemetryPredictorOptions& prediction = config.Telemetry.prediction;
+	prediction.enabled = ini.getBool("Prediction", "Enabled", "False");
+	prediction.alpha = std::max(0.f, std::min(ini.getFloat("Prediction", "Alpha", "0.5"), 1.f));
+	prediction.beta = std::max(0.f, std::min(ini.getFloat("Prediction", "Beta", "0.1"), 1.f));
+	prediction.rpmAlpha = std::max(0.f, std::min(ini.getFloat("Prediction", "RpmAlpha", "0.8"), 1.f));
+	prediction.rpmBeta = std::max(0.f, std::min(ini.getFloat("Prediction", "RpmBeta", "0.3"), 1.f));
+	prediction.leadMs = std::max(0.f, ini.getFloat("Prediction", "LeadMs", "0"));
+	prediction.maxMs = std::max(0.f, ini.getFloat("Prediction", "MaxMs", "50"));
+
+	// Pad1..Pad8: empty for the [Telemetry] port, "Off" (or anything else that isn't a number) reads as 0.
+	for (size_t i = 0; i < kMaxPads; ++i) {
+		std::string key = "Pad" + std::to_string(i + 1);
+		std::string value = ini.getString("Routing", key.c_str(), "");
+		long port = value.empty() ? config.Telemetry.port : std::strtol(value.c_str(), nullptr, 10);
+		config.Routes[i].TelemetryPort = static_cast<uint16_t>(std::max(0L, std::min(port, 65535L)));
+	}
+
+	config.StatsName = ini.getString("Stats", "SharedMemory", "");
+
+	return config;
+}
+
+ConfigStore::ConfigStore() : active(nullptr), publishCount(0), epoch(0), readers{ { 0 }, { 0 } } {
+	publish(X1nputConfig());
+}
+
+const X1nputConfig* ConfigStore::publish(const X1nputConfig& config) {
+	std::unique_ptr<const X1nputConfig> version(new X1nputConfig(config));
+	std::lock_guard<std::mutex> guard(writerLock);
+
+	const X1nputConfig* published = version.get();
+	active.store(published);
+	publishCount.fetch_add(1, std::memory_order_relaxed);
+
+	// A reader that loaded the old pointer counted itself first, under either bit: wait for both counters, each after
+	// the flip that sends new readers to the other one.
+	for (int flip = 0; flip < 2; ++flip) {
+		unsigned left = epoch.fetch_xor(1) & 1;
+		while (readers[left].load() != 0) {
+			std::this_thread::yield();
+		}
+	}
+
+	activeVersion = std::move(version);
+	return published;
+}
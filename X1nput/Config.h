@@ -0,0 +1,108 @@
+#pragma once
+
+#include "HapticsEngine.h"
+#include "HapticsFilter.h"
+#include "IniFile.h"
+#include "TelemetryReader.h"
+#include "VibrationCoalescer.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	X1nput.ini, parsed once.
+
+	ParseConfig() turns an IniFile into an immutable X1nputConfig, and ConfigStore
+	publishes each new version with a single pointer swap so the input and output
+	threads read settings without taking a lock.
+*/
+
+// Gamepad slots X1nput manages (MAX_PLAYER_COUNT in dllmain.cpp).
+constexpr size_t kMaxPads = 8;
+
+// [Routing] entry for one pad.
+struct PadRoute {
+	uint16_t TelemetryPort = kDefaultTelemetryPort;  // Port whose telemetry drives the pad's effects, 0 for the game's rumble only
+};
+
+struct X1nputConfig {
+	HapticsEngine Haptics;           // [Triggers]/[Motors] strengths and the compiled [Effects] and [Presets]
+	std::string EffectsError;        // Why the [Effects] (built-in effects used then) or [Presets] (ignored then) were rejected
+	bool TriggerSwap = false;
+	bool MotorSwap = false;
+
+	int ReadingCacheUs = 1000;       // 0 disables the reading cache
+	bool LogCacheStats = false;
+
+	unsigned OutputRate = 0;         // 0: update only when the game calls XInputSetState
+	VibrationCoalescerOptions Coalescing;  // [Output] Resolution, ChangeThreshold and MaxSendRate: which outputs reach put_Vibration
+	HapticsFilterOptions Smoothing;  // [Smoothing] between the effects and put_Vibration
+
+	TelemetryReaderOptions Telemetry;
+	PadRoute Routes[kMaxPads];
+
+	std::string StatsName;           // [Stats] shared memory for LatencyStats, empty when off
+};
+
+X1nputConfig ParseConfig(const IniFile& ini);
+
+/*
+	Holds the current X1nputConfig. Readers pin it with a ConfigStore::Reader for
+	the rest of their call; publish() swaps in a new version.
+
+	Readers are counted rather than locked out. A Reader adds itself to one of two
+	counters, picked by the low bit of the epoch, and only then loads the current
+	pointer. publish() swaps the pointer, then twice flips the epoch and waits for
+	the counter it left to drain: after that no reader can still hold the version
+	it replaced, which it frees. Readers that arrive during the wait count under
+	the new bit, so a stream of them never holds a publish up. A Reader costs two
+	atomic adds; a publish waits for the readers already inside, the exports for
+	one call and the output thread for one tick.
+*/
+class ConfigStore {
+public:
+	class Reader {
+	public:
+		explicit Reader(const ConfigStore& store) :
+			count(store.readers[store.epoch.load() & 1]) {
+			count.fetch_add(1);
+			config = store.active.load();
+		}
+		~Reader() { count.fetch_sub(1, std::memory_order_release); }
+
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		const X1nputConfig* get() const { return config; }
+		const X1nputConfig* operator->() const { return config; }
+
+	private:
+		std::atomic<uint64_t>& count;
+		const X1nputConfig* config;
+	};
+
+	ConfigStore();
+
+	ConfigStore(const ConfigStore&) = delete;
+	ConfigStore& operator=(const ConfigStore&) = delete;
+
+	// Returns the published version, which only a Reader keeps alive past the next publish. Safe to call from several
+	// threads, but not by one that holds a Reader: it would wait for itself.
+	const X1nputConfig* publish(const X1nputConfig& config);
+
+	uint64_t version() const { return publishCount.load(std::memory_order_relaxed); }
+
+	// Readers alive now.
+	uint64_t readerCount() const { return readers[0].load() + readers[1].load(); }
+
+private:
+	std::atomic<const X1nputConfig*> active;
+	std::atomic<uint64_t> publishCount;
+	std::atomic<unsigned> epoch;
+	mutable std::atomic<uint64_t> readers[2];           // Readers that started under an even and an odd epoch
+	std::mutex writerLock;
+	std::unique_ptr<const X1nputConfig> activeVersion;  // Owns active
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/*
+	Fixed slot table for hot-plugged devices.
+
+	The device added/removed events call add() and remove() with the device from
+	their payload; only that slot changes, nothing is rescanned. The input path
+	calls get() from any thread without a lock and never waits for a writer.
+
+	A slot remembers the last device it held. When that device comes back it gets
+	the same slot again, so a controller that drops out mid-race is still player
+	2 after it reconnects. New devices take a slot that has never been used first
+	and only then one reserved for a device that is gone.
+
+	The registry does not own the devices. The caller must keep every device it
+	ever passed to add() alive for as long as readers may call get(): a reader
+	that loaded a pointer just before remove() then still holds a live object.
+*/
+template <typename Device, size_t SlotCount>
+class DeviceRegistry {
+public:
+	static constexpr size_t kNoSlot = SlotCount;
+
+	DeviceRegistry() : changeCount(0) {
+		for (size_t i = 0; i < SlotCount; ++i) {
+			slots[i].store(nullptr, std::memory_order_relaxed);
+			generations[i].store(0, std::memory_order_relaxed);
+			owners[i] = nullptr;
+		}
+	}
+
+	DeviceRegistry(const DeviceRegistry&) = delete;
+	DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+	static constexpr size_t size() { return SlotCount; }
+
+	// The device in slot, or null. Lock-free; an out of range slot is treated as empty.
+	Device* get(size_t slot) const {
+		return slot < SlotCount ? slots[slot].load(std::memory_order_acquire) : nullptr;
+	}
+
+	// Bumped every time the slot's device changes, so a cache keyed by slot can tell it is stale.
+	uint32_t generation(size_t slot) const {
+		return slot < SlotCount ? generations[slot].load(std::memory_order_acquire) : 0;
+	}
+
+	// Bumped on every add or remove that changed a slot.
+	uint64_t version() const { return changeCount.load(std::memory_order_acquire); }
+
+	// Returns the slot the device is in. added is set when it was not in a slot before.
+	// Returns kNoSlot when every slot holds another device.
+	size_t add(Device* device, bool& added) {
+		std::lock_guard<std::mutex> guard(writerLock);
+		added = false;
+		if (device == nullptr) {
+			return kNoSlot;
+		}
+
+		size_t slot = find(device);
+		if (slot != kNoSlot) {
+			return slot;
+		}
+
+		// Its own reserved slot, then a slot never used, then the first free one.
+		for (size_t i = 0; i < SlotCount && slot == kNoSlot; ++i) {
+			if (owners[i] == device && slots[i].load(std::memory_order_relaxed) == nullptr) {
+				slot = i;
+			}
+		}
+		for (size_t i = 0; i < SlotCount && slot == kNoSlot; ++i) {
+			if (owners[i] == nullptr) {
+				slot = i;
+			}
+		}
+		for (size_t i = 0; i < SlotCount && slot == kNoSlot; ++i) {
+			if (slots[i].load(std::memory_order_relaxed) == nullptr) {
+				slot = i;
+			}
+		}
+		if (slot == kNoSlot) {
+			return kNoSlot;
+		}
+
+		owners[slot] = device;
+		publish(slot, device);
+		added = true;
+		return slot;
+	}
+
+	// Empties the device's slot and keeps it reserved for the device. Returns kNoSlot if it had none.
+	size_t remove(Device* device) {
+		std::lock_guard<std::mutex> guard(writerLock);
+
+		size_t slot = device != nullptr ? find(device) : kNoSlot;
+		if (slot != kNoSlot) {
+			publish(slot, nullptr);
+		}
+		return slot;
+	}
+
+private:
+	std::atomic<Device*> slots[SlotCount];
+	std::atomic<uint32_t> generations[SlotCount];
+	std::atomic<uint64_t> changeCount;
+
+	std::mutex writerLock;
+	Device* owners[SlotCount];  // Last device each slot held; writers only
+
+	size_t find(Device* device) const {
+		for (size_t i = 0; i < SlotCount; ++i) {
+			if (slots[i].load(std::memory_order_relaxed) == device) {
+				return i;
+			}
+		}
+		return kNoSlot;
+	}
+
+	void publish(size_t slot, Device* device) {
+		generations[slot].fetch_add(1, std::memory_order_relaxed);
+		slots[slot].store(device, std::memory_order_release);
+		changeCount.fetch_add(1, std::memory_order_release);
+	}
+};
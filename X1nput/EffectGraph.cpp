@@ -0,0 +1,689 @@
+#include "EffectGraph.h"
+#include "EffectNative.h"
+#include "FastMath.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+// The effects X1nput used to have hand-written, with collisions taken from the CollisionDetector impulse instead of
+// the raw acceleration. Kept in step with the [Effect.*] sections in X1nput.ini.
+static const char kDefaultEffects[] =
+	"[Effects]\n"
+	"Order=Bump, Abs, Rpm, RpmLow, RpmHigh, RpmHighBump, Traction, Reverse\n"
+	"MotorLimit=0.85\n"
+	"TriggerLimit=0.7\n"
+	"[Effect.Bump]\n"
+	"Source=Impact\n"
+	"Curve=Linear\n"
+	"Points=0:0, 1:0.7\n"
+	"When=LeftTrigger<0.1\n"
+	"LeftMotor+=0.7*ImpactLeft\n"
+	"RightMotor+=0.7*ImpactRight\n"
+	"[Effect.Abs]\n"
+	"When=LeftTrigger>0.1, Lockup>0\n"
+	"LeftImpulse=0.1*LeftRumble + Bump + 0.15 + 0.3*Lockup\n"
+	"LeftMotor+=0.1 + 0.3*Lockup\n"
+	"RightMotor+=0.1 + 0.3*Lockup\n"
+	"[Effect.Rpm]\n"
+	"Source=NRPM\n"
+	"Curve=Exp\n"
+	"Scale=0.008333333333333333\n"
+	"Rate=4\n"
+	"Offset=0.01\n"
+	"Plus=Bump\n"
+	"[Effect.RpmLow]\n"
+	"When=Rpm<=0.5\n"
+	"RightImpulse=0.1*RightRumble + Rpm\n"
+	"[Effect.RpmHigh]\n"
+	"When=Rpm>0.5\n"
+	"RightImpulse=0.5\n"
+	"[Effect.RpmHighBump]\n"
+	"When=Rpm>0.5, Bump>0.3\n"
+	"RightImpulse=0.7\n"
+	"[Effect.Traction]\n"
+	"When=RightTrigger>0.1, Wheelspin>0\n"
+	"RightImpulse+=0.1 + 0.2*Wheelspin\n"
+	"[Effect.Reverse]\n"
+	"When=Gear<1, RightTrigger>0.3\n"
+	"LeftMotor=0.5 + GameLeftMotor\n"
+	"RightMotor=0.5 + GameRightMotor\n"
+	"LeftImpulse=0.4\n"
+	"RightImpulse=0.4\n";
+
+// The rules as XInputSetState had them. The old bump was 0.3 above 10, 0.5 strictly between 15 and 30 and 0.7 above
+// 30, so exactly 30 fell back to 0.3: the >=30 point reproduces that edge.
+static const char kClassicEffects[] =
+	"[Effects]\n"
+	"Order=Bump, Abs, Rpm, RpmLow, RpmHigh, RpmHighBump, Reverse\n"
+	"MotorLimit=0.85\n"
+	"TriggerLimit=0.7\n"
+	"[Effect.Bump]\n"
+	"Source=Acceleration\n"
+	"Curve=Step\n"
+	"Points=10:0.3, 15:0.5, >=30:0.3, 30:0.7\n"
+	"When=LeftTrigger<0.1\n"
+	"LeftMotor+=Bump\n"
+	"RightMotor+=Bump\n"
+	"[Effect.Abs]\n"
+	"When=LeftTrigger>0.1, Slip>1\n"
+	"LeftImpulse=0.1*LeftRumble + Bump + 0.3\n"
+	"LeftMotor+=0.3\n"
+	"RightMotor+=0.3\n"
+	"[Effect.Rpm]\n"
+	"Source=NRPM\n"
+	"Curve=Exp\n"
+	"Scale=0.008333333333333333\n"
+	"Rate=4\n"
+	"Offset=0.01\n"
+	"Plus=Bump\n"
+	"[Effect.RpmLow]\n"
+	"When=Rpm<=0.5\n"
+	"RightImpulse=0.1*RightRumble + Rpm\n"
+	"[Effect.RpmHigh]\n"
+	"When=Rpm>0.5\n"
+	"RightImpulse=0.5\n"
+	"[Effect.RpmHighBump]\n"
+	"When=Rpm>0.5, Bump>0.3\n"
+	"RightImpulse=0.7\n"
+	"[Effect.Reverse]\n"
+	"When=Gear<1, RightTrigger>0.3\n"
+	"LeftMotor=0.5 + GameLeftMotor\n"
+	"RightMotor=0.5 + GameRightMotor\n"
+	"LeftImpulse=0.4\n"
+	"RightImpulse=0.4\n";
+
+static const char* const kSignalNames[EffectSignal_One] = {
+	"Speed", "CurrentEngineRpm", "NRPM", "Slip", "Acceleration", "AccelerationX", "AccelerationY", "AccelerationZ", "Gear",
+	"TireSlipRatioFL", "TireSlipRatioFR", "TireSlipRatioRL", "TireSlipRatioRR",
+	"TireSlipAngleFL", "TireSlipAngleFR", "TireSlipAngleRL", "TireSlipAngleRR",
+	"TireCombinedSlipFL", "TireCombinedSlipFR", "TireCombinedSlipRL", "TireCombinedSlipRR",
+	"Lockup", "LockupFront", "LockupRear", "Wheelspin", "WheelspinFront", "WheelspinRear",
+	"Impact", "ImpactLeft", "ImpactRight",
+	"LeftTrigger", "RightTrigger", "LeftRumble", "RightRumble", "GameLeftMotor", "GameRightMotor",
+	"LeftMotor", "RightMotor", "LeftImpulse", "RightImpulse",
+};
+
+// TelemetryData field of each telemetry EffectSignal. Gear is a byte and loaded separately.
+static float TelemetryData::* const kTelemetrySignals[EffectSignal_LeftTrigger] = {
+	&TelemetryData::Speed,
+	&TelemetryData::CurrentEngineRpm,
+	&TelemetryData::NRPM,                       // Normalized RPM (0: idle, 1: maximum RPM).
+	&TelemetryData::Slip,                       // Slip (< 1: stable, > 1: starting to slide).
+	&TelemetryData::Acceleration,               // Acceleration (> 20 indicates a collision).
+	&TelemetryData::AccelerationX,
+	&TelemetryData::AccelerationY,
+	&TelemetryData::AccelerationZ,
+	nullptr,                                    // Gear
+	&TelemetryData::TireSlipRatioFrontLeft,
+	&TelemetryData::TireSlipRatioFrontRight,
+	&TelemetryData::TireSlipRatioRearLeft,
+	&TelemetryData::TireSlipRatioRearRight,
+	&TelemetryData::TireSlipAngleFrontLeft,
+	&TelemetryData::TireSlipAngleFrontRight,
+	&TelemetryData::TireSlipAngleRearLeft,
+	&TelemetryData::TireSlipAngleRearRight,
+	&TelemetryData::TireCombinedSlipFrontLeft,
+	&TelemetryData::TireCombinedSlipFrontRight,
+	&TelemetryData::TireCombinedSlipRearLeft,
+	&TelemetryData::TireCombinedSlipRearRight,
+	&TelemetryData::Lockup,                     // Wheel lock-up, 0..1.
+	&TelemetryData::LockupFront,
+	&TelemetryData::LockupRear,
+	&TelemetryData::Wheelspin,                  // Wheelspin, 0..1.
+	&TelemetryData::WheelspinFront,
+	&TelemetryData::WheelspinRear,
+	&TelemetryData::Impact,                     // Collision impulse envelope.
+	&TelemetryData::ImpactLeft,
+	&TelemetryData::ImpactRight,
+};
+
+float TelemetryData::* EffectSignalField(uint8_t signal) {
+	return kTelemetrySignals[signal];
+}
+
+double EvaluateEffectPoints(EffectCurve curve, const double* point, unsigned pointCount, double x) {
+	// Count the points below x instead of branching on each: the points are in increasing x order, padded to
+	// kCurveLanes with +infinity, which nothing is above.
+	unsigned below = 0;
+	for (unsigned i = 0; i < pointCount; i += kCurveLanes) {
+		below += (x > point[2 * i]) + (x > point[2 * i + 2]) + (x > point[2 * i + 4]) + (x > point[2 * i + 6]);
+	}
+	if (curve == EffectCurve::Step) {
+		return below > 0 ? point[2 * below - 1] : 0.0;
+	}
+
+	// Interpolate once between the two points around x (the same one at either end).
+	const double* low = point + 2 * (below > 0 ? below - 1 : 0);
+	const double* high = point + 2 * (below < pointCount ? below : below - 1);
+	const double span = high[0] - low[0];
+	return low[1] + (span > 0 ? (x - low[0]) * (high[1] - low[1]) / span : 0.0);
+}
+
+void EffectProgram::loadTelemetry(double* r, const TelemetryData& telemetry) const {
+	for (uint8_t signal : telemetrySignals) {
+		r[signal] = telemetry.*kTelemetrySignals[signal];
+	}
+	r[EffectSignal_Gear] = telemetry.Gear;
+}
+
+void EffectProgram::interpret(double* r) const {
+	r[EffectSignal_One] = 1.0;
+
+	const EffectWrite* w = writes.data();
+	for (const EffectStage& stage : stages) {
+		const EffectWrite* const end = w + stage.writeCount;
+
+		// Every stage has exactly kStageConditions conditions, so the gate is four compares and no loop.
+		const double a = r[stage.gate[0].source];
+		const double b = r[stage.gate[1].source];
+		const bool gate = (a >= stage.gate[0].above) & (a <= stage.gate[0].below) & (b >= stage.gate[1].above) & (b <= stage.gate[1].below);
+
+		// Gates change slowly with the telemetry, so this branch predicts well and keeps closed stages off the dependency chain.
+		if (!gate) {
+			if (stage.value != kNoEffectRegister) {
+				r[stage.value] = 0.0;
+			}
+			w = end;
+			continue;
+		}
+
+		if (stage.value != kNoEffectRegister) {
+			const double x = r[stage.source];
+			double value = x;
+			if (stage.curve == EffectCurve::Step || stage.curve == EffectCurve::Linear) {
+				value = EvaluateEffectPoints(stage.curve, points.data() + 2 * stage.firstPoint, stage.pointCount, x);
+			}
+			else if (stage.curve == EffectCurve::Exp) {
+				value = stage.scale * FastExp(stage.rate * x + stage.offset);
+			}
+
+			if (stage.plus != kNoEffectRegister) {
+				value += r[stage.plus];
+			}
+			r[stage.value] = static_cast<float>(value);
+		}
+
+		// Always kWriteTerms terms, the unused ones -0 * One: no loop, and the same sum as adding only the used ones.
+		for (; w != end; ++w) {
+			const double sum = w->weights[0] * r[w->sources[0]] + w->weights[1] * r[w->sources[1]] +
+				w->weights[2] * r[w->sources[2]] + w->weights[3] * r[w->sources[3]] + w->constant;
+			r[w->target] = w->accumulate ? r[w->target] + sum : sum;
+		}
+	}
+}
+
+namespace {
+
+// One term of an expression while it is compiled, before it is packed into EffectWrites.
+struct EffectTerm {
+	uint8_t source;
+	double weight;
+};
+
+// A write of just its constant: the unused terms add -0 * One. Adding -0 leaves every sum as it is, the sign of a
+// zero included, so that is also the constant of an expression without numbers.
+EffectWrite EmptyWrite(uint8_t target, bool accumulate) {
+	EffectWrite write = {};
+	write.target = target;
+	write.accumulate = accumulate;
+	std::fill(write.sources, write.sources + kWriteTerms, static_cast<uint8_t>(EffectSignal_One));
+	std::fill(write.weights, write.weights + kWriteTerms, -0.0);
+	write.constant = -0.0;
+	return write;
+}
+
+std::string Trim(const std::string& text) {
+	size_t begin = text.find_first_not_of(" \t");
+	if (begin == std::string::npos) {
+		return std::string();
+	}
+	return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+std::vector<std::string> Split(const std::string& text, char separator) {
+	std::vector<std::string> parts;
+	size_t start = 0;
+	for (;;) {
+		size_t end = text.find(separator, start);
+		std::string part = Trim(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+		if (!part.empty()) {
+			parts.push_back(part);
+		}
+		if (end == std::string::npos) {
+			return parts;
+		}
+		start = end + 1;
+	}
+}
+
+bool ParseNumber(const std::string& text, double& value) {
+	if (text.empty()) {
+		return false;
+	}
+	char* end = nullptr;
+	value = std::strtod(text.c_str(), &end);
+	return *end == '\0';
+}
+
+bool SameName(const std::string& a, const std::string& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+class EffectCompiler {
+public:
+	EffectCompiler(const IniFile& ini, EffectProgram& program) : ini(ini), program(program) {
+		for (uint8_t i = 0; i < EffectSignal_One; ++i) {
+			names.emplace_back(kSignalNames[i], i);
+		}
+	}
+
+	std::string error;
+
+	bool compile(const std::vector<std::string>& order) {
+		for (const std::string& name : order) {
+			if (!compileEffect(name)) {
+				error = "[Effect." + name + "] " + error;
+				return false;
+			}
+		}
+		removeUnusedValues();
+		CompileEffectNative(program);
+		return true;
+	}
+
+private:
+	const IniFile& ini;
+	EffectProgram& program;
+	std::vector<std::pair<std::string, uint8_t>> names;
+
+	bool lookup(const std::string& name, uint8_t& reg) const {
+		for (const auto& entry : names) {
+			if (SameName(entry.first, name)) {
+				reg = entry.second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool find(const std::string& name, uint8_t& reg) {
+		if (!lookup(name, reg)) {
+			error = "unknown signal or effect '" + name + "'";
+			return false;
+		}
+		return true;
+	}
+
+	// Effects that only gate their writes still get a value register; skip computing it when nothing reads it. Then
+	// list the telemetry the rest reads.
+	void removeUnusedValues() {
+		std::vector<bool> read(kMaxEffectRegisters, false);
+		for (const EffectWrite& write : program.writes) {
+			for (unsigned i = 0; i < write.termCount; ++i) {
+				read[write.sources[i]] = true;
+			}
+		}
+		for (const EffectStage& stage : program.stages) {
+			for (const EffectCondition& condition : stage.gate) {
+				read[condition.source] = true;
+			}
+			if (stage.plus != kNoEffectRegister) {
+				read[stage.plus] = true;
+			}
+		}
+		for (EffectStage& stage : program.stages) {
+			if (!read[stage.value]) {
+				stage.value = kNoEffectRegister;
+			}
+			else {
+				read[stage.source] = true;
+			}
+		}
+
+		program.telemetrySignals.clear();
+		for (uint8_t signal = 0; signal < EffectSignal_LeftTrigger; ++signal) {
+			if (read[signal] && signal != EffectSignal_Gear) {
+				program.telemetrySignals.push_back(signal);
+			}
+		}
+	}
+
+	bool compileCondition(const std::string& condition, std::vector<EffectCondition>& conditions) {
+		static const char* const operators[] = { "<=", ">=", "<", ">" };
+		const double infinity = std::numeric_limits<double>::infinity();
+
+		for (const char* op : operators) {
+			size_t at = condition.find(op);
+			if (at == std::string::npos) {
+				continue;
+			}
+
+			EffectCondition compiled;
+			double threshold;
+			if (!find(Trim(condition.substr(0, at)), compiled.source)) {
+				return false;
+			}
+			if (!ParseNumber(Trim(condition.substr(at + std::strlen(op))), threshold)) {
+				error = "bad number in condition '" + condition + "'";
+				return false;
+			}
+
+			compiled.above = -infinity;
+			compiled.below = infinity;
+			if (op[0] == '<') {
+				compiled.below = op[1] == '=' ? threshold : std::nextafter(threshold, -infinity);
+			}
+			else {
+				compiled.above = op[1] == '=' ? threshold : std::nextafter(threshold, infinity);
+			}
+			conditions.push_back(compiled);
+			return true;
+		}
+
+		error = "condition '" + condition + "' needs <, <=, > or >=";
+		return false;
+	}
+
+	bool compilePoints(const char* section, EffectStage& stage) {
+		std::vector<std::string> points = Split(ini.getString(section, "Points", ""), ',');
+		if (points.empty()) {
+			error = "Points needs at least one x:y pair";
+			return false;
+		}
+
+		stage.firstPoint = static_cast<uint16_t>(program.points.size() / 2);
+		stage.pointCount = static_cast<uint16_t>(points.size());
+		for (const std::string& point : points) {
+			size_t colon = point.find(':');
+			std::string left = Trim(point.substr(0, colon == std::string::npos ? 0 : colon));
+			// A step taken at x itself: compiled as exceeding the value just below x.
+			bool inclusive = left.compare(0, 2, ">=") == 0;
+			if (inclusive && stage.curve != EffectCurve::Step) {
+				error = "only Step points can be written >=x:y";
+				return false;
+			}
+			double x, y;
+			if (colon == std::string::npos || !ParseNumber(Trim(inclusive ? left.substr(2) : left), x) ||
+				!ParseNumber(Trim(point.substr(colon + 1)), y)) {
+				error = "bad point '" + point + "', expected x:y";
+				return false;
+			}
+			if (inclusive) {
+				x = std::nextafter(x, -std::numeric_limits<double>::infinity());
+			}
+			if (program.points.size() / 2 > stage.firstPoint && x <= program.points[program.points.size() - 2]) {
+				error = "Points must be in increasing x order";
+				return false;
+			}
+			program.points.push_back(x);
+			program.points.push_back(y);
+		}
+		// Padding for run(), which compares kCurveLanes points at a time.
+		for (size_t i = stage.pointCount; i % kCurveLanes != 0; ++i) {
+			program.points.push_back(std::numeric_limits<double>::infinity());
+			program.points.push_back(0.0);
+		}
+		return true;
+	}
+
+	// Sum of terms, each a number, a name or number*name.
+	bool compileExpression(const std::string& expression, uint8_t target, bool accumulate) {
+		std::string text = Trim(expression);
+		std::vector<EffectTerm> terms;
+
+		size_t start = 0;
+		while (start < text.size()) {
+			double sign = 1;
+			if (text[start] == '+' || text[start] == '-') {
+				sign = text[start] == '-' ? -1 : 1;
+				++start;
+			}
+			size_t end = text.find_first_of("+-", start);
+			// A sign right after an exponent marker belongs to the number (1e-3).
+			while (end != std::string::npos && end >= start + 2 && (text[end - 1] == 'e' || text[end - 1] == 'E') &&
+				std::isdigit(static_cast<unsigned char>(text[end - 2]))) {
+				end = text.find_first_of("+-", end + 1);
+			}
+			std::string term = Trim(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+			start = end == std::string::npos ? text.size() : end;
+
+			EffectTerm compiled;
+			compiled.source = EffectSignal_One;
+			compiled.weight = 1;
+			size_t star = term.find('*');
+			if (star != std::string::npos) {
+				std::string left = Trim(term.substr(0, star));
+				std::string right = Trim(term.substr(star + 1));
+				std::string signal;
+				if (ParseNumber(left, compiled.weight)) {
+					signal = right;
+				}
+				else if (ParseNumber(right, compiled.weight)) {
+					signal = left;
+				}
+				else {
+					error = "term '" + term + "' must be number*name";
+					return false;
+				}
+				if (!find(signal, compiled.source)) {
+					return false;
+				}
+			}
+			else if (!ParseNumber(term, compiled.weight)) {
+				compiled.weight = 1;
+				if (!find(term, compiled.source)) {
+					return false;
+				}
+			}
+
+			compiled.weight *= sign;
+			terms.push_back(compiled);
+		}
+
+		if (terms.empty()) {
+			error = "empty expression";
+			return false;
+		}
+		// Number terms are added up into the constant. Longer sums become an assignment and accumulations, which only
+		// works if none of them reads the target.
+		EffectWrite write = EmptyWrite(target, accumulate);
+		size_t signalTerms = 0;
+		for (const EffectTerm& term : terms) {
+			signalTerms += term.source != EffectSignal_One;
+		}
+		if (signalTerms > kWriteTerms) {
+			for (const EffectTerm& term : terms) {
+				if (term.source == target) {
+					error = "an expression reading its own output can have at most 4 terms";
+					return false;
+				}
+			}
+		}
+		for (const EffectTerm& term : terms) {
+			if (term.source == EffectSignal_One) {
+				write.constant += term.weight;
+				continue;
+			}
+			if (write.termCount == kWriteTerms) {
+				program.writes.push_back(write);
+				write = EmptyWrite(target, true);
+			}
+			write.sources[write.termCount] = term.source;
+			write.weights[write.termCount] = term.weight;
+			++write.termCount;
+		}
+		program.writes.push_back(write);
+		return true;
+	}
+
+	bool compileEffect(const std::string& name) {
+		uint8_t existing;
+		if (lookup(name, existing)) {
+			error = "name is already used by a signal or an earlier effect";
+			return false;
+		}
+		if (program.registerCount >= kMaxEffectRegisters) {
+			error = "too many effects";
+			return false;
+		}
+
+		const std::string sectionName = "Effect." + name;
+		const char* section = sectionName.c_str();
+
+		EffectStage stage = {};
+		std::vector<EffectCondition> conditions;
+		for (const std::string& condition : Split(ini.getString(section, "When", ""), ',')) {
+			if (!compileCondition(condition, conditions)) {
+				return false;
+			}
+		}
+		// Longer condition lists go to unnamed stages ahead of this one, each open (value 1) when its conditions pass
+		// and tested by the next.
+		const double infinity = std::numeric_limits<double>::infinity();
+		while (conditions.size() > kStageConditions) {
+			if (program.registerCount >= kMaxEffectRegisters - 1) {
+				error = "too many effects";
+				return false;
+			}
+			EffectStage chained = {};
+			std::copy(conditions.begin(), conditions.begin() + kStageConditions, chained.gate);
+			chained.value = program.registerCount++;
+			chained.curve = EffectCurve::None;
+			chained.source = EffectSignal_One;
+			chained.plus = kNoEffectRegister;
+			chained.firstWrite = static_cast<uint16_t>(program.writes.size());
+			program.stages.push_back(chained);
+
+			conditions.erase(conditions.begin(), conditions.begin() + kStageConditions);
+			conditions.insert(conditions.begin(), EffectCondition{ chained.value, 1.0, infinity });
+		}
+		for (size_t i = 0; i < kStageConditions; ++i) {
+			stage.gate[i] = i < conditions.size() ? conditions[i] : EffectCondition{ EffectSignal_One, -infinity, infinity };
+		}
+
+		std::string source = ini.getString(section, "Source", "");
+		stage.source = EffectSignal_One;
+		if (!source.empty() && !find(source, stage.source)) {
+			return false;
+		}
+
+		std::string curve = ini.getString(section, "Curve", "None");
+		if (SameName(curve, "Step") || SameName(curve, "Linear")) {
+			stage.curve = SameName(curve, "Step") ? EffectCurve::Step : EffectCurve::Linear;
+			if (!compilePoints(section, stage)) {
+				return false;
+			}
+		}
+		else if (SameName(curve, "Exp")) {
+			stage.curve = EffectCurve::Exp;
+			if (!ParseNumber(ini.getString(section, "Scale", "1"), stage.scale) ||
+				!ParseNumber(ini.getString(section, "Rate", "1"), stage.rate) ||
+				!ParseNumber(ini.getString(section, "Offset", "0"), stage.offset)) {
+				error = "bad Scale, Rate or Offset";
+				return false;
+			}
+		}
+		else if (SameName(curve, "None")) {
+			stage.curve = EffectCurve::None;
+		}
+		else {
+			error = "unknown Curve '" + curve + "', expected Step, Linear, Exp or None";
+			return false;
+		}
+
+		std::string plus = ini.getString(section, "Plus", "");
+		stage.plus = kNoEffectRegister;
+		if (!plus.empty() && !find(plus, stage.plus)) {
+			return false;
+		}
+
+		stage.value = program.registerCount++;
+		names.emplace_back(name, stage.value);
+
+		stage.firstWrite = static_cast<uint16_t>(program.writes.size());
+		static const uint8_t outputs[] = { EffectSignal_LeftMotor, EffectSignal_RightMotor, EffectSignal_LeftImpulse, EffectSignal_RightImpulse };
+		for (uint8_t output : outputs) {
+			std::string key = kSignalNames[output];
+			std::string assign = ini.getString(section, key.c_str(), "");
+			std::string accumulate = ini.getString(section, (key + "+").c_str(), "");
+			if (!assign.empty() && !compileExpression(assign, output, false)) {
+				return false;
+			}
+			if (!accumulate.empty() && !compileExpression(accumulate, output, true)) {
+				return false;
+			}
+		}
+		stage.writeCount = static_cast<uint16_t>(program.writes.size() - stage.firstWrite);
+
+		program.stages.push_back(stage);
+		return true;
+	}
+};
+
+} // namespace
+
+bool CompileEffectGraph(const IniFile& ini, EffectProgram& program, std::string& error) {
+	return CompileEffectSection(ini, "Effects", DefaultEffectProgram(), program, error);
+}
+
+bool CompileEffectSection(const IniFile& ini, const char* section, const EffectProgram& fallback, EffectProgram& program, std::string& error) {
+	EffectProgram compiled;
+	std::vector<std::string> order = Split(ini.getString(section, "Order", ""), ',');
+
+	if (order.empty()) {
+		compiled = fallback;
+	}
+	else {
+		EffectCompiler compiler(ini, compiled);
+		if (!compiler.compile(order)) {
+			error = compiler.error;
+			return false;
+		}
+	}
+
+	std::string motorLimit = ini.getString(section, "MotorLimit", "");
+	std::string triggerLimit = ini.getString(section, "TriggerLimit", "");
+	compiled.MotorLimit = fallback.MotorLimit;
+	compiled.TriggerLimit = fallback.TriggerLimit;
+	if ((!motorLimit.empty() && !ParseNumber(motorLimit, compiled.MotorLimit)) ||
+		(!triggerLimit.empty() && !ParseNumber(triggerLimit, compiled.TriggerLimit))) {
+		error = std::string("[") + section + "] bad MotorLimit or TriggerLimit";
+		return false;
+	}
+
+	program = std::move(compiled);
+	return true;
+}
+
+static EffectProgram CompileBuiltInEffects(const char* text) {
+	IniFile ini;
+	ini.parse(text);
+
+	EffectProgram compiled;
+	EffectCompiler compiler(ini, compiled);
+	compiler.compile(Split(ini.getString("Effects", "Order", ""), ','));
+	return compiled;
+}
+
+const EffectProgram& DefaultEffectProgram() {
+	static const EffectProgram program = CompileBuiltInEffects(kDefaultEffects);
+	return program;
+}
+
+const EffectProgram& ClassicEffectProgram() {
+	static const EffectProgram program = CompileBuiltInEffects(kClassicEffects);
+	return program;
+}
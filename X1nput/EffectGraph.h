@@ -0,0 +1,195 @@
+#pragma once
+
+#include "IniFile.h"
+#include "TelemetryData.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+	Haptic effects declared in X1nput.ini.
+
+	Every effect has an [Effect.Name] section. It may compute a value from one
+	signal through a curve, is gated by a list of conditions, and writes to the
+	four outputs with short linear expressions:
+
+		[Effect.Bump]
+		Source=Impact
+		Curve=Linear
+		Points=0:0, 1:0.7
+		When=LeftTrigger<0.1
+		LeftMotor+=0.7*ImpactLeft
+		RightMotor+=0.7*ImpactRight
+
+	Effects run in the order listed in [Effects] Order. Later effects can read the
+	value of earlier ones by name (0 while the effect is gated off), and an
+	assignment without '+' replaces what earlier effects wrote.
+
+	CompileEffectGraph() turns the sections into flat arrays of stages and
+	fixed-size weighted sums once, when the file is loaded, and drops effect
+	values nothing reads. It also lists the telemetry signals the program reads,
+	so only those are copied into registers. On x86-64 those arrays are then
+	lowered to straight-line machine code (EffectNative.h): the telemetry loads,
+	every condition a compare and branch, every write its own loads, multiplies
+	and adds, with the register numbers, field offsets and constants built in.
+	That is what runs per frame, and it costs no more than the effects did
+	hand-written. Elsewhere, or when the OS does not allow executable memory,
+	interpret() runs the arrays in a single pass: no name lookups, no allocation
+	and no dispatch on operation type.
+*/
+
+// Registers every program starts with. Names are the ones used in X1nput.ini.
+enum EffectSignal : uint8_t {
+	// Telemetry
+	EffectSignal_Speed,
+	EffectSignal_CurrentEngineRpm,
+	EffectSignal_NRPM,
+	EffectSignal_Slip,
+	EffectSignal_Acceleration,
+	EffectSignal_AccelerationX,
+	EffectSignal_AccelerationY,
+	EffectSignal_AccelerationZ,
+	EffectSignal_Gear,
+	EffectSignal_TireSlipRatioFL,
+	EffectSignal_TireSlipRatioFR,
+	EffectSignal_TireSlipRatioRL,
+	EffectSignal_TireSlipRatioRR,
+	EffectSignal_TireSlipAngleFL,
+	EffectSignal_TireSlipAngleFR,
+	EffectSignal_TireSlipAngleRL,
+	EffectSignal_TireSlipAngleRR,
+	EffectSignal_TireCombinedSlipFL,
+	EffectSignal_TireCombinedSlipFR,
+	EffectSignal_TireCombinedSlipRL,
+	EffectSignal_TireCombinedSlipRR,
+	EffectSignal_Lockup,         // Wheels locking, 0..1 per axle and the worse one, see WheelSlip.h
+	EffectSignal_LockupFront,
+	EffectSignal_LockupRear,
+	EffectSignal_Wheelspin,      // Wheels spinning, same
+	EffectSignal_WheelspinFront,
+	EffectSignal_WheelspinRear,
+	EffectSignal_Impact,         // Collision impulse envelope, 0..1, see CollisionDetector.h
+	EffectSignal_ImpactLeft,     // Impact biased towards the side that was hit
+	EffectSignal_ImpactRight,
+
+	// Controller and game
+	EffectSignal_LeftTrigger,    // Trigger positions, 0..1
+	EffectSignal_RightTrigger,
+	EffectSignal_LeftRumble,     // Rumble requested by the game, 0..1
+	EffectSignal_RightRumble,
+	EffectSignal_GameLeftMotor,  // The game's rumble after the [Motors] strength
+	EffectSignal_GameRightMotor,
+
+	// Outputs, start out as the game's rumble
+	EffectSignal_LeftMotor,
+	EffectSignal_RightMotor,
+	EffectSignal_LeftImpulse,    // Trigger motors
+	EffectSignal_RightImpulse,
+
+	EffectSignal_One,            // Constant 1, used for constant terms
+
+	EffectSignal_Count
+};
+
+// The TelemetryData field of each signal below EffectSignal_LeftTrigger; null for Gear, which is a byte.
+float TelemetryData::* EffectSignalField(uint8_t signal);
+
+constexpr size_t kMaxEffectRegisters = 64;
+constexpr uint8_t kNoEffectRegister = 0xFF;
+
+enum class EffectCurve : uint8_t {
+	None,    // value = r[source]
+	Step,    // value = y of the last point whose x r[source] exceeds (or reaches, for a point written >=x:y), else 0
+	Linear,  // value = r[source] interpolated through the points, clamped to the end values
+	Exp,     // value = scale * exp(rate * r[source] + offset)
+};
+
+constexpr size_t kStageConditions = 2;  // Conditions per stage; longer lists are split over several stages
+constexpr size_t kWriteTerms = 4;       // Signal terms per EffectWrite; longer sums are split over several writes
+constexpr size_t kCurveLanes = 4;       // Step and Linear points are padded to a multiple of this
+
+// Passes when above <= r[source] <= below. < and > are turned into <= and >= with the next representable threshold;
+// an open side is an infinity, which only NaN fails.
+struct EffectCondition {
+	uint8_t source;
+	double above;
+	double below;
+};
+
+// r[target] = (accumulate ? r[target] : 0) + sum of weights[i] * r[sources[i]] + constant, when the gate is open.
+// The sum is taken in term order, then the constant is added.
+struct EffectWrite {
+	uint8_t target;
+	bool accumulate;
+	uint8_t termCount;
+	uint8_t sources[kWriteTerms];  // Terms past termCount read EffectSignal_One with weight 0
+	double weights[kWriteTerms];
+	double constant;        // The number terms, added up at compile time
+};
+
+struct EffectStage {
+	EffectCondition gate[kStageConditions]; // Unused ones read EffectSignal_One and always pass
+	uint16_t firstWrite;
+	uint16_t writeCount;
+
+	uint8_t value;           // Register for the effect's value, kNoEffectRegister if nothing reads it
+	EffectCurve curve;
+	uint8_t source;
+	uint8_t plus;            // Added to the curve output, kNoEffectRegister for none
+	uint16_t firstPoint;     // Step/Linear: (x, y) pairs in EffectProgram::points
+	uint16_t pointCount;
+	double scale;            // Exp
+	double rate;
+	double offset;
+};
+
+struct EffectProgram {
+	std::vector<EffectStage> stages;
+	std::vector<EffectWrite> writes;
+	std::vector<double> points;
+	std::vector<uint8_t> telemetrySignals; // Signals below EffectSignal_LeftTrigger the program reads, Gear excepted
+	uint8_t registerCount = EffectSignal_Count;
+	double MotorLimit = 0.85;       // Applied to the outputs after every effect has run
+	double TriggerLimit = 0.7;
+
+	// The program as machine code, loadTelemetry() included; null where it could not be made.
+	void (*native)(double* registers, const TelemetryData* telemetry) = nullptr;
+	std::shared_ptr<const void> nativeCode;  // Owns native's memory, shared by the copies of the program
+
+	// registers holds kMaxEffectRegisters values. The caller fills every signal from EffectSignal_LeftTrigger to
+	// EffectSignal_RightImpulse; Gear and the telemetrySignals come from telemetry, the other telemetry registers
+	// are never read.
+	void run(double* registers, const TelemetryData& telemetry) const {
+		if (native != nullptr) {
+			native(registers, &telemetry);
+		}
+		else {
+			loadTelemetry(registers, telemetry);
+			interpret(registers);
+		}
+	}
+
+	// The same from the arrays, bit for bit.
+	void loadTelemetry(double* registers, const TelemetryData& telemetry) const;
+	void interpret(double* registers) const;
+};
+
+// A Step or Linear curve at x: pointCount (x, y) pairs, padded to kCurveLanes as in EffectProgram::points.
+double EvaluateEffectPoints(EffectCurve curve, const double* points, unsigned pointCount, double x);
+
+// Compiles [Effects] and the [Effect.*] sections. Returns false and describes the problem in error
+// if the file has an invalid effect; program is left untouched then.
+bool CompileEffectGraph(const IniFile& ini, EffectProgram& program, std::string& error);
+
+// Same for another section with Order, MotorLimit and TriggerLimit keys (a [Preset.*], see EffectPresets.h). Missing
+// keys are taken from fallback, so a section without Order runs fallback's effects.
+bool CompileEffectSection(const IniFile& ini, const char* section, const EffectProgram& fallback, EffectProgram& program, std::string& error);
+
+// The effects X1nput shipped with, used when X1nput.ini has no [Effects] section.
+const EffectProgram& DefaultEffectProgram();
+
+// The hand-written effects X1nput had before the effect graph, thresholds included: bumps from the raw acceleration,
+// ABS from Slip > 1, no traction effect. Matches ComputeHapticsReference() (HapticsEngine.h) for every input.
+const EffectProgram& ClassicEffectProgram();
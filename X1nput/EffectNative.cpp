@@ -0,0 +1,887 @@
+#include "EffectNative.h"
+#include "FastMath.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define X1NPUT_EFFECT_NATIVE 1
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+#ifdef X1NPUT_EFFECT_NATIVE
+
+namespace {
+
+// Called from the generated code for the arguments FastExp() hands to std::exp.
+double NativeExp(double x) {
+	return FastExp(x);
+}
+
+// The SSE2 instructions the lowering uses: mandatory prefix and opcode after 0F.
+struct SseOp {
+	uint8_t prefix;
+	uint8_t opcode;
+};
+
+const SseOp kMovsdLoad = { 0xF2, 0x10 };
+const SseOp kMovsdStore = { 0xF2, 0x11 };
+const SseOp kUnpcklpd = { 0x66, 0x14 };
+const SseOp kMovapd = { 0x66, 0x28 };
+const SseOp kCvtsi2sd = { 0xF2, 0x2A };
+const SseOp kUcomisd = { 0x66, 0x2E };
+const SseOp kXorpd = { 0x66, 0x57 };
+const SseOp kAddsd = { 0xF2, 0x58 };
+const SseOp kMulsd = { 0xF2, 0x59 };
+const SseOp kCvtsd2ss = { 0xF2, 0x5A };
+const SseOp kCvtss2sd = { 0xF3, 0x5A };
+const SseOp kPshufd = { 0x66, 0x70 };
+const SseOp kSubsd = { 0xF2, 0x5C };
+const SseOp kDivsd = { 0xF2, 0x5E };
+const SseOp kCmppd = { 0x66, 0xC2 };
+const SseOp kPaddq = { 0x66, 0xD4 };
+
+// Jcc rel32 after 0F, for the flags ucomisd leaves: unordered sets ZF, PF and CF
+const uint8_t kJb = 0x82;   // below or unordered
+const uint8_t kJa = 0x87;   // above
+const uint8_t kJbe = 0x86;  // below, equal or unordered
+const uint8_t kJp = 0x8A;   // unordered
+
+// Predicate of cmppd
+const uint8_t kLessThan = 1;
+
+// Order of pshufd: the low double in both halves
+const uint8_t kBothLow = 0x44;
+
+// xmm0 to xmm4 are scratch; the others are handed out to registers by Lowering::allocate().
+const uint8_t kFirstCacheXmm = 5;
+const uint8_t kLastCacheXmm = 15;
+
+double Bits(uint64_t bits) {
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+bool IsNegativeZero(double value) {
+	return value == 0.0 && std::signbit(value);
+}
+
+// The second operand of an SSE instruction.
+struct Operand {
+	enum Kind : uint8_t {
+		Xmm,        // xmm[value]
+		Register,   // r[value]; the registers pointer is in rbx on Windows, rdi elsewhere
+		Constant,   // value, from the pool behind the code
+		Pair,       // value and high, 16-byte aligned in the pool, for the packed instructions
+		Entry,      // [rcx + value], the table entry Assembler::selectEntry() picked
+		Scaled,     // [rcx + rax * 8], the double Assembler::selectTable() and eax pick
+		Telemetry,  // the TelemetryData field at byte offset value; the pointer is the second argument
+		Eax,        // cvtsi2sd only
+	};
+	Kind kind;
+	double value;
+	double high;
+};
+
+Operand Xmm(uint8_t xmm) { return Operand{ Operand::Xmm, static_cast<double>(xmm), 0 }; }
+Operand Memory(uint8_t index) { return Operand{ Operand::Register, static_cast<double>(index), 0 }; }
+Operand Constant(double value) { return Operand{ Operand::Constant, value, 0 }; }
+Operand Pair(double low, double high) { return Operand{ Operand::Pair, low, high }; }
+Operand Entry(uint8_t offset) { return Operand{ Operand::Entry, static_cast<double>(offset), 0 }; }
+Operand Scaled() { return Operand{ Operand::Scaled, 0, 0 }; }
+Operand Telemetry(size_t offset) { return Operand{ Operand::Telemetry, static_cast<double>(offset), 0 }; }
+Operand Eax() { return Operand{ Operand::Eax, 0, 0 }; }
+
+class Assembler {
+public:
+	// op xmm, operand, with the predicate of a compare or the order of a shuffle after it
+	void sse(SseOp op, uint8_t xmm, Operand operand, int immediate = -1) {
+		const unsigned rm = operand.kind == Operand::Xmm ? static_cast<unsigned>(operand.value) : 0;
+		const uint8_t reg = static_cast<uint8_t>((xmm & 7) << 3);
+		const size_t fixupCount = fixups.size();
+		emit({ op.prefix });
+		if (xmm >= 8 || rm >= 8) {
+			emit({ static_cast<uint8_t>(0x40 | (xmm >= 8) << 2 | (rm >= 8)) });  // REX.R, REX.B
+		}
+		emit({ 0x0F, op.opcode });
+		switch (operand.kind) {
+		case Operand::Xmm:
+			emit({ static_cast<uint8_t>(0xC0 | reg | (rm & 7)) });
+			break;
+		case Operand::Register:
+			emit({ static_cast<uint8_t>(kRegistersBase | reg) });
+			emit32(static_cast<uint32_t>(operand.value) * sizeof(double));
+			break;
+		case Operand::Constant:
+			emit({ static_cast<uint8_t>(0x05 | reg) });  // [rip + disp32]
+			fixup(constant(operand.value));
+			break;
+		case Operand::Pair:
+			emit({ static_cast<uint8_t>(0x05 | reg) });
+			fixup(pair(operand.value, operand.high));
+			break;
+		case Operand::Entry:
+			emit({ static_cast<uint8_t>(0x41 | reg), static_cast<uint8_t>(operand.value) });  // [rcx + disp8]
+			break;
+		case Operand::Scaled:
+			emit({ static_cast<uint8_t>(0x04 | reg), 0xC1 });  // [rcx + rax * 8]
+			break;
+		case Operand::Telemetry:
+			emit({ static_cast<uint8_t>(kTelemetryBase | reg) });
+			emit32(static_cast<uint32_t>(operand.value));
+			break;
+		case Operand::Eax:
+			emit({ static_cast<uint8_t>(0xC0 | reg) });
+			break;
+		}
+		if (immediate >= 0) {
+			emit({ static_cast<uint8_t>(immediate) });
+			if (fixups.size() > fixupCount) {
+				fixups.back().tail = 1;
+			}
+		}
+	}
+
+	// Windows: the registers pointer goes to rbx, which survives calls, xmm6 to xmm15 below lastXmm are saved as the
+	// convention asks, and the frame has the home space and keeps rsp 16-byte aligned. System V preserves no xmm
+	// register, so the function needs no frame: the pointer stays in rdi and is pushed only around call().
+	void prologue(uint8_t lastXmm) {
+#ifdef _WIN32
+		emit({ 0x53 });                                // push rbx
+		emit({ 0x48, 0x89, 0xCB });                    // mov rbx, rcx
+		savedXmm = lastXmm >= 6 ? lastXmm - 5 : 0;
+		emit({ 0x48, 0x81, 0xEC });                    // sub rsp, imm32
+		emit32(frameSize());
+		for (uint8_t i = 0; i < savedXmm; ++i) {
+			frameSlot(0x11, static_cast<uint8_t>(6 + i), i);
+		}
+#else
+		(void)lastXmm;
+#endif
+	}
+
+	void epilogue() {
+#ifdef _WIN32
+		for (uint8_t i = 0; i < savedXmm; ++i) {
+			frameSlot(0x10, static_cast<uint8_t>(6 + i), i);
+		}
+		emit({ 0x48, 0x81, 0xC4 });                    // add rsp, imm32
+		emit32(frameSize());
+		emit({ 0x5B });                                // pop rbx
+#endif
+		emit({ 0xC3 });                                // ret
+	}
+
+	// eax = the number of points below xmm0, as EvaluateEffectPoints() counts them; clobbers edx.
+	void countBelow(const double* point, unsigned pointCount) {
+		emit({ 0x31, 0xC0 });                          // xor eax, eax
+		for (unsigned i = 0; i < pointCount; ++i) {
+			sse(kUcomisd, 0, Constant(point[2 * i]));
+			emit({ 0x0F, 0x97, 0xC2 });                // seta dl
+			emit({ 0x0F, 0xB6, 0xD2 });                // movzx edx, dl
+			emit({ 0x01, 0xD0 });                      // add eax, edx
+		}
+	}
+
+	// eax = a bit for each of the first four points x is above, compared two at a time, with x in both halves of
+	// xmm1; clobbers xmm2, xmm3 and edx.
+	void maskBelow(const double* point) {
+		sse(kMovapd, 2, Pair(point[0], point[2]));
+		sse(kCmppd, 2, Xmm(1), kLessThan);             // point < x
+		sse(kMovapd, 3, Pair(point[4], point[6]));
+		sse(kCmppd, 3, Xmm(1), kLessThan);
+		emit({ 0x66, 0x0F, 0x50, 0xC2 });              // movmskpd eax, xmm2
+		emit({ 0x66, 0x0F, 0x50, 0xD3 });              // movmskpd edx, xmm3
+		emit({ 0x8D, 0x04, 0x90 });                    // lea eax, [rax + rdx * 4]
+	}
+
+	// rcx = entries, for Scaled().
+	void selectTable(const std::vector<double>& entries) {
+		size_t slot = pool.size();
+		pool.insert(pool.end(), entries.begin(), entries.end());
+		emit({ 0x48, 0x8D, 0x0D });                    // lea rcx, [rip + disp32]
+		fixup(slot);
+	}
+
+	// rcx = &entries[eax], each entry 1 << shift bytes.
+	void selectEntry(const std::vector<double>& entries, uint8_t shift) {
+		selectTable(entries);
+		emit({ 0xC1, 0xE0, shift });                   // shl eax, shift
+		emit({ 0x48, 0x01, 0xC1 });                    // add rcx, rax
+	}
+
+	// eax = the byte at telemetry + offset
+	void telemetryByte(size_t offset) {
+		emit({ 0x0F, 0xB6, kTelemetryBase });          // movzx eax, byte
+		emit32(static_cast<uint32_t>(offset));
+	}
+
+	// xmm = 2^n, from the n FastExp() leaves in the low bits of shifted, in xmm.
+	void exponentFromShifted(uint8_t xmm) {
+		sse(kPaddq, xmm, Pair(Bits(1023), Bits(1023)));
+		if (xmm >= 8) {
+			emit({ 0x66, 0x41, 0x0F, 0x73, static_cast<uint8_t>(0xF0 | (xmm & 7)), 0x34 });  // psllq xmm, 52
+		}
+		else {
+			emit({ 0x66, 0x0F, 0x73, static_cast<uint8_t>(0xF0 | xmm), 0x34 });
+		}
+	}
+
+	// Calls double function(double x) with x in xmm0. Every xmm register may change.
+	void call(const void* function) {
+#ifndef _WIN32
+		emit({ 0x57 });                                // push rdi, which also aligns rsp to 16
+#endif
+		emit({ 0x48, 0xB8 });                          // mov rax, imm64
+		uint64_t address = reinterpret_cast<uintptr_t>(function);
+		for (int i = 0; i < 8; ++i) {
+			code.push_back(static_cast<uint8_t>(address >> 8 * i));
+		}
+		emit({ 0xFF, 0xD0 });                          // call rax
+#ifndef _WIN32
+		emit({ 0x5F });                                // pop rdi
+#endif
+	}
+
+	// Returns the jump to pass to bind() once its target is known.
+	size_t jump(uint8_t condition) {
+		emit({ 0x0F, condition });
+		emit32(0);
+		return code.size() - 4;
+	}
+
+	size_t jump() {
+		emit({ 0xE9 });
+		emit32(0);
+		return code.size() - 4;
+	}
+
+	void bind(size_t jump) {
+		uint32_t offset = static_cast<uint32_t>(code.size() - (jump + 4));
+		std::memcpy(&code[jump], &offset, sizeof(offset));
+	}
+
+	// The code with the pool behind it, 16-byte aligned, every rip-relative operand pointing into the pool.
+	std::vector<uint8_t> link() const {
+		std::vector<uint8_t> image(code);
+		image.resize((image.size() + 15) & ~size_t(15));
+		const size_t poolStart = image.size();
+		image.resize(poolStart + pool.size() * sizeof(double));
+		if (!pool.empty()) {
+			std::memcpy(&image[poolStart], pool.data(), pool.size() * sizeof(double));
+		}
+		for (const Fixup& f : fixups) {
+			uint32_t offset = static_cast<uint32_t>(poolStart + f.slot * sizeof(double) - (f.at + 4 + f.tail));
+			std::memcpy(&image[f.at], &offset, sizeof(offset));
+		}
+		return image;
+	}
+
+private:
+#ifdef _WIN32
+	static constexpr uint8_t kRegistersBase = 0x83;  // [rbx + disp32]
+	static constexpr uint8_t kTelemetryBase = 0x82;  // [rdx + disp32]
+#else
+	static constexpr uint8_t kRegistersBase = 0x87;  // [rdi + disp32]
+	static constexpr uint8_t kTelemetryBase = 0x86;  // [rsi + disp32]
+#endif
+
+	struct Fixup {
+		size_t at;    // disp32, followed by tail bytes to the end of the instruction
+		size_t slot;
+		size_t tail;
+	};
+
+	std::vector<uint8_t> code;
+	std::vector<double> pool;
+	std::vector<Fixup> fixups;
+
+#ifdef _WIN32
+	uint8_t savedXmm = 0;
+
+	// The home space, then the saved xmm registers
+	uint32_t frameSize() const {
+		return 32 + 16u * savedXmm;
+	}
+
+	// movups [rsp + 32 + 16 * slot], xmm (opcode 11) or back (10)
+	void frameSlot(uint8_t opcode, uint8_t xmm, uint8_t slot) {
+		if (xmm >= 8) {
+			emit({ 0x44 });
+		}
+		emit({ 0x0F, opcode, static_cast<uint8_t>(0x84 | (xmm & 7) << 3), 0x24 });
+		emit32(32 + 16u * slot);
+	}
+#endif
+
+	void emit(std::initializer_list<uint8_t> bytes) {
+		code.insert(code.end(), bytes);
+	}
+
+	void emit32(uint32_t value) {
+		for (int i = 0; i < 4; ++i) {
+			code.push_back(static_cast<uint8_t>(value >> 8 * i));
+		}
+	}
+
+	void fixup(size_t slot) {
+		fixups.push_back(Fixup{ code.size(), slot, 0 });
+		emit32(0);
+	}
+
+	size_t constant(double value) {
+		for (size_t slot = 0; slot < pool.size(); ++slot) {
+			if (std::memcmp(&pool[slot], &value, sizeof(value)) == 0) {
+				return slot;
+			}
+		}
+		pool.push_back(value);
+		return pool.size() - 1;
+	}
+
+	// Pairs start at an even slot, 16 bytes into the 16-byte aligned pool.
+	size_t pair(double low, double high) {
+		const double wanted[2] = { low, high };
+		for (size_t slot = 0; slot + 1 < pool.size(); slot += 2) {
+			if (std::memcmp(&pool[slot], wanted, sizeof(wanted)) == 0) {
+				return slot;
+			}
+		}
+		if (pool.size() % 2 != 0) {
+			pool.push_back(0.0);
+		}
+		pool.insert(pool.end(), { low, high });
+		return pool.size() - 2;
+	}
+};
+
+// The same operations as EffectProgram::loadTelemetry() and interpret(), in the same order, with what they look up
+// per frame filled in.
+class Lowering {
+public:
+	Lowering(const EffectProgram& program, Assembler& a) : program(program), a(a) {}
+
+	void lower() {
+		allocate();
+		a.prologue(static_cast<uint8_t>(nextXmm - 1));
+
+		// A cached register stays in its xmm register from here to the end, on every path, so the branches need no
+		// bookkeeping.
+		static const TelemetryData probe = {};
+		const char* const base = reinterpret_cast<const char*>(&probe);
+		for (uint8_t signal : program.telemetrySignals) {
+			const size_t offset = reinterpret_cast<const char*>(&(probe.*EffectSignalField(signal))) - base;
+			a.sse(kCvtss2sd, xmmFor(signal), Telemetry(offset));
+			finish(signal);
+		}
+		if (read[EffectSignal_Gear]) {
+			a.telemetryByte(reinterpret_cast<const char*>(&probe.Gear) - base);
+			a.sse(kCvtsi2sd, xmmFor(EffectSignal_Gear), Eax());
+			finish(EffectSignal_Gear);
+		}
+		for (unsigned index = 0; index < kMaxEffectRegisters; ++index) {
+			if (cache[index] != 0 && initial[index]) {
+				a.sse(kMovsdLoad, cache[index], Memory(static_cast<uint8_t>(index)));
+			}
+		}
+
+		for (const EffectStage* stage : early) {
+			const uint8_t curve = earlyCurve[stage - program.stages.data()];
+			store(curve, lowerCurve(*stage, cache[curve]));
+		}
+		for (const EffectStage& stage : program.stages) {
+			lowerStage(stage);
+		}
+
+		for (unsigned index = 0; index < kMaxEffectRegisters; ++index) {
+			if (cache[index] != 0 && written[index]) {
+				a.sse(kMovsdStore, cache[index], Memory(static_cast<uint8_t>(index)));
+			}
+		}
+		a.epilogue();
+	}
+
+private:
+	const EffectProgram& program;
+	Assembler& a;
+	bool read[kMaxEffectRegisters] = {};
+	bool initial[kMaxEffectRegisters] = {};    // Keeps or reads the caller's value: read before it is set, or set by a gate
+	bool written[kMaxEffectRegisters] = {};
+	uint8_t cache[kMaxEffectRegisters] = {};   // xmm register of each register, 0 for memory
+	uint8_t nextXmm = kFirstCacheXmm;
+	std::vector<const EffectStage*> early;
+	std::vector<uint8_t> earlyCurve = std::vector<uint8_t>(program.stages.size(), kNoEffectRegister);  // Its register
+
+	// Exp and Linear curves whose source no earlier effect writes are worked out first, before any branch: a
+	// mispredicted gate then does not throw away the long FastExp or divide chain with it. A Step is a few
+	// instructions and stays behind its gate. Each early curve gets a spare register past registerCount.
+	// Those, the effect values, the telemetry, the outputs and then the inputs get xmm registers while there are
+	// any left. Only what the program writes goes back to r[], and only what it reads before it sets it comes from
+	// there.
+	void allocate() {
+		bool set[kMaxEffectRegisters] = {};
+		for (uint8_t signal : program.telemetrySignals) {
+			set[signal] = true;
+		}
+		set[EffectSignal_Gear] = true;
+		auto use = [&](uint8_t index) {
+			read[index] = true;
+			initial[index] |= !set[index] && index != EffectSignal_One;
+		};
+
+		uint8_t spare = program.registerCount;
+		for (const EffectStage& stage : program.stages) {
+			for (const EffectCondition& c : stage.gate) {
+				use(c.source);
+			}
+			if (stage.value != kNoEffectRegister) {
+				const bool chain = stage.curve == EffectCurve::Exp || stage.curve == EffectCurve::Linear;
+				if (chain && !written[stage.source] && spare < kMaxEffectRegisters) {
+					early.push_back(&stage);
+					earlyCurve[&stage - program.stages.data()] = spare++;
+				}
+				use(stage.source);
+				if (stage.plus != kNoEffectRegister) {
+					use(stage.plus);
+				}
+				written[stage.value] = set[stage.value] = true;
+			}
+			for (const EffectWrite* w = program.writes.data() + stage.firstWrite, *end = w + stage.writeCount; w != end; ++w) {
+				for (unsigned i = 0; i < w->termCount; ++i) {
+					use(w->sources[i]);
+				}
+				if (w->accumulate) {
+					use(w->target);
+				}
+				written[w->target] = initial[w->target] = true;
+			}
+		}
+
+		for (const EffectStage* stage : early) {
+			assign(earlyCurve[stage - program.stages.data()]);
+		}
+		for (const EffectStage& stage : program.stages) {
+			if (stage.value != kNoEffectRegister) {
+				assign(stage.value);
+			}
+		}
+		for (uint8_t signal : program.telemetrySignals) {
+			assign(signal);
+		}
+		if (read[EffectSignal_Gear]) {
+			assign(EffectSignal_Gear);
+		}
+		for (unsigned index = 0; index < kMaxEffectRegisters; ++index) {
+			if (written[index]) {
+				assign(static_cast<uint8_t>(index));
+			}
+		}
+		for (unsigned index = 0; index < kMaxEffectRegisters; ++index) {
+			if (read[index]) {
+				assign(static_cast<uint8_t>(index));
+			}
+		}
+	}
+
+	void assign(uint8_t index) {
+		if (cache[index] == 0 && index != EffectSignal_One && nextXmm <= kLastCacheXmm) {
+			cache[index] = nextXmm++;
+		}
+	}
+
+	// One is the constant it always holds.
+	Operand operand(uint8_t index) const {
+		if (index == EffectSignal_One) {
+			return Constant(1.0);
+		}
+		return cache[index] != 0 ? Xmm(cache[index]) : Memory(index);
+	}
+
+	// Where to compute a value for index: its own register, or xmm0 and then finish().
+	uint8_t xmmFor(uint8_t index) const {
+		return cache[index];
+	}
+
+	void finish(uint8_t index) {
+		if (cache[index] == 0) {
+			a.sse(kMovsdStore, 0, Memory(index));
+		}
+	}
+
+	void load(uint8_t xmm, Operand from) {
+		if (from.kind != Operand::Xmm) {
+			a.sse(kMovsdLoad, xmm, from);
+		}
+		else if (from.value != xmm) {
+			a.sse(kMovapd, xmm, from);
+		}
+	}
+
+	void store(uint8_t index, uint8_t xmm) {
+		if (cache[index] == 0) {
+			a.sse(kMovsdStore, xmm, Memory(index));
+		}
+		else if (cache[index] != xmm) {
+			a.sse(kMovapd, cache[index], Xmm(xmm));
+		}
+	}
+
+	// Around calls every cached register is kept in r[], the spare ones included.
+	void spill(SseOp op) {
+		for (unsigned index = 0; index < kMaxEffectRegisters; ++index) {
+			if (cache[index] != 0) {
+				a.sse(op, cache[index], Memory(static_cast<uint8_t>(index)));
+			}
+		}
+	}
+
+	void lowerStage(const EffectStage& stage) {
+		// Only the bounds a condition has are compared: an open side is an infinity, which only NaN fails, and NaN
+		// fails the other bound too, or the unordered check when there is neither. Gear is never NaN, so its upper
+		// bound alone is one compare.
+		const double infinity = std::numeric_limits<double>::infinity();
+		std::vector<size_t> closed;
+		bool neverOpens = false;
+
+		// A value in an xmm register is cleared before a gate, which then jumps straight past the stage.
+		bool gated = false;
+		for (const EffectCondition& c : stage.gate) {
+			gated |= c.source != EffectSignal_One || !(1.0 >= c.above && 1.0 <= c.below);
+		}
+		const bool cleared = gated && stage.value != kNoEffectRegister && cache[stage.value] != 0;
+		if (cleared) {
+			a.sse(kXorpd, cache[stage.value], Xmm(cache[stage.value]));
+		}
+
+		for (const EffectCondition& c : stage.gate) {
+			if (c.source == EffectSignal_One) {
+				// Decided now: One is 1.
+				neverOpens |= !(1.0 >= c.above && 1.0 <= c.below);
+				continue;
+			}
+			const uint8_t x = cache[c.source];
+			const bool lower = c.above != -infinity;
+			const bool upper = c.below != infinity;
+			const bool ordered = c.source == EffectSignal_Gear;  // From a byte, never NaN
+			if (x == 0 && (lower || !upper || ordered)) {
+				a.sse(kMovsdLoad, 0, Memory(c.source));
+			}
+			if (lower) {
+				a.sse(kUcomisd, x, Constant(c.above));  // x >= above
+				closed.push_back(a.jump(kJb));
+			}
+			if (upper && (lower || ordered)) {
+				a.sse(kUcomisd, x, Constant(c.below));  // x <= below, not NaN
+				closed.push_back(a.jump(kJa));
+			}
+			else if (upper) {
+				a.sse(kMovsdLoad, 1, Constant(c.below));
+				a.sse(kUcomisd, 1, operand(c.source));   // below >= x
+				closed.push_back(a.jump(kJb));
+			}
+			else if (!lower) {
+				a.sse(kUcomisd, x, Xmm(x));
+				closed.push_back(a.jump(kJp));
+			}
+		}
+		if (neverOpens) {
+			closed.push_back(a.jump());
+		}
+
+		if (stage.value != kNoEffectRegister) {
+			const uint8_t curve = earlyCurve[&stage - program.stages.data()];
+			Operand value = operand(stage.source);
+			if (curve != kNoEffectRegister) {
+				value = operand(curve);
+			}
+			else if (stage.curve != EffectCurve::None) {
+				value = Xmm(lowerCurve(stage, 0));
+			}
+			if (stage.plus != kNoEffectRegister) {
+				// An early curve is read only here, so its register can take the sum.
+				const uint8_t sum = value.kind == Operand::Xmm && curve != kNoEffectRegister ? cache[curve] : 0;
+				load(sum, value);
+				a.sse(kAddsd, sum, operand(stage.plus));
+				value = Xmm(sum);
+			}
+			a.sse(kCvtsd2ss, 0, value);
+			a.sse(kCvtss2sd, xmmFor(stage.value), Xmm(0));
+			finish(stage.value);
+		}
+
+		for (const EffectWrite* w = program.writes.data() + stage.firstWrite, *end = w + stage.writeCount; w != end; ++w) {
+			lowerWrite(*w);
+		}
+
+		if (!closed.empty()) {
+			const bool zeroes = stage.value != kNoEffectRegister && !cleared;
+			size_t opened = zeroes ? a.jump() : 0;
+			for (size_t jump : closed) {
+				a.bind(jump);
+			}
+			if (zeroes) {
+				a.sse(kXorpd, 0, Xmm(0));
+				finish(stage.value);
+				a.bind(opened);
+			}
+		}
+	}
+
+	// sum = the terms and the constant; the unused terms and a constant of -0 add nothing and are left out.
+	void lowerSum(const EffectWrite& w, uint8_t sum) {
+		if (w.termCount == 0) {
+			a.sse(kMovsdLoad, sum, Constant(w.constant));
+			return;
+		}
+		load(sum, operand(w.sources[0]));
+		if (w.weights[0] != 1.0) {
+			a.sse(kMulsd, sum, Constant(w.weights[0]));
+		}
+		for (unsigned i = 1; i < w.termCount; ++i) {
+			if (w.weights[i] == 1.0) {
+				a.sse(kAddsd, sum, operand(w.sources[i]));
+				continue;
+			}
+			load(1, operand(w.sources[i]));
+			a.sse(kMulsd, 1, Constant(w.weights[i]));
+			a.sse(kAddsd, sum, Xmm(1));
+		}
+		if (!IsNegativeZero(w.constant)) {
+			a.sse(kAddsd, sum, Constant(w.constant));
+		}
+	}
+
+	// The sum goes straight to a cached target when it replaces it and reads nothing of it.
+	void lowerWrite(const EffectWrite& w) {
+		const uint8_t target = cache[w.target];
+		bool readsTarget = false;
+		for (unsigned i = 0; i < w.termCount; ++i) {
+			readsTarget |= w.sources[i] == w.target;
+		}
+		const uint8_t sum = target != 0 && !w.accumulate && !readsTarget ? target : 0;
+
+		// += of one signal or just a number, to a cached target: one add.
+		if (target != 0 && w.accumulate &&
+			(w.termCount == 0 || (w.termCount == 1 && w.weights[0] == 1.0 && IsNegativeZero(w.constant)))) {
+			a.sse(kAddsd, target, w.termCount == 0 ? Constant(w.constant) : operand(w.sources[0]));
+			return;
+		}
+
+		lowerSum(w, sum);
+		if (!w.accumulate) {
+			store(w.target, sum);
+		}
+		else if (target != 0) {
+			a.sse(kAddsd, target, Xmm(sum));
+		}
+		else {
+			a.sse(kMovsdLoad, 1, Memory(w.target));
+			a.sse(kAddsd, 1, Xmm(sum));
+			a.sse(kMovsdStore, 1, Memory(w.target));
+		}
+	}
+
+	// The stage's curve at its source, in the register returned; a Step and an Exp go to xmm when that is not 0.
+	uint8_t lowerCurve(const EffectStage& stage, uint8_t xmm) {
+		const double* point = program.points.data() + 2 * stage.firstPoint;
+		if (stage.curve == EffectCurve::Step) {
+			std::vector<double> steps;
+			for (unsigned below : lowerCount(point, stage.pointCount, operand(stage.source))) {
+				steps.push_back(below > 0 ? point[2 * below - 1] : 0.0);
+			}
+			a.selectTable(steps);
+			a.sse(kMovsdLoad, xmm, Scaled());
+			return xmm;
+		}
+		else if (stage.curve == EffectCurve::Linear) {
+			load(0, operand(stage.source));
+			lowerLinear(point, stage.pointCount);
+		}
+		else if (stage.curve == EffectCurve::Exp) {
+			load(0, operand(stage.source));
+			a.sse(kMulsd, 0, Constant(stage.rate));
+			a.sse(kAddsd, 0, Constant(stage.offset));
+			const uint8_t result = lowerFastExp(xmm);
+			a.sse(kMulsd, result, Constant(stage.scale));
+			return result;
+		}
+		return 0;
+	}
+
+	// eax = an index for x; returns the number of points below x for each index. Up to kCurveLanes points (the
+	// padding is +infinity) that is a mask from two packed compares, past that a count.
+	std::vector<unsigned> lowerCount(const double* point, unsigned pointCount, Operand x) {
+		std::vector<unsigned> below;
+		if (pointCount <= kCurveLanes) {
+			if (x.kind == Operand::Xmm) {
+				a.sse(kPshufd, 1, x, kBothLow);
+			}
+			else {
+				load(1, x);
+				a.sse(kUnpcklpd, 1, Xmm(1));
+			}
+			a.maskBelow(point);
+			for (unsigned mask = 0; mask < 16; ++mask) {
+				below.push_back((mask & 1) + (mask >> 1 & 1) + (mask >> 2 & 1) + (mask >> 3));
+			}
+		}
+		else {
+			load(0, x);
+			a.countBelow(point, pointCount);
+			for (unsigned count = 0; count <= pointCount; ++count) {
+				below.push_back(count);
+			}
+		}
+		return below;
+	}
+
+	// xmm0 = the interpolation around xmm0. Each index has its entry { low x, low y, high y - low y, high x - low x },
+	// worked out here the way EvaluateEffectPoints() works them out per call.
+	void lowerLinear(const double* point, unsigned pointCount) {
+		std::vector<double> entries;
+		for (unsigned below : lowerCount(point, pointCount, Xmm(0))) {
+			const double* low = point + 2 * (below > 0 ? below - 1 : 0);
+			const double* high = point + 2 * (below < pointCount ? below : below - 1);
+			entries.insert(entries.end(), { low[0], low[1], high[1] - low[1], high[0] - low[0] });
+		}
+		a.selectEntry(entries, 5);
+		a.sse(kMovsdLoad, 1, Entry(24));
+		a.sse(kXorpd, 2, Xmm(2));
+		a.sse(kUcomisd, 1, Xmm(2));                    // span > 0
+		size_t flat = a.jump(kJbe);
+		a.sse(kSubsd, 0, Entry(0));
+		a.sse(kMulsd, 0, Entry(16));
+		a.sse(kDivsd, 0, Xmm(1));
+		size_t done = a.jump();
+		a.bind(flat);
+		a.sse(kMovapd, 0, Xmm(2));
+		a.bind(done);
+		a.sse(kAddsd, 0, Entry(8));
+	}
+
+	// FastExp(xmm0), its operations written out, in xmm when that is not 0 and else in xmm0; returns the register.
+	// For the arguments it hands to std::exp it is called, with the cached registers kept in memory around the call.
+	uint8_t lowerFastExp(uint8_t xmm) {
+		a.sse(kUcomisd, 0, Constant(-700.0));
+		size_t low = a.jump(kJb);
+		a.sse(kUcomisd, 0, Constant(700.0));
+		size_t high = a.jump(kJa);
+
+		// shifted and then 2^n go to the result register, so the last multiply leaves the result there.
+		const double shifter = 6755399441055744.0;
+		const uint8_t scale = xmm != 0 ? xmm : 1;
+		a.sse(kMovapd, scale, Xmm(0));
+		a.sse(kMulsd, scale, Constant(1.4426950408889634));
+		a.sse(kAddsd, scale, Constant(shifter));      // shifted
+		a.sse(kMovapd, 2, Xmm(scale));
+		a.sse(kSubsd, 2, Constant(shifter));          // n
+		a.sse(kMulsd, 2, Constant(0.69314718055994531));
+		a.sse(kSubsd, 0, Xmm(2));                      // r
+		a.exponentFromShifted(scale);
+		a.sse(kMovapd, 2, Xmm(0));
+		a.sse(kMulsd, 2, Constant(0.0083691484908563867));
+		a.sse(kAddsd, 2, Constant(0.041917507249615259));   // high
+		a.sse(kMovapd, 3, Xmm(0));
+		a.sse(kMulsd, 3, Constant(0.16666505260408124));
+		a.sse(kAddsd, 3, Constant(0.49998869378303396));    // middle
+		a.sse(kMovapd, 4, Xmm(0));
+		a.sse(kMulsd, 4, Xmm(0));                           // r2
+		a.sse(kMulsd, 2, Xmm(4));
+		a.sse(kAddsd, 2, Xmm(3));
+		a.sse(kMulsd, 2, Xmm(4));
+		a.sse(kMulsd, 0, Constant(1.0000000107715701));
+		a.sse(kAddsd, 0, Constant(1.0000000754548972));     // low
+		a.sse(kAddsd, 0, Xmm(2));
+		if (xmm != 0) {
+			a.sse(kMulsd, xmm, Xmm(0));                     // 2^n * p, the same product
+		}
+		else {
+			a.sse(kMulsd, 0, Xmm(1));
+		}
+		size_t done = a.jump();
+
+		a.bind(low);
+		a.bind(high);
+		spill(kMovsdStore);
+		a.call(reinterpret_cast<const void*>(&NativeExp));
+		spill(kMovsdLoad);
+		load(xmm, Xmm(0));
+		a.bind(done);
+		return xmm;
+	}
+};
+
+void* MapCode(const std::vector<uint8_t>& image) {
+#ifdef _WIN32
+	void* memory = VirtualAlloc(nullptr, image.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (memory == nullptr) {
+		return nullptr;
+	}
+	std::memcpy(memory, image.data(), image.size());
+	DWORD previous;
+	if (!VirtualProtect(memory, image.size(), PAGE_EXECUTE_READ, &previous)) {
+		VirtualFree(memory, 0, MEM_RELEASE);
+		return nullptr;
+	}
+	FlushInstructionCache(GetCurrentProcess(), memory, image.size());
+#else
+	void* memory = mmap(nullptr, image.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return nullptr;
+	}
+	std::memcpy(memory, image.data(), image.size());
+	if (mprotect(memory, image.size(), PROT_READ | PROT_EXEC) != 0) {
+		munmap(memory, image.size());
+		return nullptr;
+	}
+#endif
+	return memory;
+}
+
+void UnmapCode(void* memory, size_t size) {
+#ifdef _WIN32
+	(void)size;
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	munmap(memory, size);
+#endif
+}
+
+} // namespace
+
+bool CompileEffectNative(EffectProgram& program) {
+	program.native = nullptr;
+	program.nativeCode.reset();
+
+	Assembler assembler;
+	Lowering(program, assembler).lower();
+	const std::vector<uint8_t> image = assembler.link();
+
+	void* memory = MapCode(image);
+	if (memory == nullptr) {
+		return false;
+	}
+	const size_t size = image.size();
+	program.nativeCode = std::shared_ptr<const void>(memory, [size](const void* code) { UnmapCode(const_cast<void*>(code), size); });
+	program.native = reinterpret_cast<void (*)(double*, const TelemetryData*)>(memory);
+	return true;
+}
+
+#else
+
+bool CompileEffectNative(EffectProgram& program) {
+	program.native = nullptr;
+	program.nativeCode.reset();
+	return false;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "EffectGraph.h"
+
+/*
+	Machine code for an EffectProgram.
+
+	The interpreter pays for being general on every frame: it copies the
+	telemetry in a loop over member pointers, loads each register number and
+	constant before it can use it, and runs every gate and sum at their full
+	size whatever the effect wrote. CompileEffectNative()
+	lowers the program once, when it is compiled, into one straight-line
+	function for the x86-64 SSE2 baseline:
+
+		registers the telemetry read, the effect values and the outputs, as
+		          many as fit, live in xmm registers for the whole call; r[] is read once for what
+		          the program keeps or reads before setting, and written once
+		          for what it sets
+		curves    Exp and Linear curves of what no effect writes go first,
+		          ahead of every branch, so a mispredicted gate does not restart FastExp
+		gate      a compare and branch per finite bound; conditions on One
+		          are decided at compile time
+		value     Step and Linear count the points below x with two packed
+		          compares and look up a per-count table of what they would
+		          compute; then Plus, the float rounding and the register
+		write     the used terms only, in order, without the multiply for a
+		          weight of 1 or the add of a constant of -0
+
+	Register numbers and TelemetryData fields become displacements and the
+	constants sit in a table behind the code, so the function reads nothing from
+	the program. The results are the interpreter's, bit for bit: every value is
+	rounded by the same operations, only the order of exact ones (a product by
+	2^n, the operands of an add) differs.
+
+	The code lives in its own pages, written first and then made read-only and
+	executable, and is freed with the last copy of the program. Other CPUs, and
+	processes where the OS refuses executable memory, keep the interpreter.
+*/
+
+// Sets program.native and program.nativeCode. Returns false, with the program left to the interpreter, where that
+// is not possible.
+bool CompileEffectNative(EffectProgram& program);
@@ -0,0 +1,87 @@
+#include "EffectPresets.h"
+
+#include <algorithm>
+#include <cctype>
+
+// Class names by the number each game sends, see CarClassScale.
+static const char* const kClassNames[CarClassScale_Count][kCarClassCount] = {
+	{ "E", "D", "C", "B", "A", "S", "R", "P", "X" },
+	{ "D", "C", "B", "A", "S1", "S2", "X", nullptr, nullptr },
+};
+static const char* const kDrivetrainNames[kDrivetrainCount] = { "FWD", "RWD", "AWD" };
+
+static std::string ToLower(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return text;
+}
+
+// The [Presets] entry for one class of one game and drivetrain ("" for any), under either name of the class.
+static std::string FindPreset(const IniFile& ini, CarClassScale scale, uint32_t carClass, const char* drivetrain) {
+	const char* const className = kClassNames[scale][carClass];
+	const std::string names[2] = { className != nullptr ? className : "", "Class" + std::to_string(carClass) };
+	for (const std::string& name : names) {
+		if (name.empty()) {
+			continue;
+		}
+		std::string key = drivetrain != nullptr ? name + "." + drivetrain : name;
+		std::string preset = ini.getString("Presets", key.c_str(), "");
+		if (!preset.empty()) {
+			return preset;
+		}
+	}
+	return "";
+}
+
+EffectPresets::EffectPresets(const EffectProgram& effects) : programs(1, effects) {
+	std::fill(selection, selection + kCarPresetCount, 0);
+}
+
+bool CompileEffectPresets(const IniFile& ini, const EffectProgram& effects, EffectPresets& presets, std::string& error) {
+	EffectPresets compiled(effects);
+	std::vector<std::string> names(1);  // Lower case preset name of each program, "" for [Effects]
+
+	for (uint32_t game = 0; game < CarClassScale_Count; ++game) {
+		const CarClassScale scale = static_cast<CarClassScale>(game);
+		for (uint32_t carClass = 0; carClass < kCarClassCount; ++carClass) {
+			for (uint32_t drivetrain = 0; drivetrain < kDrivetrainCount; ++drivetrain) {
+				std::string preset = FindPreset(ini, scale, carClass, kDrivetrainNames[drivetrain]);
+				if (preset.empty()) {
+					preset = FindPreset(ini, scale, carClass, nullptr);
+				}
+				if (preset.empty()) {
+					preset = ini.getString("Presets", kDrivetrainNames[drivetrain], "");
+				}
+				if (preset.empty()) {
+					continue;
+				}
+
+				// Presets shared by several cars are compiled once.
+				std::string name = ToLower(preset);
+				size_t index = std::find(names.begin(), names.end(), name) - names.begin();
+				if (index == names.size()) {
+					std::string section = "Preset." + preset;
+					if (ini.getString(section.c_str(), "Order", "").empty() && ini.getString(section.c_str(), "MotorLimit", "").empty() &&
+						ini.getString(section.c_str(), "TriggerLimit", "").empty()) {
+						error = "[" + section + "] is missing or empty";
+						return false;
+					}
+					EffectProgram program;
+					if (!CompileEffectSection(ini, section.c_str(), effects, program, error)) {
+						if (error.compare(0, section.size() + 1, "[" + section) != 0) {
+							error = "[" + section + "] " + error;
+						}
+						return false;
+					}
+					compiled.programs.push_back(std::move(program));
+					names.push_back(name);
+				}
+
+				const uint8_t key = CarPresetKey(scale, static_cast<int32_t>(carClass), static_cast<int32_t>(drivetrain));
+				compiled.selection[key] = static_cast<uint8_t>(index);
+			}
+		}
+	}
+
+	presets = std::move(compiled);
+	return true;
+}
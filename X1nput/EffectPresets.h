@@ -0,0 +1,51 @@
+#pragma once
+
+#include "EffectGraph.h"
+#include "IniFile.h"
+#include "TelemetryData.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+	Effect programs per car class and drivetrain.
+
+	[Presets] in X1nput.ini sends cars to [Preset.Name] sections:
+
+		[Presets]
+		X=Hypercar      every X class car
+		AWD=Grip        every other all-wheel drive car
+		D.RWD=Truck     D class with rear-wheel drive
+
+	The most specific entry wins (class and drivetrain, then class, then
+	drivetrain), and cars no entry matches run [Effects]. Drivetrains are FWD,
+	RWD and AWD. Classes go by the game's own names, and the decoder tells the
+	games apart by their packet format: Motorsport (FM7, FM 2023) has E, D, C, B,
+	A, S, R, P and X, Horizon (FH4, FH5) D, C, B, A, S1, S2 and X. D.RWD and X are
+	the same classes in both, S is Motorsport only and S1 Horizon only. Class0 to
+	Class8 take the number the game sends instead, in whichever game it is.
+
+	A [Preset.Name] section takes the Order, MotorLimit and TriggerLimit keys of
+	[Effects] and runs the same [Effect.*] sections; what it leaves out comes from
+	[Effects]. Each preset is compiled once when the file is loaded, into a table
+	with the program of every class and drivetrain. The decoder stores the car's
+	index in TelemetryData::CarPreset, so the output path picks its program with
+	one table load. A new car takes effect with its first packet, and since
+	packets reach the output threads whole through the SeqLock the car and the
+	telemetry always change together.
+*/
+struct EffectPresets {
+	std::vector<EffectProgram> programs;  // [Effects] first, then every preset [Presets] uses
+	uint8_t selection[kCarPresetCount];   // Index into programs for every CarPresetKey()
+
+	// Every car runs effects.
+	explicit EffectPresets(const EffectProgram& effects = DefaultEffectProgram());
+
+	const EffectProgram& forCar(uint8_t carPreset) const { return programs[selection[carPreset]]; }
+	const EffectProgram& base() const { return programs[0]; }
+};
+
+// Compiles [Presets] and the [Preset.*] sections it names, with effects ([Effects]) for every other car. Returns
+// false and describes the problem in error if a preset is invalid; presets is left untouched then.
+bool CompileEffectPresets(const IniFile& ini, const EffectProgram& effects, EffectPresets& presets, std::string& error);
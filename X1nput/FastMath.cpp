@@ -0,0 +1,58 @@
+#include "FastMath.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define X1NPUT_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define X1NPUT_NEON 1
+#include <arm_neon.h>
+#endif
+
+FastNormsResult FastNorms(const float tireSlip[4], float accelerationY, float accelerationZ) {
+	FastNormsResult result;
+
+#if defined(X1NPUT_SSE2)
+	__m128 slip = _mm_loadu_ps(tireSlip);
+	slip = _mm_mul_ps(slip, slip);
+	__m128 acceleration = _mm_set_ps(0.f, 0.f, accelerationZ, accelerationY);
+	acceleration = _mm_mul_ps(acceleration, acceleration);
+
+	// [FL+RL, FR+RR, Y+0, Z+0] -> [FL+RL+FR+RR, ..., Y+Z, ...], then both roots at once.
+	__m128 pairs = _mm_add_ps(_mm_movelh_ps(slip, acceleration), _mm_movehl_ps(acceleration, slip));
+	__m128 sums = _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m128 roots = _mm_sqrt_ps(sums);
+
+	result.Slip = _mm_cvtss_f32(roots);
+	result.Acceleration = _mm_cvtss_f32(_mm_movehl_ps(roots, roots));
+#elif defined(X1NPUT_NEON)
+	float32x4_t slip = vld1q_f32(tireSlip);
+	slip = vmulq_f32(slip, slip);
+	float32x2_t acceleration = { accelerationY, accelerationZ };
+	acceleration = vmul_f32(acceleration, acceleration);
+
+	// [FL+FR, RL+RR] -> [FL+FR+RL+RR, Y+Z], then both roots at once.
+	float32x2_t sums = vpadd_f32(vpadd_f32(vget_low_f32(slip), vget_high_f32(slip)), acceleration);
+	float32x2_t roots = vsqrt_f32(sums);
+
+	result.Slip = vget_lane_f32(roots, 0);
+	result.Acceleration = vget_lane_f32(roots, 1);
+#else
+	result.Slip = std::sqrt(tireSlip[0] * tireSlip[0] + tireSlip[1] * tireSlip[1] + tireSlip[2] * tireSlip[2] + tireSlip[3] * tireSlip[3]);
+	result.Acceleration = std::sqrt(accelerationY * accelerationY + accelerationZ * accelerationZ);
+#endif
+
+	return result;
+}
+
+FastNormsResult FastNormsReference(const float tireSlip[4], float accelerationY, float accelerationZ) {
+	FastNormsResult result;
+	result.Slip = static_cast<float>(std::sqrt(
+		std::pow(tireSlip[0], 2) +
+		std::pow(tireSlip[1], 2) +
+		std::pow(tireSlip[2], 2) +
+		std::pow(tireSlip[3], 2)
+	));
+	result.Acceleration = static_cast<float>(std::sqrt(std::pow(accelerationZ, 2)
+		+ std::pow(accelerationY, 2)));
+	return result;
+}
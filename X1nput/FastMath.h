@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/*
+	Cheaper replacements for the per-packet and per-frame math.
+
+	FastNorms() computes the slip magnitude (four tire slip ratios) and the
+	collision acceleration (Y and Z) in one single-precision SSE2/NEON pass with
+	one square root instruction for both. The original formulas square in double
+	through std::pow and round the result to float; the float version differs
+	from them by at most 1 ulp (relative 1.2e-7).
+
+	FastExp() replaces std::exp for the Exp effect curve with a range reduction
+	to 2^n * e^r, |r| <= ln2/2, and a degree 5 polynomial for e^r. Its maximum
+	relative error against std::exp is 1.02e-7, below the float rounding the
+	effect registers apply to every value anyway. Arguments outside
+	[-700, 700], NaN and infinities go to std::exp.
+*/
+
+struct FastNormsResult {
+	float Slip;          // sqrt(FL^2 + FR^2 + RL^2 + RR^2)
+	float Acceleration;  // sqrt(Y^2 + Z^2)
+};
+
+FastNormsResult FastNorms(const float tireSlip[4], float accelerationY, float accelerationZ);
+
+// The formulas ForzaDecoder used before FastNorms(), kept as the accuracy reference.
+FastNormsResult FastNormsReference(const float tireSlip[4], float accelerationY, float accelerationZ);
+
+inline double FastExp(double x) {
+	if (!(x >= -700.0 && x <= 700.0)) {
+		return std::exp(x);
+	}
+
+	// x = n * ln2 + r. Adding 1.5 * 2^52 rounds x / ln2 to the nearest integer and leaves it in the low mantissa bits.
+	const double shifter = 6755399441055744.0;
+	const double shifted = x * 1.4426950408889634 + shifter;
+	const double n = shifted - shifter;
+	// n * ln2 in one product: for |n| <= 1010 its rounding moves e^r by about 1e-13, far below the polynomial's error.
+	const double r = x - n * 0.69314718055994531;
+
+	// Degree 5 fit of e^r through the Chebyshev nodes of [-ln2/2, ln2/2]: close to minimax, relative error 1.02e-7.
+	// Taken as (c0 + c1 r) + r^2 ((c2 + c3 r) + r^2 (c4 + c5 r)): half the dependent steps of Horner's rule.
+	const double r2 = r * r;
+	const double high = r * 0.0083691484908563867 + 0.041917507249615259;
+	const double middle = r * 0.16666505260408124 + 0.49998869378303396;
+	const double low = r * 1.0000000107715701 + 1.0000000754548972;
+	const double p = low + r2 * (middle + r2 * high);
+
+	// 2^n built directly in the exponent field.
+	uint64_t bits;
+	std::memcpy(&bits, &shifted, sizeof(bits));
+	bits = (bits + 1023) << 52;
+	double scale;
+	std::memcpy(&scale, &bits, sizeof(scale));
+	return p * scale;
+}
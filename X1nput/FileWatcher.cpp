@@ -0,0 +1,216 @@
+#include "FileWatcher.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Editors often save in several steps (truncate, write, rename); wait this long after the last event.
+static const int kSettleMs = 100;
+
+FileWatcher::FileWatcher() : running(false),
+#ifdef _WIN32
+	directoryHandle(INVALID_HANDLE_VALUE), stopEvent(nullptr)
+#else
+	notifyFd(-1), wakePipe{ -1, -1 }
+#endif
+{
+}
+
+FileWatcher::~FileWatcher() {
+	stop();
+}
+
+bool FileWatcher::start(const std::string& path, Callback onChange) {
+	if (!onChange || running.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	size_t slash = path.find_last_of("/\\");
+	directory = slash == std::string::npos ? std::string(".") : path.substr(0, slash == 0 ? 1 : slash);
+	fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+	callback = onChange;
+
+#ifdef _WIN32
+	directoryHandle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	if (directoryHandle == INVALID_HANDLE_VALUE || stopEvent == nullptr) {
+		closeHandles();
+		return false;
+	}
+#else
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFd < 0 || pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0 ||
+		inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+		closeHandles();
+		return false;
+	}
+#endif
+
+	running.store(true, std::memory_order_release);
+	thread = std::thread(&FileWatcher::run, this);
+	return true;
+}
+
+void FileWatcher::stop() {
+	running.store(false, std::memory_order_release);
+
+	if (thread.joinable()) {
+#ifdef _WIN32
+		SetEvent(stopEvent);
+#else
+		char wake = 0;
+		(void)!write(wakePipe[1], &wake, 1);
+#endif
+		thread.join();
+	}
+
+	closeHandles();
+}
+
+void FileWatcher::closeHandles() {
+#ifdef _WIN32
+	if (directoryHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(directoryHandle);
+		directoryHandle = INVALID_HANDLE_VALUE;
+	}
+	if (stopEvent != nullptr) {
+		CloseHandle(stopEvent);
+		stopEvent = nullptr;
+	}
+#else
+	if (notifyFd >= 0) {
+		close(notifyFd);
+		notifyFd = -1;
+	}
+	for (int& fd : wakePipe) {
+		if (fd >= 0) {
+			close(fd);
+			fd = -1;
+		}
+	}
+#endif
+}
+
+#ifdef _WIN32
+
+void FileWatcher::run() {
+	WCHAR wideName[MAX_PATH];
+	int wideLength = MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, wideName, MAX_PATH) - 1;
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	// FILE_NOTIFY_INFORMATION records must be DWORD aligned.
+	DWORD buffer[4096];
+	bool reading = false;
+	bool pending = false;
+
+	while (running.load(std::memory_order_acquire) && overlapped.hEvent != nullptr) {
+		if (!reading) {
+			if (!ReadDirectoryChangesW(directoryHandle, buffer, sizeof(buffer), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+				NULL, &overlapped, NULL)) {
+				break;
+			}
+			reading = true;
+		}
+
+		HANDLE handles[2] = { overlapped.hEvent, stopEvent };
+		DWORD wait = WaitForMultipleObjects(2, handles, FALSE, pending ? kSettleMs : INFINITE);
+
+		if (wait == WAIT_TIMEOUT) {
+			pending = false;
+			callback();
+			continue;
+		}
+		if (wait != WAIT_OBJECT_0) {
+			break;
+		}
+
+		reading = false;
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(directoryHandle, &overlapped, &bytes, FALSE)) {
+			break;
+		}
+		if (bytes == 0) {
+			// The change buffer overflowed, so the file may be among the lost events.
+			pending = true;
+			continue;
+		}
+
+		const char* record = reinterpret_cast<const char*>(buffer);
+		for (;;) {
+			const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+			if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME &&
+				CompareStringOrdinal(info->FileName, static_cast<int>(info->FileNameLength / sizeof(WCHAR)), wideName, wideLength, TRUE) == CSTR_EQUAL) {
+				pending = true;
+			}
+			if (info->NextEntryOffset == 0) {
+				break;
+			}
+			record += info->NextEntryOffset;
+		}
+	}
+
+	if (reading) {
+		DWORD bytes = 0;
+		CancelIoEx(directoryHandle, &overlapped);
+		GetOverlappedResult(directoryHandle, &overlapped, &bytes, TRUE);
+	}
+	if (overlapped.hEvent != nullptr) {
+		CloseHandle(overlapped.hEvent);
+	}
+}
+
+#else
+
+void FileWatcher::run() {
+	alignas(inotify_event) char buffer[4096];
+	bool pending = false;
+
+	pollfd fds[2] = {};
+	fds[0].fd = notifyFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = wakePipe[0];
+	fds[1].events = POLLIN;
+
+	while (running.load(std::memory_order_acquire)) {
+		int ready = poll(fds, 2, pending ? kSettleMs : -1);
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if (fds[1].revents != 0) {
+			break;
+		}
+		if (ready == 0) {
+			pending = false;
+			callback();
+			continue;
+		}
+
+		ssize_t length;
+		while ((length = read(notifyFd, buffer, sizeof(buffer))) > 0) {
+			for (char* record = buffer; record < buffer + length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(record);
+				if ((event->mask & IN_Q_OVERFLOW) != 0 || (event->len > 0 && fileName == event->name)) {
+					pending = true;
+				}
+				record += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/*
+	Calls a function when a file is written, renamed into place or created.
+
+	The directory containing the file is watched (inotify on Linux,
+	ReadDirectoryChangesW elsewhere) so editors that save through a temporary file
+	and a rename are picked up too. Bursts of events from a single save are
+	collapsed into one callback after a short settle time. The callback runs on
+	the watcher thread.
+*/
+class FileWatcher {
+public:
+	typedef std::function<void()> Callback;
+
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool start(const std::string& path, Callback onChange);
+	void stop();
+	bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+private:
+	std::atomic<bool> running;
+	std::thread thread;
+	std::string directory;
+	std::string fileName;
+	Callback callback;
+
+#ifdef _WIN32
+	void* directoryHandle;
+	void* stopEvent;
+#else
+	int notifyFd;
+	int wakePipe[2];
+#endif
+
+	void run();
+	void closeHandles();
+};
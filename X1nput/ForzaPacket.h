@@ -0,0 +1,252 @@
+#pragma once
+
+#include "TelemetryData.h"
+#include "TelemetryPacket.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*
+	Forza "Data Out" packet decoding.
+
+	Every Forza title sends the same "Sled" block first and most of them append a
+	"Dash" block. Horizon 4/5 insert 12 undocumented bytes between the two, which
+	is the "offset = 12" the old parser hardcoded. The layouts below are plain
+	constexpr tables, each decoder is specialised per format at compile time and
+	the right one is picked from the datagram length, so a short or unknown packet
+	is rejected instead of read past its end.
+*/
+
+enum class ForzaFormat {
+	Sled,    // 232 bytes, FM7 "Sled"
+	Dash,    // 311 bytes, FM7 "Car Dash" (331 bytes on FM 2023, same layout plus extra fields at the end)
+	Horizon, // 324 bytes, FH4/FH5 "Dash" with 12 extra bytes after the Sled block
+};
+
+enum class ForzaFieldType : uint8_t {
+	F32,
+	S32,
+	U32,
+	U16,
+	U8,
+	S8,
+};
+
+// Fields the haptics pipeline reads. Add new ones here and in kForzaFields.
+enum ForzaField : uint8_t {
+	ForzaField_TimestampMs,
+	ForzaField_EngineMaxRpm,
+	ForzaField_EngineIdleRpm,
+	ForzaField_CurrentEngineRpm,
+	ForzaField_AccelerationX,
+	ForzaField_AccelerationY,
+	ForzaField_AccelerationZ,
+	ForzaField_VelocityX,
+	ForzaField_VelocityY,
+	ForzaField_VelocityZ,
+	ForzaField_TireSlipRatioFrontLeft,
+	ForzaField_TireSlipRatioFrontRight,
+	ForzaField_TireSlipRatioRearLeft,
+	ForzaField_TireSlipRatioRearRight,
+	ForzaField_TireSlipAngleFrontLeft,
+	ForzaField_TireSlipAngleFrontRight,
+	ForzaField_TireSlipAngleRearLeft,
+	ForzaField_TireSlipAngleRearRight,
+	ForzaField_TireCombinedSlipFrontLeft,
+	ForzaField_TireCombinedSlipFrontRight,
+	ForzaField_TireCombinedSlipRearLeft,
+	ForzaField_TireCombinedSlipRearRight,
+	ForzaField_Speed,
+	ForzaField_Gear,
+	ForzaField_Accel,
+	ForzaField_Brake,
+	ForzaField_CarOrdinal,
+	ForzaField_CarClass,
+	ForzaField_CarPerformanceIndex,
+	ForzaField_DrivetrainType,
+	ForzaField_NumCylinders,
+
+	ForzaField_Count
+};
+
+struct ForzaFieldDesc {
+	uint16_t offset;     // Byte offset inside its block
+	ForzaFieldType type;
+	bool dash;           // true if the offset is relative to the Dash block
+};
+
+// Sled offsets are absolute; Dash offsets are relative to the start of the Dash block (byte 232 on FM7).
+inline constexpr ForzaFieldDesc kForzaFields[ForzaField_Count] = {
+	{   4, ForzaFieldType::U32, false }, // TimestampMs
+	{   8, ForzaFieldType::F32, false }, // EngineMaxRpm
+	{  12, ForzaFieldType::F32, false }, // EngineIdleRpm
+	{  16, ForzaFieldType::F32, false }, // CurrentEngineRpm
+	{  20, ForzaFieldType::F32, false }, // AccelerationX
+	{  24, ForzaFieldType::F32, false }, // AccelerationY
+	{  28, ForzaFieldType::F32, false }, // AccelerationZ
+	{  32, ForzaFieldType::F32, false }, // VelocityX
+	{  36, ForzaFieldType::F32, false }, // VelocityY
+	{  40, ForzaFieldType::F32, false }, // VelocityZ
+	{  84, ForzaFieldType::F32, false }, // TireSlipRatioFrontLeft
+	{  88, ForzaFieldType::F32, false }, // TireSlipRatioFrontRight
+	{  92, ForzaFieldType::F32, false }, // TireSlipRatioRearLeft
+	{  96, ForzaFieldType::F32, false }, // TireSlipRatioRearRight
+	{ 164, ForzaFieldType::F32, false }, // TireSlipAngleFrontLeft
+	{ 168, ForzaFieldType::F32, false }, // TireSlipAngleFrontRight
+	{ 172, ForzaFieldType::F32, false }, // TireSlipAngleRearLeft
+	{ 176, ForzaFieldType::F32, false }, // TireSlipAngleRearRight
+	{ 180, ForzaFieldType::F32, false }, // TireCombinedSlipFrontLeft
+	{ 184, ForzaFieldType::F32, false }, // TireCombinedSlipFrontRight
+	{ 188, ForzaFieldType::F32, false }, // TireCombinedSlipRearLeft
+	{ 192, ForzaFieldType::F32, false }, // TireCombinedSlipRearRight
+	{  12, ForzaFieldType::F32, true  }, // Speed
+	{  75, ForzaFieldType::U8,  true  }, // Gear
+	{  71, ForzaFieldType::U8,  true  }, // Accel (pedal, 0..255)
+	{  72, ForzaFieldType::U8,  true  }, // Brake
+	{ 212, ForzaFieldType::S32, false }, // CarOrdinal
+	{ 216, ForzaFieldType::S32, false }, // CarClass
+	{ 220, ForzaFieldType::S32, false }, // CarPerformanceIndex
+	{ 224, ForzaFieldType::S32, false }, // DrivetrainType
+	{ 228, ForzaFieldType::S32, false }, // NumCylinders
+};
+
+template <ForzaFormat Format>
+struct ForzaLayout;
+
+template <>
+struct ForzaLayout<ForzaFormat::Sled> {
+	static constexpr size_t kPacketSize = 232;
+	static constexpr bool kHasDash = false;
+	static constexpr size_t kDashOffset = 0;
+	static constexpr CarClassScale kCarClasses = CarClassScale_Motorsport;
+};
+
+template <>
+struct ForzaLayout<ForzaFormat::Dash> {
+	static constexpr size_t kPacketSize = 311;
+	static constexpr bool kHasDash = true;
+	static constexpr size_t kDashOffset = 232;
+	static constexpr CarClassScale kCarClasses = CarClassScale_Motorsport;
+};
+
+template <>
+struct ForzaLayout<ForzaFormat::Horizon> {
+	static constexpr size_t kPacketSize = 324;
+	static constexpr bool kHasDash = true;
+	static constexpr size_t kDashOffset = 244;
+	static constexpr CarClassScale kCarClasses = CarClassScale_Horizon;
+};
+
+template <ForzaFieldType Type> struct ForzaFieldStorage;
+template <> struct ForzaFieldStorage<ForzaFieldType::F32> { typedef float type; };
+template <> struct ForzaFieldStorage<ForzaFieldType::S32> { typedef int32_t type; };
+template <> struct ForzaFieldStorage<ForzaFieldType::U32> { typedef uint32_t type; };
+template <> struct ForzaFieldStorage<ForzaFieldType::U16> { typedef uint16_t type; };
+template <> struct ForzaFieldStorage<ForzaFieldType::U8> { typedef uint8_t type; };
+template <> struct ForzaFieldStorage<ForzaFieldType::S8> { typedef int8_t type; };
+
+template <ForzaFormat Format>
+struct ForzaDecoder {
+	typedef ForzaLayout<Format> Layout;
+
+	template <ForzaField Field>
+	static constexpr bool has() {
+		return !kForzaFields[Field].dash || Layout::kHasDash;
+	}
+
+	template <ForzaField Field>
+	static constexpr size_t offset() {
+		return kForzaFields[Field].dash ? Layout::kDashOffset + kForzaFields[Field].offset : kForzaFields[Field].offset;
+	}
+
+	template <ForzaField Field>
+	static typename ForzaFieldStorage<kForzaFields[Field].type>::type get(const PacketView& packet) {
+		typedef typename ForzaFieldStorage<kForzaFields[Field].type>::type Value;
+		static_assert(has<Field>(), "field is not present in this packet format");
+		static_assert(offset<Field>() + sizeof(Value) <= Layout::kPacketSize, "field lies outside the packet");
+		return packet.read<Value>(offset<Field>());
+	}
+
+	// Decode only the fields TelemetryData needs. The caller guarantees packet.length() == kPacketSize.
+	static void decode(const PacketView& packet, TelemetryData& telemetry) {
+		telemetry.TimestampMs = get<ForzaField_TimestampMs>(packet);
+		telemetry.EngineMaxRpm = get<ForzaField_EngineMaxRpm>(packet);
+		telemetry.EngineIdleRpm = get<ForzaField_EngineIdleRpm>(packet);
+		telemetry.CurrentEngineRpm = get<ForzaField_CurrentEngineRpm>(packet);
+
+		telemetry.TireSlipRatioFrontLeft = get<ForzaField_TireSlipRatioFrontLeft>(packet);
+		telemetry.TireSlipRatioFrontRight = get<ForzaField_TireSlipRatioFrontRight>(packet);
+		telemetry.TireSlipRatioRearLeft = get<ForzaField_TireSlipRatioRearLeft>(packet);
+		telemetry.TireSlipRatioRearRight = get<ForzaField_TireSlipRatioRearRight>(packet);
+		telemetry.TireSlipAngleFrontLeft = get<ForzaField_TireSlipAngleFrontLeft>(packet);
+		telemetry.TireSlipAngleFrontRight = get<ForzaField_TireSlipAngleFrontRight>(packet);
+		telemetry.TireSlipAngleRearLeft = get<ForzaField_TireSlipAngleRearLeft>(packet);
+		telemetry.TireSlipAngleRearRight = get<ForzaField_TireSlipAngleRearRight>(packet);
+		telemetry.TireCombinedSlipFrontLeft = get<ForzaField_TireCombinedSlipFrontLeft>(packet);
+		telemetry.TireCombinedSlipFrontRight = get<ForzaField_TireCombinedSlipFrontRight>(packet);
+		telemetry.TireCombinedSlipRearLeft = get<ForzaField_TireCombinedSlipRearLeft>(packet);
+		telemetry.TireCombinedSlipRearRight = get<ForzaField_TireCombinedSlipRearRight>(packet);
+
+		telemetry.AccelerationX = get<ForzaField_AccelerationX>(packet);
+		telemetry.AccelerationY = get<ForzaField_AccelerationY>(packet);
+		telemetry.AccelerationZ = get<ForzaField_AccelerationZ>(packet);
+
+		telemetry.CarOrdinal = get<ForzaField_CarOrdinal>(packet);
+		telemetry.CarClass = get<ForzaField_CarClass>(packet);
+		telemetry.CarPerformanceIndex = get<ForzaField_CarPerformanceIndex>(packet);
+		telemetry.DrivetrainType = get<ForzaField_DrivetrainType>(packet);
+		telemetry.NumCylinders = get<ForzaField_NumCylinders>(packet);
+		telemetry.CarPreset = CarPresetKey(Layout::kCarClasses, telemetry.CarClass, telemetry.DrivetrainType);
+
+		if constexpr (Layout::kHasDash) {
+			telemetry.Speed = get<ForzaField_Speed>(packet);
+			telemetry.Gear = get<ForzaField_Gear>(packet);
+			telemetry.Throttle = get<ForzaField_Accel>(packet) / 255.f;
+			telemetry.Brake = get<ForzaField_Brake>(packet) / 255.f;
+		}
+		else {
+			// Sled packets have no Dash block: derive speed from the velocity vector and report first gear.
+			float vx = get<ForzaField_VelocityX>(packet);
+			float vy = get<ForzaField_VelocityY>(packet);
+			float vz = get<ForzaField_VelocityZ>(packet);
+			telemetry.Speed = std::sqrt(vx * vx + vy * vy + vz * vz);
+			telemetry.Gear = 1;
+			telemetry.Throttle = telemetry.Brake = 0.f;
+		}
+
+		telemetry.Source = TelemetrySource_Forza;
+		DeriveTelemetry(telemetry);
+	}
+};
+
+// Size of the extended FM 2023 Dash packet; its first 311 bytes match the FM7 Dash layout.
+constexpr size_t kForzaMotorsport2023PacketSize = 331;
+
+// True if the datagram length matches one of the packet formats above.
+inline bool IsForzaPacket(size_t length) {
+	return length == ForzaLayout<ForzaFormat::Sled>::kPacketSize ||
+		length == ForzaLayout<ForzaFormat::Dash>::kPacketSize ||
+		length == kForzaMotorsport2023PacketSize ||
+		length == ForzaLayout<ForzaFormat::Horizon>::kPacketSize;
+}
+
+// Picks the decoder from the datagram length. Returns false for anything that is not a known Forza packet.
+inline bool DecodeForzaPacket(const char* data, size_t length, TelemetryData& telemetry) {
+	PacketView packet(data, length);
+
+	switch (length) {
+	case ForzaLayout<ForzaFormat::Sled>::kPacketSize:
+		ForzaDecoder<ForzaFormat::Sled>::decode(packet, telemetry);
+		return true;
+	case ForzaLayout<ForzaFormat::Dash>::kPacketSize:
+	case kForzaMotorsport2023PacketSize:
+		ForzaDecoder<ForzaFormat::Dash>::decode(packet, telemetry);
+		return true;
+	case ForzaLayout<ForzaFormat::Horizon>::kPacketSize:
+		ForzaDecoder<ForzaFormat::Horizon>::decode(packet, telemetry);
+		return true;
+	default:
+		return false;
+	}
+}
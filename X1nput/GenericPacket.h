@@ -0,0 +1,126 @@
+#pragma once
+
+#include "TelemetryData.h"
+#include "TelemetryPacket.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+	X1nput's generic telemetry packet, for games X1nput has no decoder for (a
+	plugin or a script can send it) and for test tools.
+
+		offset  type      field
+		0       char[4]   magic "X1TD"
+		4       uint16_t  version, 1
+		6       uint16_t  number of floats that follow, N
+		8       uint32_t  timestamp in milliseconds, may wrap around
+		12      float[N]  the fields below, in this order
+
+	Little-endian, packed. A sender can stop after any field: fields it leaves
+	out read as 0, floats past the last known field are ignored, so newer and
+	older senders keep working. Units are those of TelemetryData: m/s, RPM,
+	m/s^2 with X right, Y up and Z forward, slip ratios normalized so 1 is the
+	limit of grip, and gear 0 for reverse. A combined slip of 0 tells the ABS
+	and traction effects to use the slip ratio alone.
+*/
+
+constexpr char kGenericPacketMagic[4] = { 'X', '1', 'T', 'D' };
+constexpr uint16_t kGenericPacketVersion = 1;
+constexpr size_t kGenericHeaderSize = 12;
+
+enum GenericField : uint8_t {
+	GenericField_Speed,
+	GenericField_CurrentEngineRpm,
+	GenericField_EngineIdleRpm,
+	GenericField_EngineMaxRpm,
+	GenericField_Gear,
+	GenericField_AccelerationX,
+	GenericField_AccelerationY,
+	GenericField_AccelerationZ,
+	GenericField_TireSlipRatioFrontLeft,
+	GenericField_TireSlipRatioFrontRight,
+	GenericField_TireSlipRatioRearLeft,
+	GenericField_TireSlipRatioRearRight,
+	GenericField_TireCombinedSlipFrontLeft,
+	GenericField_TireCombinedSlipFrontRight,
+	GenericField_TireCombinedSlipRearLeft,
+	GenericField_TireCombinedSlipRearRight,
+	GenericField_Throttle,  // 0..1; the effects read the triggers, x1nput-sim uses it as the right one
+	GenericField_Brake,     // 0..1, the left trigger in x1nput-sim
+
+	GenericField_Count
+};
+
+struct GenericDecoder {
+	// Number of floats the packet carries, from its header.
+	static size_t fieldCount(const PacketView& packet) {
+		return packet.read<uint16_t>(6);
+	}
+
+	// 0 for a field the sender left out.
+	static float get(const PacketView& packet, size_t count, GenericField field) {
+		return field < count ? packet.read<float>(kGenericHeaderSize + field * sizeof(float)) : 0.f;
+	}
+
+	// The caller guarantees IsGenericPacket().
+	static void decode(const PacketView& packet, TelemetryData& telemetry) {
+		size_t count = fieldCount(packet);
+
+		telemetry.TimestampMs = packet.read<uint32_t>(8);
+		telemetry.Speed = get(packet, count, GenericField_Speed);
+		telemetry.CurrentEngineRpm = get(packet, count, GenericField_CurrentEngineRpm);
+		telemetry.EngineIdleRpm = get(packet, count, GenericField_EngineIdleRpm);
+		telemetry.EngineMaxRpm = get(packet, count, GenericField_EngineMaxRpm);
+
+		float gear = get(packet, count, GenericField_Gear);
+		telemetry.Gear = gear > 0.f ? static_cast<uint8_t>(gear < 255.f ? gear + 0.5f : 255.f) : 0;
+
+		telemetry.AccelerationX = get(packet, count, GenericField_AccelerationX);
+		telemetry.AccelerationY = get(packet, count, GenericField_AccelerationY);
+		telemetry.AccelerationZ = get(packet, count, GenericField_AccelerationZ);
+
+		telemetry.TireSlipRatioFrontLeft = get(packet, count, GenericField_TireSlipRatioFrontLeft);
+		telemetry.TireSlipRatioFrontRight = get(packet, count, GenericField_TireSlipRatioFrontRight);
+		telemetry.TireSlipRatioRearLeft = get(packet, count, GenericField_TireSlipRatioRearLeft);
+		telemetry.TireSlipRatioRearRight = get(packet, count, GenericField_TireSlipRatioRearRight);
+		telemetry.TireSlipAngleFrontLeft = telemetry.TireSlipAngleFrontRight = 0.f;
+		telemetry.TireSlipAngleRearLeft = telemetry.TireSlipAngleRearRight = 0.f;
+		telemetry.TireCombinedSlipFrontLeft = get(packet, count, GenericField_TireCombinedSlipFrontLeft);
+		telemetry.TireCombinedSlipFrontRight = get(packet, count, GenericField_TireCombinedSlipFrontRight);
+		telemetry.TireCombinedSlipRearLeft = get(packet, count, GenericField_TireCombinedSlipRearLeft);
+		telemetry.TireCombinedSlipRearRight = get(packet, count, GenericField_TireCombinedSlipRearRight);
+
+		telemetry.Throttle = get(packet, count, GenericField_Throttle);
+		telemetry.Brake = get(packet, count, GenericField_Brake);
+
+		telemetry.CarOrdinal = -1;
+		telemetry.CarClass = -1;
+		telemetry.CarPerformanceIndex = 0;
+		telemetry.DrivetrainType = -1;
+		telemetry.NumCylinders = 0;
+		telemetry.CarPreset = kUnknownCarPreset;
+
+		telemetry.Source = TelemetrySource_Generic;
+		DeriveTelemetry(telemetry);
+	}
+};
+
+// The magic, a version this decoder reads and a length that holds the floats the header announces.
+inline bool IsGenericPacket(const char* data, size_t length) {
+	if (length < kGenericHeaderSize || data[0] != kGenericPacketMagic[0] || data[1] != kGenericPacketMagic[1] ||
+		data[2] != kGenericPacketMagic[2] || data[3] != kGenericPacketMagic[3]) {
+		return false;
+	}
+	PacketView packet(data, length);
+	return packet.read<uint16_t>(4) == kGenericPacketVersion &&
+		length >= kGenericHeaderSize + GenericDecoder::fieldCount(packet) * sizeof(float);
+}
+
+inline bool DecodeGenericPacket(const char* data, size_t length, TelemetryData& telemetry) {
+	if (!IsGenericPacket(data, length)) {
+		return false;
+	}
+	GenericDecoder::decode(PacketView(data, length), telemetry);
+	return true;
+}
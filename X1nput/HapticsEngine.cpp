@@ -0,0 +1,141 @@
+﻿#include "HapticsEngine.h"
+
+HapticsOutput HapticsEngine::compute(const TelemetryData* telemetryPtr, const HapticsInput& input, HapticsState& state) const {
+	HapticsOutput output;
+
+	// 依車型選擇效果 The car's preset; without telemetry only the limits of [Effects] apply.
+	const EffectProgram& program = telemetryPtr != nullptr ? effects.forCar(telemetryPtr->CarPreset) : effects.base();
+
+	output.LeftMotor = input.LeftRumble * settings.LMotorStrength;
+	output.RightMotor = input.RightRumble * settings.RMotorStrength;
+	output.LeftTrigger = 0;
+	output.RightTrigger = 0;
+
+	if (telemetryPtr != nullptr && wantsTelemetry(state, input)) {
+		const TelemetryData& telemetry = *telemetryPtr;
+
+		float CRPM = telemetry.CurrentEngineRpm;   // 返回當前轉速(0:暫停遊戲), Return the current RPM (0: game is paused).
+
+		if (CRPM == 0) { // CRPM為當前引擎轉速，0:遊戲暫停中，自訂震動暫停, CRPM is the current engine RPM, 0: game is paused, custom vibration is paused.
+			output.LeftMotor = input.LeftRumble * settings.LMotorStrength;
+			output.RightMotor = input.RightRumble * settings.RMotorStrength;
+			output.LeftTrigger = 0;
+			output.RightTrigger = 0;
+		}
+		else {
+			double registers[kMaxEffectRegisters];
+			registers[EffectSignal_LeftTrigger] = input.LeftTrigger;
+			registers[EffectSignal_RightTrigger] = input.RightTrigger;
+			registers[EffectSignal_LeftRumble] = input.LeftRumble;
+			registers[EffectSignal_RightRumble] = input.RightRumble;
+			registers[EffectSignal_GameLeftMotor] = input.LeftRumble * settings.LMotorStrength;
+			registers[EffectSignal_GameRightMotor] = input.RightRumble * settings.RMotorStrength;
+
+			registers[EffectSignal_LeftMotor] = output.LeftMotor;
+			registers[EffectSignal_RightMotor] = output.RightMotor;
+			registers[EffectSignal_LeftImpulse] = output.LeftTrigger;
+			registers[EffectSignal_RightImpulse] = output.RightTrigger;
+
+			program.run(registers, telemetry);
+
+			output.LeftMotor = registers[EffectSignal_LeftMotor];
+			output.RightMotor = registers[EffectSignal_RightMotor];
+			output.LeftTrigger = registers[EffectSignal_LeftImpulse];
+			output.RightTrigger = registers[EffectSignal_RightImpulse];
+
+			state.Engaged = true; //通過檢查，無條件開啟板機震動, Enable trigger vibration unconditionally through checks.
+		}
+	}
+
+	if (output.LeftMotor > program.MotorLimit) { output.LeftMotor = program.MotorLimit; }
+	if (output.RightMotor > program.MotorLimit) { output.RightMotor = program.MotorLimit; }
+	if (output.LeftTrigger > program.TriggerLimit) { output.LeftTrigger = program.TriggerLimit; }
+	if (output.RightTrigger > program.TriggerLimit) { output.RightTrigger = program.TriggerLimit; }
+
+	output.LeftTrigger = output.LeftTrigger * settings.LTriggerStrength;
+	output.RightTrigger = output.RightTrigger * settings.RTriggerStrength;
+
+	return output;
+}
+
+HapticsOutput ComputeHapticsReference(const TelemetryData* telemetryPtr, const HapticsInput& input, const HapticsSettings& settings, HapticsState& state) {
+	HapticsOutput vibration;
+
+	float LSpeed = input.LeftRumble;
+	float RSpeed = input.RightRumble;
+
+	vibration.LeftMotor = LSpeed * settings.LMotorStrength;
+	vibration.RightMotor = RSpeed * settings.RMotorStrength;
+	vibration.LeftTrigger = 0;
+	vibration.RightTrigger = 0;
+
+	if (telemetryPtr != nullptr && (state.Engaged || LSpeed > 0.1)) {
+		float Slip = telemetryPtr->Slip;
+		float NRPM = telemetryPtr->NRPM;
+		float CRPM = telemetryPtr->CurrentEngineRpm;
+		float Acceleration = telemetryPtr->Acceleration;
+		int Gear = telemetryPtr->Gear;
+		float BUMP = 0;
+
+		if (CRPM == 0) { // 0:遊戲暫停中，自訂震動暫停, 0: game is paused, custom vibration is paused.
+			vibration.LeftMotor = LSpeed * settings.LMotorStrength;
+			vibration.RightMotor = RSpeed * settings.RMotorStrength;
+			vibration.LeftTrigger = 0;
+			vibration.RightTrigger = 0;
+		}
+		else {
+			if (Acceleration > 10 && input.LeftTrigger < 0.1) {
+				BUMP = 0.3;
+				if (Acceleration > 15 && Acceleration < 30) {
+					BUMP = 0.5;
+				}
+				if (Acceleration > 30) {
+					BUMP = 0.7;
+				}
+				vibration.LeftMotor += BUMP;
+				vibration.RightMotor += BUMP;
+			}
+			else {
+				BUMP = 0;
+			}
+
+			if (input.LeftTrigger > 0.1) {
+				if (Slip > 1) {   //滑移率(>1，打滑，則震動), Slip rate (> 1, slipping, then vibrate).
+					vibration.LeftTrigger = 0.1 * LSpeed + BUMP + 0.3;
+					vibration.LeftMotor += 0.3;
+					vibration.RightMotor += 0.3;
+				}
+			}
+
+			float RightTrigger_level = 0.5 * (std::exp(4 * NRPM + 0.01) / 60) + BUMP; // exponential function
+
+			if (RightTrigger_level > 0.5) {
+				vibration.RightTrigger = 0.5;
+				if (BUMP > 0.3) {
+					vibration.RightTrigger = 0.7;
+				}
+			}
+			else {
+				vibration.RightTrigger = 0.1 * RSpeed + RightTrigger_level;
+			}
+
+			if (Gear == 0 && input.RightTrigger > 0.3) {
+				vibration.LeftMotor = 0.5 + LSpeed * settings.LMotorStrength;
+				vibration.RightMotor = 0.5 + RSpeed * settings.RMotorStrength;
+				vibration.LeftTrigger = 0.4;
+				vibration.RightTrigger = 0.4;
+			}
+			state.Engaged = true;
+		}
+	}
+
+	if (vibration.LeftMotor > 0.85) { vibration.LeftMotor = 0.85; }
+	if (vibration.RightMotor > 0.85) { vibration.RightMotor = 0.85; }
+	if (vibration.LeftTrigger > 0.7) { vibration.LeftTrigger = 0.7; }
+	if (vibration.RightTrigger > 0.7) { vibration.RightTrigger = 0.7; }
+
+	vibration.LeftTrigger = vibration.LeftTrigger * settings.LTriggerStrength;
+	vibration.RightTrigger = vibration.RightTrigger * settings.RTriggerStrength;
+
+	return vibration;
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include "EffectGraph.h"
+#include "EffectPresets.h"
+#include "TelemetryData.h"
+
+#include <cmath>
+
+/*
+	Platform-independent haptics effects.
+
+	compute() is a pure function of its arguments: the telemetry snapshot, the
+	trigger positions, the game's own rumble request and the per-pad state. It does
+	not touch COM or any globals, so it can be profiled and tested on its own. The
+	effects themselves (BUMP, ABS/slip, RPM and reverse gear by default) are an
+	EffectProgram compiled from X1nput.ini, see EffectGraph.h, picked per car
+	class and drivetrain from EffectPresets.
+*/
+
+// 強度設定 Strength settings from X1nput.ini.
+struct HapticsSettings {
+	float LTriggerStrength = 0.25f;
+	float RTriggerStrength = 0.25f;
+	float LMotorStrength = 1.0f;
+	float RMotorStrength = 1.0f;
+};
+
+struct HapticsInput {
+	float LeftTrigger;  // 板機深度 Trigger positions from the last reading, 0..1
+	float RightTrigger;
+	float LeftRumble;   // 遊戲的震動要求 Rumble requested by the game, 0..1
+	float RightRumble;
+};
+
+// Same units as Windows.Gaming.Input GamepadVibration.
+struct HapticsOutput {
+	double LeftMotor;
+	double RightMotor;
+	double LeftTrigger;
+	double RightTrigger;
+};
+
+// True if any channel moved by more than threshold since the last output.
+inline bool VibrationChanged(const HapticsOutput& previous, const HapticsOutput& current, double threshold) {
+	return std::fabs(current.LeftMotor - previous.LeftMotor) > threshold ||
+		std::fabs(current.RightMotor - previous.RightMotor) > threshold ||
+		std::fabs(current.LeftTrigger - previous.LeftTrigger) > threshold ||
+		std::fabs(current.RightTrigger - previous.RightTrigger) > threshold;
+}
+
+// 每個手把的狀態 State carried from one frame to the next.
+struct HapticsState {
+	bool Engaged = false; // 通過檢查後保持開啟 Set once telemetry effects have run; keeps them on even when the game stops rumbling.
+};
+
+class HapticsEngine {
+public:
+	explicit HapticsEngine(const HapticsSettings& settings = HapticsSettings(), const EffectPresets& effects = EffectPresets())
+		: settings(settings), effects(effects) {}
+
+	const HapticsSettings& getSettings() const { return settings; }
+	void setSettings(const HapticsSettings& value) { settings = value; }
+
+	const EffectPresets& getEffects() const { return effects; }
+	void setEffects(const EffectPresets& value) { effects = value; }
+
+	// True when the telemetry effects should run (and the telemetry reader is needed).
+	static bool wantsTelemetry(const HapticsState& state, const HapticsInput& input) {
+		return state.Engaged || input.LeftRumble > 0.1;
+	}
+
+	// telemetry may be null when wantsTelemetry() is false; only the game's rumble is passed through then.
+	HapticsOutput compute(const TelemetryData* telemetry, const HapticsInput& input, HapticsState& state) const;
+
+private:
+	HapticsSettings settings;
+	EffectPresets effects;
+};
+
+// 原本的效果 The effects as XInputSetState had them hand-written, kept as the reference for the golden tests and
+// x1nput-bench. HapticsEngine with ClassicEffectProgram() gives the same output, up to FastExp's rounding.
+HapticsOutput ComputeHapticsReference(const TelemetryData* telemetry, const HapticsInput& input, const HapticsSettings& settings, HapticsState& state);
@@ -0,0 +1,229 @@
+#include "HapticsFilter.h"
+
+#include "FastMath.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define X1NPUT_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define X1NPUT_NEON 1
+#include <arm_neon.h>
+#endif
+
+static bool PassesThrough(const HapticsFilterSettings& settings) {
+	return settings.attackMs <= 0.f && settings.releaseMs <= 0.f && settings.smoothingMs <= 0.f && settings.slewRate <= 0.f;
+}
+
+bool HapticsFilterOptions::enabled() const {
+	return !PassesThrough(motors) || !PassesThrough(triggers);
+}
+
+// Share of the remaining distance a one-pole stage covers in one step, as a coefficient.
+static int32_t OnePole(float timeConstantMs, double stepSeconds) {
+	if (timeConstantMs <= 0.f) {
+		return kHapticsFilterOne - 1;
+	}
+	double share = 1.0 - FastExp(-stepSeconds * 1000.0 / timeConstantMs);
+	return std::max(0, std::min(static_cast<int32_t>(share * kHapticsFilterOne + 0.5) - 1, kHapticsFilterOne - 1));
+}
+
+static int32_t SlewStep(float slewRate, double stepSeconds) {
+	if (slewRate <= 0.f) {
+		return kHapticsFilterOne - 1;
+	}
+	return std::max(1, static_cast<int32_t>(std::min(slewRate * stepSeconds, 1.0) * (kHapticsFilterOne - 1) + 0.5));
+}
+
+HapticsFilterCoefficients ComputeFilterCoefficients(const HapticsFilterOptions& options, double stepSeconds) {
+	stepSeconds = std::max(0.0, stepSeconds);
+
+	HapticsFilterCoefficients coefficients;
+	const HapticsFilterSettings* const groups[2] = { &options.motors, &options.triggers };  // Channels 0-1 and 2-3
+	for (size_t group = 0; group < 2; ++group) {
+		const HapticsFilterSettings& settings = *groups[group];
+		int32_t attack = OnePole(settings.attackMs, stepSeconds);
+		int32_t release = OnePole(settings.releaseMs, stepSeconds);
+		int32_t smoothing = OnePole(settings.smoothingMs, stepSeconds);
+		int32_t slew = SlewStep(settings.slewRate, stepSeconds);
+		for (size_t channel = 2 * group; channel < 2 * group + 2; ++channel) {
+			coefficients.attack[channel] = attack;
+			coefficients.release[channel] = release;
+			coefficients.smoothing[channel] = smoothing;
+			coefficients.slew[channel] = slew;
+		}
+	}
+	return coefficients;
+}
+
+// state + (target - state) * (coefficient + 1) / 2^15, rounded. A step that rounds to 0 short of the target is one
+// LSB instead, so a slow stage still reaches its target rather than stalling up to 2^14 / (coefficient + 1) from it.
+static inline int32_t Approach(int32_t state, int32_t target, int32_t coefficient) {
+	int32_t difference = target - state;
+	int32_t step = (difference * coefficient + difference + (1 << 14)) >> 15;
+	return state + (step != 0 ? step : (difference > 0) - (difference < 0));
+}
+
+void FilterHapticsScalar(const HapticsFilterCoefficients& coefficients, HapticsFilterState* states, HapticsOutput* outputs, size_t count) {
+	const int32_t top = kHapticsFilterOne - 1;
+
+	for (size_t pad = 0; pad < count; ++pad) {
+		HapticsFilterState& state = states[pad];
+		HapticsOutput& output = outputs[pad];
+		double values[kHapticsChannels] = { output.LeftMotor, output.RightMotor, output.LeftTrigger, output.RightTrigger };
+
+		for (size_t channel = 0; channel < kHapticsChannels; ++channel) {
+			// NaN reads as 0.
+			double value = values[channel] > 0.0 ? std::min(values[channel], 1.0) : 0.0;
+			int32_t target = static_cast<int32_t>(value * top + 0.5);
+
+			// Attack while the target is above the envelope, release otherwise, picked with a mask.
+			int32_t rising = -static_cast<int32_t>(target > state.envelope[channel]);
+			int32_t coefficient = (coefficients.attack[channel] & rising) | (coefficients.release[channel] & ~rising);
+			state.envelope[channel] = Approach(state.envelope[channel], target, coefficient);
+
+			state.smooth[channel] = Approach(state.smooth[channel], state.envelope[channel], coefficients.smoothing[channel]);
+
+			int32_t limit = coefficients.slew[channel];
+			int32_t step = std::max(-limit, std::min(state.smooth[channel] - state.output[channel], limit));
+			state.output[channel] += step;
+
+			values[channel] = state.output[channel] * (1.0 / top);
+		}
+
+		output.LeftMotor = values[0];
+		output.RightMotor = values[1];
+		output.LeftTrigger = values[2];
+		output.RightTrigger = values[3];
+	}
+}
+
+#if defined(X1NPUT_SSE2)
+
+static inline __m128i Select(__m128i mask, __m128i whenSet, __m128i whenClear) {
+	return _mm_or_si128(_mm_and_si128(mask, whenSet), _mm_andnot_si128(mask, whenClear));
+}
+
+// Approach() on four channels. SSE2 has no 32-bit multiply, but the difference and the coefficient both fit
+// 16 bits: _mm_madd_epi16 multiplies the low halves and adds the high half of the difference (its sign) times the
+// high half of the coefficient, which is 0.
+static inline __m128i Approach(__m128i state, __m128i target, __m128i coefficient) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i difference = _mm_sub_epi32(target, state);
+	__m128i product = _mm_add_epi32(_mm_madd_epi16(difference, coefficient), difference);
+	__m128i step = _mm_srai_epi32(_mm_add_epi32(product, _mm_set1_epi32(1 << 14)), 15);
+	// The comparisons are -1 where true: sign = -1, 0 or 1.
+	__m128i sign = _mm_sub_epi32(_mm_cmplt_epi32(difference, zero), _mm_cmpgt_epi32(difference, zero));
+	return _mm_add_epi32(state, Select(_mm_cmpeq_epi32(step, zero), sign, step));
+}
+
+#elif defined(X1NPUT_NEON)
+
+// Approach() on four channels, with vrshrq_n_s32 as the rounded shift; coefficient is already plus one.
+static inline int32x4_t Approach(int32x4_t state, int32x4_t target, int32x4_t coefficient) {
+	const int32x4_t zero = vdupq_n_s32(0);
+	int32x4_t difference = vsubq_s32(target, state);
+	int32x4_t step = vrshrq_n_s32(vmulq_s32(difference, coefficient), 15);
+	// The comparisons are all ones where true: sign = -1, 0 or 1.
+	int32x4_t sign = vsubq_s32(vreinterpretq_s32_u32(vcltq_s32(difference, zero)), vreinterpretq_s32_u32(vcgtq_s32(difference, zero)));
+	return vaddq_s32(state, vbslq_s32(vceqq_s32(step, zero), sign, step));
+}
+
+#endif
+
+void FilterHaptics(const HapticsFilterCoefficients& coefficients, HapticsFilterState* states, HapticsOutput* outputs, size_t count) {
+#if defined(X1NPUT_SSE2)
+	const __m128i attack = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients.attack));
+	const __m128i release = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients.release));
+	const __m128i smoothing = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients.smoothing));
+	const __m128i slew = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients.slew));
+	const __m128i negativeSlew = _mm_sub_epi32(_mm_setzero_si128(), slew);
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d top = _mm_set1_pd(kHapticsFilterOne - 1);
+	const __m128d half = _mm_set1_pd(0.5);
+	const __m128d scale = _mm_set1_pd(1.0 / (kHapticsFilterOne - 1));
+
+	for (size_t pad = 0; pad < count; ++pad) {
+		HapticsFilterState& state = states[pad];
+		HapticsOutput& output = outputs[pad];
+
+		// _mm_max_pd returns its second operand for NaN, so NaN reads as 0 like the scalar version.
+		__m128d motors = _mm_min_pd(_mm_max_pd(_mm_set_pd(output.RightMotor, output.LeftMotor), zero), one);
+		__m128d triggers = _mm_min_pd(_mm_max_pd(_mm_set_pd(output.RightTrigger, output.LeftTrigger), zero), one);
+		__m128i target = _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(motors, top), half)),
+			_mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(triggers, top), half)));
+
+		__m128i envelope = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.envelope));
+		__m128i smooth = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.smooth));
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.output));
+
+		envelope = Approach(envelope, target, Select(_mm_cmpgt_epi32(target, envelope), attack, release));
+		smooth = Approach(smooth, envelope, smoothing);
+
+		__m128i step = _mm_sub_epi32(smooth, value);
+		step = Select(_mm_cmpgt_epi32(step, slew), slew, step);
+		step = Select(_mm_cmplt_epi32(step, negativeSlew), negativeSlew, step);
+		value = _mm_add_epi32(value, step);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state.envelope), envelope);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state.smooth), smooth);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state.output), value);
+
+		motors = _mm_mul_pd(_mm_cvtepi32_pd(value), scale);
+		triggers = _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(value, value)), scale);
+		_mm_storel_pd(&output.LeftMotor, motors);
+		_mm_storeh_pd(&output.RightMotor, motors);
+		_mm_storel_pd(&output.LeftTrigger, triggers);
+		_mm_storeh_pd(&output.RightTrigger, triggers);
+	}
+#elif defined(X1NPUT_NEON)
+	const int32x4_t attack = vld1q_s32(coefficients.attack);
+	const int32x4_t release = vld1q_s32(coefficients.release);
+	const int32x4_t smoothing = vaddq_s32(vld1q_s32(coefficients.smoothing), vdupq_n_s32(1));
+	const int32x4_t slew = vld1q_s32(coefficients.slew);
+	const int32x4_t negativeSlew = vnegq_s32(slew);
+	const float64x2_t zero = vdupq_n_f64(0.0);
+	const float64x2_t one = vdupq_n_f64(1.0);
+	const float64x2_t top = vdupq_n_f64(kHapticsFilterOne - 1);
+	const float64x2_t half = vdupq_n_f64(0.5);
+	const float64x2_t scale = vdupq_n_f64(1.0 / (kHapticsFilterOne - 1));
+
+	for (size_t pad = 0; pad < count; ++pad) {
+		HapticsFilterState& state = states[pad];
+		HapticsOutput& output = outputs[pad];
+
+		// vmaxnmq_f64 returns the number when the other operand is NaN, so NaN reads as 0.
+		float64x2_t motors = vminq_f64(vmaxnmq_f64(vcombine_f64(vdup_n_f64(output.LeftMotor), vdup_n_f64(output.RightMotor)), zero), one);
+		float64x2_t triggers = vminq_f64(vmaxnmq_f64(vcombine_f64(vdup_n_f64(output.LeftTrigger), vdup_n_f64(output.RightTrigger)), zero), one);
+		int32x4_t target = vcombine_s32(
+			vmovn_s64(vcvtq_s64_f64(vaddq_f64(vmulq_f64(motors, top), half))),
+			vmovn_s64(vcvtq_s64_f64(vaddq_f64(vmulq_f64(triggers, top), half))));
+
+		int32x4_t envelope = vld1q_s32(state.envelope);
+		int32x4_t smooth = vld1q_s32(state.smooth);
+		int32x4_t value = vld1q_s32(state.output);
+
+		int32x4_t coefficient = vaddq_s32(vbslq_s32(vcgtq_s32(target, envelope), attack, release), vdupq_n_s32(1));
+		envelope = Approach(envelope, target, coefficient);
+		smooth = Approach(smooth, envelope, smoothing);
+
+		value = vaddq_s32(value, vmaxq_s32(negativeSlew, vminq_s32(vsubq_s32(smooth, value), slew)));
+
+		vst1q_s32(state.envelope, envelope);
+		vst1q_s32(state.smooth, smooth);
+		vst1q_s32(state.output, value);
+
+		motors = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(value))), scale);
+		triggers = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_high_s32(value))), scale);
+		output.LeftMotor = vgetq_lane_f64(motors, 0);
+		output.RightMotor = vgetq_lane_f64(motors, 1);
+		output.LeftTrigger = vgetq_lane_f64(triggers, 0);
+		output.RightTrigger = vgetq_lane_f64(triggers, 1);
+	}
+#else
+	FilterHapticsScalar(coefficients, states, outputs, count);
+#endif
+}
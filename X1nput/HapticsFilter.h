@@ -0,0 +1,78 @@
+#pragma once
+
+#include "HapticsEngine.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+	Smoothing between the effects and put_Vibration.
+
+	The effects jump: a threshold effect switches a trigger fully on or off, a
+	step in Speed moves a motor by half its range from one frame to the next.
+	Every channel (both motors and both triggers of every pad) goes through
+	three stages before it is sent:
+
+		envelope   follows the effect output with a rise time constant
+		           (attackMs) while it grows and a fall one (releaseMs) while it
+		           shrinks, so a kick can start at once and still fade out
+		low-pass   one-pole filter with time constant smoothingMs on top
+		slew       the output moves at most slewRate (full scale per second)
+
+	A time constant of 0 passes the stage through, so the default settings send
+	the effect output unchanged.
+
+	The channels are Q15 fixed point (32767 is full scale) and the time
+	constants are turned into Q15 coefficients once per pass from the time since
+	the last one, so the per-channel work is a few integer multiplies, shifts and
+	min/max with no branches. FilterHaptics() does the four channels of a pad in
+	one SSE2 or NEON register and runs every pad of the output thread in one
+	loop over one array, with no allocation.
+*/
+
+// [Smoothing] settings of one kind of channel.
+struct HapticsFilterSettings {
+	float attackMs = 0.f;     // Envelope rise time constant
+	float releaseMs = 0.f;    // Envelope fall time constant
+	float smoothingMs = 0.f;  // Low-pass time constant
+	float slewRate = 0.f;     // Largest change per second (1 is the full range), 0 for no limit
+};
+
+struct HapticsFilterOptions {
+	HapticsFilterSettings motors;
+	HapticsFilterSettings triggers;
+
+	// False when every stage passes through and FilterHaptics() would change nothing.
+	bool enabled() const;
+};
+
+// Channels of one pad, in the order of HapticsOutput.
+constexpr size_t kHapticsChannels = 4;
+
+constexpr int32_t kHapticsFilterOne = 1 << 15;
+
+// Per-channel coefficients for one pass, from HapticsFilterOptions and the time step. A one-pole coefficient c
+// covers (c + 1) / 2^15 of the distance to its input per pass, so 32767 passes the input through.
+struct HapticsFilterCoefficients {
+	int32_t attack[kHapticsChannels];
+	int32_t release[kHapticsChannels];
+	int32_t smoothing[kHapticsChannels];
+	int32_t slew[kHapticsChannels];      // Largest step of the output, 32767 for none
+};
+
+// Filter state of one pad. Zero is silence.
+struct HapticsFilterState {
+	int32_t envelope[kHapticsChannels] = {};
+	int32_t smooth[kHapticsChannels] = {};
+	int32_t output[kHapticsChannels] = {};
+};
+
+// stepSeconds is the time since the previous pass; after a long one (the first pass, a pad that was
+// idle) every stage catches up with its target in that pass.
+HapticsFilterCoefficients ComputeFilterCoefficients(const HapticsFilterOptions& options, double stepSeconds);
+
+// Filters count pads: outputs[i] is replaced by its filtered value and states[i] advanced one step.
+void FilterHaptics(const HapticsFilterCoefficients& coefficients, HapticsFilterState* states, HapticsOutput* outputs, size_t count);
+
+// FilterHaptics() one channel at a time, the reference for the SIMD versions. Both give the same results.
+void FilterHapticsScalar(const HapticsFilterCoefficients& coefficients, HapticsFilterState* states, HapticsOutput* outputs, size_t count);
@@ -0,0 +1,104 @@
+#include "IniFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+static std::string Trim(const std::string& text) {
+	size_t begin = text.find_first_not_of(" \t\r\n");
+	if (begin == std::string::npos) {
+		return std::string();
+	}
+	size_t end = text.find_last_not_of(" \t\r\n");
+	return text.substr(begin, end - begin + 1);
+}
+
+static std::string ToLower(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return text;
+}
+
+static std::string MakeKey(const std::string& section, const std::string& key) {
+	return ToLower(section) + '\n' + ToLower(key);
+}
+
+bool IniFile::load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		values.clear();
+		return false;
+	}
+
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+		text.erase(0, 3);
+	}
+	parse(text);
+	return true;
+}
+
+void IniFile::parse(const std::string& text) {
+	values.clear();
+
+	std::istringstream lines(text);
+	std::string line;
+	std::string section;
+
+	while (std::getline(lines, line)) {
+		line = Trim(line);
+		if (line.empty() || line[0] == ';') {
+			continue;
+		}
+
+		if (line[0] == '[') {
+			size_t close = line.find(']');
+			section = Trim(line.substr(1, close == std::string::npos ? std::string::npos : close - 1));
+			continue;
+		}
+
+		size_t equals = line.find('=');
+		if (equals == std::string::npos) {
+			continue;
+		}
+
+		std::string value = Trim(line.substr(equals + 1));
+		if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+			value = value.substr(1, value.size() - 2);
+		}
+		values.emplace_back(MakeKey(section, Trim(line.substr(0, equals))), value);
+	}
+
+	// Stable, so the first of several duplicate keys is still found first, like GetPrivateProfileString.
+	std::stable_sort(values.begin(), values.end(), [](const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b) {
+		return a.first < b.first;
+	});
+}
+
+const std::string* IniFile::find(const char* section, const char* key) const {
+	std::string wanted = MakeKey(section, key);
+	auto it = std::lower_bound(values.begin(), values.end(), wanted, [](const std::pair<std::string, std::string>& entry, const std::string& name) {
+		return entry.first < name;
+	});
+	return it != values.end() && it->first == wanted ? &it->second : nullptr;
+}
+
+std::string IniFile::getString(const char* section, const char* key, const char* defaultValue) const {
+	const std::string* value = find(section, key);
+	return value != nullptr ? *value : std::string(defaultValue);
+}
+
+float IniFile::getFloat(const char* section, const char* key, const char* defaultValue) const {
+	return static_cast<float>(std::atof(getString(section, key, defaultValue).c_str()));
+}
+
+int IniFile::getInt(const char* section, const char* key, int defaultValue) const {
+	const std::string* value = find(section, key);
+	return value != nullptr ? static_cast<int>(std::strtol(value->c_str(), nullptr, 10)) : defaultValue;
+}
+
+bool IniFile::getBool(const char* section, const char* key, const char* defaultValue) const {
+	return ToLower(getString(section, key, defaultValue)) == "true";
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+	An INI file read in one go. Lookups are answered from memory with the same rules
+	as GetPrivateProfileString: case-insensitive names, trimmed values, surrounding
+	quotes removed, and the first of several duplicate keys wins.
+*/
+class IniFile {
+public:
+	// Reads and parses path. Returns false if the file can't be read; lookups then return their defaults.
+	bool load(const std::string& path);
+	void parse(const std::string& text);
+
+	std::string getString(const char* section, const char* key, const char* defaultValue) const;
+	float getFloat(const char* section, const char* key, const char* defaultValue) const;
+	int getInt(const char* section, const char* key, int defaultValue) const;
+	bool getBool(const char* section, const char* key, const char* defaultValue) const;
+
+private:
+	std::vector<std::pair<std::string, std::string>> values; // "section\nkey" (lower case) -> value, sorted
+
+	const std::string* find(const char* section, const char* key) const;
+};
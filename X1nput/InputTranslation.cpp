@@ -0,0 +1,233 @@
+#include "InputTranslation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define X1NPUT_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define X1NPUT_NEON 1
+#include <arm_neon.h>
+#endif
+
+// XInput button bits (XINPUT_GAMEPAD_*)
+enum : uint16_t {
+	XButton_DPadUp = 0x0001,
+	XButton_DPadDown = 0x0002,
+	XButton_DPadLeft = 0x0004,
+	XButton_DPadRight = 0x0008,
+	XButton_Start = 0x0010,
+	XButton_Back = 0x0020,
+	XButton_LeftThumb = 0x0040,
+	XButton_RightThumb = 0x0080,
+	XButton_LeftShoulder = 0x0100,
+	XButton_RightShoulder = 0x0200,
+	XButton_A = 0x1000,
+	XButton_B = 0x2000,
+	XButton_X = 0x4000,
+	XButton_Y = 0x8000,
+};
+
+// XInput bit for each GamepadButtons bit, lowest first.
+static constexpr uint16_t kButtonMap[16] = {
+	XButton_Start, XButton_Back, XButton_A, XButton_B,
+	XButton_X, XButton_Y, XButton_DPadUp, XButton_DPadDown,
+	XButton_DPadLeft, XButton_DPadRight, XButton_LeftShoulder, XButton_RightShoulder,
+	XButton_LeftThumb, XButton_RightThumb, 0, 0, // Paddles have no XInput equivalent
+};
+
+struct ButtonTables {
+	uint16_t nibble[4][16];
+};
+
+static constexpr ButtonTables MakeButtonTables() {
+	ButtonTables tables = {};
+	for (int n = 0; n < 4; ++n) {
+		for (int value = 0; value < 16; ++value) {
+			uint16_t bits = 0;
+			for (int bit = 0; bit < 4; ++bit) {
+				if (value & (1 << bit)) {
+					bits |= kButtonMap[n * 4 + bit];
+				}
+			}
+			tables.nibble[n][value] = bits;
+		}
+	}
+	return tables;
+}
+
+static constexpr ButtonTables kButtonTables = MakeButtonTables();
+
+float ApplyLinearDeadZone(float value, float maxValue, float deadZoneSize)
+{
+	if (value < -deadZoneSize)
+	{
+		// Increase negative values to remove the deadzone discontinuity.
+		value += deadZoneSize;
+	}
+	else if (value > deadZoneSize)
+	{
+		// Decrease positive values to remove the deadzone discontinuity.
+		value -= deadZoneSize;
+	}
+	else
+	{
+		// Values inside the deadzone come out zero.
+		return 0;
+	}
+
+	// Scale into 0-1 range.
+	float scaledValue = value / (maxValue - deadZoneSize);
+	return std::max(-1.f, std::min(scaledValue, 1.f));
+}
+
+// Applies DeadZone to thumbstick positions
+void ApplyStickDeadZone(float x, float y, DeadZone deadZoneMode, float maxValue, float deadZoneSize, float& resultX, float& resultY)
+{
+	switch (deadZoneMode)
+	{
+	case DEAD_ZONE_INDEPENDENT_AXES:
+		resultX = ApplyLinearDeadZone(x, maxValue, deadZoneSize);
+		resultY = ApplyLinearDeadZone(y, maxValue, deadZoneSize);
+		break;
+
+	case DEAD_ZONE_CIRCULAR:
+	{
+		float dist = std::sqrt(x * x + y * y);
+		float wanted = ApplyLinearDeadZone(dist, maxValue, deadZoneSize);
+
+		float scale = (wanted > 0.f) ? (wanted / dist) : 0.f;
+
+		resultX = std::max(-1.f, std::min(x * scale, 1.f));
+		resultY = std::max(-1.f, std::min(y * scale, 1.f));
+	}
+	break;
+
+	default: // GamePad::DEAD_ZONE_NONE
+		resultX = ApplyLinearDeadZone(x, maxValue, 0);
+		resultY = ApplyLinearDeadZone(y, maxValue, 0);
+		break;
+	}
+}
+
+uint16_t TranslateButtons(uint32_t buttons) {
+	return kButtonTables.nibble[0][buttons & 0xF] |
+		kButtonTables.nibble[1][(buttons >> 4) & 0xF] |
+		kButtonTables.nibble[2][(buttons >> 8) & 0xF] |
+		kButtonTables.nibble[3][(buttons >> 12) & 0xF];
+}
+
+void TranslateReadingScalar(const RawGamepadReading& state, float deadZoneSize, TranslatedGamepad& result) {
+	float LeftThumbstickX;
+	float LeftThumbstickY;
+	float RightThumbstickX;
+	float RightThumbstickY;
+
+	ApplyStickDeadZone(static_cast<float>(state.LeftThumbstickX), static_cast<float>(state.LeftThumbstickY), DEAD_ZONE_INDEPENDENT_AXES, 1.f, deadZoneSize, LeftThumbstickX, LeftThumbstickY);
+
+	ApplyStickDeadZone(static_cast<float>(state.RightThumbstickX), static_cast<float>(state.RightThumbstickY), DEAD_ZONE_INDEPENDENT_AXES, 1.f, deadZoneSize, RightThumbstickX, RightThumbstickY);
+
+	result.bRightTrigger = static_cast<uint8_t>(state.RightTrigger * 255);
+	result.bLeftTrigger = static_cast<uint8_t>(state.LeftTrigger * 255);
+	result.sThumbLX = static_cast<int16_t>((LeftThumbstickX >= 0) ? LeftThumbstickX * 32767 : LeftThumbstickX * 32768);
+	result.sThumbLY = static_cast<int16_t>((LeftThumbstickY >= 0) ? LeftThumbstickY * 32767 : LeftThumbstickY * 32768);
+	result.sThumbRX = static_cast<int16_t>((RightThumbstickX >= 0) ? RightThumbstickX * 32767 : RightThumbstickX * 32768);
+	result.sThumbRY = static_cast<int16_t>((RightThumbstickY >= 0) ? RightThumbstickY * 32767 : RightThumbstickY * 32768);
+
+	uint16_t keys = 0;
+	if ((state.Buttons & RawGamepadButtons_A) != 0) keys += XButton_A;
+	if ((state.Buttons & RawGamepadButtons_X) != 0) keys += XButton_X;
+	if ((state.Buttons & RawGamepadButtons_Y) != 0) keys += XButton_Y;
+	if ((state.Buttons & RawGamepadButtons_B) != 0) keys += XButton_B;
+
+	if ((state.Buttons & RawGamepadButtons_RightThumbstick) != 0) keys += XButton_RightThumb;
+	if ((state.Buttons & RawGamepadButtons_LeftThumbstick) != 0) keys += XButton_LeftThumb;
+	if ((state.Buttons & RawGamepadButtons_RightShoulder) != 0) keys += XButton_RightShoulder;
+	if ((state.Buttons & RawGamepadButtons_LeftShoulder) != 0) keys += XButton_LeftShoulder;
+
+	if ((state.Buttons & RawGamepadButtons_View) != 0) keys += XButton_Back;
+	if ((state.Buttons & RawGamepadButtons_Menu) != 0) keys += XButton_Start;
+
+	if ((state.Buttons & RawGamepadButtons_DPadUp) != 0) keys += XButton_DPadUp;
+	if ((state.Buttons & RawGamepadButtons_DPadDown) != 0) keys += XButton_DPadDown;
+	if ((state.Buttons & RawGamepadButtons_DPadLeft) != 0) keys += XButton_DPadLeft;
+	if ((state.Buttons & RawGamepadButtons_DPadRight) != 0) keys += XButton_DPadRight;
+	result.wButtons = keys;
+}
+
+void TranslateReading(const RawGamepadReading& state, float deadZoneSize, TranslatedGamepad& result) {
+	result.wButtons = TranslateButtons(state.Buttons);
+
+#if defined(X1NPUT_SSE2)
+	// Sticks: [LX, LY, RX, RY]
+	__m128 axes = _mm_movelh_ps(
+		_mm_cvtpd_ps(_mm_set_pd(state.LeftThumbstickY, state.LeftThumbstickX)),
+		_mm_cvtpd_ps(_mm_set_pd(state.RightThumbstickY, state.RightThumbstickX)));
+
+	const __m128 deadZone = _mm_set1_ps(deadZoneSize);
+	const __m128 negDeadZone = _mm_set1_ps(-deadZoneSize);
+	const __m128 range = _mm_set1_ps(1.f - deadZoneSize);
+	const __m128 zero = _mm_setzero_ps();
+
+	// Shift the live range back to start at zero, zero out the dead zone.
+	__m128 below = _mm_cmplt_ps(axes, negDeadZone);
+	__m128 above = _mm_cmpgt_ps(axes, deadZone);
+	__m128 shifted = _mm_or_ps(
+		_mm_and_ps(below, _mm_add_ps(axes, deadZone)),
+		_mm_and_ps(above, _mm_sub_ps(axes, deadZone)));
+	__m128 scaled = _mm_div_ps(shifted, range);
+	scaled = _mm_max_ps(_mm_set1_ps(-1.f), _mm_min_ps(scaled, _mm_set1_ps(1.f)));
+
+	// Positive values scale by 32767, negative by 32768, then truncate like the scalar cast.
+	__m128 positive = _mm_cmpge_ps(scaled, zero);
+	__m128 factor = _mm_or_ps(_mm_and_ps(positive, _mm_set1_ps(32767.f)), _mm_andnot_ps(positive, _mm_set1_ps(32768.f)));
+	__m128i quantized = _mm_cvttps_epi32(_mm_mul_ps(scaled, factor));
+	quantized = _mm_packs_epi32(quantized, quantized);
+
+	int16_t sticks[8];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sticks), quantized);
+	result.sThumbLX = sticks[0];
+	result.sThumbLY = sticks[1];
+	result.sThumbRX = sticks[2];
+	result.sThumbRY = sticks[3];
+
+	// Triggers: [Left, Right], still in double like the reading.
+	__m128i triggers = _mm_cvttpd_epi32(_mm_mul_pd(_mm_set_pd(state.RightTrigger, state.LeftTrigger), _mm_set1_pd(255.0)));
+	result.bLeftTrigger = static_cast<uint8_t>(_mm_cvtsi128_si32(triggers));
+	result.bRightTrigger = static_cast<uint8_t>(_mm_cvtsi128_si32(_mm_srli_si128(triggers, 4)));
+#elif defined(X1NPUT_NEON)
+	float32x2_t left = vcvt_f32_f64(vcombine_f64(vdup_n_f64(state.LeftThumbstickX), vdup_n_f64(state.LeftThumbstickY)));
+	float32x2_t right = vcvt_f32_f64(vcombine_f64(vdup_n_f64(state.RightThumbstickX), vdup_n_f64(state.RightThumbstickY)));
+	float32x4_t axes = vcombine_f32(left, right);
+
+	const float32x4_t deadZone = vdupq_n_f32(deadZoneSize);
+	const float32x4_t negDeadZone = vdupq_n_f32(-deadZoneSize);
+
+	uint32x4_t below = vcltq_f32(axes, negDeadZone);
+	uint32x4_t above = vcgtq_f32(axes, deadZone);
+	float32x4_t shifted = vbslq_f32(below, vaddq_f32(axes, deadZone), vbslq_f32(above, vsubq_f32(axes, deadZone), vdupq_n_f32(0.f)));
+	float32x4_t scaled = vdivq_f32(shifted, vdupq_n_f32(1.f - deadZoneSize));
+	scaled = vmaxq_f32(vdupq_n_f32(-1.f), vminq_f32(scaled, vdupq_n_f32(1.f)));
+
+	uint32x4_t positive = vcgeq_f32(scaled, vdupq_n_f32(0.f));
+	float32x4_t factor = vbslq_f32(positive, vdupq_n_f32(32767.f), vdupq_n_f32(32768.f));
+	int16x4_t quantized = vmovn_s32(vcvtq_s32_f32(vmulq_f32(scaled, factor)));
+
+	result.sThumbLX = vget_lane_s16(quantized, 0);
+	result.sThumbLY = vget_lane_s16(quantized, 1);
+	result.sThumbRX = vget_lane_s16(quantized, 2);
+	result.sThumbRY = vget_lane_s16(quantized, 3);
+
+	float64x2_t triggers = vmulq_f64(vcombine_f64(vdup_n_f64(state.LeftTrigger), vdup_n_f64(state.RightTrigger)), vdupq_n_f64(255.0));
+	int64x2_t truncated = vcvtq_s64_f64(triggers);
+	result.bLeftTrigger = static_cast<uint8_t>(vgetq_lane_s64(truncated, 0));
+	result.bRightTrigger = static_cast<uint8_t>(vgetq_lane_s64(truncated, 1));
+#else
+	TranslatedGamepad scalar;
+	TranslateReadingScalar(state, deadZoneSize, scalar);
+	uint16_t buttons = result.wButtons;
+	result = scalar;
+	result.wButtons = buttons;
+#endif
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+	Windows.Gaming.Input reading -> XInput state translation.
+
+	TranslateReading() maps the button mask through four 16-entry nibble tables
+	and runs the dead zone, clamp and quantization for all four stick axes in one
+	SSE2/NEON pass (triggers in a second, double-precision lane pair, since the
+	reading stores doubles). It is bit-exact with TranslateReadingScalar(), the
+	original per-axis code, which is kept as the reference.
+*/
+
+// DeadZone enum
+enum DeadZone
+{
+	DEAD_ZONE_INDEPENDENT_AXES = 0,
+	DEAD_ZONE_CIRCULAR,
+	DEAD_ZONE_NONE,
+};
+
+// GamepadButtons bit values from windows.gaming.input.h
+enum RawGamepadButtons : uint32_t {
+	RawGamepadButtons_Menu = 0x1,
+	RawGamepadButtons_View = 0x2,
+	RawGamepadButtons_A = 0x4,
+	RawGamepadButtons_B = 0x8,
+	RawGamepadButtons_X = 0x10,
+	RawGamepadButtons_Y = 0x20,
+	RawGamepadButtons_DPadUp = 0x40,
+	RawGamepadButtons_DPadDown = 0x80,
+	RawGamepadButtons_DPadLeft = 0x100,
+	RawGamepadButtons_DPadRight = 0x200,
+	RawGamepadButtons_LeftShoulder = 0x400,
+	RawGamepadButtons_RightShoulder = 0x800,
+	RawGamepadButtons_LeftThumbstick = 0x1000,
+	RawGamepadButtons_RightThumbstick = 0x2000,
+};
+
+// The parts of a GamepadReading that XInputGetState needs, without the WinRT types.
+struct RawGamepadReading {
+	uint32_t Buttons;
+	double LeftTrigger;
+	double RightTrigger;
+	double LeftThumbstickX;
+	double LeftThumbstickY;
+	double RightThumbstickX;
+	double RightThumbstickY;
+};
+
+// Same layout as XINPUT_GAMEPAD.
+struct TranslatedGamepad {
+	uint16_t wButtons;
+	uint8_t bLeftTrigger;
+	uint8_t bRightTrigger;
+	int16_t sThumbLX;
+	int16_t sThumbLY;
+	int16_t sThumbRX;
+	int16_t sThumbRY;
+};
+
+float ApplyLinearDeadZone(float value, float maxValue, float deadZoneSize);
+
+// Applies DeadZone to thumbstick positions
+void ApplyStickDeadZone(float x, float y, DeadZone deadZoneMode, float maxValue, float deadZoneSize, float& resultX, float& resultY);
+
+// XInput wButtons for a GamepadButtons mask.
+uint16_t TranslateButtons(uint32_t buttons);
+
+// Independent-axes dead zone on both sticks, then XInput quantization.
+void TranslateReading(const RawGamepadReading& reading, float deadZoneSize, TranslatedGamepad& result);
+
+// Reference implementation: the original branchy scalar code.
+void TranslateReadingScalar(const RawGamepadReading& reading, float deadZoneSize, TranslatedGamepad& result);
@@ -0,0 +1,171 @@
+#include "LatencyStats.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+	"LatencyStatsBlock is shared between processes, its atomics must not need a lock");
+
+LatencyStats::LatencyStats() : block(nullptr), mapping(nullptr), owner(false), nextSummaryNs(0) {
+	name[0] = '\0';
+}
+
+LatencyStats::~LatencyStats() {
+	close();
+}
+
+bool LatencyStats::open(const char* blockName) {
+	close();
+
+	void* view = nullptr;
+
+#ifdef _WIN32
+	char path[sizeof(name) + 8];
+	snprintf(path, sizeof(path), "Local\\%s", blockName);
+
+	HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(LatencyStatsBlock), path);
+	if (handle == nullptr) {
+		return false;
+	}
+	view = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(LatencyStatsBlock));
+	if (view == nullptr) {
+		CloseHandle(handle);
+		return false;
+	}
+	mapping = handle;
+#else
+	snprintf(name, sizeof(name), "/%s", blockName);
+
+	// Only the process that creates the block removes it: a second one (another game, a test) that opens the same
+	// name must not pull it from under the first when it closes.
+	bool created = true;
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0 && errno == EEXIST) {
+		created = false;
+		fd = shm_open(name, O_RDWR, 0644);
+	}
+	if (fd < 0) {
+		return false;
+	}
+	// A block left by an older version may be shorter; a longer one is kept whole.
+	struct stat info;
+	if (fstat(fd, &info) != 0 ||
+		(info.st_size < static_cast<off_t>(sizeof(LatencyStatsBlock)) && ftruncate(fd, sizeof(LatencyStatsBlock)) != 0)) {
+		::close(fd);
+		if (created) {
+			shm_unlink(name);
+		}
+		return false;
+	}
+	view = mmap(nullptr, sizeof(LatencyStatsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) {
+		if (created) {
+			shm_unlink(name);
+		}
+		return false;
+	}
+	owner = created;
+#endif
+
+	// A new mapping is zero-filled, which is also a valid empty block; the header goes in last.
+	LatencyStatsBlock* shared = static_cast<LatencyStatsBlock*>(view);
+	if (shared->magic != kLatencyStatsMagic || shared->version != kLatencyStatsVersion) {
+		std::memset(view, 0, sizeof(LatencyStatsBlock));
+		shared->stageCount = LatencyStage_Count;
+		shared->bucketCount = kLatencyBucketCount;
+		shared->subBucketBits = kLatencySubBucketBits;
+		shared->summaryIntervalMs = 1000;
+		shared->version = kLatencyStatsVersion;
+		std::atomic_thread_fence(std::memory_order_release);
+		shared->magic = kLatencyStatsMagic;
+	}
+
+	for (uint32_t stage = 0; stage < LatencyStage_Count; ++stage) {
+		for (uint32_t i = 0; i < kLatencyBucketCount; ++i) {
+			previous[stage][i] = shared->buckets[stage][i].load(std::memory_order_relaxed);
+		}
+	}
+
+	block = shared;
+	return true;
+}
+
+void LatencyStats::close() {
+	if (block == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(block);
+	CloseHandle(static_cast<HANDLE>(mapping));
+	mapping = nullptr;
+#else
+	munmap(block, sizeof(LatencyStatsBlock));
+	if (owner) {
+		shm_unlink(name);
+		owner = false;
+	}
+#endif
+	block = nullptr;
+}
+
+void LatencyStats::refreshSummary(uint64_t nowNs) {
+	uint64_t due = nextSummaryNs.load(std::memory_order_relaxed);
+	if (nowNs < due) {
+		return;
+	}
+	// Whoever moves the deadline does the work; everyone else goes back to their frame.
+	const uint64_t intervalNs = uint64_t(block->summaryIntervalMs) * 1000000;
+	if (!nextSummaryNs.compare_exchange_strong(due, nowNs + intervalNs, std::memory_order_relaxed)) {
+		return;
+	}
+
+	LatencySummary summary[LatencyStage_Count];
+	for (uint32_t stage = 0; stage < LatencyStage_Count; ++stage) {
+		uint32_t counts[kLatencyBucketCount];
+		uint64_t total = 0;
+		for (uint32_t i = 0; i < kLatencyBucketCount; ++i) {
+			uint32_t current = block->buckets[stage][i].load(std::memory_order_relaxed);
+			counts[i] = current - previous[stage][i];
+			previous[stage][i] = current;
+			total += counts[i];
+		}
+
+		LatencySummary& result = summary[stage];
+		result = LatencySummary();
+		result.count = total;
+
+		const uint64_t ranks[3] = { (total * 50 + 99) / 100, (total * 90 + 99) / 100, (total * 99 + 99) / 100 };
+		uint64_t* targets[3] = { &result.p50Ns, &result.p90Ns, &result.p99Ns };
+		uint64_t seen = 0;
+		unsigned next = 0;
+		for (uint32_t i = 0; i < kLatencyBucketCount && seen < total; ++i) {
+			if (counts[i] == 0) {
+				continue;
+			}
+			seen += counts[i];
+			for (; next < 3 && seen >= ranks[next]; ++next) {
+				*targets[next] = LatencyBucketUpperBound(i);
+			}
+			result.maxNs = LatencyBucketUpperBound(i);
+		}
+	}
+
+	uint32_t sequence = block->summarySequence.load(std::memory_order_relaxed);
+	block->summarySequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(block->summary, summary, sizeof(summary));
+	block->summarySequence.store(sequence + 2, std::memory_order_release);
+}
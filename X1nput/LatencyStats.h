@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+/*
+	Packet-to-motor latency, published in shared memory.
+
+	Four timestamps follow a telemetry packet: taken off the socket, decoded,
+	used by an output frame (XInputSetState or the output thread), and handed to
+	put_Vibration. The time between them goes into one histogram per stage.
+
+	Each histogram is log-linear like HdrHistogram: values below 16 ns have a
+	bucket each, above that every power of two is split into 16 buckets, so any
+	reading is off by at most 6.25%. Recording a value is a bit scan and one
+	relaxed atomic increment, with no lock and no allocation.
+
+	The whole LatencyStatsBlock lives in a named shared memory mapping
+	("Local\\X1nputLatency" on Windows, "/X1nputLatency" elsewhere), so an
+	overlay or a script can map it read-only. It can read the cumulative buckets
+	directly, or read the summary. The summary holds p50/p90/p99/max of the last
+	interval and is refreshed about once a second by whichever output frame
+	notices the second has passed. The layout below is versioned by
+	kLatencyStatsVersion and only ever grows at the end.
+*/
+
+enum LatencyStage : uint32_t {
+	LatencyStage_Decode,   // Received -> decoded and published by the reader thread
+	LatencyStage_Wait,     // Decoded -> picked up by an output frame (how old the data is when it is used)
+	LatencyStage_Output,   // Picked up -> put_Vibration returned (effects and the driver call)
+	LatencyStage_Total,    // Received -> put_Vibration returned
+
+	LatencyStage_Count
+};
+
+constexpr uint32_t kLatencyStatsMagic = 0x534C3158; // "X1LS"
+constexpr uint32_t kLatencyStatsVersion = 2;
+constexpr uint32_t kLatencySubBucketBits = 4;
+constexpr uint32_t kLatencyMaxExponent = 39;        // Values are clamped to 2^40 ns, about 18 minutes
+constexpr uint32_t kLatencyBucketCount = (kLatencyMaxExponent - kLatencySubBucketBits + 2) << kLatencySubBucketBits;
+
+struct LatencySummary {
+	uint64_t count;   // Values recorded during the interval
+	uint64_t p50Ns;   // Upper bound of the bucket holding the percentile
+	uint64_t p90Ns;
+	uint64_t p99Ns;
+	uint64_t maxNs;
+};
+
+struct LatencyStatsBlock {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t stageCount;
+	uint32_t bucketCount;
+	uint32_t subBucketBits;
+	uint32_t reserved;
+
+	std::atomic<uint64_t> packetsReceived;   // Datagrams taken off every telemetry socket
+	std::atomic<uint64_t> packetsDropped;    // Valid packets skipped because a newer one was queued
+	std::atomic<uint64_t> packetsMalformed;  // Datagrams that are not a known Forza packet
+	std::atomic<uint64_t> framesEmitted;     // put_Vibration calls
+
+	// Odd while the summary is being rewritten; read it, copy the summary, and retry if it changed.
+	std::atomic<uint32_t> summarySequence;
+	uint32_t summaryIntervalMs;
+	LatencySummary summary[LatencyStage_Count];
+
+	std::atomic<uint32_t> buckets[LatencyStage_Count][kLatencyBucketCount];  // Cumulative since the game started
+
+	// Version 2
+	std::atomic<uint64_t> framesSuppressed;  // Outputs the pad already played closely enough, or held back by [Output] MaxSendRate
+};
+
+// Index of the bucket holding valueNs.
+inline uint32_t LatencyBucket(uint64_t valueNs) {
+	const uint64_t linear = uint64_t(1) << kLatencySubBucketBits;
+	if (valueNs < linear) {
+		return static_cast<uint32_t>(valueNs);
+	}
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long highest;
+	_BitScanReverse64(&highest, valueNs);
+	uint32_t exponent = highest;
+#elif defined(__GNUC__)
+	uint32_t exponent = 63 - __builtin_clzll(valueNs);
+#else
+	uint32_t exponent = 63;
+	while ((valueNs >> exponent) == 0) {
+		--exponent;
+	}
+#endif
+	if (exponent > kLatencyMaxExponent) {
+		return kLatencyBucketCount - 1;
+	}
+
+	uint32_t sub = static_cast<uint32_t>(valueNs >> (exponent - kLatencySubBucketBits)) & (linear - 1);
+	return ((exponent - kLatencySubBucketBits + 1) << kLatencySubBucketBits) + sub;
+}
+
+// Largest value that falls in bucket.
+inline uint64_t LatencyBucketUpperBound(uint32_t bucket) {
+	const uint32_t linear = 1u << kLatencySubBucketBits;
+	if (bucket < linear) {
+		return bucket;
+	}
+
+	uint32_t exponent = (bucket >> kLatencySubBucketBits) + kLatencySubBucketBits - 1;
+	uint64_t sub = bucket & (linear - 1);
+	return ((linear + sub + 1) << (exponent - kLatencySubBucketBits)) - 1;
+}
+
+class LatencyStats {
+public:
+	LatencyStats();
+	~LatencyStats();
+
+	LatencyStats(const LatencyStats&) = delete;
+	LatencyStats& operator=(const LatencyStats&) = delete;
+
+	// Maps (or creates) the shared block. record() and the counters need it open; callers that run without stats
+	// hold a null LatencyStats* instead of checking on every call.
+	bool open(const char* name);
+	void close();
+	bool isOpen() const { return block != nullptr; }
+
+	static uint64_t now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void record(LatencyStage stage, uint64_t fromNs, uint64_t toNs) {
+		uint64_t elapsed = toNs > fromNs ? toNs - fromNs : 0;
+		block->buckets[stage][LatencyBucket(elapsed)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void countReceived(uint64_t count) { block->packetsReceived.fetch_add(count, std::memory_order_relaxed); }
+	void countDropped(uint64_t count) { block->packetsDropped.fetch_add(count, std::memory_order_relaxed); }
+	void countMalformed(uint64_t count) { block->packetsMalformed.fetch_add(count, std::memory_order_relaxed); }
+	void countFrame() { block->framesEmitted.fetch_add(1, std::memory_order_relaxed); }
+	void countSuppressed() { block->framesSuppressed.fetch_add(1, std::memory_order_relaxed); }
+
+	// Rewrites the summary if the interval has passed. Cheap to call on every frame; only one caller does the work.
+	void refreshSummary(uint64_t nowNs);
+
+	const LatencyStatsBlock* data() const { return block; }
+
+private:
+	LatencyStatsBlock* block;
+	void* mapping;  // Windows file mapping handle
+	bool owner;     // This process created the block (O_EXCL) and removes it on close (POSIX)
+	char name[64];
+
+	std::atomic<uint64_t> nextSummaryNs;
+	uint32_t previous[LatencyStage_Count][kLatencyBucketCount];  // Bucket counts at the last summary, refresh winner only
+};
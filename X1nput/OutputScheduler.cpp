@@ -0,0 +1,83 @@
+#include "OutputScheduler.h"
+
+#include <chrono>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Wake this long before a deadline and spin the rest, to absorb OS sleep granularity.
+static const std::chrono::microseconds kSpinMargin(200);
+
+OutputScheduler::OutputScheduler() : running(false), tickCount(0), overrunCount(0) {
+}
+
+OutputScheduler::~OutputScheduler() {
+	stop();
+}
+
+bool OutputScheduler::start(unsigned rateHz, Callback onTick, Callback onThreadStart, Callback onThreadExit) {
+	if (rateHz == 0 || !onTick || running.exchange(true)) {
+		return false;
+	}
+
+	thread = std::thread(&OutputScheduler::run, this, rateHz, onTick, onThreadStart, onThreadExit);
+	return true;
+}
+
+void OutputScheduler::stop() {
+	running.store(false, std::memory_order_release);
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void OutputScheduler::run(unsigned rateHz, Callback onTick, Callback onThreadStart, Callback onThreadExit) {
+	typedef std::chrono::steady_clock Clock;
+
+#ifdef _WIN32
+	// Default Windows timer resolution is ~15.6 ms, far too coarse for a 250+ Hz loop.
+	timeBeginPeriod(1);
+#endif
+
+	if (onThreadStart) {
+		onThreadStart();
+	}
+
+	const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000ull / rateHz));
+	Clock::time_point deadline = Clock::now();
+
+	while (running.load(std::memory_order_acquire)) {
+		onTick();
+		tickCount.fetch_add(1, std::memory_order_relaxed);
+
+		deadline += period;
+		Clock::time_point now = Clock::now();
+
+		if (now > deadline + period) {
+			// Fell behind (callback stalled or the thread was descheduled): start a new timeline.
+			overrunCount.fetch_add(1, std::memory_order_relaxed);
+			deadline = now;
+			continue;
+		}
+
+		if (deadline - now > kSpinMargin) {
+			std::this_thread::sleep_until(deadline - kSpinMargin);
+		}
+		while (Clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+	}
+
+	if (onThreadExit) {
+		onThreadExit();
+	}
+
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+/*
+	Runs a callback at a fixed rate on its own thread.
+
+	Ticks are scheduled on an absolute steady_clock timeline (start + n * period) so
+	the rate does not drift with the time spent inside the callback. The thread sleeps
+	until shortly before each deadline and spins for the rest, which keeps jitter
+	well below a millisecond. If a tick runs late the timeline is re-anchored instead
+	of firing a burst of catch-up ticks.
+*/
+class OutputScheduler {
+public:
+	typedef std::function<void()> Callback;
+
+	OutputScheduler();
+	~OutputScheduler();
+
+	OutputScheduler(const OutputScheduler&) = delete;
+	OutputScheduler& operator=(const OutputScheduler&) = delete;
+
+	// onThreadStart/onThreadExit run on the scheduler thread (e.g. to initialize COM).
+	bool start(unsigned rateHz, Callback onTick, Callback onThreadStart = Callback(), Callback onThreadExit = Callback());
+	void stop();
+	bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+	uint64_t ticks() const { return tickCount.load(std::memory_order_relaxed); }
+	uint64_t overruns() const { return overrunCount.load(std::memory_order_relaxed); } // Deadlines missed by more than one period
+
+private:
+	std::atomic<bool> running;
+	std::thread thread;
+	std::atomic<uint64_t> tickCount;
+	std::atomic<uint64_t> overrunCount;
+
+	void run(unsigned rateHz, Callback onTick, Callback onThreadStart, Callback onThreadExit);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Size of a cache line on the x86/ARM parts we run on.
+constexpr size_t kCacheLineSize = 64;
+
+/*
+	Single-writer, many-reader sequence lock.
+
+	The telemetry thread publishes a whole struct with store() while any number of
+	game threads call load() and always get one consistent copy. The writer never
+	waits; a reader retries only if it raced a store. The payload is kept in atomic
+	words so the copy itself is race-free, and the whole object sits on its own
+	cache line(s) so it does not share a line with whatever is allocated next to it.
+*/
+template <typename T>
+class alignas(kCacheLineSize) SeqLock {
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+	SeqLock() : sequence(0) {
+		store(T{});
+	}
+
+	SeqLock(const SeqLock&) = delete;
+	SeqLock& operator=(const SeqLock&) = delete;
+
+	// Publish a new value. Must only be called from one thread.
+	void store(const T& value) {
+		Word buffer[kWordCount] = {};
+		std::memcpy(buffer, &value, sizeof(T));
+
+		uint32_t seq = sequence.load(std::memory_order_relaxed);
+		sequence.store(seq + 1, std::memory_order_relaxed); // Odd: write in progress
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i = 0; i < kWordCount; ++i) {
+			words[i].store(buffer[i], std::memory_order_relaxed);
+		}
+
+		sequence.store(seq + 2, std::memory_order_release);
+	}
+
+	// Return the most recently published value. Safe from any thread.
+	T load() const {
+		Word buffer[kWordCount];
+		uint32_t before;
+		uint32_t after;
+
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			for (size_t i = 0; i < kWordCount; ++i) {
+				buffer[i] = words[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) != 0 || before != after);
+
+		T value;
+		std::memcpy(&value, buffer, sizeof(T));
+		return value;
+	}
+
+	// Number of completed stores, useful to tell whether anything new arrived.
+	uint32_t version() const {
+		return sequence.load(std::memory_order_acquire) >> 1;
+	}
+
+private:
+	typedef uint32_t Word;
+	static constexpr size_t kWordCount = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+	std::atomic<uint32_t> sequence;
+	std::atomic<Word> words[kWordCount];
+};
@@ -0,0 +1,249 @@
+#include "TelemetryCapture.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+template <typename V>
+static void PutLittleEndian(char* out, V value) {
+	for (size_t i = 0; i < sizeof(V); ++i) {
+		out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+}
+
+template <typename V>
+static V GetLittleEndian(const char* in) {
+	V value = 0;
+	for (size_t i = 0; i < sizeof(V); ++i) {
+		value |= static_cast<V>(static_cast<uint8_t>(in[i])) << (8 * i);
+	}
+	return value;
+}
+
+CaptureWriter::CaptureWriter() : file(nullptr) {
+}
+
+CaptureWriter::~CaptureWriter() {
+	close();
+}
+
+bool CaptureWriter::open(const std::string& path) {
+	close();
+
+	file = std::fopen(path.c_str(), "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	std::setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+
+	char header[kCaptureHeaderSize] = {};
+	std::memcpy(header, kCaptureMagic, sizeof(kCaptureMagic));
+	PutLittleEndian<uint32_t>(header + 8, kCaptureVersion);
+	std::fwrite(header, 1, sizeof(header), file);
+	return true;
+}
+
+void CaptureWriter::close() {
+	if (file != nullptr) {
+		std::fclose(file);
+		file = nullptr;
+	}
+}
+
+void CaptureWriter::append(uint64_t timestamp, const char* data, size_t length) {
+	if (file == nullptr || length > kCaptureMaxPayload) {
+		return;
+	}
+
+	char header[kCaptureRecordHeaderSize];
+	PutLittleEndian<uint64_t>(header, timestamp);
+	PutLittleEndian<uint16_t>(header + 8, static_cast<uint16_t>(length));
+	std::fwrite(header, 1, sizeof(header), file);
+	std::fwrite(data, 1, length, file);
+}
+
+MappedWindow::MappedWindow() : fileSize(0), windowStart(0), windowLength(0), view(nullptr), granularity(1),
+#ifdef _WIN32
+	fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#else
+	fd(-1)
+#endif
+{
+}
+
+MappedWindow::~MappedWindow() {
+	close();
+}
+
+bool MappedWindow::open(const std::string& path) {
+	close();
+
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	granularity = info.dwAllocationGranularity;
+
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(fileHandle, &length) || length.QuadPart == 0) {
+		close();
+		return false;
+	}
+	fileSize = static_cast<uint64_t>(length.QuadPart);
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == nullptr) {
+		close();
+		return false;
+	}
+#else
+	granularity = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close();
+		return false;
+	}
+	fileSize = static_cast<uint64_t>(info.st_size);
+#endif
+
+	return true;
+}
+
+void MappedWindow::unmap() {
+	if (view != nullptr) {
+#ifdef _WIN32
+		UnmapViewOfFile(view);
+#else
+		munmap(const_cast<char*>(view), windowLength);
+#endif
+		view = nullptr;
+		windowLength = 0;
+	}
+}
+
+void MappedWindow::close() {
+	unmap();
+
+#ifdef _WIN32
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+#endif
+
+	fileSize = 0;
+}
+
+const char* MappedWindow::map(uint64_t offset, size_t length) {
+	if (offset + length > fileSize) {
+		return nullptr;
+	}
+
+	if (view != nullptr && offset >= windowStart && offset + length <= windowStart + windowLength) {
+		return view + (offset - windowStart);
+	}
+
+	unmap();
+
+	// Map from the allocation boundary below offset, at least one full window when the file is that long.
+	uint64_t start = offset - offset % granularity;
+	uint64_t end = start + kWindowSize;
+	if (end < offset + length) {
+		end = offset + length;
+	}
+	if (end > fileSize) {
+		end = fileSize;
+	}
+	size_t mapLength = static_cast<size_t>(end - start);
+
+#ifdef _WIN32
+	view = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ,
+		static_cast<DWORD>(start >> 32), static_cast<DWORD>(start & 0xFFFFFFFF), mapLength));
+	if (view == nullptr) {
+		return nullptr;
+	}
+#else
+	void* address = mmap(nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(start));
+	if (address == MAP_FAILED) {
+		return nullptr;
+	}
+	madvise(address, mapLength, MADV_SEQUENTIAL);
+	view = static_cast<const char*>(address);
+#endif
+
+	windowStart = start;
+	windowLength = mapLength;
+	return view + (offset - windowStart);
+}
+
+CaptureReader::CaptureReader() : position(kCaptureHeaderSize) {
+}
+
+bool CaptureReader::open(const std::string& path) {
+	if (!file.open(path)) {
+		return false;
+	}
+
+	const char* header = file.map(0, kCaptureHeaderSize);
+	if (header == nullptr ||
+		std::memcmp(header, kCaptureMagic, sizeof(kCaptureMagic)) != 0 ||
+		GetLittleEndian<uint32_t>(header + 8) != kCaptureVersion) {
+		file.close();
+		return false;
+	}
+
+	position = kCaptureHeaderSize;
+	return true;
+}
+
+void CaptureReader::close() {
+	file.close();
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+	const char* header = file.map(position, kCaptureRecordHeaderSize);
+	if (header == nullptr) {
+		return false;
+	}
+
+	uint16_t length = GetLittleEndian<uint16_t>(header + 8);
+	const char* payload = file.map(position, kCaptureRecordHeaderSize + length);
+	if (payload == nullptr || length > kCaptureMaxPayload) {
+		return false;
+	}
+
+	record.timestamp = GetLittleEndian<uint64_t>(payload);
+	record.length = length;
+	record.data = payload + kCaptureRecordHeaderSize;
+
+	position += kCaptureRecordHeaderSize + length;
+	return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/*
+	Telemetry capture files.
+
+	A capture is a 16 byte header followed by one record per received datagram:
+
+		uint64_t timestamp   microseconds since the capture started
+		uint16_t length      payload size in bytes
+		char     payload[length]
+
+	All values are little-endian and records are packed back to back. Captures are
+	written with buffered appends from the telemetry thread and read back through a
+	sliding memory-mapped window, so a multi-hour session never has to fit in RAM
+	(or in a 32-bit address space).
+*/
+
+constexpr char kCaptureMagic[8] = { 'X', '1', 'C', 'A', 'P', 'T', 'R', 'E' };
+constexpr uint32_t kCaptureVersion = 1;
+constexpr size_t kCaptureHeaderSize = 16;
+constexpr size_t kCaptureRecordHeaderSize = 10;
+constexpr size_t kCaptureMaxPayload = 1500;
+
+struct CaptureRecord {
+	uint64_t timestamp; // Microseconds since the start of the capture
+	const char* data;   // Points into the mapped file, valid until the next call to CaptureReader::next()
+	uint16_t length;
+};
+
+class CaptureWriter {
+public:
+	CaptureWriter();
+	~CaptureWriter();
+
+	CaptureWriter(const CaptureWriter&) = delete;
+	CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+	// Creates (or truncates) the file and writes the header.
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return file != nullptr; }
+
+	void append(uint64_t timestamp, const char* data, size_t length);
+
+private:
+	FILE* file;
+	char buffer[1 << 16];
+};
+
+// Read-only view of part of a file, remapped as the reader moves forward.
+class MappedWindow {
+public:
+	MappedWindow();
+	~MappedWindow();
+
+	MappedWindow(const MappedWindow&) = delete;
+	MappedWindow& operator=(const MappedWindow&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+	uint64_t size() const { return fileSize; }
+
+	// Returns a pointer to [offset, offset + length) or nullptr if that range is outside the file.
+	const char* map(uint64_t offset, size_t length);
+
+private:
+	static constexpr size_t kWindowSize = 64 << 20;
+
+	uint64_t fileSize;
+	uint64_t windowStart;
+	size_t windowLength;
+	const char* view;
+	size_t granularity;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fd;
+#endif
+
+	void unmap();
+};
+
+class CaptureReader {
+public:
+	CaptureReader();
+
+	// Opens the file and checks the header.
+	bool open(const std::string& path);
+	void close();
+
+	// Reads the next record. Returns false at the end of the file or on a truncated record.
+	bool next(CaptureRecord& record);
+
+	// Starts again from the first record.
+	void rewind() { position = kCaptureHeaderSize; }
+
+private:
+	MappedWindow file;
+	uint64_t position;
+};
+
+enum class ReplayPacing {
+	Original,    // Sleep so records are delivered with their recorded spacing
+	AsFastAsPossible,
+};
+
+// Feeds every record of a capture to sink(record), optionally at the original timing.
+// With ReplayPacing::Original, sleepUntil(time) waits for each record's time and returns false to stop the replay,
+// so the wait can be cut short. Also stops early when running becomes false. Returns the number of records delivered.
+template <typename Sink, typename SleepUntil>
+uint64_t ReplayCapture(CaptureReader& reader, ReplayPacing pacing, const std::atomic<bool>& running, Sink&& sink, SleepUntil&& sleepUntil) {
+	typedef std::chrono::steady_clock Clock;
+
+	CaptureRecord record;
+	uint64_t delivered = 0;
+	Clock::time_point start = Clock::now();
+
+	while (running.load(std::memory_order_relaxed) && reader.next(record)) {
+		if (pacing == ReplayPacing::Original && !sleepUntil(start + std::chrono::microseconds(record.timestamp))) {
+			break;
+		}
+		sink(record);
+		++delivered;
+	}
+
+	return delivered;
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// 車輛分級 Car class and drivetrain folded into one index, see EffectPresets.h.
+// The games number their classes differently: Motorsport (FM7, FM 2023) 0 E, 1 D, 2 C, 3 B, 4 A, 5 S, 6 R, 7 P, 8 X,
+// Horizon (FH4, FH5) 0 D, 1 C, 2 B, 3 A, 4 S1, 5 S2, 6 X. Drivetrains are 0 FWD, 1 RWD, 2 AWD.
+enum CarClassScale : uint8_t {
+	CarClassScale_Motorsport,
+	CarClassScale_Horizon,
+
+	CarClassScale_Count
+};
+
+constexpr uint32_t kCarClassCount = 9;
+constexpr uint32_t kDrivetrainCount = 3;
+constexpr uint32_t kCarPresetCount = CarClassScale_Count * kCarClassCount * kDrivetrainCount + 1;
+constexpr uint8_t kUnknownCarPreset = kCarPresetCount - 1;  // Out of range class or drivetrain
+
+inline uint8_t CarPresetKey(CarClassScale scale, int32_t carClass, int32_t drivetrainType) {
+	if (static_cast<uint32_t>(carClass) >= kCarClassCount || static_cast<uint32_t>(drivetrainType) >= kDrivetrainCount) {
+		return kUnknownCarPreset;
+	}
+	return static_cast<uint8_t>((scale * kCarClassCount + carClass) * kDrivetrainCount + drivetrainType);
+}
+
+// 遙測來源 Game format a packet was decoded from, see TelemetryDecoders.h.
+enum TelemetrySource : uint8_t {
+	TelemetrySource_None,
+	TelemetrySource_Forza,        // Forza "Data Out"
+	TelemetrySource_Codemasters,  // DiRT Rally, DiRT 4, GRID: "extradata=3" UDP
+	TelemetrySource_Generic,      // X1nput's own float array, for other games and tools
+
+	TelemetrySource_Count
+};
+
+struct TelemetryData {
+
+	uint32_t TimestampMs;              // 遊戲時間戳(毫秒，會溢位歸零) Game timestamp in milliseconds, wraps around
+	float Speed;                       // 車速（米/秒）Vehicle speed in meters per second
+	float EngineIdleRpm;               // 引擎怠速 RPM Engine idle RPM
+	float CurrentEngineRpm;            // 當前引擎 RPM Current engine RPM
+	float EngineMaxRpm;                // 引擎最大 RPM Maximum engine RPM
+	float TireSlipRatioFrontLeft;      // 左前輪滑移率 Front-left tire slip ratio
+	float TireSlipRatioFrontRight;     // 右前輪滑移率 Front-right tire slip ratio
+	float TireSlipRatioRearLeft;       // 左後輪滑移率 Rear-left tire slip ratio
+	float TireSlipRatioRearRight;      // 右後輪滑移率 Rear-right tire slip ratio
+	float TireSlipAngleFrontLeft;      // 左前輪滑移角(正規化，>1:失去抓地力) Front-left tire slip angle, normalized (> 1: past the grip)
+	float TireSlipAngleFrontRight;
+	float TireSlipAngleRearLeft;
+	float TireSlipAngleRearRight;
+	float TireCombinedSlipFrontLeft;   // 左前輪綜合滑移(滑移率與滑移角) Front-left combined slip (ratio and angle), normalized
+	float TireCombinedSlipFrontRight;
+	float TireCombinedSlipRearLeft;
+	float TireCombinedSlipRearRight;
+
+	float Slip;                        // 計算的滑移值(Slip<1:穩定，1<Slip:開始滑移，有煞車時需開ABS) Calculated slip value (Slip < 1: stable; Slip > 1: beginning to slide; ABS needed if braking)
+	float Lockup;                      // 煞車鎖死(0..1，較差的軸) Wheel lock-up, 0..1, the worse axle (AnalyzeWheelSlip)
+	float LockupFront;
+	float LockupRear;
+	float Wheelspin;                   // 輪胎空轉(0..1，較差的軸) Wheelspin, 0..1, the worse axle
+	float WheelspinFront;
+	float WheelspinRear;
+	float NRPM;                        // 正規化  RPM (0:與怠速相同，1:最高轉速) Normalized RPM (0: equal to idle speed, 1: maximum RPM)
+
+	float AccelerationX;               // X:左右   X = right
+	float AccelerationY;			   // Y:上下   Y = up
+	float AccelerationZ;			   // Z:前後   Z = forward
+	float Acceleration;                // 偵測碰撞(>20為突然出狀況) Collision detection (> 20 indicates a sudden event)
+
+	float Throttle;                    // 油門 Throttle pedal as the game reports it, 0..1 (0 when the packet has no pedals)
+	float Brake;                       // 煞車 Brake pedal, 0..1
+
+	float Impact;                      // 碰撞脈衝(0..1，撞擊後衰減) Collision impulse, 0..1, decays after a hit (CollisionDetector)
+	float ImpactLeft;                  // 偏向被撞的一側 Impact with more weight on the side that was hit
+	float ImpactRight;
+
+	float SpeedRate;                   // 變化率 Rates of change per second (TelemetryPredictor), 0 before the second packet
+	float EngineRpmRate;
+
+	uint8_t Gear;                      // 偵測檔位(0:R 1:1 ...) Detect gear position (0:R 1:1 ...)
+	uint8_t Source;                    // 遙測來源 TelemetrySource of the packet
+
+	int32_t CarOrdinal;                // 車輛編號 Unique id of the car model
+	int32_t CarClass;                  // 車輛等級 Class, numbered by the game (see CarClassScale)
+	int32_t CarPerformanceIndex;       // 性能指數 PI, 100..999
+	int32_t DrivetrainType;            // 驅動方式 0 FWD, 1 RWD, 2 AWD
+	int32_t NumCylinders;              // 汽缸數 Number of cylinders in the engine
+	uint8_t CarPreset;                 // CarPresetKey(scale, CarClass, DrivetrainType), picks the EffectPresets program
+
+	uint64_t ReceivedNs;               // 延遲統計 LatencyStats::now() when the packet came off the socket (or was replayed)
+	uint64_t DecodedNs;                // LatencyStats::now() when it was decoded
+
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CodemastersPacket.h"
+#include "ForzaPacket.h"
+#include "GenericPacket.h"
+#include "TelemetryData.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+	Every telemetry format X1nput reads, and the pick between them.
+
+	A port is not tied to a game: each datagram is matched against the formats
+	below in order by its signature (its length, plus a magic or a sanity check
+	where the length alone could be mistaken) and decoded by the first one that
+	accepts it, so the same port takes Forza one evening and DiRT the next.
+	TelemetryDecoderSet is expanded at compile time into one chain of inline
+	checks, without a table of function pointers.
+
+	Adding a game: write its packet header like CodemastersPacket.h, a format
+	below, a TelemetrySource value and a name in kTelemetrySourceNames.
+*/
+
+// One format: its source, a signature check and the decoder. decode() is only called on packets matches() accepted.
+struct ForzaTelemetryFormat {
+	static constexpr TelemetrySource kSource = TelemetrySource_Forza;
+	static bool matches(const char*, size_t length) { return IsForzaPacket(length); }
+	static bool decode(const char* data, size_t length, TelemetryData& telemetry) { return DecodeForzaPacket(data, length, telemetry); }
+};
+
+struct CodemastersTelemetryFormat {
+	static constexpr TelemetrySource kSource = TelemetrySource_Codemasters;
+	static bool matches(const char* data, size_t length) { return IsCodemastersPacket(data, length); }
+	static bool decode(const char* data, size_t length, TelemetryData& telemetry) {
+		CodemastersDecoder::decode(PacketView(data, length), telemetry);
+		return true;
+	}
+};
+
+struct GenericTelemetryFormat {
+	static constexpr TelemetrySource kSource = TelemetrySource_Generic;
+	static bool matches(const char* data, size_t length) { return IsGenericPacket(data, length); }
+	static bool decode(const char* data, size_t length, TelemetryData& telemetry) {
+		GenericDecoder::decode(PacketView(data, length), telemetry);
+		return true;
+	}
+};
+
+// Bit (1 << source) set for every source a reader accepts ([Telemetry] Formats).
+typedef uint32_t TelemetryFormats;
+constexpr TelemetryFormats kAllTelemetryFormats = ((1u << TelemetrySource_Count) - 1) & ~(1u << TelemetrySource_None);
+
+template <typename... Formats>
+struct TelemetryDecoderSet {
+	// The first enabled format that accepts the datagram, TelemetrySource_None if none does.
+	static TelemetrySource detect(const char* data, size_t length, TelemetryFormats enabled) {
+		TelemetrySource source = TelemetrySource_None;
+		(void)((((enabled >> Formats::kSource) & 1) != 0 && Formats::matches(data, length) && (source = Formats::kSource, true)) || ...);
+		return source;
+	}
+
+	// Decodes a datagram detect() returned source for.
+	static bool decode(TelemetrySource source, const char* data, size_t length, TelemetryData& telemetry) {
+		bool decoded = false;
+		(void)((source == Formats::kSource && (decoded = Formats::decode(data, length, telemetry), true)) || ...);
+		return decoded;
+	}
+};
+
+typedef TelemetryDecoderSet<ForzaTelemetryFormat, CodemastersTelemetryFormat, GenericTelemetryFormat> TelemetryDecoders;
+
+inline TelemetrySource DetectTelemetrySource(const char* data, size_t length, TelemetryFormats enabled = kAllTelemetryFormats) {
+	return TelemetryDecoders::detect(data, length, enabled);
+}
+
+// Detects and decodes in one call. Returns false for anything none of the enabled formats accepts.
+inline bool DecodeTelemetryPacket(const char* data, size_t length, TelemetryData& telemetry, TelemetryFormats enabled = kAllTelemetryFormats) {
+	TelemetrySource source = DetectTelemetrySource(data, length, enabled);
+	return source != TelemetrySource_None && TelemetryDecoders::decode(source, data, length, telemetry);
+}
+
+// Names as written in [Telemetry] Formats, indexed by TelemetrySource.
+inline constexpr const char* kTelemetrySourceNames[TelemetrySource_Count] = { "None", "Forza", "Codemasters", "Generic" };
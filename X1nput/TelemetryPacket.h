@@ -0,0 +1,60 @@
+#pragma once
+
+#include "FastMath.h"
+#include "TelemetryData.h"
+#include "WheelSlip.h"
+
+#include <cstddef>
+#include <cstring>
+
+// Parts every telemetry decoder shares: reading a datagram and the values the effects derive from the raw fields.
+
+// Non-owning view over a received datagram. Nothing is copied until a field is read.
+class PacketView {
+public:
+	PacketView(const char* data, size_t size) : data(data), size(size) {}
+
+	const char* bytes() const { return data; }
+	size_t length() const { return size; }
+
+	template <typename V>
+	V read(size_t offset) const {
+		V value;
+		std::memcpy(&value, data + offset, sizeof(V));
+		return value;
+	}
+
+private:
+	const char* data;
+	size_t size;
+};
+
+// Fills Slip, Acceleration, the lock-up and wheelspin values and NRPM from the decoded fields.
+inline void DeriveTelemetry(TelemetryData& telemetry) {
+	const float tireSlip[4] = {
+		telemetry.TireSlipRatioFrontLeft,
+		telemetry.TireSlipRatioFrontRight,
+		telemetry.TireSlipRatioRearLeft,
+		telemetry.TireSlipRatioRearRight,
+	};
+	FastNormsResult norms = FastNorms(tireSlip, telemetry.AccelerationY, telemetry.AccelerationZ);
+	telemetry.Slip = norms.Slip;
+	telemetry.Acceleration = norms.Acceleration;
+
+	const float combinedSlip[4] = {
+		telemetry.TireCombinedSlipFrontLeft,
+		telemetry.TireCombinedSlipFrontRight,
+		telemetry.TireCombinedSlipRearLeft,
+		telemetry.TireCombinedSlipRearRight,
+	};
+	WheelSlipResult wheels = AnalyzeWheelSlip(tireSlip, combinedSlip);
+	telemetry.Lockup = wheels.Lockup;
+	telemetry.LockupFront = wheels.LockupFront;
+	telemetry.LockupRear = wheels.LockupRear;
+	telemetry.Wheelspin = wheels.Wheelspin;
+	telemetry.WheelspinFront = wheels.WheelspinFront;
+	telemetry.WheelspinRear = wheels.WheelspinRear;
+
+	telemetry.NRPM = (telemetry.CurrentEngineRpm - telemetry.EngineIdleRpm + 0.001) /
+		(telemetry.EngineMaxRpm - telemetry.EngineIdleRpm);
+}
@@ -0,0 +1,69 @@
+#include "TelemetryPredictor.h"
+
+#include <algorithm>
+#include <limits>
+
+void TelemetryPredictor::reset() {
+	for (Channel& channel : channels) {
+		channel = {};
+	}
+	lastTimestampMs = 0;
+	lastGear = 0;
+	primed = false;
+}
+
+void TelemetryPredictor::update(TelemetryData& telemetry) {
+	// Unsigned, so the wrap of the game clock is a small step; a clock going backwards reads as a huge one.
+	uint32_t stepMs = telemetry.TimestampMs - lastTimestampMs;
+
+	// A first packet, a gap, or a game clock that stands still (paused, or a repeated packet): nothing to go on.
+	if (!primed || stepMs == 0 || stepMs > kPredictorMaxGapMs) {
+		for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+			channels[i].value = telemetry.*kPredictedValues[i];
+			channels[i].rate = 0.f;
+		}
+	}
+	else {
+		float step = stepMs * 1e-3f;
+		for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+			Channel& channel = channels[i];
+			bool rpm = i == PredictedChannel_EngineRpm;
+			float expected = channel.value + channel.rate * step;
+			float error = telemetry.*kPredictedValues[i] - expected;
+			channel.value = expected + (rpm ? options.rpmAlpha : options.alpha) * error;
+			channel.rate += (rpm ? options.rpmBeta : options.beta) / step * error;
+		}
+
+		// A shift steps the RPM: start it over rather than read the step as revving.
+		if (telemetry.Gear != lastGear) {
+			channels[PredictedChannel_EngineRpm].value = telemetry.CurrentEngineRpm;
+			channels[PredictedChannel_EngineRpm].rate = 0.f;
+		}
+	}
+
+	for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+		telemetry.*kPredictedRates[i] = channels[i].rate;
+	}
+	lastTimestampMs = telemetry.TimestampMs;
+	lastGear = telemetry.Gear;
+	primed = true;
+}
+
+void PredictTelemetry(TelemetryData& telemetry, float horizonSeconds) {
+	if (horizonSeconds <= 0.f) {
+		return;
+	}
+	const float packetRpm = telemetry.CurrentEngineRpm;
+	for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+		telemetry.*kPredictedValues[i] += telemetry.*kPredictedRates[i] * horizonSeconds;
+	}
+
+	// RPM 0 (paused) stays 0 and a running engine never gets there. Games that do not send the limiter leave
+	// EngineMaxRpm at 0: no upper bound then.
+	float lowest = packetRpm > 0.f ? std::min(packetRpm, std::max(telemetry.EngineIdleRpm, 1.f)) : 0.f;
+	float highest = packetRpm <= 0.f ? 0.f :
+		telemetry.EngineMaxRpm > 0.f ? std::max(telemetry.EngineMaxRpm, lowest) : std::numeric_limits<float>::max();
+	telemetry.CurrentEngineRpm = std::max(lowest, std::min(telemetry.CurrentEngineRpm, highest));
+	telemetry.NRPM = (telemetry.CurrentEngineRpm - telemetry.EngineIdleRpm + 0.001) /
+		(telemetry.EngineMaxRpm - telemetry.EngineIdleRpm);
+}
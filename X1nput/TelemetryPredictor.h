@@ -0,0 +1,106 @@
+#pragma once
+
+#include "TelemetryData.h"
+
+#include <cstdint>
+
+/*
+	Short-horizon extrapolation of the speed and the engine RPM.
+
+	Telemetry arrives about every 16 ms and an output frame then uses the
+	newest packet for up to another packet, plus the controller's own latency,
+	so an effect that fires on a threshold (the rev limiter buzz on NRPM) is
+	late by that much. TelemetryPredictor runs an alpha-beta filter per value on
+	the packets' game timestamps and stores each value's rate of change in the
+	packet; PredictTelemetry() then moves a snapshot forward along those rates
+	when an output uses it, by its age plus [Prediction] LeadMs.
+
+	The filter only supplies the rates. At a horizon of 0 every value is the
+	packet's own, so the effects match those without prediction. A stalled game
+	clock (a paused game) zeroes the rates, and a gap of more than
+	kPredictorMaxGapMs or a clock going backwards starts the filter over. Each
+	update() is constant time and allocates nothing.
+
+	The engine RPM has gains of its own. Within a gear it follows the speed
+	closely and changes pace quickly, so it wants a faster filter than the
+	speed; at a shift it steps, which no filter sees coming, so a gear change
+	starts its rate over from 0 instead of letting the step wind it up.
+
+	The accelerations are left as the packet has them. Kerbs, impacts and load
+	transfer move them too abruptly for a rate to say where they go next: on
+	x1nput-sim's lap 16 ms ahead every axis came out further from the truth
+	extrapolated than held.
+*/
+
+struct TelemetryPredictorOptions {
+	bool enabled = false;  // Extrapolate the snapshots outputs use; the rates are tracked either way
+	float alpha = 0.5f;    // Share of each packet's error that corrects the value, 0..1
+	float beta = 0.1f;     // Share that corrects the rate, 0..1; higher follows changes sooner but noisier
+	float rpmAlpha = 0.8f; // The same for the engine RPM
+	float rpmBeta = 0.3f;
+	float leadMs = 0.f;    // Extrapolated beyond the moment of output, for the controller's own latency
+	float maxMs = 50.f;    // Longest extrapolation, so a stream that stopped is not run off into the distance
+};
+
+// Packets further apart than this start the filter over.
+constexpr uint32_t kPredictorMaxGapMs = 250;
+
+// The values extrapolated, and where each one's rate is stored.
+enum PredictedChannel : uint8_t {
+	PredictedChannel_Speed,
+	PredictedChannel_EngineRpm,
+
+	PredictedChannel_Count
+};
+
+inline constexpr float TelemetryData::* kPredictedValues[PredictedChannel_Count] = {
+	&TelemetryData::Speed, &TelemetryData::CurrentEngineRpm,
+};
+inline constexpr float TelemetryData::* kPredictedRates[PredictedChannel_Count] = {
+	&TelemetryData::SpeedRate, &TelemetryData::EngineRpmRate,
+};
+inline constexpr const char* kPredictedChannelNames[PredictedChannel_Count] = {
+	"Speed", "CurrentEngineRpm",
+};
+
+class TelemetryPredictor {
+public:
+	explicit TelemetryPredictor(const TelemetryPredictorOptions& options = TelemetryPredictorOptions()) : options(options) { reset(); }
+
+	const TelemetryPredictorOptions& getOptions() const { return options; }
+	void setOptions(const TelemetryPredictorOptions& value) { options = value; }
+
+	// Forgets the history; the next packet's rates are 0.
+	void reset();
+
+	// Feeds one packet, in the order they were sent, and writes its rates back into it.
+	void update(TelemetryData& telemetry);
+
+private:
+	struct Channel {
+		float value; // Filtered
+		float rate;  // Per second
+	};
+
+	TelemetryPredictorOptions options;
+	Channel channels[PredictedChannel_Count];
+	uint32_t lastTimestampMs;
+	uint8_t lastGear;
+	bool primed;
+};
+
+// Moves the snapshot horizonSeconds ahead along its rates and derives NRPM again. The RPM stays
+// below EngineMaxRpm when the game sends one, a running engine stays above idle and an RPM of 0 stays 0: it reads as
+// a paused game.
+void PredictTelemetry(TelemetryData& telemetry, float horizonSeconds);
+
+// How far to extrapolate a snapshot used at nowNs: the time since it was received plus the lead, at most maxMs.
+// 0 with prediction off.
+inline float PredictionHorizon(const TelemetryPredictorOptions& options, const TelemetryData& telemetry, uint64_t nowNs) {
+	if (!options.enabled) {
+		return 0.f;
+	}
+	float ageMs = telemetry.ReceivedNs != 0 && nowNs > telemetry.ReceivedNs ? (nowNs - telemetry.ReceivedNs) * 1e-6f : 0.f;
+	float horizonMs = ageMs + options.leadMs;
+	return (horizonMs < options.maxMs ? horizonMs : options.maxMs) * 1e-3f;
+}
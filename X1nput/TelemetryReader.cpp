@@ -0,0 +1,235 @@
+﻿#include "TelemetryReader.h"
+
+#include <cstring>
+#include <iostream>
+
+TelemetryReader::TelemetryReader(const TelemetryReaderOptions& options)
+	: options(options), running(true), listening(false), activeSource(TelemetrySource_None), received(0), dropped(0), malformed(0),
+	collisions(options.collision), predictor(options.prediction), optionsChanged(false) {
+	// 重播有自己的執行緒 A replay runs on its own thread; the router drains network readers on its thread.
+	if (replays()) {
+		readerThread = std::thread(&TelemetryReader::runReplay, this);
+	}
+}
+
+TelemetryReader::~TelemetryReader() {
+	stop();
+	socket.close();
+	capture.close();
+	telemetryRelay.close();
+}
+
+void TelemetryReader::stop() {
+	// 停止執行緒 Stop the thread
+	{
+		std::lock_guard<std::mutex> guard(stopLock);
+		running = false;
+	}
+	stopSignal.notify_all();
+
+	if (readerThread.joinable()) {
+		readerThread.join(); // 等待執行緒結束 Wait for the thread to finish
+	}
+	listening.store(false, std::memory_order_release);
+}
+
+void TelemetryReader::setOptions(const TelemetryReaderOptions& value) {
+	std::lock_guard<std::mutex> guard(pendingOptionsLock);
+	pendingOptions = value;
+	optionsChanged.store(true, std::memory_order_release);
+}
+
+static bool SameRelayTargets(const std::vector<RelayTarget>& a, const std::vector<RelayTarget>& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i].fromPort != b[i].fromPort || a[i].endpoint.address != b[i].endpoint.address || a[i].endpoint.port != b[i].endpoint.port) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TelemetryReader::applyPendingOptions() {
+	if (!optionsChanged.exchange(false, std::memory_order_acquire)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(pendingOptionsLock);
+	options.formats = pendingOptions.formats;
+	collisions.setOptions(pendingOptions.collision);
+	predictor.setOptions(pendingOptions.prediction);
+
+	// 轉發 A listening reader swaps its relay socket; one that has not listened yet opens the new targets in listen().
+	if (!SameRelayTargets(options.relay, pendingOptions.relay)) {
+		options.relay = pendingOptions.relay;
+		if (listening.load(std::memory_order_relaxed) && !replays()) {
+			openRelay();
+		}
+	}
+}
+
+void TelemetryReader::openRelay() {
+	if (telemetryRelay.open(options.port, options.relay)) {
+		for (size_t i = 0; i < telemetryRelay.targetCount(); ++i) {
+			std::cout << "Relaying port " << options.port << " to " << FormatUdpEndpoint(telemetryRelay.target(i)) << std::endl;
+		}
+	}
+	else if (!options.relay.empty()) {
+		std::cout << "Failed to create the relay socket for port " << options.port << std::endl;
+	}
+}
+
+bool TelemetryReader::publish(const char* data, size_t length, TelemetrySource source, uint64_t receivedNs) {
+	// 解析數據包, Parse data packet.
+	TelemetryData parsed = {};
+	if (!TelemetryDecoders::decode(source, data, length, parsed)) {
+		return false;
+	}
+
+	collisions.update(parsed); // 依遊戲時間戳計算 Timed by the packet timestamp, so skipped stale packets only widen the step
+	predictor.update(parsed);  // Same
+	parsed.ReceivedNs = receivedNs;
+	if (options.stats) {
+		parsed.DecodedNs = LatencyStats::now();
+		options.stats->record(LatencyStage_Decode, receivedNs, parsed.DecodedNs);
+	}
+	telemetryData.store(parsed);
+
+	// 來源改變 Say which game is sending, once per change.
+	if (activeSource.exchange(source, std::memory_order_relaxed) != source) {
+		std::cout << "Telemetry on port " << options.port << ": " << kTelemetrySourceNames[source] << std::endl;
+	}
+	return true;
+}
+
+void TelemetryReader::runReplay() {
+	CaptureReader reader;
+	if (!reader.open(options.replayPath)) {
+		std::cout << "Failed to open telemetry capture " << options.replayPath << std::endl;
+		return;
+	}
+
+	std::cout << "Replaying telemetry from " << options.replayPath << std::endl;
+	listening.store(true, std::memory_order_release);
+
+	ReplayCapture(reader, options.replayPacing, running, [this](const CaptureRecord& record) {
+		applyPendingOptions();
+		received.fetch_add(1, std::memory_order_relaxed);
+		if (options.stats) {
+			options.stats->countReceived(1);
+		}
+		// 回放沒有 socket 時間 Replayed packets count as received when they are published
+		if (!publish(record.data, record.length, DetectTelemetrySource(record.data, record.length, options.formats), LatencyStats::now())) {
+			malformed.fetch_add(1, std::memory_order_relaxed);
+			if (options.stats) {
+				options.stats->countMalformed(1);
+			}
+		}
+	}, [this](std::chrono::steady_clock::time_point time) {
+		// stopLock makes stop() either happen before the check or wait until the thread sleeps, so its notify is never missed.
+		std::unique_lock<std::mutex> guard(stopLock);
+		return !stopSignal.wait_until(guard, time, [this]() { return !running.load(std::memory_order_relaxed); });
+	});
+}
+
+bool TelemetryReader::listen(UdpPoller& poller, size_t tag) {
+	applyPendingOptions();
+
+	// 綁定 socket, Bind socket.
+	if (!socket.bind(options.port) || !poller.add(socket, tag)) {
+		std::cout << "Failed to bind telemetry port " << options.port << std::endl;
+		socket.close();
+		return false;
+	}
+
+	if (!options.capturePath.empty() && !capture.open(options.capturePath)) {
+		std::cout << "Failed to create telemetry capture " << options.capturePath << std::endl;
+	}
+	captureStart = std::chrono::steady_clock::now();
+
+	// 轉發 Relay targets
+	openRelay();
+
+	std::cout << "Waiting for telemetry data on port " << options.port << "..." << std::endl;
+	listening.store(true, std::memory_order_release);
+	return true;
+}
+
+void TelemetryReader::drain() {
+	typedef std::chrono::steady_clock Clock;
+
+	char latest[DatagramBatch::kDatagramSize];
+	applyPendingOptions();
+
+	// 取出排隊中的所有數據包，只保留最新的有效包 Drain the queue and keep only the newest valid packet.
+	size_t latestLength = 0;
+	TelemetrySource latestSource = TelemetrySource_None;
+	uint64_t latestReceivedNs = 0;
+	uint64_t valid = 0;
+	uint64_t invalid = 0;
+	int count = socket.receive(batch);
+	while (count > 0) {
+		uint64_t receivedNs = LatencyStats::now();  // Also the age [Prediction] extrapolates by
+		received.fetch_add(count, std::memory_order_relaxed);
+
+		// 錄製原始數據包 Record the raw datagrams, stale ones included.
+		if (capture.isOpen()) {
+			uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - captureStart).count();
+			for (int i = 0; i < count; ++i) {
+				capture.append(timestamp, batch.data[i], static_cast<size_t>(batch.lengths[i]));
+			}
+		}
+
+		// Later batches are newer, so the newest valid packet of each batch replaces the previous pick.
+		bool taken = false;
+		for (int i = count - 1; i >= 0; --i) {
+			size_t length = static_cast<size_t>(batch.lengths[i]);
+			TelemetrySource source = DetectTelemetrySource(batch.data[i], length, options.formats);
+			if (source == TelemetrySource_None) {
+				++invalid;
+				continue;
+			}
+			++valid;
+			if (!taken) {
+				std::memcpy(latest, batch.data[i], length);
+				latestLength = length;
+				latestSource = source;
+				latestReceivedNs = receivedNs;
+				taken = true;
+			}
+		}
+
+		// A full batch means more may still be queued. The last batch stays in batch and is relayed once its packet
+		// is published; full ones before it only hold stale packets and go out right away.
+		if (count < DatagramBatch::kCapacity) {
+			break;
+		}
+		if (telemetryRelay.isOpen()) {
+			telemetryRelay.send(batch);
+		}
+		count = socket.receive(batch);
+	}
+
+	// A packet its size let through but its decoder rejected is malformed, not valid as well.
+	bool published = latestLength > 0 && publish(latest, latestLength, latestSource, latestReceivedNs);
+	if (latestLength > 0 && !published) {
+		--valid;
+		++invalid;
+	}
+	uint64_t skipped = published ? valid - 1 : valid;
+
+	dropped.fetch_add(skipped, std::memory_order_relaxed);
+	malformed.fetch_add(invalid, std::memory_order_relaxed);
+	if (options.stats) {
+		options.stats->countReceived(valid + invalid);
+		options.stats->countMalformed(invalid);
+		options.stats->countDropped(skipped);
+	}
+
+	// 轉發 Relayed after publishing, so the effects never wait for the relay targets.
+	if (count > 0 && telemetryRelay.isOpen()) {
+		telemetryRelay.send(batch);
+	}
+}
@@ -0,0 +1,127 @@
+﻿#pragma once
+
+#include "CollisionDetector.h"
+#include "LatencyStats.h"
+#include "SeqLock.h"
+#include "TelemetryCapture.h"
+#include "TelemetryData.h"
+#include "TelemetryDecoders.h"
+#include "TelemetryPredictor.h"
+#include "TelemetryRelay.h"
+#include "UdpSocket.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 預設的 Forza Data Out 端口 Default Forza "Data Out" port.
+constexpr uint16_t kDefaultTelemetryPort = 9999;
+
+struct TelemetryReaderOptions {
+	uint16_t port = kDefaultTelemetryPort;
+	std::string capturePath;  // 錄製 If set, every received datagram is appended to this capture file
+	std::string replayPath;   // 重播 If set, packets are read from this capture instead of the network
+	ReplayPacing replayPacing = ReplayPacing::Original;
+	TelemetryFormats formats = kAllTelemetryFormats; // 格式 [Telemetry] Formats, the games the port accepts
+	std::vector<RelayTarget> relay;     // 轉發 [Telemetry] Relay, where received datagrams are re-sent
+	CollisionDetectorOptions collision; // 碰撞偵測 [Collision] settings
+	TelemetryPredictorOptions prediction; // 預測 [Prediction] settings; the reader tracks the rates, outputs extrapolate
+	LatencyStats* stats = nullptr;      // 延遲統計 Shared by every reader, null when [Stats] is off
+};
+
+/*
+	The telemetry of one port, or of one replayed capture.
+
+	A network reader has no thread of its own: TelemetryRouter binds it with
+	listen() and waits on every port at once on its thread, then calls drain()
+	when the port has datagrams queued. Each datagram is decoded by whichever
+	format of TelemetryDecoders.h accepts it, so any supported game can send to
+	any port. With [Telemetry] Relay set, every datagram taken off the socket is
+	then passed on by a TelemetryRelay, after the newest packet is published.
+
+	A replay has no socket to wait on, so a reader with a replayPath plays the
+	capture on its own thread, started by the constructor. Its pacing can be
+	interrupted: stop() wakes it and joins within microseconds.
+*/
+class TelemetryReader {
+public:
+	explicit TelemetryReader(const TelemetryReaderOptions& options = TelemetryReaderOptions());
+	~TelemetryReader();
+
+	TelemetryReader(const TelemetryReader&) = delete;
+	TelemetryReader& operator=(const TelemetryReader&) = delete;
+
+	// 取得一致的遙測快照 Return one consistent copy of the latest telemetry packet.
+	// Read every field for a frame from the same snapshot so values never mix two packets.
+	TelemetryData snapshot() const { return telemetryData.load(); }
+
+	// 統計 Counters, updated by the thread that drains the reader (or replays).
+	uint64_t packetsReceived() const { return received.load(std::memory_order_relaxed); }  // Every datagram taken off the socket
+	uint64_t packetsDropped() const { return dropped.load(std::memory_order_relaxed); }    // Valid packets skipped because a newer one was queued
+	uint64_t packetsMalformed() const { return malformed.load(std::memory_order_relaxed); } // Datagrams no enabled format accepts
+
+	// 遙測來源 Format of the newest packet published, TelemetrySource_None before the first.
+	TelemetrySource source() const { return static_cast<TelemetrySource>(activeSource.load(std::memory_order_relaxed)); }
+
+	// 更新設定 Takes formats, relay, collision and prediction from value; the reader thread applies them before the next
+	// packet and reopens the relay if its targets changed. The port, capture, replay and stats stay as constructed.
+	// Safe to call from any thread.
+	void setOptions(const TelemetryReaderOptions& value);
+
+	// 已綁定 True once the socket is bound (or the capture opened) and packets can arrive.
+	bool isListening() const { return listening.load(std::memory_order_acquire); }
+
+	// 轉發 Targets of [Telemetry] Relay for this port and their counters. Empty until listen(); reopened, counters
+	// cleared, when setOptions() changes the targets.
+	const TelemetryRelay& relay() const { return telemetryRelay; }
+
+	// 重播 True for a reader that plays a capture instead of listening.
+	bool replays() const { return !options.replayPath.empty(); }
+
+	// 綁定 Binds the port, opens the capture file and has poller report the socket as tag. Network readers only, on
+	// the thread that drains them.
+	bool listen(UdpPoller& poller, size_t tag);
+
+	// 接收 Takes every queued datagram and publishes the newest valid packet. Never waits.
+	void drain();
+
+	// 停止重播 Stops the replay thread and waits for it to finish. Called by the destructor; calling it again does nothing.
+	void stop();
+
+private:
+	TelemetryReaderOptions options;
+	std::atomic<bool> running; // 控制執行緒運行的變數 Variable to control the execution thread.
+	std::atomic<bool> listening;
+	std::atomic<uint8_t> activeSource;
+	std::thread readerThread; // 重播執行緒, Replay thread.
+	std::mutex stopLock;      // With stopSignal, interrupts the replay pacing
+	std::condition_variable stopSignal;
+	UdpSocket socket;
+	std::chrono::steady_clock::time_point captureStart;
+	SeqLock<TelemetryData> telemetryData; // 存儲 telemetry 數據, Store telemetry data.
+
+	std::atomic<uint64_t> received;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> malformed;
+
+	DatagramBatch batch; // 接收緩衝區 Receive buffers, reused for every drain pass.
+	CaptureWriter capture;
+	TelemetryRelay telemetryRelay;
+
+	CollisionDetector collisions; // Draining or replay thread only
+	TelemetryPredictor predictor; // Same thread
+	std::mutex pendingOptionsLock;
+	TelemetryReaderOptions pendingOptions;
+	std::atomic<bool> optionsChanged;
+
+	void applyPendingOptions();
+	void openRelay();
+	void runReplay();
+	// Decodes and stores a detected packet. Returns false, counting nothing, if its decoder rejects it.
+	bool publish(const char* data, size_t length, TelemetrySource source, uint64_t receivedNs);
+};
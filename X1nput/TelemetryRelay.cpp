@@ -0,0 +1,61 @@
+#include "TelemetryRelay.h"
+
+TelemetryRelay::TelemetryRelay() : count(0) {
+	for (size_t i = 0; i < kMaxRelayTargets; ++i) {
+		sent[i] = 0;
+		dropped[i] = 0;
+	}
+}
+
+bool TelemetryRelay::open(uint16_t port, const std::vector<RelayTarget>& targets) {
+	close();
+
+	size_t taken = 0;
+	for (const RelayTarget& target : targets) {
+		if ((target.fromPort == 0 || target.fromPort == port) && taken < kMaxRelayTargets) {
+			endpoints[taken++] = target.endpoint;
+		}
+	}
+	if (taken == 0 || !socket.open()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < taken; ++i) {
+		sent[i].store(0, std::memory_order_relaxed);
+		dropped[i].store(0, std::memory_order_relaxed);
+	}
+	count = taken;
+	return true;
+}
+
+void TelemetryRelay::close() {
+	socket.close();
+	count = 0;
+}
+
+void TelemetryRelay::send(const DatagramBatch& batch) {
+	// Datagram by datagram, so when the send buffer fills up every target loses the newest ones alike.
+	size_t total = 0;
+	for (int i = 0; i < batch.count; ++i) {
+		for (size_t target = 0; target < count; ++target) {
+			OutgoingDatagram& datagram = outgoing[total++];
+			datagram.endpoint = &endpoints[target];
+			datagram.data = batch.data[i];
+			datagram.length = static_cast<size_t>(batch.lengths[i]);
+		}
+	}
+	if (total == 0) {
+		return;
+	}
+
+	socket.sendBatch(outgoing, total);
+
+	uint64_t targetSent[kMaxRelayTargets] = {};
+	for (size_t i = 0; i < total; ++i) {
+		targetSent[i % count] += outgoing[i].sent ? 1 : 0;
+	}
+	for (size_t target = 0; target < count; ++target) {
+		sent[target].fetch_add(targetSent[target], std::memory_order_relaxed);
+		dropped[target].fetch_add(batch.count - targetSent[target], std::memory_order_relaxed);
+	}
+}
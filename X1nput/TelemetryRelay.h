@@ -0,0 +1,60 @@
+#pragma once
+
+#include "UdpSocket.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Most endpoints one telemetry port is relayed to.
+constexpr size_t kMaxRelayTargets = 8;
+
+// [Telemetry] Relay entry: "HOST:PORT" relays every port, "FROM>HOST:PORT" only port FROM.
+struct RelayTarget {
+	uint16_t fromPort = 0;  // Telemetry port relayed, 0 for every port
+	UdpEndpoint endpoint;
+};
+
+/*
+	Re-sends the datagrams of one telemetry port to other programs: a
+	dashboard, a logger, a motion rig. Forza sends Data Out to a single
+	address, and while the DLL has that port bound nothing else could read it.
+
+	send() runs on the thread that drains the port and never waits. All the
+	batch's datagrams for all targets go out in one sendmmsg() on Linux; a
+	datagram that does not fit in the send buffer, or that its target
+	refuses, is dropped and counted against that target. The buffers are
+	fixed, nothing is allocated per packet.
+*/
+class TelemetryRelay {
+public:
+	TelemetryRelay();
+
+	TelemetryRelay(const TelemetryRelay&) = delete;
+	TelemetryRelay& operator=(const TelemetryRelay&) = delete;
+
+	// Opens the sending socket for the targets that relay port (the first kMaxRelayTargets). Returns false when no
+	// target does or the socket cannot be created.
+	bool open(uint16_t port, const std::vector<RelayTarget>& targets);
+	void close();
+	bool isOpen() const { return count > 0; }
+
+	// Sends every datagram of the batch to every target.
+	void send(const DatagramBatch& batch);
+
+	// Per target, in the order open() took them. Safe to read from any thread.
+	size_t targetCount() const { return count; }
+	const UdpEndpoint& target(size_t index) const { return endpoints[index]; }
+	uint64_t packetsSent(size_t index) const { return sent[index].load(std::memory_order_relaxed); }
+	uint64_t packetsDropped(size_t index) const { return dropped[index].load(std::memory_order_relaxed); }
+
+private:
+	UdpSocket socket;
+	UdpEndpoint endpoints[kMaxRelayTargets];
+	std::atomic<uint64_t> sent[kMaxRelayTargets];
+	std::atomic<uint64_t> dropped[kMaxRelayTargets];
+	size_t count;
+
+	OutgoingDatagram outgoing[DatagramBatch::kCapacity * kMaxRelayTargets]; // Reused by every send()
+};
@@ -0,0 +1,141 @@
+#include "TelemetryRouter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+TelemetryRouter::TelemetryRouter() : sourceCount(0), running(false), stopped(false) {
+}
+
+TelemetryRouter::~TelemetryRouter() {
+	stop();
+}
+
+TelemetryReader* TelemetryRouter::reader(uint16_t port, const TelemetryReaderOptions& options) {
+	if (stopped.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+
+	size_t count = sourceCount.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; ++i) {
+		if (sources[i].port == port) {
+			return &*sources[i].reader;
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(startLock);
+
+	// Another thread may have started it, or stop() run, while we waited for the lock.
+	if (stopped.load(std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	count = sourceCount.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < count; ++i) {
+		if (sources[i].port == port) {
+			return &*sources[i].reader;
+		}
+	}
+	if (count == kMaxTelemetrySources) {
+		return nullptr;
+	}
+
+	TelemetryReaderOptions sourceOptions = options;
+	if (port != options.port) {
+		sourceOptions.port = port;
+		sourceOptions.capturePath.clear();
+		sourceOptions.replayPath.clear();
+	}
+
+	sources[count].port = port;
+	sources[count].reader.emplace(sourceOptions);
+	sourceCount.store(count + 1, std::memory_order_release);
+
+	// The network thread binds the new port.
+	if (!sources[count].reader->replays()) {
+		if (!networkThread.joinable()) {
+			running.store(true, std::memory_order_release);
+			networkThread = std::thread(&TelemetryRouter::run, this);
+		}
+		poller.wake();
+	}
+	return &*sources[count].reader;
+}
+
+void TelemetryRouter::setOptions(const TelemetryReaderOptions& value) {
+	size_t count = sourceCount.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; ++i) {
+		sources[i].reader->setOptions(value);
+	}
+}
+
+void TelemetryRouter::stop() {
+	std::lock_guard<std::mutex> guard(startLock);
+	stopped.store(true, std::memory_order_release);
+
+	{
+		// backoffLock makes the store either happen before run() checks it or wait until run() sleeps.
+		std::lock_guard<std::mutex> backoffGuard(backoffLock);
+		running.store(false, std::memory_order_release);
+	}
+	backoffSignal.notify_all();
+	poller.wake();
+	if (networkThread.joinable()) {
+		networkThread.join();
+	}
+
+	// Wakes and joins the replay threads. The readers themselves, their sockets and captures, go with the router.
+	size_t count = sourceCount.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < count; ++i) {
+		sources[i].reader->stop();
+	}
+}
+
+void TelemetryRouter::run() {
+	size_t watched = 0;  // Sources below this have been bound (or are replays)
+	size_t ready[kMaxTelemetrySources];
+	std::chrono::milliseconds backoff(0);  // Pause after the last failed wait, 0 while waits succeed
+
+	while (running.load(std::memory_order_acquire)) {
+		size_t count = sourceCount.load(std::memory_order_acquire);
+		for (; watched < count; ++watched) {
+			TelemetryReader& reader = *sources[watched].reader;
+			if (!reader.replays()) {
+				reader.listen(poller, watched);
+			}
+		}
+
+		// 等待任一端口的數據包 Wait for a datagram on any port, or for reader() or stop() to wake us.
+		int signalled = poller.wait(ready, kMaxTelemetrySources);
+		if (signalled < 0) {
+			// A real failure, the poller retries interrupted waits itself. Logged once per run of failures.
+			if (backoff.count() == 0) {
+				std::cout << "Failed to wait for telemetry, retrying" << std::endl;
+			}
+			backoff = std::min(std::max(backoff * 2, std::chrono::milliseconds(1)), std::chrono::milliseconds(1000));
+			std::unique_lock<std::mutex> guard(backoffLock);
+			backoffSignal.wait_for(guard, backoff, [this]() { return !running.load(std::memory_order_relaxed); });
+			continue;
+		}
+		if (backoff.count() != 0) {
+			std::cout << "Waiting for telemetry data again" << std::endl;
+			backoff = std::chrono::milliseconds(0);
+		}
+		for (int i = 0; i < signalled; ++i) {
+			sources[ready[i]].reader->drain();
+		}
+	}
+}
+
+const TelemetryData& TelemetrySnapshots::get(const TelemetryReader& reader) {
+	for (size_t i = 0; i < count; ++i) {
+		if (readers[i] == &reader) {
+			return data[i];
+		}
+	}
+
+	// More readers than slots cannot happen, TelemetryRouter never starts more than kMaxTelemetrySources.
+	size_t slot = count < kMaxTelemetrySources ? count++ : kMaxTelemetrySources - 1;
+	readers[slot] = &reader;
+	data[slot] = reader.snapshot();
+	return data[slot];
+}
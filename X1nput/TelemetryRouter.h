@@ -0,0 +1,90 @@
+#pragma once
+
+#include "TelemetryReader.h"
+#include "UdpSocket.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// Most telemetry ports that can be routed at the same time.
+constexpr size_t kMaxTelemetrySources = 8;
+
+/*
+	One TelemetryReader per UDP port, shared by every pad routed to that port.
+
+	[Routing] in X1nput.ini maps each pad to a port, so one game can drive every
+	pad on the couch or several games (or PCs) can each drive their own pad.
+	The DLL starts the readers of every routed port when it loads its settings,
+	so they are listening before the first frame; a port first routed by a
+	reload starts the first time a pad needs it. Readers run until stop().
+	From then on reader() returns null, but the readers stay allocated, with
+	their last telemetry, until the router is destroyed: a game thread that got
+	a reader just before stop() can keep using it for the rest of its call.
+	Looking one up is a scan of at most kMaxTelemetrySources entries with no
+	lock; only starting a new reader takes the mutex. Readers are built in place
+	in fixed slots, so neither path allocates a reader.
+
+	Every port is served by one thread: it binds new readers, waits on all of
+	their sockets at once with a UdpPoller and drains whichever have datagrams
+	queued. Starting a reader wakes it to pick the new port up; stop() wakes it
+	to exit. If the wait itself fails the thread logs it once and retries with a
+	growing pause (1 ms up to 1 s) that stop() also cuts short, rather than
+	spinning. Replays run on their own threads (see TelemetryReader). Waking the
+	threads and joining them is all stop() waits for; sockets and files are
+	closed with the readers.
+*/
+class TelemetryRouter {
+public:
+	TelemetryRouter();
+	~TelemetryRouter();
+
+	TelemetryRouter(const TelemetryRouter&) = delete;
+	TelemetryRouter& operator=(const TelemetryRouter&) = delete;
+
+	// The reader for port, started if needed. The capture and replay settings in options only apply when port is
+	// options.port; other ports just listen. Returns null if every source is taken by other ports, or after stop().
+	TelemetryReader* reader(uint16_t port, const TelemetryReaderOptions& options);
+
+	// Passed on to every running reader, see TelemetryReader::setOptions() for what can change under one.
+	void setOptions(const TelemetryReaderOptions& value);
+
+	// Stops every reader's thread. Safe while other threads call reader() or use the readers it returned.
+	void stop();
+
+private:
+	struct Source {
+		uint16_t port;
+		std::optional<TelemetryReader> reader;
+	};
+
+	Source sources[kMaxTelemetrySources];
+	std::atomic<size_t> sourceCount;  // Entries below this are fully constructed
+	std::mutex startLock;
+
+	UdpPoller poller;
+	std::thread networkThread;        // Started with the first network reader
+	std::atomic<bool> running;
+	std::atomic<bool> stopped;        // Set by stop(), for good
+	std::mutex backoffLock;           // With backoffSignal, lets stop() end the pause after a failed wait
+	std::condition_variable backoffSignal;
+
+	void run();
+};
+
+// Snapshots taken during one output pass, so pads sharing a port read its SeqLock once.
+class TelemetrySnapshots {
+public:
+	TelemetrySnapshots() : count(0) {}
+
+	const TelemetryData& get(const TelemetryReader& reader);
+
+private:
+	const TelemetryReader* readers[kMaxTelemetrySources];
+	TelemetryData data[kMaxTelemetrySources];
+	size_t count;
+};
@@ -0,0 +1,460 @@
+#include "UdpSocket.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib") // Winsock library
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+static const NativeSocket kInvalidSocket = INVALID_SOCKET;
+#else
+static const NativeSocket kInvalidSocket = -1;
+#endif
+
+static sockaddr_in ToSocketAddress(const UdpEndpoint& endpoint) {
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(endpoint.port);
+	address.sin_addr.s_addr = htonl(endpoint.address);
+	return address;
+}
+
+bool ParseUdpEndpoint(const std::string& text, UdpEndpoint& endpoint) {
+	size_t colon = text.rfind(':');
+	if (colon == std::string::npos) {
+		return false;
+	}
+
+	std::string host = text.substr(0, colon);
+	if (host == "localhost") {
+		host = "127.0.0.1";
+	}
+
+	// a.b.c.d, each part 0..255.
+	uint32_t address = 0;
+	size_t position = 0;
+	for (int part = 0; part < 4; ++part) {
+		size_t end = part < 3 ? host.find('.', position) : host.size();
+		if (end == std::string::npos || end == position || end - position > 3) {
+			return false;
+		}
+		unsigned value = 0;
+		for (size_t i = position; i < end; ++i) {
+			if (host[i] < '0' || host[i] > '9') {
+				return false;
+			}
+			value = value * 10 + (host[i] - '0');
+		}
+		if (value > 255) {
+			return false;
+		}
+		address = (address << 8) | value;
+		position = end + 1;
+	}
+
+	std::string portText = text.substr(colon + 1);
+	char* end = nullptr;
+	long port = std::strtol(portText.c_str(), &end, 10);
+	if (portText.empty() || *end != '\0' || port <= 0 || port > 65535) {
+		return false;
+	}
+
+	endpoint.address = address;
+	endpoint.port = static_cast<uint16_t>(port);
+	return true;
+}
+
+std::string FormatUdpEndpoint(const UdpEndpoint& endpoint) {
+	return std::to_string(endpoint.address >> 24) + "." + std::to_string((endpoint.address >> 16) & 0xff) + "." +
+		std::to_string((endpoint.address >> 8) & 0xff) + "." + std::to_string(endpoint.address & 0xff) + ":" + std::to_string(endpoint.port);
+}
+
+UdpSocket::UdpSocket() : handle(kInvalidSocket), started(false)
+#ifdef _WIN32
+	, readEvent(nullptr)
+#endif
+{
+}
+
+UdpSocket::~UdpSocket() {
+	close();
+}
+
+bool UdpSocket::create() {
+	close();
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		return false;
+	}
+	started = true;
+#endif
+
+	handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (handle == kInvalidSocket) {
+		close();
+		return false;
+	}
+
+#ifdef _WIN32
+	// Also makes the socket non-blocking. UdpPoller waits on the event.
+	readEvent = WSACreateEvent();
+	if (readEvent == WSA_INVALID_EVENT || WSAEventSelect(handle, readEvent, FD_READ) != 0) {
+		close();
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+bool UdpSocket::bind(uint16_t port) {
+	if (!create()) {
+		return false;
+	}
+
+	sockaddr_in server = {};
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (::bind(handle, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) != 0) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool UdpSocket::open() {
+	return create();
+}
+
+void UdpSocket::close() {
+	if (handle != kInvalidSocket) {
+#ifdef _WIN32
+		closesocket(handle);
+#else
+		::close(handle);
+#endif
+		handle = kInvalidSocket;
+	}
+
+#ifdef _WIN32
+	if (readEvent != nullptr && readEvent != WSA_INVALID_EVENT) {
+		WSACloseEvent(readEvent);
+	}
+	readEvent = nullptr;
+
+	if (started) {
+		WSACleanup();
+		started = false;
+	}
+#endif
+}
+
+bool UdpSocket::isOpen() const {
+	return handle != kInvalidSocket;
+}
+
+bool UdpSocket::sendTo(const UdpEndpoint& endpoint, const char* data, size_t length) {
+	sockaddr_in target = ToSocketAddress(endpoint);
+
+#ifdef _WIN32
+	int sent = sendto(handle, data, static_cast<int>(length), 0, reinterpret_cast<const sockaddr*>(&target), sizeof(target));
+	return sent == static_cast<int>(length);
+#else
+	ssize_t sent = sendto(handle, data, length, MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&target), sizeof(target));
+	return sent == static_cast<ssize_t>(length);
+#endif
+}
+
+#ifdef _WIN32
+
+int UdpSocket::receive(DatagramBatch& batch) {
+	batch.count = 0;
+
+	while (batch.count < DatagramBatch::kCapacity) {
+		int length = recv(handle, batch.data[batch.count], DatagramBatch::kDatagramSize, 0);
+		if (length == SOCKET_ERROR) {
+			// WSAEWOULDBLOCK: nothing more queued.
+			// WSAEMSGSIZE: oversized datagram, it was truncated and is dropped by the decoder.
+			// WSAECONNRESET: ICMP port unreachable from an earlier send, harmless for a receiver.
+			int error = WSAGetLastError();
+			if (error == WSAEWOULDBLOCK) {
+				break;
+			}
+			else if (error == WSAEMSGSIZE) {
+				length = DatagramBatch::kDatagramSize;
+			}
+			else if (error == WSAECONNRESET) {
+				continue;
+			}
+			else {
+				return batch.count > 0 ? batch.count : -1;
+			}
+		}
+
+		batch.lengths[batch.count++] = length;
+	}
+
+	return batch.count;
+}
+
+size_t UdpSocket::sendBatch(OutgoingDatagram* datagrams, size_t count) {
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i) {
+		datagrams[i].sent = false;
+	}
+
+	// Winsock has no call that sends several datagrams, each goes out with its own WSASendMsg().
+	for (size_t i = 0; i < count; ++i) {
+		sockaddr_in target = ToSocketAddress(*datagrams[i].endpoint);
+		WSABUF buffer;
+		buffer.len = static_cast<ULONG>(datagrams[i].length);
+		buffer.buf = const_cast<char*>(datagrams[i].data);
+		WSAMSG message = {};
+		message.name = reinterpret_cast<sockaddr*>(&target);
+		message.namelen = sizeof(target);
+		message.lpBuffers = &buffer;
+		message.dwBufferCount = 1;
+
+		DWORD sent = 0;
+		if (WSASendMsg(handle, &message, 0, &sent, nullptr, nullptr) == 0) {
+			datagrams[i].sent = true;
+			++total;
+		}
+		else if (WSAGetLastError() == WSAEWOULDBLOCK) {
+			break; // The send buffer is full
+		}
+	}
+	return total;
+}
+
+UdpPoller::UdpPoller() : count(0), wakeEvent(CreateEventA(NULL, FALSE, FALSE, NULL)) {
+}
+
+UdpPoller::~UdpPoller() {
+	if (wakeEvent != nullptr) {
+		CloseHandle(wakeEvent);
+	}
+}
+
+bool UdpPoller::add(UdpSocket& socket, size_t tag) {
+	if (count == kMaxPolledSockets || socket.readEvent == nullptr) {
+		return false;
+	}
+	events[count] = socket.readEvent;
+	tags[count] = tag;
+	++count;
+	return true;
+}
+
+void UdpPoller::clear() {
+	count = 0;
+}
+
+void UdpPoller::wake() {
+	if (wakeEvent != nullptr) {
+		SetEvent(wakeEvent);
+	}
+}
+
+int UdpPoller::wait(size_t* ready, size_t capacity) {
+	// wakeEvent resets itself when this wait takes it. A read event is reset before the socket is drained: any
+	// datagram still queued after the drain signals it again.
+	events[count] = wakeEvent;
+	DWORD total = static_cast<DWORD>(count + (wakeEvent != nullptr ? 1 : 0));
+	DWORD signalled = WSAWaitForMultipleEvents(total, events, FALSE, WSA_INFINITE, FALSE);
+	if (signalled < WSA_WAIT_EVENT_0 || signalled >= WSA_WAIT_EVENT_0 + total) {
+		return -1;
+	}
+	size_t first = signalled - WSA_WAIT_EVENT_0;
+	if (first == count) {
+		return 0;
+	}
+
+	// The wait only reports the first signalled event, look at the ones after it without waiting.
+	size_t found = 0;
+	for (size_t i = first; i < count && found < capacity; ++i) {
+		if (i == first || WSAWaitForMultipleEvents(1, &events[i], FALSE, 0, FALSE) == WSA_WAIT_EVENT_0) {
+			WSAResetEvent(events[i]);
+			ready[found++] = tags[i];
+		}
+	}
+	return static_cast<int>(found);
+}
+
+#else
+
+int UdpSocket::receive(DatagramBatch& batch) {
+	batch.count = 0;
+
+	mmsghdr messages[DatagramBatch::kCapacity];
+	iovec vectors[DatagramBatch::kCapacity];
+
+	for (int i = 0; i < DatagramBatch::kCapacity; ++i) {
+		vectors[i].iov_base = batch.data[i];
+		vectors[i].iov_len = DatagramBatch::kDatagramSize;
+		messages[i] = {};
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int received;
+	do {
+		received = recvmmsg(handle, messages, DatagramBatch::kCapacity, MSG_DONTWAIT, nullptr);
+	} while (received < 0 && errno == EINTR);
+
+	if (received < 0) {
+		return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+	}
+
+	for (int i = 0; i < received; ++i) {
+		batch.lengths[i] = static_cast<int>(messages[i].msg_len);
+	}
+	batch.count = received;
+	return received;
+}
+
+size_t UdpSocket::sendBatch(OutgoingDatagram* datagrams, size_t count) {
+	const size_t kChunk = 64;
+	mmsghdr messages[kChunk];
+	iovec vectors[kChunk];
+	sockaddr_in targets[kChunk];
+
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i) {
+		datagrams[i].sent = false;
+	}
+
+	for (size_t first = 0; first < count; first += kChunk) {
+		size_t chunk = std::min(count - first, kChunk);
+		for (size_t i = 0; i < chunk; ++i) {
+			const OutgoingDatagram& datagram = datagrams[first + i];
+			targets[i] = ToSocketAddress(*datagram.endpoint);
+			vectors[i].iov_base = const_cast<char*>(datagram.data);
+			vectors[i].iov_len = datagram.length;
+			messages[i] = {};
+			messages[i].msg_hdr.msg_name = &targets[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(targets[i]);
+			messages[i].msg_hdr.msg_iov = &vectors[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		// sendmmsg() stops at the first datagram it cannot send; skip that one and go on with the others.
+		size_t next = 0;
+		while (next < chunk) {
+			int sent = sendmmsg(handle, messages + next, static_cast<unsigned>(chunk - next), MSG_DONTWAIT);
+			if (sent < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+					return total; // The send buffer is full
+				}
+				++next; // This target refused it (unreachable network, ...)
+				continue;
+			}
+			for (int i = 0; i < sent; ++i) {
+				datagrams[first + next + i].sent = true;
+			}
+			total += sent;
+			next += sent;
+		}
+	}
+	return total;
+}
+
+// Tag of the wake pipe in the epoll set.
+static const uint64_t kWakeTag = ~0ull;
+
+UdpPoller::UdpPoller() : epollHandle(-1), wakePipe{ -1, -1 } {
+	if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+		wakePipe[0] = wakePipe[1] = -1;
+	}
+	clear();
+}
+
+UdpPoller::~UdpPoller() {
+	if (epollHandle >= 0) {
+		::close(epollHandle);
+	}
+	for (int fd : wakePipe) {
+		if (fd >= 0) {
+			::close(fd);
+		}
+	}
+}
+
+bool UdpPoller::add(UdpSocket& socket, size_t tag) {
+	if (epollHandle < 0 || !socket.isOpen()) {
+		return false;
+	}
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.u64 = tag;
+	return epoll_ctl(epollHandle, EPOLL_CTL_ADD, socket.handle, &event) == 0;
+}
+
+void UdpPoller::clear() {
+	// A fresh set holding only the wake pipe.
+	if (epollHandle >= 0) {
+		::close(epollHandle);
+	}
+	epollHandle = epoll_create1(EPOLL_CLOEXEC);
+	if (epollHandle >= 0 && wakePipe[0] >= 0) {
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u64 = kWakeTag;
+		epoll_ctl(epollHandle, EPOLL_CTL_ADD, wakePipe[0], &event);
+	}
+}
+
+void UdpPoller::wake() {
+	if (wakePipe[1] >= 0) {
+		char signal = 0;
+		(void)!write(wakePipe[1], &signal, 1);  // A full pipe already holds a wake-up
+	}
+}
+
+int UdpPoller::wait(size_t* ready, size_t capacity) {
+	epoll_event events[kMaxPolledSockets + 1];
+	int signalled;
+	do {
+		signalled = epoll_wait(epollHandle, events, kMaxPolledSockets + 1, -1);
+	} while (signalled < 0 && errno == EINTR);
+	if (signalled < 0) {
+		return -1;
+	}
+
+	size_t found = 0;
+	for (int i = 0; i < signalled; ++i) {
+		if (events[i].data.u64 == kWakeTag) {
+			char drained[64];
+			while (read(wakePipe[0], drained, sizeof(drained)) > 0) {
+			}
+			return 0;
+		}
+		if (found < capacity) {
+			ready[found++] = static_cast<size_t>(events[i].data.u64);
+		}
+	}
+	return static_cast<int>(found);
+}
+
+#endif
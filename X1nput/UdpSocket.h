@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+typedef uintptr_t NativeSocket; // SOCKET
+#else
+typedef int NativeSocket;
+#endif
+
+// Fixed storage for one drain pass. Large enough for any UDP datagram sent over Ethernet.
+struct DatagramBatch {
+	static constexpr int kCapacity = 16;
+	static constexpr int kDatagramSize = 1500;
+
+	char data[kCapacity][kDatagramSize];
+	int lengths[kCapacity];
+	int count;
+};
+
+// IPv4 address and port, both in host byte order.
+struct UdpEndpoint {
+	uint32_t address = 0;
+	uint16_t port = 0;
+};
+
+// Parses "a.b.c.d:port" (or "localhost:port"). Returns false for anything else.
+bool ParseUdpEndpoint(const std::string& text, UdpEndpoint& endpoint);
+// "a.b.c.d:port", for messages.
+std::string FormatUdpEndpoint(const UdpEndpoint& endpoint);
+
+// One datagram of a UdpSocket::sendBatch() call.
+struct OutgoingDatagram {
+	const UdpEndpoint* endpoint;
+	const char* data;
+	size_t length;
+	bool sent;  // Set by sendBatch()
+};
+
+/*
+	Minimal UDP socket: Winsock on Windows, BSD sockets elsewhere.
+
+	The socket never blocks. receive() takes every datagram that is already
+	queued (up to the batch capacity) and returns; waiting for the next one is
+	UdpPoller's job, which waits on any number of sockets at once. On Linux a
+	receive() is a single recvmmsg() call.
+*/
+class UdpSocket {
+public:
+	UdpSocket();
+	~UdpSocket();
+
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+
+	// Bind to INADDR_ANY:port. Returns false if the socket could not be created or bound.
+	bool bind(uint16_t port);
+	// An unbound socket for sending only.
+	bool open();
+	void close();
+	bool isOpen() const;
+
+	// Fills the batch. Returns the number of datagrams received, 0 when nothing is queued, or -1 on error.
+	int receive(DatagramBatch& batch);
+
+	// Sends one datagram. Returns false if it could not be queued.
+	bool sendTo(const UdpEndpoint& endpoint, const char* data, size_t length);
+
+	// Sends every datagram without waiting: one sendmmsg() per 64 datagrams on Linux, a WSASendMsg() each on
+	// Windows. Once the send buffer is full the rest are left unsent. Sets each one's sent and returns how many were.
+	size_t sendBatch(OutgoingDatagram* datagrams, size_t count);
+
+private:
+	friend class UdpPoller;
+
+	NativeSocket handle;
+	bool started; // Winsock initialized
+#ifdef _WIN32
+	void* readEvent;  // Signalled by Winsock when a datagram is queued (WSAEventSelect)
+#endif
+
+	bool create();
+};
+
+// Most sockets one UdpPoller waits on.
+constexpr size_t kMaxPolledSockets = 16;
+
+/*
+	Waits until one of several UdpSockets has a datagram queued: epoll on Linux,
+	WSAWaitForMultipleEvents on the sockets' read events on Windows.
+
+	The wait can be interrupted: wake() from any thread makes the wait() that is
+	waiting, or the next one to wait, return 0. The wake handle (a pipe on Linux,
+	an event on Windows) is created with the poller, so a wake() can never be
+	lost to a thread that has not started waiting yet. add() and wait() belong to
+	the thread that polls.
+*/
+class UdpPoller {
+public:
+	UdpPoller();
+	~UdpPoller();
+
+	UdpPoller(const UdpPoller&) = delete;
+	UdpPoller& operator=(const UdpPoller&) = delete;
+
+	// Watches a bound socket; wait() reports it by tag. Returns false when the poller is full or the socket is closed.
+	bool add(UdpSocket& socket, size_t tag);
+	// Forgets every socket, for example before they are closed.
+	void clear();
+
+	// Stores the tags of the sockets with datagrams queued in ready. Returns how many, 0 when woken, or -1 on error.
+	// A wait interrupted by a signal (EINTR) is not an error: it is restarted.
+	int wait(size_t* ready, size_t capacity);
+
+	// Interrupts wait(). Safe to call from any thread, at any time.
+	void wake();
+
+private:
+#ifdef _WIN32
+	void* events[kMaxPolledSockets + 1];  // The sockets' read events, then wakeEvent
+	size_t tags[kMaxPolledSockets];
+	size_t count;
+	void* wakeEvent;
+#else
+	int epollHandle;
+	int wakePipe[2];
+#endif
+};
@@ -0,0 +1,57 @@
+#include "VibrationCoalescer.h"
+
+#include <algorithm>
+#include <cmath>
+
+static double Quantize(double value, double levels) {
+	return std::round(std::max(0.0, std::min(value, 1.0)) * levels) / levels;
+}
+
+static double Floor(double value, double silence) {
+	return value < silence ? 0.0 : value;
+}
+
+static bool IsSilent(const HapticsOutput& output) {
+	return output.LeftMotor == 0 && output.RightMotor == 0 && output.LeftTrigger == 0 && output.RightTrigger == 0;
+}
+
+bool VibrationCoalescer::update(const VibrationCoalescerOptions& options, HapticsOutput& output, uint64_t nowNs) {
+	if (options.resolution > 0) {
+		double levels = options.resolution;
+		output.LeftMotor = Quantize(output.LeftMotor, levels);
+		output.RightMotor = Quantize(output.RightMotor, levels);
+		output.LeftTrigger = Quantize(output.LeftTrigger, levels);
+		output.RightTrigger = Quantize(output.RightTrigger, levels);
+	}
+	else {
+		// Otherwise a fading channel never reaches exactly 0, and its last traces are held back like any small change.
+		double silence = std::max(options.threshold * 0.5, 0.5 / 65535);
+		output.LeftMotor = Floor(output.LeftMotor, silence);
+		output.RightMotor = Floor(output.RightMotor, silence);
+		output.LeftTrigger = Floor(output.LeftTrigger, silence);
+		output.RightTrigger = Floor(output.RightTrigger, silence);
+	}
+
+	bool send;
+	if (!hasSent) {
+		send = true;
+	}
+	else if (IsSilent(output)) {
+		send = !IsSilent(lastSent);  // Stopping is never held back
+	}
+	else {
+		// The values are rounded, so a change of exactly the threshold must not get through on rounding noise.
+		send = VibrationChanged(lastSent, output, options.threshold + 1e-9) &&
+			(options.maxRate == 0 || nowNs - lastSentNs >= 1000000000ull / options.maxRate);
+	}
+
+	if (!send) {
+		suppressedCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	lastSent = output;
+	lastSentNs = nowNs;
+	hasSent = true;
+	sentCount.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "HapticsEngine.h"
+
+#include <atomic>
+#include <cstdint>
+
+// [Output] settings of the stage between the effects and put_Vibration.
+struct VibrationCoalescerOptions {
+	unsigned resolution = 100;  // Levels per channel the controller tells apart (whole percent on Xbox One pads), 0 sends values as they are
+	double threshold = 0.01;    // Smallest change that is sent
+	unsigned maxRate = 0;       // Most updates per second per pad, 0 for no limit
+};
+
+/*
+	Decides, for one pad, which outputs reach put_Vibration.
+
+	Every call to the driver is a report over USB or the radio link, and
+	wireless pads in particular lag when they are flooded. The effects and the
+	output thread produce values far more often, and far more finely, than the
+	controller can play them, so each output is rounded to the controller's
+	resolution and only sent when a channel moves by more than the threshold,
+	at most maxRate times per second. Without rounding (resolution 0), values
+	under half the threshold, or under half a step of XInput's 16-bit motor
+	speeds, are rounded to 0 instead.
+
+	Silence is the exception: the first all-zero output after a non-zero one
+	is always sent, at once, so a pad never keeps buzzing on a change that was
+	held back. A held back change goes out on a later update once it is due,
+	the output thread updates every tick and the game calls XInputSetState
+	every frame.
+
+	update() belongs to the thread computing the pad's output; the counters
+	can be read from anywhere.
+*/
+class VibrationCoalescer {
+public:
+	VibrationCoalescer() : lastSent(), lastSentNs(0), hasSent(false), sentCount(0), suppressedCount(0) {}
+
+	// Rounds output to the resolution. Returns true if it should be sent now, false if the controller already plays
+	// something close enough or the last update was too recent.
+	bool update(const VibrationCoalescerOptions& options, HapticsOutput& output, uint64_t nowNs);
+
+	// The controller plays nothing known (a new or reconnected one): the next output is sent.
+	void reset() { hasSent = false; }
+
+	// Counters since the pad was first used.
+	uint64_t sent() const { return sentCount.load(std::memory_order_relaxed); }
+	uint64_t suppressed() const { return suppressedCount.load(std::memory_order_relaxed); }
+
+private:
+	HapticsOutput lastSent;
+	uint64_t lastSentNs;
+	bool hasSent;
+
+	std::atomic<uint64_t> sentCount;
+	std::atomic<uint64_t> suppressedCount;
+};
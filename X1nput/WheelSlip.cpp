@@ -0,0 +1,97 @@
+#include "WheelSlip.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define X1NPUT_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define X1NPUT_NEON 1
+#include <arm_neon.h>
+#endif
+
+static const float kGripScale = 1.f / (kWheelSlipFull - kWheelSlipStart);
+static const float kSmallestSlip = 1e-6f;  // Keeps the share finite for a wheel that does not slip at all
+
+WheelSlipResult AnalyzeWheelSlipReference(const float slipRatio[4], const float combinedSlip[4]) {
+	float lockup[4];
+	float wheelspin[4];
+	for (int wheel = 0; wheel < 4; ++wheel) {
+		// fmax drops a NaN operand. A NaN ratio leaves a NaN share, which the clamps turn into 0.
+		float ratio = slipRatio[wheel];
+		float size = std::fmax(std::fmax(combinedSlip[wheel], std::fabs(ratio)), kSmallestSlip);
+		float grip = std::fmin(std::fmax((size - kWheelSlipStart) * kGripScale, 0.f), 1.f);
+		float share = ratio / size;
+		lockup[wheel] = grip * std::fmin(std::fmax(-share, 0.f), 1.f);
+		wheelspin[wheel] = grip * std::fmin(std::fmax(share, 0.f), 1.f);
+	}
+
+	WheelSlipResult result;
+	result.LockupFront = std::fmax(lockup[0], lockup[1]);
+	result.LockupRear = std::fmax(lockup[2], lockup[3]);
+	result.WheelspinFront = std::fmax(wheelspin[0], wheelspin[1]);
+	result.WheelspinRear = std::fmax(wheelspin[2], wheelspin[3]);
+	result.Lockup = std::fmax(result.LockupFront, result.LockupRear);
+	result.Wheelspin = std::fmax(result.WheelspinFront, result.WheelspinRear);
+	return result;
+}
+
+WheelSlipResult AnalyzeWheelSlip(const float slipRatio[4], const float combinedSlip[4]) {
+#if defined(X1NPUT_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+
+	// _mm_max_ps/_mm_min_ps return the second operand when either is NaN, so the clamps turn NaN into 0 like the reference.
+	__m128 ratio = _mm_loadu_ps(slipRatio);
+	__m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.f), ratio);
+	__m128 size = _mm_max_ps(_mm_max_ps(_mm_loadu_ps(combinedSlip), magnitude), _mm_set1_ps(kSmallestSlip));
+	__m128 grip = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(size, _mm_set1_ps(kWheelSlipStart)), _mm_set1_ps(kGripScale)), zero), one);
+	__m128 share = _mm_div_ps(ratio, size);
+	__m128 lockup = _mm_mul_ps(grip, _mm_min_ps(_mm_max_ps(_mm_sub_ps(zero, share), zero), one));
+	__m128 wheelspin = _mm_mul_ps(grip, _mm_min_ps(_mm_max_ps(share, zero), one));
+
+	// [FL, FR, RL, RR] -> [front, rear] of both, then the worse axle of both.
+	__m128 lefts = _mm_shuffle_ps(lockup, wheelspin, _MM_SHUFFLE(2, 0, 2, 0));   // [lock FL, lock RL, spin FL, spin RL]
+	__m128 rights = _mm_shuffle_ps(lockup, wheelspin, _MM_SHUFFLE(3, 1, 3, 1));  // [lock FR, lock RR, spin FR, spin RR]
+	__m128 axles = _mm_max_ps(lefts, rights);                                    // [lock F, lock R, spin F, spin R]
+	__m128 worst = _mm_max_ps(axles, _mm_shuffle_ps(axles, axles, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	float values[4];
+	_mm_storeu_ps(values, axles);
+	WheelSlipResult result;
+	result.LockupFront = values[0];
+	result.LockupRear = values[1];
+	result.WheelspinFront = values[2];
+	result.WheelspinRear = values[3];
+	result.Lockup = _mm_cvtss_f32(worst);
+	result.Wheelspin = _mm_cvtss_f32(_mm_movehl_ps(worst, worst));
+	return result;
+#elif defined(X1NPUT_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.f);
+	const float32x4_t one = vdupq_n_f32(1.f);
+
+	// vmaxnmq_f32 returns the number when the other operand is NaN.
+	float32x4_t ratio = vld1q_f32(slipRatio);
+	float32x4_t size = vmaxnmq_f32(vmaxnmq_f32(vld1q_f32(combinedSlip), vabsq_f32(ratio)), vdupq_n_f32(kSmallestSlip));
+	float32x4_t grip = vminq_f32(vmaxnmq_f32(vmulq_f32(vsubq_f32(size, vdupq_n_f32(kWheelSlipStart)), vdupq_n_f32(kGripScale)), zero), one);
+	float32x4_t share = vdivq_f32(ratio, size);
+	float32x4_t lockup = vmulq_f32(grip, vminq_f32(vmaxnmq_f32(vnegq_f32(share), zero), one));
+	float32x4_t wheelspin = vmulq_f32(grip, vminq_f32(vmaxnmq_f32(share, zero), one));
+
+	// Pairwise maximum: [FL, FR, RL, RR] -> [front, rear].
+	float32x2_t lockupAxles = vpmax_f32(vget_low_f32(lockup), vget_high_f32(lockup));
+	float32x2_t wheelspinAxles = vpmax_f32(vget_low_f32(wheelspin), vget_high_f32(wheelspin));
+	float32x2_t worst = vpmax_f32(lockupAxles, wheelspinAxles);
+
+	WheelSlipResult result;
+	result.LockupFront = vget_lane_f32(lockupAxles, 0);
+	result.LockupRear = vget_lane_f32(lockupAxles, 1);
+	result.WheelspinFront = vget_lane_f32(wheelspinAxles, 0);
+	result.WheelspinRear = vget_lane_f32(wheelspinAxles, 1);
+	result.Lockup = vget_lane_f32(worst, 0);
+	result.Wheelspin = vget_lane_f32(worst, 1);
+	return result;
+#else
+	return AnalyzeWheelSlipReference(slipRatio, combinedSlip);
+#endif
+}
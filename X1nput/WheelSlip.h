@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+	Per-wheel lock-up and wheelspin for the ABS and traction effects.
+
+	Slip (the length of all four slip ratios) fires when every tyre slips a
+	little and can miss a single locked wheel. AnalyzeWheelSlip() looks at each
+	wheel on its own instead, in one SSE2/NEON pass over the four wheels:
+
+		grip loss   how far the combined slip (slip ratio and slip angle
+		            together, 1 is the limit of the tyre) is past
+		            kWheelSlipStart, 0 there and 1 at kWheelSlipFull
+		direction   the slip ratio's share of it: a wheel turning slower than
+		            the road (ratio < 0) is locking, faster (ratio > 0) is
+		            spinning, and a tyre sliding sideways is neither
+
+	Lock-up is grip loss times the backward share, wheelspin times the forward
+	share, and each axle reports its worse wheel. Games that leave the combined
+	slip at 0 get the slip ratio's size instead. Inputs are in the order
+	front left, front right, rear left, rear right; NaN reads as no slip.
+*/
+
+constexpr float kWheelSlipStart = 0.8f;
+constexpr float kWheelSlipFull = 1.8f;
+
+struct WheelSlipResult {
+	float LockupFront;     // 0..1
+	float LockupRear;
+	float WheelspinFront;
+	float WheelspinRear;
+	float Lockup;          // The worse axle
+	float Wheelspin;
+};
+
+WheelSlipResult AnalyzeWheelSlip(const float slipRatio[4], const float combinedSlip[4]);
+
+// The same one wheel at a time, the reference for the SIMD versions. Both give the same results.
+WheelSlipResult AnalyzeWheelSlipReference(const float slipRatio[4], const float combinedSlip[4]);
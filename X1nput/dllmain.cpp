@@ -1,976 +1,1040 @@
-/*
-	Thanks to r57zone for his Xinput emulation library
-	https://github.com/r57zone/XInput
-*/
-
-#include "stdafx.h"
-#include <thread>
-#include <atomic>
-#include <winsock2.h>
-#include <iostream>
-#include <cmath>  // Ω exp  Used for the exp function
-#pragma comment(lib, "ws2_32.lib") // Winsock library
-#include <cstring> // ݭn]tYHϥ std::memcpy ,need to include this header to use `std::memcpy`.
-
-struct TelemetryData {
-
-	float Speed;                       // t]/^Vehicle speed in meters per second
-	float EngineIdleRpm;               // t RPM Engine idle RPM
-	float CurrentEngineRpm;            // e RPM Current engine RPM
-	float EngineMaxRpm;                // ̤j RPM Maximum engine RPM
-	float TireSlipRatioFrontLeft;      // eƲv Front-left tire slip ratio
-	float TireSlipRatioFrontRight;     // keƲv Front-right tire slip ratio
-	float TireSlipRatioRearLeft;       // Ʋv Rear-left tire slip ratio
-	float TireSlipRatioRearRight;      // kƲv Rear-right tire slip ratio
-
-	float Slip;                        // p⪺Ʋ(Slip<1:íwA1<Slip:}lƲA٨ɻݶ}ABS) Calculated slip value (Slip < 1: stable; Slip > 1: beginning to slide; ABS needed if braking)
-	float NRPM;                        // W  RPM (0:PtۦPA1:̰t) Normalized RPM (0: equal to idle speed, 1: maximum RPM)
-
-	float AccelerationX;               // X:k   X = right
-	float AccelerationY;			   // Y:WU   Y = up
-	float AccelerationZ;			   // Z:e   Z = forward
-	float Acceleration;                // I(>20MXp) Collision detection (> 20 indicates a sudden event)
-
-	uint8_t Gear;                      // ɦ(0:R 1:1 ...) Detect gear position (0:R 1:1 ...)
-
-};
-
-class TelemetryReader {
-public:
-	TelemetryReader() : running(true) {
-		// ЫبñҰʱƾڪ Create and start a thread to receive data
-		readerThread = std::thread(&TelemetryReader::run, this);
-	}
-	~TelemetryReader() {
-		//  Stop the thread
-		running = false;
-		if (readerThread.joinable()) {
-			readerThread.join(); // ݰ Wait for the thread to finish
-		}
-	}
-	float getSpeed() { return telemetryData.Speed; } // ^et Return the current speed.
-	float getSlip() { return telemetryData.Slip; }   // ^eƲ(Slip<1:íwA1<Slip:}lƲA٨ɻݶ}ABS) Return the current slip (Slip < 1: stable, Slip > 1: starting to slide, ABS must be engaged when braking).
-	float getNRPM() { return telemetryData.NRPM; }   // ^eWt(0:PtۦPA1:̰t) Return the current normalized RPM (0: same as idle, 1: maximum RPM).
-	float getCRPM() { return telemetryData.CurrentEngineRpm; } // ^t(0:CȰA_ʼȰ) Return the RPM (0: game is paused, vibration is paused).
-	float getAcceleration() { return telemetryData.Acceleration; } // ^e[t(>20MXpAϥ Float BUMP ()) Return the current acceleration (> 20 indicates a sudden event, use Float BUMP (collision)).
-	int   getGear() { return telemetryData.Gear; }
-
-
-private:
-	std::atomic<bool> running; // B檺ܼ Variable to control the execution thread.
-	std::thread readerThread; // ƾڪ, Thread for receiving data.
-	TelemetryData telemetryData; // sx telemetry ƾ, Store telemetry data.
-
-	void run() {
-		WSADATA wsaData;
-		SOCKET sock;
-		sockaddr_in server;
-		const int bufferSize = 1024;
-		char buffer[bufferSize];
-
-		// l Winsock, Initialize Winsock.
-		WSAStartup(MAKEWORD(2, 2), &wsaData);
-
-		// Ы socket, Create socket.
-		sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-		server.sin_family = AF_INET;
-		server.sin_port = htons(9999); // ]w Forza ǿݤf, Set the transmission port for Forza.
-		server.sin_addr.s_addr = INADDR_ANY;
-
-		// jw socket, Bind socket.
-		bind(sock, (struct sockaddr*)&server, sizeof(server));
-
-		std::cout << "Waiting for telemetry data..." << std::endl;
-
-		while (running) {
-			// ƾڥ], Receive data packet.
-			int recvLen = recv(sock, buffer, bufferSize, 0);
-			if (recvLen != SOCKET_ERROR) {
-				// ѪRƾڥ], Parse data packet.
-				telemetryData = parseTelemetryData(buffer);
-			}
-		}
-
-		//  socket, Close socket.
-		closesocket(sock);
-		WSACleanup();
-	}
-
-	TelemetryData parseTelemetryData(const char* data) {
-		TelemetryData telemetryData;
-		int offset = 12;
-
-		// ѪRһݼƾ, Parse the required data.
-		telemetryData.Speed = *reinterpret_cast<const float*>(&data[offset+244]);
-
-		telemetryData.EngineMaxRpm = *reinterpret_cast<const float*>(&data[8]);
-		telemetryData.EngineIdleRpm = *reinterpret_cast<const float*>(&data[12]);
-		telemetryData.CurrentEngineRpm = *reinterpret_cast<const float*>(&data[16]);
-		
-		telemetryData.TireSlipRatioFrontLeft = *reinterpret_cast<const float*>(&data[84]);
-		telemetryData.TireSlipRatioFrontRight = *reinterpret_cast<const float*>(&data[88]);
-		telemetryData.TireSlipRatioRearLeft = *reinterpret_cast<const float*>(&data[92]);
-		telemetryData.TireSlipRatioRearRight = *reinterpret_cast<const float*>(&data[96]);
-
-		
-		telemetryData.AccelerationX = *reinterpret_cast<const float*>(&data[20]);
-		telemetryData.AccelerationY = *reinterpret_cast<const float*>(&data[24]);
-		telemetryData.AccelerationZ = *reinterpret_cast<const float*>(&data[28]);
-		
-		// ϥ std::memcpy Ӧwaƻsƾ, Use `std::memcpy` to safely copy data.
-		std::memcpy(&telemetryData.Gear, &data[offset + 307], sizeof(uint8_t));
-
-
-		// p Slip M NRPM, Calculate Slip and NRPM.
-		telemetryData.Slip = sqrt(
-			pow(telemetryData.TireSlipRatioFrontLeft, 2) +
-			pow(telemetryData.TireSlipRatioFrontRight, 2) +
-			pow(telemetryData.TireSlipRatioRearLeft, 2) +
-			pow(telemetryData.TireSlipRatioRearRight, 2)
-		);
-		
-
-		telemetryData.NRPM = (telemetryData.CurrentEngineRpm - telemetryData.EngineIdleRpm + 0.001) /
-			(telemetryData.EngineMaxRpm - telemetryData.EngineIdleRpm);
-
-		telemetryData.Acceleration = sqrt(pow(telemetryData.AccelerationZ, 2)
-			+ pow(telemetryData.AccelerationY, 2));
-
-		return telemetryData;
-	}
-};
-#define XINPUT_GAMEPAD_DPAD_UP          0x0001
-#define XINPUT_GAMEPAD_DPAD_DOWN        0x0002
-#define XINPUT_GAMEPAD_DPAD_LEFT        0x0004
-#define XINPUT_GAMEPAD_DPAD_RIGHT       0x0008
-#define XINPUT_GAMEPAD_START            0x0010
-#define XINPUT_GAMEPAD_BACK             0x0020
-#define XINPUT_GAMEPAD_LEFT_THUMB       0x0040
-#define XINPUT_GAMEPAD_RIGHT_THUMB      0x0080
-#define XINPUT_GAMEPAD_LEFT_SHOULDER    0x0100
-#define XINPUT_GAMEPAD_RIGHT_SHOULDER   0x0200
-#define XINPUT_GAMEPAD_A                0x1000
-#define XINPUT_GAMEPAD_B                0x2000
-#define XINPUT_GAMEPAD_X                0x4000
-#define XINPUT_GAMEPAD_Y				0x8000
-
-#define XINPUT_CAPS_FFB_SUPPORTED       0x0001
-#define XINPUT_CAPS_WIRELESS            0x0002
-#define XINPUT_CAPS_PMD_SUPPORTED       0x0008
-#define XINPUT_CAPS_NO_NAVIGATION       0x0010
-
-//
-// Flags for battery status level
-//
-#define BATTERY_TYPE_DISCONNECTED       0x00    // This device is not connected
-#define BATTERY_TYPE_WIRED              0x01    // Wired device, no battery
-#define BATTERY_TYPE_ALKALINE           0x02    // Alkaline battery source
-#define BATTERY_TYPE_NIMH               0x03    // Nickel Metal Hydride battery source
-#define BATTERY_TYPE_UNKNOWN            0xFF    // Cannot determine the battery type
-
-// These are only valid for wireless, connected devices, with known battery types
-// The amount of use time remaining depends on the type of device.
-#define BATTERY_LEVEL_EMPTY             0x00
-#define BATTERY_LEVEL_LOW               0x01
-#define BATTERY_LEVEL_MEDIUM            0x02
-#define BATTERY_LEVEL_FULL              0x03
-
-
-#define XINPUT_DEVTYPE_GAMEPAD          0x01
-#define XINPUT_DEVSUBTYPE_GAMEPAD       0x01
-
-#define BATTERY_TYPE_DISCONNECTED		0x00
-
-#define XUSER_MAX_COUNT                 4
-#define MAX_PLAYER_COUNT				8
-#define XUSER_INDEX_ANY					0x000000FF
-
-#define ERROR_DEVICE_NOT_CONNECTED		1167
-#define ERROR_SUCCESS					0
-
-#define CONFIG_PATH						_T(".\\X1nput.ini")
-
-
-using namespace ABI::Windows::Foundation::Collections;
-using namespace ABI::Windows::Gaming::Input;
-using namespace Microsoft::WRL;
-using namespace Microsoft::WRL::Wrappers;
-
-const float c_XboxOneThumbDeadZone = .24f;  // Recommended Xbox One controller deadzone
-
-ComPtr<IGamepadStatics> gamepadStatics;
-ComPtr<IGamepad> gamepads[MAX_PLAYER_COUNT];
-EventRegistrationToken mUserChangeToken[MAX_PLAYER_COUNT];
-
-EventRegistrationToken gAddedToken;
-EventRegistrationToken gRemovedToken;
-
-int mMostRecentGamepad = 0;
-
-HRESULT hr;
-
-float RTriggerStrength = 0.25f;
-float LTriggerStrength = 0.25f;
-float RMotorStrength = 1.0f;
-float LMotorStrength = 1.0f;
-float enteredSpeedCheck = 0.0f;
-float globalRightTrigger = 0;
-float globalLeftTrigger = 0;
-bool TriggerSwap = false;
-bool MotorSwap = false;
-
-
-
-// Config related methods, thanks to xiaohe521, https://www.codeproject.com/Articles/10809/A-Small-Class-to-Read-INI-File
-#pragma region Config loading
-float GetConfigFloat(LPCSTR AppName, LPCSTR KeyName, LPCSTR Default) {
-	TCHAR result[256];
-	GetPrivateProfileString(AppName, KeyName, Default, result, 256, CONFIG_PATH);
-	return atof(result);
-}
-
-bool GetConfigBool(LPCSTR AppName, LPCSTR KeyName, LPCSTR Default) {
-	TCHAR result[256];
-	GetPrivateProfileString(AppName, KeyName, Default, result, 256, CONFIG_PATH);
-	// Thanks to CookiePLMonster for recommending _tcsicmp to me
-	return _tcsicmp(result, "true") == 0 ? true : false;
-}
-
-void GetConfig() {
-	LTriggerStrength = GetConfigFloat(_T("Triggers"), _T("LeftStrength"), _T("0.25"));
-	RTriggerStrength = GetConfigFloat(_T("Triggers"), _T("RightStrength"), _T("0.25"));
-	TriggerSwap = GetConfigBool(_T("Triggers"), _T("SwapSides"), _T("False"));
-
-	LMotorStrength = GetConfigFloat(_T("Motors"), _T("LeftStrength"), _T("1.0"));
-	RMotorStrength = GetConfigFloat(_T("Motors"), _T("RightStrength"), _T("1.0"));
-	MotorSwap = GetConfigBool(_T("Motors"), _T("SwapSides"), _T("False"));
-}
-#pragma endregion
-
-// Gamepad scanning and gamepad related methods
-#pragma region Stuff from GamePad.cpp
-
-// DeadZone enum
-enum DeadZone
-{
-	DEAD_ZONE_INDEPENDENT_AXES = 0,
-	DEAD_ZONE_CIRCULAR,
-	DEAD_ZONE_NONE,
-};
-
-float ApplyLinearDeadZone(float value, float maxValue, float deadZoneSize)
-{
-	if (value < -deadZoneSize)
-	{
-		// Increase negative values to remove the deadzone discontinuity.
-		value += deadZoneSize;
-	}
-	else if (value > deadZoneSize)
-	{
-		// Decrease positive values to remove the deadzone discontinuity.
-		value -= deadZoneSize;
-	}
-	else
-	{
-		// Values inside the deadzone come out zero.
-		return 0;
-	}
-
-	// Scale into 0-1 range.
-	float scaledValue = value / (maxValue - deadZoneSize);
-	return std::max(-1.f, std::min(scaledValue, 1.f));
-}
-
-// Applies DeadZone to thumbstick positions
-void ApplyStickDeadZone(float x, float y, DeadZone deadZoneMode, float maxValue, float deadZoneSize, _Out_ float& resultX, _Out_ float& resultY)
-{
-	switch (deadZoneMode)
-	{
-	case DEAD_ZONE_INDEPENDENT_AXES:
-		resultX = ApplyLinearDeadZone(x, maxValue, deadZoneSize);
-		resultY = ApplyLinearDeadZone(y, maxValue, deadZoneSize);
-		break;
-
-	case DEAD_ZONE_CIRCULAR:
-	{
-		float dist = sqrtf(x * x + y * y);
-		float wanted = ApplyLinearDeadZone(dist, maxValue, deadZoneSize);
-
-		float scale = (wanted > 0.f) ? (wanted / dist) : 0.f;
-
-		resultX = std::max(-1.f, std::min(x * scale, 1.f));
-		resultY = std::max(-1.f, std::min(y * scale, 1.f));
-	}
-	break;
-
-	default: // GamePad::DEAD_ZONE_NONE
-		resultX = ApplyLinearDeadZone(x, maxValue, 0);
-		resultY = ApplyLinearDeadZone(y, maxValue, 0);
-		break;
-	}
-}
-
-// UserChanged Event
-static HRESULT UserChanged(ABI::Windows::Gaming::Input::IGameController*, ABI::Windows::System::IUserChangedEventArgs*)
-{
-	return S_OK;
-}
-
-// Scans for gamepads (adds/removes gamepads from gamepads array)
-void ScanGamePads()
-{
-	ComPtr<IVectorView<Gamepad*>> pads;
-	hr = gamepadStatics->get_Gamepads(&pads);
-	assert(SUCCEEDED(hr));
-
-	unsigned int count = 0;
-	hr = pads->get_Size(&count);
-	assert(SUCCEEDED(hr));
-
-	// Check for removed gamepads
-	for (size_t j = 0; j < MAX_PLAYER_COUNT; ++j)
-	{
-		if (gamepads[j])
-		{
-			unsigned int k = 0;
-			for (; k < count; ++k)
-			{
-				ComPtr<IGamepad> pad;
-				HRESULT hr = pads->GetAt(k, pad.GetAddressOf());
-				if (SUCCEEDED(hr) && (pad == gamepads[j]))
-				{
-					break;
-				}
-			}
-
-			if (k >= count)
-			{
-				ComPtr<IGameController> ctrl;
-				HRESULT hr = gamepads[j].As(&ctrl);
-				if (SUCCEEDED(hr) && ctrl)
-				{
-					(void)ctrl->remove_UserChanged(mUserChangeToken[j]);
-					mUserChangeToken[j].value = 0;
-				}
-
-				gamepads[j].Reset();
-			}
-		}
-	}
-
-	// Check for added gamepads
-	for (unsigned int j = 0; j < count; ++j)
-	{
-		ComPtr<IGamepad> pad;
-		hr = pads->GetAt(j, pad.GetAddressOf());
-		if (SUCCEEDED(hr))
-		{
-			size_t empty = MAX_PLAYER_COUNT;
-			size_t k = 0;
-			for (; k < MAX_PLAYER_COUNT; ++k)
-			{
-				if (gamepads[k] == pad)
-				{
-					if (j == (count - 1))
-						mMostRecentGamepad = static_cast<int>(k);
-					break;
-				}
-				else if (!gamepads[k])
-				{
-					if (empty >= MAX_PLAYER_COUNT)
-						empty = k;
-				}
-			}
-
-			if (k >= MAX_PLAYER_COUNT)
-			{
-				// Silently ignore "extra" gamepads as there's no hard limit
-				if (empty < MAX_PLAYER_COUNT)
-				{
-					gamepads[empty] = pad;
-					if (j == (count - 1))
-						mMostRecentGamepad = static_cast<int>(empty);
-
-					ComPtr<IGameController> ctrl;
-					hr = pad.As(&ctrl);
-					if (SUCCEEDED(hr) && ctrl)
-					{
-						typedef __FITypedEventHandler_2_Windows__CGaming__CInput__CIGameController_Windows__CSystem__CUserChangedEventArgs UserHandler;
-						hr = ctrl->add_UserChanged(Callback<UserHandler>(UserChanged).Get(), &mUserChangeToken[empty]);
-						assert(SUCCEEDED(hr));
-					}
-				}
-			}
-		}
-	}
-}
-
-// GamepadAdded Event
-static HRESULT GamepadAdded(IInspectable*, ABI::Windows::Gaming::Input::IGamepad*)
-{
-	ScanGamePads();
-	return S_OK;
-}
-
-// GamepadRemoved Event
-static HRESULT GamepadRemoved(IInspectable*, ABI::Windows::Gaming::Input::IGamepad*)
-{
-	ScanGamePads();
-	return S_OK;
-}
-#pragma endregion
-
-/*
-	Thanks to CookiePLMonster for suggesting this.
-	I definitely should have asked how to implement it, but oh well, there's still a lot of time for fixing.
-	Oddly enough, this seemed to have fixed HITMAN 2 once again. That game is really cursed. Before, only debug version of the DLL worked.
-*/
-#pragma region InitOnceExecuteOnce
-
-// Global variable for one-time initialization structure
-INIT_ONCE g_InitOnce = INIT_ONCE_STATIC_INIT; // Static initialization
-
-// Initialization callback function 
-BOOL CALLBACK InitHandleFunction(
-	PINIT_ONCE InitOnce,
-	PVOID Parameter,
-	PVOID* lpContext);
-
-// Returns a handle to an event object that is created only once
-HANDLE InitializeGamepad()
-{
-	PVOID lpContext;
-	BOOL  bStatus;
-
-	// Execute the initialization callback function 
-	bStatus = InitOnceExecuteOnce(&g_InitOnce,          // One-time initialization structure
-		InitHandleFunction,   // Pointer to initialization callback function
-		NULL,                 // Optional parameter to callback function (not used)
-		&lpContext);          // Receives pointer to event object stored in g_InitOnce
-
-	// InitOnceExecuteOnce function succeeded. Return event object.
-	if (bStatus)
-	{
-		return (HANDLE)lpContext;
-	}
-	else
-	{
-		return (INVALID_HANDLE_VALUE);
-	}
-}
-
-// Initialization callback function that creates the event object 
-BOOL CALLBACK InitHandleFunction(
-	PINIT_ONCE InitOnce,        // Pointer to one-time initialization structure        
-	PVOID Parameter,            // Optional parameter passed by InitOnceExecuteOnce            
-	PVOID* lpContext)           // Receives pointer to event object           
-{
-	hr = RoInitialize(RO_INIT_MULTITHREADED);
-	assert(SUCCEEDED(hr));
-
-	hr = RoGetActivationFactory(HStringReference(L"Windows.Gaming.Input.Gamepad").Get(), __uuidof(IGamepadStatics), &gamepadStatics);
-	assert(SUCCEEDED(hr));
-
-	typedef __FIEventHandler_1_Windows__CGaming__CInput__CGamepad AddedHandler;
-	hr = gamepadStatics->add_GamepadAdded(Callback<AddedHandler>(GamepadAdded).Get(), &gAddedToken);
-	assert(SUCCEEDED(hr));
-
-	typedef __FIEventHandler_1_Windows__CGaming__CInput__CGamepad RemovedHandler;
-	hr = gamepadStatics->add_GamepadRemoved(Callback<RemovedHandler>(GamepadRemoved).Get(), &gRemovedToken);
-	assert(SUCCEEDED(hr));
-
-	GetConfig();
-
-	ScanGamePads();
-
-	return TRUE;
-}
-
-#pragma endregion
-
-//
-// Structures used by XInput APIs
-//
-typedef struct _XINPUT_GAMEPAD
-{
-	WORD                                wButtons;
-	BYTE                                bLeftTrigger;
-	BYTE                                bRightTrigger;
-	SHORT                               sThumbLX;
-	SHORT                               sThumbLY;
-	SHORT                               sThumbRX;
-	SHORT                               sThumbRY;
-} XINPUT_GAMEPAD, * PXINPUT_GAMEPAD;
-
-typedef struct _XINPUT_STATE
-{
-	DWORD                               dwPacketNumber;
-	XINPUT_GAMEPAD                      Gamepad;
-} XINPUT_STATE, * PXINPUT_STATE;
-
-typedef struct _XINPUT_VIBRATION
-{
-	WORD                                wLeftMotorSpeed;
-	WORD                                wRightMotorSpeed;
-} XINPUT_VIBRATION, * PXINPUT_VIBRATION;
-
-typedef struct _XINPUT_CAPABILITIES
-{
-	BYTE                                Type;
-	BYTE                                SubType;
-	WORD                                Flags;
-	XINPUT_GAMEPAD                      Gamepad;
-	XINPUT_VIBRATION                    Vibration;
-} XINPUT_CAPABILITIES, * PXINPUT_CAPABILITIES;
-
-typedef struct _XINPUT_BATTERY_INFORMATION
-{
-	BYTE BatteryType;
-	BYTE BatteryLevel;
-} XINPUT_BATTERY_INFORMATION, * PXINPUT_BATTERY_INFORMATION;
-
-typedef struct _XINPUT_KEYSTROKE
-{
-	WORD    VirtualKey;
-	WCHAR   Unicode;
-	WORD    Flags;
-	BYTE    UserIndex;
-	BYTE    HidCode;
-} XINPUT_KEYSTROKE, * PXINPUT_KEYSTROKE;
-
-#define DLLEXPORT extern "C" __declspec(dllexport)
-
-DLLEXPORT BOOL APIENTRY DllMain(HMODULE hModule,
-	DWORD  ul_reason_for_call,
-	LPVOID lpReserved
-)
-{
-	/*switch (ul_reason_for_call)
-	{
-	case DLL_PROCESS_ATTACH:
-	case DLL_THREAD_ATTACH:
-	case DLL_THREAD_DETACH:
-	case DLL_PROCESS_DETACH:
-		break;
-	}*/
-	return TRUE;
-}
-
-DLLEXPORT DWORD WINAPI XInputGetState(_In_ DWORD dwUserIndex, _Out_ XINPUT_STATE* pState)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-
-		DWORD keys = 0;
-
-		float LeftThumbstickX;
-		float LeftThumbstickY;
-		float RightThumbstickX;
-		float RightThumbstickY;
-
-		ApplyStickDeadZone(state.LeftThumbstickX, state.LeftThumbstickY, DEAD_ZONE_INDEPENDENT_AXES, 1.f, c_XboxOneThumbDeadZone, LeftThumbstickX, LeftThumbstickY);
-
-		ApplyStickDeadZone(state.RightThumbstickX, state.RightThumbstickY, DEAD_ZONE_INDEPENDENT_AXES, 1.f, c_XboxOneThumbDeadZone, RightThumbstickX, RightThumbstickY);
-
-		pState->Gamepad.bRightTrigger = state.RightTrigger * 255;
-		pState->Gamepad.bLeftTrigger = state.LeftTrigger * 255;
-		globalRightTrigger = state.RightTrigger;  // xs RightTrigger Ȩܼ, Store RightTrigger value in a global variable.
-		globalLeftTrigger = state.LeftTrigger;  // xs RightTrigger Ȩܼ, Store RightTrigger value in a global variable.
-		pState->Gamepad.sThumbLX = (LeftThumbstickX >= 0) ? LeftThumbstickX * 32767 : LeftThumbstickX * 32768;
-		pState->Gamepad.sThumbLY = (LeftThumbstickY >= 0) ? LeftThumbstickY * 32767 : LeftThumbstickY * 32768;
-		pState->Gamepad.sThumbRX = (RightThumbstickX >= 0) ? RightThumbstickX * 32767 : RightThumbstickX * 32768;
-		pState->Gamepad.sThumbRY = (RightThumbstickY >= 0) ? RightThumbstickY * 32767 : RightThumbstickY * 32768;
-
-		if ((state.Buttons & GamepadButtons::GamepadButtons_A) != 0) keys += XINPUT_GAMEPAD_A;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_X) != 0) keys += XINPUT_GAMEPAD_X;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_Y) != 0) keys += XINPUT_GAMEPAD_Y;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_B) != 0) keys += XINPUT_GAMEPAD_B;
-
-		if ((state.Buttons & GamepadButtons::GamepadButtons_RightThumbstick) != 0) keys += XINPUT_GAMEPAD_RIGHT_THUMB;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_LeftThumbstick) != 0) keys += XINPUT_GAMEPAD_LEFT_THUMB;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_RightShoulder) != 0) keys += XINPUT_GAMEPAD_RIGHT_SHOULDER;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_LeftShoulder) != 0) keys += XINPUT_GAMEPAD_LEFT_SHOULDER;
-
-		if ((state.Buttons & GamepadButtons::GamepadButtons_View) != 0) keys += XINPUT_GAMEPAD_BACK;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_Menu) != 0) keys += XINPUT_GAMEPAD_START;
-
-		if ((state.Buttons & GamepadButtons::GamepadButtons_DPadUp) != 0) keys += XINPUT_GAMEPAD_DPAD_UP;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_DPadDown) != 0) keys += XINPUT_GAMEPAD_DPAD_DOWN;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_DPadLeft) != 0) keys += XINPUT_GAMEPAD_DPAD_LEFT;
-		if ((state.Buttons & GamepadButtons::GamepadButtons_DPadRight) != 0) keys += XINPUT_GAMEPAD_DPAD_RIGHT;
-
-		// Press both shoulder buttons and the start button to reload configuration.
-		if ((state.Buttons & GamepadButtons::GamepadButtons_RightShoulder) != 0 &&
-			(state.Buttons & GamepadButtons::GamepadButtons_LeftShoulder) != 0 &&
-			(state.Buttons & GamepadButtons::GamepadButtons_Menu) != 0) {
-			GetConfig();
-		}
-
-
-		pState->dwPacketNumber = state.Timestamp;
-		pState->Gamepad.wButtons = keys;
-
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-}
-
-// ܼơAΩ TelemetryReader , Global variable for TelemetryReader.
-TelemetryReader* telemetryReader = nullptr;
-
-DLLEXPORT DWORD WINAPI XInputSetState(_In_ DWORD dwUserIndex, _In_ XINPUT_VIBRATION* pVibration)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-
-		GamepadVibration vibration;
-
-		float LSpeed = pVibration->wLeftMotorSpeed / 65535.0f;
-		float RSpeed = pVibration->wRightMotorSpeed / 65535.0f;
-
-		vibration.LeftMotor = LSpeed * LMotorStrength;
-		vibration.RightMotor = RSpeed * RMotorStrength;
-		vibration.LeftTrigger = 0;
-		vibration.RightTrigger = 0;
-
-		if (enteredSpeedCheck == 1 || LSpeed > 0.1) {
-
-			// TO telemetryReader Ql, Ensure telemetryReader is initialized.
-			if (telemetryReader == nullptr) {
-				telemetryReader = new TelemetryReader(); // l, Initialize.
-			}
-
-			float Slip = telemetryReader->getSlip();   // Ʋ (Slip<1:íwA1<Slip:}lƲA٨ɻݶ}ABS), Get slip (Slip < 1: stable, Slip > 1: starting to slide, ABS must be engaged when braking).
-			float NRPM = telemetryReader->getNRPM();   // ^eWt(0:PtۦPA1:̰t), Return the current normalized RPM (0: same as idle, 1: maximum RPM).
-			float CRPM = telemetryReader->getCRPM();   // ^et(0:ȰC), Return the current RPM (0: game is paused).
-			float SPEED = telemetryReader->getSpeed(); // t, Get speed.
-			float Acceleration = telemetryReader->getAcceleration(); // [t(>20Q), Get acceleration (> 20 indicates a collision).
-			int Gear = telemetryReader->getGear();
-			float BUMP = 0;
-
-			/*
-			if (SPEED < 400) {
-				SPEED = SPEED / 400;
-			}
-			else if (SPEED >= 400 && SPEED < 500) {
-				SPEED = SPEED / 500;
-			}
-			else {
-				SPEED = SPEED / 600;
-			}
-			*/
-			if (CRPM == 0) { // CRPMetA0:CȰAۭq_ʼȰ, CRPM is the current engine RPM, 0: game is paused, custom vibration is paused.
-				vibration.LeftMotor = LSpeed * LMotorStrength;
-				vibration.RightMotor = RSpeed * RMotorStrength;
-				vibration.LeftTrigger = 0;
-				vibration.RightTrigger = 0;
-			}
-			else {
-				if (Acceleration > 10 && globalLeftTrigger < 0.1) {
-					BUMP = 0.3;
-					if (Acceleration > 15 && Acceleration < 30) {
-						BUMP = 0.5;
-					}
-					if (Acceleration > 30) {
-						BUMP = 0.7;
-					}
-					vibration.LeftMotor += BUMP;
-					vibration.RightMotor += BUMP;
-				}
-				else {
-					BUMP = 0;
-				}
-
-
-				/*
-				if (globalLeftTrigger > 0.7) {                                     //ĥΪO`קP_(>0.7Ah_), Use trigger depth judgment (> 0.7, then vibrate).
-					vibration.LeftTrigger = 0.2 * globalLeftTrigger * LSpeed;      //O, LeftTrigger
-				}
-				*/
-
-				if (globalLeftTrigger > 0.1) {
-					if (Slip > 1) {   //Ʋv(>1AơAh_), Slip rate (> 1, slipping, then vibrate).
-						vibration.LeftTrigger = 0.1 * LSpeed + BUMP + 0.3;      //O, LeftTrigger
-						vibration.LeftMotor += 0.3;
-						vibration.RightMotor += 0.3;
-					}
-				}
-
-				float RightTrigger_level = 0.5 * (exp(4 * NRPM + 0.01) / 60) + BUMP; // exponential function
-
-				if (RightTrigger_level > 0.5) {
-					vibration.RightTrigger = 0.5;
-					if (BUMP > 0.3) {
-						vibration.RightTrigger = 0.7;
-					}
-				}
-				else {
-					vibration.RightTrigger = 0.1 * RSpeed + RightTrigger_level;
-				}
-
-				if (Gear == 0 && globalRightTrigger > 0.3) {
-					vibration.LeftMotor = 0.5 + LSpeed * LMotorStrength;
-					vibration.RightMotor = 0.5 + RSpeed * RMotorStrength;
-					vibration.LeftTrigger = 0.4;
-					vibration.RightTrigger = 0.4;
-				}
-				enteredSpeedCheck = 1; //qLˬdAL}ҪO_, Enable trigger vibration unconditionally through checks.
-			}
-			}
-
-
-
-			
-
-		if (vibration.LeftMotor > 0.85) { vibration.LeftMotor = 0.85; }
-		if (vibration.RightMotor > 0.85) { vibration.RightMotor = 0.85; }
-		if (vibration.LeftTrigger > 0.7) { vibration.LeftTrigger = 0.7; }
-		if (vibration.RightTrigger > 0.7) { vibration.RightTrigger = 0.7; }
-
-		vibration.LeftTrigger = vibration.LeftTrigger * LTriggerStrength;
-		vibration.RightTrigger = vibration.RightTrigger * RTriggerStrength;
-
-		gamepad->put_Vibration(vibration);
-
-		return ERROR_SUCCESS;
-	}
-
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-
-DLLEXPORT DWORD WINAPI XInputGetCapabilities(_In_ DWORD dwUserIndex, _In_ DWORD dwFlags, _Out_ XINPUT_CAPABILITIES* pCapabilities)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-
-		ComPtr<IGameController> gamepadInfo;
-		gamepads[dwUserIndex].As(&gamepadInfo);
-
-		boolean wireless;
-		gamepadInfo->get_IsWireless(&wireless);
-
-		pCapabilities->Type = XINPUT_DEVTYPE_GAMEPAD;
-
-		pCapabilities->SubType = XINPUT_DEVSUBTYPE_GAMEPAD;
-
-		pCapabilities->Flags += XINPUT_CAPS_FFB_SUPPORTED;
-
-		if (wireless) pCapabilities->Flags += XINPUT_CAPS_WIRELESS;
-
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-DLLEXPORT void WINAPI XInputEnable(_In_ BOOL enable)
-{
-}
-
-DLLEXPORT DWORD WINAPI XInputGetDSoundAudioDeviceGuids(DWORD dwUserIndex, GUID* pDSoundRenderGuid, GUID* pDSoundCaptureGuid)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-DLLEXPORT DWORD WINAPI XInputGetBatteryInformation(_In_ DWORD dwUserIndex, _In_ BYTE devType, _Out_ XINPUT_BATTERY_INFORMATION* pBatteryInformation)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-	/*
-
-	ComPtr<IGameControllerBatteryInfo> battInf;
-	gamepads[dwUserIndex].As(&battInf);
-
-	ComPtr<IGameController> test;
-
-	ComPtr<ABI::Windows::Devices::Power::IBatteryReport> battReport;
-	battInf->TryGetBatteryReport(&battReport);
-
-	//Can't find any information on IReference
-	int Charge;
-	battReport->get_RemainingCapacityInMilliwattHours(&Charge);
-
-	*/
-	/*
-	InitializeGamepad();
-	auto state = m_gamePad->GetCapabilities(dwUserIndex);
-	if (state.connected) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-	*/
-}
-
-DLLEXPORT DWORD WINAPI XInputGetKeystroke(DWORD dwUserIndex, DWORD dwReserved, PXINPUT_KEYSTROKE pKeystroke)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	GamepadReading state;
-	hr = gamepads[dwUserIndex]->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-DLLEXPORT DWORD WINAPI XInputGetStateEx(_In_ DWORD dwUserIndex, _Out_ XINPUT_STATE* pState)
-{
-	return XInputGetState(dwUserIndex, pState);
-}
-
-DLLEXPORT DWORD WINAPI XInputWaitForGuideButton(_In_ DWORD dwUserIndex, _In_ DWORD dwFlag, _In_ LPVOID pVoid)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-DLLEXPORT DWORD XInputCancelGuideButtonWait(_In_ DWORD dwUserIndex)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-DLLEXPORT DWORD XInputPowerOffController(_In_ DWORD dwUserIndex)
-{
-	InitializeGamepad();
-
-	if (gamepads[dwUserIndex] == NULL) {
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-
-	auto gamepad = gamepads[dwUserIndex];
-
-	GamepadReading state;
-	hr = gamepad->GetCurrentReading(&state);
-
-	if (SUCCEEDED(hr)) {
-		return ERROR_SUCCESS;
-	}
-	else
-	{
-		return ERROR_DEVICE_NOT_CONNECTED;
-	}
-}
-
-
-// DLL ɲMz TelemetryReader
-DLLEXPORT void cleanup() {
-	delete telemetryReader;
-	telemetryReader = nullptr;
+/*
+	Thanks to r57zone for his Xinput emulation library
+	https://github.com/r57zone/XInput
+*/
+
+#include "stdafx.h"
+#include "Config.h"
+#include "DeviceRegistry.h"
+#include "FileWatcher.h"
+#include "HapticsEngine.h"
+#include "HapticsFilter.h"
+#include "InputTranslation.h"
+#include "LatencyStats.h"
+#include "OutputScheduler.h"
+#include "TelemetryRouter.h"
+#include "VibrationCoalescer.h"
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define XINPUT_GAMEPAD_DPAD_UP          0x0001
+#define XINPUT_GAMEPAD_DPAD_DOWN        0x0002
+#define XINPUT_GAMEPAD_DPAD_LEFT        0x0004
+#define XINPUT_GAMEPAD_DPAD_RIGHT       0x0008
+#define XINPUT_GAMEPAD_START            0x0010
+#define XINPUT_GAMEPAD_BACK             0x0020
+#define XINPUT_GAMEPAD_LEFT_THUMB       0x0040
+#define XINPUT_GAMEPAD_RIGHT_THUMB      0x0080
+#define XINPUT_GAMEPAD_LEFT_SHOULDER    0x0100
+#define XINPUT_GAMEPAD_RIGHT_SHOULDER   0x0200
+#define XINPUT_GAMEPAD_A                0x1000
+#define XINPUT_GAMEPAD_B                0x2000
+#define XINPUT_GAMEPAD_X                0x4000
+#define XINPUT_GAMEPAD_Y				0x8000
+
+#define XINPUT_CAPS_FFB_SUPPORTED       0x0001
+#define XINPUT_CAPS_WIRELESS            0x0002
+#define XINPUT_CAPS_PMD_SUPPORTED       0x0008
+#define XINPUT_CAPS_NO_NAVIGATION       0x0010
+
+//
+// Flags for battery status level
+//
+#define BATTERY_TYPE_DISCONNECTED       0x00    // This device is not connected
+#define BATTERY_TYPE_WIRED              0x01    // Wired device, no battery
+#define BATTERY_TYPE_ALKALINE           0x02    // Alkaline battery source
+#define BATTERY_TYPE_NIMH               0x03    // Nickel Metal Hydride battery source
+#define BATTERY_TYPE_UNKNOWN            0xFF    // Cannot determine the battery type
+
+// These are only valid for wireless, connected devices, with known battery types
+// The amount of use time remaining depends on the type of device.
+#define BATTERY_LEVEL_EMPTY             0x00
+#define BATTERY_LEVEL_LOW               0x01
+#define BATTERY_LEVEL_MEDIUM            0x02
+#define BATTERY_LEVEL_FULL              0x03
+
+
+#define XINPUT_DEVTYPE_GAMEPAD          0x01
+#define XINPUT_DEVSUBTYPE_GAMEPAD       0x01
+
+#define BATTERY_TYPE_DISCONNECTED		0x00
+
+#define XUSER_MAX_COUNT                 4
+#define MAX_PLAYER_COUNT				8
+#define XUSER_INDEX_ANY					0x000000FF
+
+#define ERROR_DEVICE_NOT_CONNECTED		1167
+#define ERROR_SUCCESS					0
+
+#define CONFIG_PATH						_T(".\\X1nput.ini")
+
+
+using namespace ABI::Windows::Foundation::Collections;
+using namespace ABI::Windows::Gaming::Input;
+using namespace Microsoft::WRL;
+using namespace Microsoft::WRL::Wrappers;
+
+const float c_XboxOneThumbDeadZone = .24f;  // Recommended Xbox One controller deadzone
+
+ComPtr<IGamepadStatics> gamepadStatics;
+DeviceRegistry<IGamepad, MAX_PLAYER_COUNT> gamepads;  // Slot table read lock-free by every export, see DeviceRegistry.h
+std::mutex gamepadRegistrationLock;                   // Serializes the added/removed events
+std::vector<ComPtr<IGamepad>> knownGamepads;          // Every gamepad ever registered, kept alive for the lock-free readers
+EventRegistrationToken mUserChangeToken[MAX_PLAYER_COUNT];
+
+EventRegistrationToken gAddedToken;
+EventRegistrationToken gRemovedToken;
+
+int mMostRecentGamepad = 0;
+
+HRESULT hr;
+
+// Per-slot haptics: every pad has its own trigger positions and effect state.
+struct PadHaptics {
+	std::atomic<float> leftTrigger{ 0.f };   // From the last XInputGetState for this slot
+	std::atomic<float> rightTrigger{ 0.f };
+	std::atomic<bool> gameDriven{ false };   // The game has sent rumble to this slot
+	std::atomic<bool> engaged{ false };      // Copy of state.Engaged that other threads can read
+	HapticsState state;                      // Only touched by the thread computing this slot's output
+	uint64_t receivedNs = 0;                 // Latency timestamps of the telemetry behind the output being sent,
+	uint64_t decodedNs = 0;                  // 0 when it used none; same thread as state
+	uint64_t consumedNs = 0;
+	uint64_t filteredNs = 0;                 // When [Smoothing] last ran for this slot outside the output thread
+	VibrationCoalescer coalescer;            // [Output] resolution, threshold and rate limit; same thread as state
+	IGamepad* coalescedGamepad = nullptr;    // Gamepad the coalescer's last output went to
+};
+
+static_assert(MAX_PLAYER_COUNT == kMaxPads, "[Routing] has an entry per gamepad slot");
+
+PadHaptics padHaptics[MAX_PLAYER_COUNT];
+HapticsFilterState padFilters[MAX_PLAYER_COUNT];  // [Smoothing] state, one array so the output thread filters every pad in one pass
+ConfigStore config;              // Current X1nput.ini settings, swapped in whole on every reload
+// The three objects that own threads are never destroyed: DllMain pins the DLL, so their destructors could only run at
+// process exit, joining threads Windows has already ended, under the loader lock. cleanup() stops them in order.
+FileWatcher& configWatcher = *new FileWatcher();
+std::atomic<bool> reloadComboHeld{ false };
+// 全局變數，用於 TelemetryReader , One TelemetryReader per routed port.
+TelemetryRouter& telemetryRouter = *new TelemetryRouter();
+// [Stats] packet-to-motor latency, opened by the first GetConfig and reached through settings->Telemetry.stats
+LatencyStats latencyStats;
+std::once_flag latencyStatsOnce;
+
+
+
+// Per-slot gamepad reading cache
+#pragma region Reading cache
+
+/*
+	Games poll every user index every frame, often more than once (GetState, GetStateEx,
+	input layers in middleware), and each GetCurrentReading is a cross-apartment WinRT
+	call. A reading younger than ReadingCacheUs is handed out again instead of asking
+	the driver; the reading's own Timestamp travels with it as the packet number.
+*/
+struct CachedReading {
+	SRWLOCK lock = SRWLOCK_INIT;
+	bool valid = false;
+	LONGLONG fetchedAt = 0;     // QueryPerformanceCounter ticks
+	GamepadReading reading = {};
+};
+
+CachedReading readingCache[MAX_PLAYER_COUNT];
+std::atomic<LONGLONG> readingMaxAge{ 0 };  // In QueryPerformanceCounter ticks, 0 disables the cache
+LONGLONG performanceFrequency = 0;
+std::atomic<bool> logReadingStats{ false };
+
+std::atomic<uint64_t> readingCalls{ 0 };  // GetCurrentReading calls made
+std::atomic<uint64_t> readingSaved{ 0 };  // Calls answered from the cache (or dropped from exports that only check the connection)
+std::atomic<LONGLONG> readingStatsSince{ 0 };
+
+void SetReadingCacheWindow(int microseconds)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	performanceFrequency = frequency.QuadPart;
+	readingMaxAge.store(std::max(0, microseconds) * frequency.QuadPart / 1000000, std::memory_order_relaxed);
+}
+
+void InvalidateReading(size_t index)
+{
+	AcquireSRWLockExclusive(&readingCache[index].lock);
+	readingCache[index].valid = false;
+	ReleaseSRWLockExclusive(&readingCache[index].lock);
+}
+
+// Writes counters to the debugger output about once per second when [Input] LogCacheStats is on.
+void ReportReadingStats(LONGLONG now)
+{
+	LONGLONG since = readingStatsSince.load(std::memory_order_relaxed);
+	if (now - since < performanceFrequency || !readingStatsSince.compare_exchange_strong(since, now)) {
+		return;
+	}
+
+	double seconds = static_cast<double>(now - since) / performanceFrequency;
+	uint64_t calls = readingCalls.exchange(0, std::memory_order_relaxed);
+	uint64_t saved = readingSaved.exchange(0, std::memory_order_relaxed);
+
+	// The coalescers count for ever; only this thread gets here, so it can keep the previous totals.
+	static uint64_t previousSent = 0;
+	static uint64_t previousSuppressed = 0;
+	uint64_t sent = 0;
+	uint64_t suppressed = 0;
+	for (const PadHaptics& pad : padHaptics) {
+		sent += pad.coalescer.sent();
+		suppressed += pad.coalescer.suppressed();
+	}
+
+	char message[160];
+	sprintf_s(message, "X1nput: GetCurrentReading %.0f/s, saved %.0f/s; put_Vibration %.0f/s, saved %.0f/s\n", calls / seconds, saved / seconds,
+		(sent - previousSent) / seconds, (suppressed - previousSuppressed) / seconds);
+	OutputDebugStringA(message);
+	previousSent = sent;
+	previousSuppressed = suppressed;
+}
+
+// Connection check for exports that used to fetch a reading just to see whether the pad is there.
+// The slot is kept up to date by the GamepadAdded/GamepadRemoved events.
+bool IsConnected(DWORD index)
+{
+	if (gamepads.get(index) == NULL) {
+		return false;
+	}
+	readingSaved.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+HRESULT GetCachedReading(DWORD index, const ComPtr<IGamepad>& gamepad, GamepadReading& reading)
+{
+	CachedReading& cache = readingCache[index];
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+
+	if (logReadingStats.load(std::memory_order_relaxed)) {
+		ReportReadingStats(now.QuadPart);
+	}
+
+	LONGLONG maxAge = readingMaxAge.load(std::memory_order_relaxed);
+	if (maxAge > 0) {
+		AcquireSRWLockShared(&cache.lock);
+		bool fresh = cache.valid && now.QuadPart - cache.fetchedAt <= maxAge;
+		if (fresh) {
+			reading = cache.reading;
+		}
+		ReleaseSRWLockShared(&cache.lock);
+
+		if (fresh) {
+			readingSaved.fetch_add(1, std::memory_order_relaxed);
+			return S_OK;
+		}
+	}
+
+	HRESULT result = gamepad->GetCurrentReading(&reading);
+	readingCalls.fetch_add(1, std::memory_order_relaxed);
+
+	if (SUCCEEDED(result) && maxAge > 0) {
+		AcquireSRWLockExclusive(&cache.lock);
+		// Another thread may have stored a newer reading in the meantime.
+		if (!cache.valid || reading.Timestamp >= cache.reading.Timestamp) {
+			cache.reading = reading;
+			cache.fetchedAt = now.QuadPart;
+			cache.valid = true;
+		}
+		ReleaseSRWLockExclusive(&cache.lock);
+	}
+
+	return result;
+}
+
+#pragma endregion
+
+// Config loading: X1nput.ini is read in one pass and published as a whole, see Config.h
+#pragma region Config loading
+void RestartOutputScheduler(unsigned rateHz);  // With the output thread below
+
+void GetConfig() {
+	IniFile ini;
+	ini.load(CONFIG_PATH);
+
+	X1nputConfig parsed = ParseConfig(ini);
+
+	// [Stats] is read once: the mapping stays under the same name for the whole session.
+	std::call_once(latencyStatsOnce, [&parsed]() {
+		if (!parsed.StatsName.empty() && !latencyStats.open(parsed.StatsName.c_str())) {
+			OutputDebugStringA(("X1nput: cannot open latency stats " + parsed.StatsName + "\n").c_str());
+		}
+	});
+	parsed.Telemetry.stats = latencyStats.isOpen() ? &latencyStats : nullptr;
+
+	// From here on parsed stands for the published version: a concurrent reload may replace and free that one.
+	config.publish(parsed);
+	const X1nputConfig* settings = &parsed;
+
+	if (!settings->EffectsError.empty()) {
+		OutputDebugStringA(("X1nput: ignoring effects, " + settings->EffectsError + "\n").c_str());
+	}
+
+	SetReadingCacheWindow(settings->ReadingCacheUs);
+	logReadingStats.store(settings->LogCacheStats, std::memory_order_relaxed);
+
+	// [Telemetry] Formats and Relay, [Collision] and [Prediction] change under running readers. A reload never rebinds
+	// a port or restarts a capture or replay: those only apply when a reader starts.
+	telemetryRouter.setOptions(settings->Telemetry);
+
+	// A running output thread picks up a new [Output] UpdateRate, or stops and hands the pads back to the game's calls.
+	RestartOutputScheduler(settings->OutputRate);
+
+	// Start every routed port now, so the readers bind on their own threads and are listening before the first frame
+	// asks for telemetry. Ports a reload adds start here too.
+	for (const PadRoute& route : settings->Routes) {
+		if (route.TelemetryPort != 0) {
+			telemetryRouter.reader(route.TelemetryPort, settings->Telemetry);
+		}
+	}
+}
+
+// Reloads whenever X1nput.ini is saved, so settings can be tuned while the game is running.
+void StartConfigWatcher() {
+	configWatcher.start(CONFIG_PATH, GetConfig);
+}
+#pragma endregion
+
+// Gamepad scanning and gamepad related methods
+#pragma region Stuff from GamePad.cpp
+
+// UserChanged Event
+static HRESULT UserChanged(ABI::Windows::Gaming::Input::IGameController*, ABI::Windows::System::IUserChangedEventArgs*)
+{
+	return S_OK;
+}
+
+// The gamepad in a slot, or null for an empty or out of range slot. Safe from any thread.
+ComPtr<IGamepad> GetGamepad(DWORD index)
+{
+	return ComPtr<IGamepad>(gamepads.get(index));
+}
+
+// Puts a new or reconnected gamepad in a slot; a gamepad that comes back gets the slot it had before.
+void AddGamepad(IGamepad* pad)
+{
+	std::lock_guard<std::mutex> guard(gamepadRegistrationLock);
+
+	bool known = false;
+	for (const ComPtr<IGamepad>& knownPad : knownGamepads) {
+		known = known || knownPad.Get() == pad;
+	}
+	if (!known) {
+		knownGamepads.emplace_back(pad);
+	}
+
+	bool added = false;
+	size_t slot = gamepads.add(pad, added);
+	if (!added) {
+		// Already registered, or silently ignore "extra" gamepads as there's no hard limit
+		return;
+	}
+
+	InvalidateReading(slot);
+	mMostRecentGamepad = static_cast<int>(slot);
+
+	ComPtr<IGameController> ctrl;
+	HRESULT result = ComPtr<IGamepad>(pad).As(&ctrl);
+	if (SUCCEEDED(result) && ctrl)
+	{
+		typedef __FITypedEventHandler_2_Windows__CGaming__CInput__CIGameController_Windows__CSystem__CUserChangedEventArgs UserHandler;
+		result = ctrl->add_UserChanged(Callback<UserHandler>(UserChanged).Get(), &mUserChangeToken[slot]);
+		assert(SUCCEEDED(result));
+	}
+}
+
+// Empties the gamepad's slot. Readers that already loaded it keep a live object (see knownGamepads).
+void RemoveGamepad(IGamepad* pad)
+{
+	std::lock_guard<std::mutex> guard(gamepadRegistrationLock);
+
+	size_t slot = gamepads.remove(pad);
+	if (slot == gamepads.kNoSlot) {
+		return;
+	}
+
+	ComPtr<IGameController> ctrl;
+	HRESULT result = ComPtr<IGamepad>(pad).As(&ctrl);
+	if (SUCCEEDED(result) && ctrl)
+	{
+		(void)ctrl->remove_UserChanged(mUserChangeToken[slot]);
+		mUserChangeToken[slot].value = 0;
+	}
+
+	InvalidateReading(slot);
+}
+
+// Registers the gamepads that were connected before the events were hooked up. Only runs once, at startup.
+void AddConnectedGamepads()
+{
+	ComPtr<IVectorView<Gamepad*>> pads;
+	hr = gamepadStatics->get_Gamepads(&pads);
+	assert(SUCCEEDED(hr));
+
+	unsigned int count = 0;
+	hr = pads->get_Size(&count);
+	assert(SUCCEEDED(hr));
+
+	for (unsigned int j = 0; j < count; ++j)
+	{
+		ComPtr<IGamepad> pad;
+		if (SUCCEEDED(pads->GetAt(j, pad.GetAddressOf())))
+		{
+			AddGamepad(pad.Get());
+		}
+	}
+}
+
+// GamepadAdded Event: only the gamepad in the payload is looked at.
+static HRESULT GamepadAdded(IInspectable*, ABI::Windows::Gaming::Input::IGamepad* pad)
+{
+	AddGamepad(pad);
+	return S_OK;
+}
+
+// GamepadRemoved Event
+static HRESULT GamepadRemoved(IInspectable*, ABI::Windows::Gaming::Input::IGamepad* pad)
+{
+	RemoveGamepad(pad);
+	return S_OK;
+}
+#pragma endregion
+
+/*
+	Thanks to CookiePLMonster for suggesting this.
+	I definitely should have asked how to implement it, but oh well, there's still a lot of time for fixing.
+	Oddly enough, this seemed to have fixed HITMAN 2 once again. That game is really cursed. Before, only debug version of the DLL worked.
+*/
+#pragma region InitOnceExecuteOnce
+
+// Global variable for one-time initialization structure
+INIT_ONCE g_InitOnce = INIT_ONCE_STATIC_INIT; // Static initialization
+
+// Initialization callback function 
+BOOL CALLBACK InitHandleFunction(
+	PINIT_ONCE InitOnce,
+	PVOID Parameter,
+	PVOID* lpContext);
+
+// Returns a handle to an event object that is created only once
+HANDLE InitializeGamepad()
+{
+	PVOID lpContext;
+	BOOL  bStatus;
+
+	// Execute the initialization callback function 
+	bStatus = InitOnceExecuteOnce(&g_InitOnce,          // One-time initialization structure
+		InitHandleFunction,   // Pointer to initialization callback function
+		NULL,                 // Optional parameter to callback function (not used)
+		&lpContext);          // Receives pointer to event object stored in g_InitOnce
+
+	// InitOnceExecuteOnce function succeeded. Return event object.
+	if (bStatus)
+	{
+		return (HANDLE)lpContext;
+	}
+	else
+	{
+		return (INVALID_HANDLE_VALUE);
+	}
+}
+
+// Initialization callback function that creates the event object 
+BOOL CALLBACK InitHandleFunction(
+	PINIT_ONCE InitOnce,        // Pointer to one-time initialization structure        
+	PVOID Parameter,            // Optional parameter passed by InitOnceExecuteOnce            
+	PVOID* lpContext)           // Receives pointer to event object           
+{
+	hr = RoInitialize(RO_INIT_MULTITHREADED);
+	assert(SUCCEEDED(hr));
+
+	hr = RoGetActivationFactory(HStringReference(L"Windows.Gaming.Input.Gamepad").Get(), __uuidof(IGamepadStatics), &gamepadStatics);
+	assert(SUCCEEDED(hr));
+
+	typedef __FIEventHandler_1_Windows__CGaming__CInput__CGamepad AddedHandler;
+	hr = gamepadStatics->add_GamepadAdded(Callback<AddedHandler>(GamepadAdded).Get(), &gAddedToken);
+	assert(SUCCEEDED(hr));
+
+	typedef __FIEventHandler_1_Windows__CGaming__CInput__CGamepad RemovedHandler;
+	hr = gamepadStatics->add_GamepadRemoved(Callback<RemovedHandler>(GamepadRemoved).Get(), &gRemovedToken);
+	assert(SUCCEEDED(hr));
+
+	GetConfig();
+	StartConfigWatcher();
+
+	AddConnectedGamepads();
+
+	return TRUE;
+}
+
+#pragma endregion
+
+//
+// Structures used by XInput APIs
+//
+typedef struct _XINPUT_GAMEPAD
+{
+	WORD                                wButtons;
+	BYTE                                bLeftTrigger;
+	BYTE                                bRightTrigger;
+	SHORT                               sThumbLX;
+	SHORT                               sThumbLY;
+	SHORT                               sThumbRX;
+	SHORT                               sThumbRY;
+} XINPUT_GAMEPAD, * PXINPUT_GAMEPAD;
+
+typedef struct _XINPUT_STATE
+{
+	DWORD                               dwPacketNumber;
+	XINPUT_GAMEPAD                      Gamepad;
+} XINPUT_STATE, * PXINPUT_STATE;
+
+typedef struct _XINPUT_VIBRATION
+{
+	WORD                                wLeftMotorSpeed;
+	WORD                                wRightMotorSpeed;
+} XINPUT_VIBRATION, * PXINPUT_VIBRATION;
+
+typedef struct _XINPUT_CAPABILITIES
+{
+	BYTE                                Type;
+	BYTE                                SubType;
+	WORD                                Flags;
+	XINPUT_GAMEPAD                      Gamepad;
+	XINPUT_VIBRATION                    Vibration;
+} XINPUT_CAPABILITIES, * PXINPUT_CAPABILITIES;
+
+typedef struct _XINPUT_BATTERY_INFORMATION
+{
+	BYTE BatteryType;
+	BYTE BatteryLevel;
+} XINPUT_BATTERY_INFORMATION, * PXINPUT_BATTERY_INFORMATION;
+
+typedef struct _XINPUT_KEYSTROKE
+{
+	WORD    VirtualKey;
+	WCHAR   Unicode;
+	WORD    Flags;
+	BYTE    UserIndex;
+	BYTE    HidCode;
+} XINPUT_KEYSTROKE, * PXINPUT_KEYSTROKE;
+
+#define DLLEXPORT extern "C" __declspec(dllexport)
+
+DLLEXPORT BOOL APIENTRY DllMain(HMODULE hModule,
+	DWORD  ul_reason_for_call,
+	LPVOID lpReserved
+)
+{
+	/*switch (ul_reason_for_call)
+	{
+	case DLL_PROCESS_ATTACH:
+	case DLL_THREAD_ATTACH:
+	case DLL_THREAD_DETACH:
+	case DLL_PROCESS_DETACH:
+		break;
+	}*/
+	// Pinned: FreeLibrary never unmaps the code under the output, reader and watcher threads, so the DLL only
+	// unloads with the process.
+	if (ul_reason_for_call == DLL_PROCESS_ATTACH) {
+		HMODULE pinned;
+		GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+			reinterpret_cast<LPCWSTR>(hModule), &pinned);
+	}
+	return TRUE;
+}
+
+DLLEXPORT DWORD WINAPI XInputGetState(_In_ DWORD dwUserIndex, _Out_ XINPUT_STATE* pState)
+{
+	InitializeGamepad();
+
+	ComPtr<IGamepad> gamepad = GetGamepad(dwUserIndex);
+	if (gamepad == NULL) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	GamepadReading state;
+	hr = GetCachedReading(dwUserIndex, gamepad, state);
+
+	if (SUCCEEDED(hr)) {
+
+		RawGamepadReading raw;
+		raw.Buttons = static_cast<uint32_t>(state.Buttons);
+		raw.LeftTrigger = state.LeftTrigger;
+		raw.RightTrigger = state.RightTrigger;
+		raw.LeftThumbstickX = state.LeftThumbstickX;
+		raw.LeftThumbstickY = state.LeftThumbstickY;
+		raw.RightThumbstickX = state.RightThumbstickX;
+		raw.RightThumbstickY = state.RightThumbstickY;
+
+		TranslatedGamepad pad;
+		TranslateReading(raw, c_XboxOneThumbDeadZone, pad);
+
+		pState->Gamepad.bRightTrigger = pad.bRightTrigger;
+		pState->Gamepad.bLeftTrigger = pad.bLeftTrigger;
+		padHaptics[dwUserIndex].rightTrigger.store(static_cast<float>(state.RightTrigger), std::memory_order_relaxed);  // 儲存 RightTrigger 值, Store the RightTrigger value for this pad's effects.
+		padHaptics[dwUserIndex].leftTrigger.store(static_cast<float>(state.LeftTrigger), std::memory_order_relaxed);  // 儲存 LeftTrigger 值, Store the LeftTrigger value for this pad's effects.
+		pState->Gamepad.sThumbLX = pad.sThumbLX;
+		pState->Gamepad.sThumbLY = pad.sThumbLY;
+		pState->Gamepad.sThumbRX = pad.sThumbRX;
+		pState->Gamepad.sThumbRY = pad.sThumbRY;
+
+		// Press both shoulder buttons and the start button to reload configuration.
+		// Saving X1nput.ini reloads it too; the combo is for when the file watcher can't see the change.
+		bool combo = (state.Buttons & GamepadButtons::GamepadButtons_RightShoulder) != 0 &&
+			(state.Buttons & GamepadButtons::GamepadButtons_LeftShoulder) != 0 &&
+			(state.Buttons & GamepadButtons::GamepadButtons_Menu) != 0;
+		if (!reloadComboHeld.exchange(combo, std::memory_order_relaxed) && combo) {
+			GetConfig(); // Once per press, not on every frame the buttons are held
+		}
+
+
+		pState->dwPacketNumber = state.Timestamp;
+		pState->Gamepad.wButtons = pad.wButtons;
+
+		return ERROR_SUCCESS;
+	}
+	else
+	{
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+}
+
+// True if a pad the game drives on this port has its telemetry effects running.
+bool PortEngaged(const X1nputConfig* settings, uint16_t port)
+{
+	if (port == 0) {
+		return false;
+	}
+	for (DWORD i = 0; i < MAX_PLAYER_COUNT; ++i) {
+		if (settings->Routes[i].TelemetryPort == port && padHaptics[i].gameDriven.load(std::memory_order_relaxed) &&
+			padHaptics[i].engaged.load(std::memory_order_relaxed)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// A pad the game never sends rumble to (the second controller on the couch) runs the effects of its port
+// as soon as a pad the game drives does.
+bool FollowsTelemetry(const X1nputConfig* settings, DWORD index)
+{
+	return !padHaptics[index].gameDriven.load(std::memory_order_relaxed) && PortEngaged(settings, settings->Routes[index].TelemetryPort);
+}
+
+// Runs the effects for one pad from the latest telemetry snapshot of its port and the game's rumble request.
+HapticsOutput ComputeVibration(DWORD index, float leftRumble, float rightRumble, TelemetrySnapshots& snapshots)
+{
+	ConfigStore::Reader settingsReader(config);
+	const X1nputConfig* settings = settingsReader.get();
+	PadHaptics& pad = padHaptics[index];
+
+	HapticsInput input;
+	input.LeftTrigger = pad.leftTrigger.load(std::memory_order_relaxed);
+	input.RightTrigger = pad.rightTrigger.load(std::memory_order_relaxed);
+	input.LeftRumble = leftRumble;
+	input.RightRumble = rightRumble;
+
+	const TelemetryData* telemetryPtr = nullptr;
+	uint16_t port = settings->Routes[index].TelemetryPort;
+
+	if (!pad.state.Engaged && FollowsTelemetry(settings, index)) {
+		pad.state.Engaged = true;
+	}
+
+	if (port != 0 && HapticsEngine::wantsTelemetry(pad.state, input)) {
+
+		// 確保 telemetryReader 被初始化, Ensure the port's TelemetryReader is started.
+		TelemetryReader* reader = telemetryRouter.reader(port, settings->Telemetry);
+
+		// 每幀只取一次快照 One snapshot per port per frame, shared by every pad routed to it.
+		if (reader != nullptr) {
+			telemetryPtr = &snapshots.get(*reader);
+		}
+	}
+
+	pad.receivedNs = 0;
+	if (settings->Telemetry.stats && telemetryPtr != nullptr && telemetryPtr->ReceivedNs != 0) {
+		pad.receivedNs = telemetryPtr->ReceivedNs;
+		pad.decodedNs = telemetryPtr->DecodedNs;
+		pad.consumedNs = LatencyStats::now();
+	}
+
+	// [Prediction] Run the effects on the telemetry as it should be by now, not as it was when the packet arrived.
+	TelemetryData predicted;
+	if (telemetryPtr != nullptr && settings->Telemetry.prediction.enabled) {
+		predicted = *telemetryPtr;
+		PredictTelemetry(predicted, PredictionHorizon(settings->Telemetry.prediction, predicted, LatencyStats::now()));
+		telemetryPtr = &predicted;
+	}
+
+	HapticsOutput output = settings->Haptics.compute(telemetryPtr, input, pad.state);
+	pad.engaged.store(pad.state.Engaged, std::memory_order_relaxed);
+	return output;
+}
+
+// [Smoothing] for one pad on the game's thread, stepped by the time since that pad's previous output.
+void SmoothVibration(DWORD index, HapticsOutput& output)
+{
+	ConfigStore::Reader settingsReader(config);
+	const X1nputConfig* settings = settingsReader.get();
+	if (!settings->Smoothing.enabled()) {
+		return;
+	}
+	PadHaptics& pad = padHaptics[index];
+	uint64_t now = LatencyStats::now();
+	HapticsFilterCoefficients coefficients = ComputeFilterCoefficients(settings->Smoothing, (now - pad.filteredNs) * 1e-9);
+	pad.filteredNs = now;
+	FilterHaptics(coefficients, &padFilters[index], &output, 1);
+}
+
+// Sends the output ComputeVibration just returned for the pad in slot index, unless the pad already plays it
+// closely enough ([Output] Resolution, ChangeThreshold and MaxSendRate).
+void SendVibration(DWORD index, const ComPtr<IGamepad>& gamepad, const HapticsOutput& output)
+{
+	ConfigStore::Reader settingsReader(config);
+	const X1nputConfig* settings = settingsReader.get();
+	LatencyStats* stats = settings->Telemetry.stats;
+	PadHaptics& pad = padHaptics[index];
+
+	// A gamepad that took over the slot plays nothing yet.
+	if (pad.coalescedGamepad != gamepad.Get()) {
+		pad.coalescer.reset();
+		pad.coalescedGamepad = gamepad.Get();
+	}
+
+	HapticsOutput coalesced = output;
+	if (!pad.coalescer.update(settings->Coalescing, coalesced, LatencyStats::now())) {
+		if (stats != nullptr) {
+			stats->countSuppressed();
+		}
+		return;
+	}
+
+	GamepadVibration vibration;
+	vibration.LeftMotor = coalesced.LeftMotor;
+	vibration.RightMotor = coalesced.RightMotor;
+	vibration.LeftTrigger = coalesced.LeftTrigger;
+	vibration.RightTrigger = coalesced.RightTrigger;
+
+	gamepad->put_Vibration(vibration);
+
+	if (stats == nullptr) {
+		return;
+	}
+	uint64_t sentNs = LatencyStats::now();
+	if (pad.receivedNs != 0) {
+		stats->record(LatencyStage_Wait, pad.decodedNs, pad.consumedNs);
+		stats->record(LatencyStage_Output, pad.consumedNs, sentNs);
+		stats->record(LatencyStage_Total, pad.receivedNs, sentNs);
+	}
+	stats->countFrame();
+	stats->refreshSummary(sentNs);
+}
+
+// Fixed-rate output thread, used instead of the game's XInputSetState calls when [Output] UpdateRate > 0
+#pragma region Output scheduler
+
+struct PadOutput {
+	std::atomic<uint32_t> rumble{ 0 };  // Last game request, left motor in the high 16 bits
+	std::atomic<bool> active{ false };  // The game has called XInputSetState for this pad
+};
+
+PadOutput padOutputs[MAX_PLAYER_COUNT];
+OutputScheduler& outputScheduler = *new OutputScheduler();  // Never destroyed, see configWatcher
+unsigned outputSchedulerRate = 0;      // Rate the running thread was started with
+uint64_t outputTickNs = 0;             // Start of the previous tick, for [Smoothing]
+
+/*
+	Either the output thread or the game's XInputSetState calls drive the pads, never both: they share padHaptics,
+	padFilters and the coalescers. The game's calls hold this shared while they drive a pad directly; starting and
+	stopping the thread holds it exclusive, so no direct call is in flight while a tick can run and the other way
+	round. Only XInputSetState starts the thread, a reload only restarts or stops one that is running.
+*/
+SRWLOCK outputOwnership = SRWLOCK_INIT;
+
+void OutputTick()
+{
+	ConfigStore::Reader settingsReader(config);
+	const X1nputConfig* settings = settingsReader.get();
+	TelemetrySnapshots snapshots;
+	ComPtr<IGamepad> gamepads[MAX_PLAYER_COUNT];
+	HapticsOutput outputs[MAX_PLAYER_COUNT] = {};  // Silence for the pads that are skipped
+
+	for (DWORD i = 0; i < MAX_PLAYER_COUNT; ++i) {
+		PadOutput& pad = padOutputs[i];
+		if (!pad.active.load(std::memory_order_acquire) && !FollowsTelemetry(settings, i)) {
+			continue;
+		}
+
+		gamepads[i] = GetGamepad(i);
+		if (!gamepads[i]) {
+			padHaptics[i].coalescer.reset();
+			continue;
+		}
+
+		uint32_t rumble = pad.rumble.load(std::memory_order_relaxed);
+		outputs[i] = ComputeVibration(i, (rumble >> 16) / 65535.0f, (rumble & 0xFFFF) / 65535.0f, snapshots);
+	}
+
+	// Every pad in one pass, skipped ones included so they fade out and start again from silence.
+	uint64_t now = LatencyStats::now();
+	if (settings->Smoothing.enabled()) {
+		FilterHaptics(ComputeFilterCoefficients(settings->Smoothing, (now - outputTickNs) * 1e-9), padFilters, outputs, MAX_PLAYER_COUNT);
+	}
+	outputTickNs = now;
+
+	// SendVibration only talks to the driver when the output actually moved.
+	for (DWORD i = 0; i < MAX_PLAYER_COUNT; ++i) {
+		if (gamepads[i]) {
+			SendVibration(i, gamepads[i], outputs[i]);
+		}
+	}
+}
+
+// Caller holds outputOwnership exclusive.
+void StartOutputThread(unsigned rateHz)
+{
+	outputSchedulerRate = rateHz;
+	outputTickNs = LatencyStats::now();
+	outputScheduler.start(rateHz, OutputTick,
+		[]() { RoInitialize(RO_INIT_MULTITHREADED); },
+		[]() { RoUninitialize(); });
+}
+
+void StartOutputScheduler()
+{
+	AcquireSRWLockExclusive(&outputOwnership);
+	unsigned rateHz = ConfigStore::Reader(config)->OutputRate;
+	if (!outputScheduler.isRunning() && rateHz > 0) {
+		StartOutputThread(rateHz);
+	}
+	ReleaseSRWLockExclusive(&outputOwnership);
+}
+
+void RestartOutputScheduler(unsigned rateHz)
+{
+	AcquireSRWLockExclusive(&outputOwnership);
+	if (outputScheduler.isRunning() && rateHz != outputSchedulerRate) {
+		outputScheduler.stop();
+		if (rateHz > 0) {
+			StartOutputThread(rateHz);
+		}
+	}
+	ReleaseSRWLockExclusive(&outputOwnership);
+}
+
+void StopOutputScheduler()
+{
+	AcquireSRWLockExclusive(&outputOwnership);
+	outputScheduler.stop();
+	ReleaseSRWLockExclusive(&outputOwnership);
+}
+
+#pragma endregion
+
+// XInputSetState without the output thread, under outputOwnership shared.
+void DriveVibration(DWORD dwUserIndex, const ComPtr<IGamepad>& gamepad, const XINPUT_VIBRATION* pVibration)
+{
+	TelemetrySnapshots snapshots;
+	HapticsOutput output = ComputeVibration(dwUserIndex, pVibration->wLeftMotorSpeed / 65535.0f, pVibration->wRightMotorSpeed / 65535.0f, snapshots);
+	SmoothVibration(dwUserIndex, output);
+	SendVibration(dwUserIndex, gamepad, output);
+
+	// Without the output thread the game's calls are the only clock: the first pad the game drives on a port
+	// also updates the pads following that port, so each follower is only ever computed from one thread.
+	ConfigStore::Reader settingsReader(config);
+	const X1nputConfig* settings = settingsReader.get();
+	uint16_t port = settings->Routes[dwUserIndex].TelemetryPort;
+	for (DWORD i = 0; i < dwUserIndex; ++i) {
+		if (settings->Routes[i].TelemetryPort == port && padHaptics[i].gameDriven.load(std::memory_order_relaxed)) {
+			return;
+		}
+	}
+	for (DWORD i = 0; i < MAX_PLAYER_COUNT; ++i) {
+		ComPtr<IGamepad> follower = GetGamepad(i);
+		if (i != dwUserIndex && follower && settings->Routes[i].TelemetryPort == port && FollowsTelemetry(settings, i)) {
+			HapticsOutput followerOutput = ComputeVibration(i, 0.f, 0.f, snapshots);
+			SmoothVibration(i, followerOutput);
+			SendVibration(i, follower, followerOutput);
+		}
+	}
+}
+
+DLLEXPORT DWORD WINAPI XInputSetState(_In_ DWORD dwUserIndex, _In_ XINPUT_VIBRATION* pVibration)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	ComPtr<IGamepad> gamepad = GetGamepad(dwUserIndex);
+	if (gamepad == NULL) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+	padHaptics[dwUserIndex].gameDriven.store(true, std::memory_order_relaxed);
+
+	// With the output thread running the game's rumble is just one more input to it.
+	padOutputs[dwUserIndex].rumble.store((static_cast<uint32_t>(pVibration->wLeftMotorSpeed) << 16) | pVibration->wRightMotorSpeed, std::memory_order_relaxed);
+	padOutputs[dwUserIndex].active.store(true, std::memory_order_release);
+	if (!outputScheduler.isRunning() && ConfigStore::Reader(config)->OutputRate > 0) {
+		StartOutputScheduler();
+	}
+
+	AcquireSRWLockShared(&outputOwnership);
+	if (outputScheduler.isRunning()) {
+		ReleaseSRWLockShared(&outputOwnership);
+		return ERROR_SUCCESS;
+	}
+	DriveVibration(dwUserIndex, gamepad, pVibration);
+	ReleaseSRWLockShared(&outputOwnership);
+
+	return ERROR_SUCCESS;
+}
+
+
+DLLEXPORT DWORD WINAPI XInputGetCapabilities(_In_ DWORD dwUserIndex, _In_ DWORD dwFlags, _Out_ XINPUT_CAPABILITIES* pCapabilities)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	ComPtr<IGameController> gamepadInfo;
+	ComPtr<IGamepad> gamepad = GetGamepad(dwUserIndex);
+	if (gamepad == NULL || FAILED(gamepad.As(&gamepadInfo))) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	boolean wireless;
+	gamepadInfo->get_IsWireless(&wireless);
+
+	pCapabilities->Type = XINPUT_DEVTYPE_GAMEPAD;
+
+	pCapabilities->SubType = XINPUT_DEVSUBTYPE_GAMEPAD;
+
+	pCapabilities->Flags += XINPUT_CAPS_FFB_SUPPORTED;
+
+	if (wireless) pCapabilities->Flags += XINPUT_CAPS_WIRELESS;
+
+	return ERROR_SUCCESS;
+}
+
+DLLEXPORT void WINAPI XInputEnable(_In_ BOOL enable)
+{
+}
+
+DLLEXPORT DWORD WINAPI XInputGetDSoundAudioDeviceGuids(DWORD dwUserIndex, GUID* pDSoundRenderGuid, GUID* pDSoundCaptureGuid)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+DLLEXPORT DWORD WINAPI XInputGetBatteryInformation(_In_ DWORD dwUserIndex, _In_ BYTE devType, _Out_ XINPUT_BATTERY_INFORMATION* pBatteryInformation)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	return ERROR_SUCCESS;
+	/*
+
+	ComPtr<IGameControllerBatteryInfo> battInf;
+	gamepads[dwUserIndex].As(&battInf);
+
+	ComPtr<IGameController> test;
+
+	ComPtr<ABI::Windows::Devices::Power::IBatteryReport> battReport;
+	battInf->TryGetBatteryReport(&battReport);
+
+	//Can't find any information on IReference
+	int Charge;
+	battReport->get_RemainingCapacityInMilliwattHours(&Charge);
+
+	*/
+	/*
+	InitializeGamepad();
+	auto state = m_gamePad->GetCapabilities(dwUserIndex);
+	if (state.connected) {
+		return ERROR_SUCCESS;
+	}
+	else
+	{
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+	*/
+}
+
+DLLEXPORT DWORD WINAPI XInputGetKeystroke(DWORD dwUserIndex, DWORD dwReserved, PXINPUT_KEYSTROKE pKeystroke)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+DLLEXPORT DWORD WINAPI XInputGetStateEx(_In_ DWORD dwUserIndex, _Out_ XINPUT_STATE* pState)
+{
+	return XInputGetState(dwUserIndex, pState);
+}
+
+DLLEXPORT DWORD WINAPI XInputWaitForGuideButton(_In_ DWORD dwUserIndex, _In_ DWORD dwFlag, _In_ LPVOID pVoid)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+DLLEXPORT DWORD XInputCancelGuideButtonWait(_In_ DWORD dwUserIndex)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+DLLEXPORT DWORD XInputPowerOffController(_In_ DWORD dwUserIndex)
+{
+	InitializeGamepad();
+
+	if (!IsConnected(dwUserIndex)) {
+		return ERROR_DEVICE_NOT_CONNECTED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+
+// DLL 卸載時清理 TelemetryReader
+// For hosts that want X1nput's threads gone before they exit: stops them in order, the output thread first since it
+// reads the telemetry readers. Not called from DllMain, where joining threads under the loader lock can deadlock.
+DLLEXPORT void cleanup() {
+	StopOutputScheduler();
+	configWatcher.stop();
+	telemetryRouter.stop();
 }
\ No newline at end of file
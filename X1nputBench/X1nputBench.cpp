@@ -0,0 +1,452 @@
+/*
+	x1nput-bench: per-call cost of the hot paths of the DLL.
+
+	Each benchmark runs its body over a small table of varied inputs (so branch
+	prediction sees something like real telemetry), repeats the whole run a few
+	times and reports the fastest, in nanoseconds per call. The results of every
+	call feed a volatile sink so nothing is optimised away.
+
+		x1nput-bench [filter]   only runs benchmarks whose name contains filter
+
+	It exits with 1 when the built-in effects, run through HapticsEngine, take
+	longer than the hand-written code they replaced (ComputeHapticsReference).
+
+	Built by the CMake build next to x1nput-sim; it needs no game, gamepad or
+	Windows. Use it to compare builds (-DX1NPUT_LTO, -DX1NPUT_PGO) or to profile
+	one path under perf or VTune.
+*/
+
+#include "CollisionDetector.h"
+#include "FastMath.h"
+#include "ForzaPacket.h"
+#include "HapticsEngine.h"
+#include "HapticsFilter.h"
+#include "InputTranslation.h"
+#include "LatencyStats.h"
+#include "SeqLock.h"
+#include "TelemetryDecoders.h"
+#include "TelemetryPredictor.h"
+#include "TelemetryRouter.h"
+#include "VibrationCoalescer.h"
+#include "WheelSlip.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const size_t kInputCount = 256;  // Power of two, inputs are picked with i & (kInputCount - 1)
+static const int kRuns = 5;
+
+static volatile double benchmarkSink;
+static const char* benchmarkFilter = nullptr;
+
+static bool Selected(const char* name) {
+	return benchmarkFilter == nullptr || std::strstr(name, benchmarkFilter) != nullptr;
+}
+
+// One run of body, in nanoseconds per call.
+template <typename Body>
+static double Time(uint64_t iterations, Body& body) {
+	typedef std::chrono::steady_clock Clock;
+
+	double sum = 0;
+	Clock::time_point start = Clock::now();
+	for (uint64_t i = 0; i < iterations; ++i) {
+		sum += body(i);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	benchmarkSink = sum;
+	return seconds * 1e9 / iterations;
+}
+
+template <typename Body>
+static void Run(const char* name, uint64_t iterations, Body&& body) {
+	if (!Selected(name)) {
+		return;
+	}
+
+	double best = 0;
+	for (int run = 0; run < kRuns; ++run) {
+		double time = Time(iterations, body);
+		best = run == 0 ? time : std::min(best, time);
+	}
+
+	std::printf("%-28s %9.2f ns\n", name, best);
+}
+
+// Runs a and b in turns, so clock changes and other load hit both alike, and prints both. Returns a's time over
+// b's, or 0 when the filter skips both.
+template <typename BodyA, typename BodyB>
+static double Compare(const char* nameA, BodyA&& a, const char* nameB, BodyB&& b, uint64_t iterations) {
+	if (!Selected(nameA) && !Selected(nameB)) {
+		return 0;
+	}
+
+	double bestA = 0;
+	double bestB = 0;
+	for (int run = 0; run < kRuns; ++run) {
+		double timeA = Time(iterations, a);
+		double timeB = Time(iterations, b);
+		bestA = run == 0 ? timeA : std::min(bestA, timeA);
+		bestB = run == 0 ? timeB : std::min(bestB, timeB);
+	}
+
+	std::printf("%-28s %9.2f ns\n", nameA, bestA);
+	std::printf("%-28s %9.2f ns\n", nameB, bestB);
+	return bestA / bestB;
+}
+
+// Stands in for IGamepad::put_Vibration: counts the updates that would go over the wire.
+struct MockGamepad {
+	uint64_t updates = 0;
+	HapticsOutput playing = {};
+
+	void put_Vibration(const HapticsOutput& vibration) {
+		++updates;
+		playing = vibration;
+	}
+};
+
+// Uniform in [lo, hi), the same sequence every run.
+static float Random(uint32_t& state, float lo, float hi) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return lo + (hi - lo) * (state / 4294967296.f);
+}
+
+template <ForzaField Field, typename Value>
+static void PutField(char* packet, Value value) {
+	typedef typename ForzaFieldStorage<kForzaFields[Field].type>::type Stored;
+	Stored stored = static_cast<Stored>(value);
+	std::memcpy(packet + ForzaDecoder<ForzaFormat::Horizon>::offset<Field>(), &stored, sizeof(stored));
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1) {
+		benchmarkFilter = argv[1];
+	}
+	bool failed = false;
+
+	// FH4/FH5 packets 16 ms apart with plausible values.
+	typedef char HorizonPacket[ForzaLayout<ForzaFormat::Horizon>::kPacketSize];
+	std::vector<HorizonPacket> packets(kInputCount);
+	std::vector<TelemetryData> telemetry(kInputCount);
+	std::vector<HapticsInput> inputs(kInputCount);
+	std::vector<RawGamepadReading> readings(kInputCount);
+	typedef char CodemastersPacket[kCodemastersPacketSize];
+	std::vector<CodemastersPacket> codemastersPackets(kInputCount);
+
+	uint32_t state = 1;
+	for (size_t i = 0; i < kInputCount; ++i) {
+		char* packet = packets[i];
+		std::memset(packet, 0, sizeof(HorizonPacket));
+		PutField<ForzaField_TimestampMs>(packet, 16 * i);
+		PutField<ForzaField_EngineMaxRpm>(packet, 8000.f);
+		PutField<ForzaField_EngineIdleRpm>(packet, 900.f);
+		PutField<ForzaField_CurrentEngineRpm>(packet, Random(state, 900.f, 8000.f));
+		PutField<ForzaField_AccelerationX>(packet, Random(state, -15.f, 15.f));
+		PutField<ForzaField_AccelerationY>(packet, Random(state, -2.f, 2.f));
+		PutField<ForzaField_AccelerationZ>(packet, Random(state, -12.f, 8.f));
+		PutField<ForzaField_TireSlipRatioFrontLeft>(packet, Random(state, -1.5f, 1.5f));
+		PutField<ForzaField_TireSlipRatioFrontRight>(packet, Random(state, -1.5f, 1.5f));
+		PutField<ForzaField_TireSlipRatioRearLeft>(packet, Random(state, -1.5f, 1.5f));
+		PutField<ForzaField_TireSlipRatioRearRight>(packet, Random(state, -1.5f, 1.5f));
+		PutField<ForzaField_TireCombinedSlipFrontLeft>(packet, Random(state, 0.f, 2.f));
+		PutField<ForzaField_TireCombinedSlipFrontRight>(packet, Random(state, 0.f, 2.f));
+		PutField<ForzaField_TireCombinedSlipRearLeft>(packet, Random(state, 0.f, 2.f));
+		PutField<ForzaField_TireCombinedSlipRearRight>(packet, Random(state, 0.f, 2.f));
+		PutField<ForzaField_Speed>(packet, Random(state, 0.f, 80.f));
+		PutField<ForzaField_Gear>(packet, i % 7);
+
+		telemetry[i] = TelemetryData();
+		DecodeForzaPacket(packet, sizeof(HorizonPacket), telemetry[i]);
+
+		// The same drive as DiRT would send it.
+		float fields[kCodemastersPacketSize / sizeof(float)] = {};
+		fields[CodemastersField_TotalTime] = 0.016f * i;
+		fields[CodemastersField_Speed] = telemetry[i].Speed;
+		fields[CodemastersField_WheelSpeedRearLeft] = telemetry[i].Speed * Random(state, 0.8f, 1.2f);
+		fields[CodemastersField_WheelSpeedRearRight] = telemetry[i].Speed * Random(state, 0.8f, 1.2f);
+		fields[CodemastersField_WheelSpeedFrontLeft] = telemetry[i].Speed * Random(state, 0.8f, 1.2f);
+		fields[CodemastersField_WheelSpeedFrontRight] = telemetry[i].Speed * Random(state, 0.8f, 1.2f);
+		fields[CodemastersField_Gear] = static_cast<float>(i % 7);
+		fields[CodemastersField_GForceLateral] = telemetry[i].AccelerationX / 9.8f;
+		fields[CodemastersField_GForceLongitudinal] = telemetry[i].AccelerationZ / 9.8f;
+		fields[CodemastersField_EngineRate] = telemetry[i].CurrentEngineRpm / 10.f;
+		fields[CodemastersField_MaxRpm] = 800.f;
+		fields[CodemastersField_IdleRpm] = 90.f;
+		std::memcpy(codemastersPackets[i], fields, sizeof(fields));
+
+		inputs[i].LeftTrigger = Random(state, 0.f, 1.f);
+		inputs[i].RightTrigger = Random(state, 0.f, 1.f);
+		inputs[i].LeftRumble = Random(state, 0.f, 1.f);
+		inputs[i].RightRumble = Random(state, 0.f, 1.f);
+
+		readings[i].Buttons = static_cast<uint32_t>(Random(state, 0.f, 16384.f));
+		readings[i].LeftTrigger = Random(state, 0.f, 1.f);
+		readings[i].RightTrigger = Random(state, 0.f, 1.f);
+		readings[i].LeftThumbstickX = Random(state, -1.f, 1.f);
+		readings[i].LeftThumbstickY = Random(state, -1.f, 1.f);
+		readings[i].RightThumbstickX = Random(state, -1.f, 1.f);
+		readings[i].RightThumbstickY = Random(state, -1.f, 1.f);
+	}
+
+	const uint64_t iterations = 2000000;
+	const size_t mask = kInputCount - 1;
+
+	std::printf("%-28s %12s\n", "Benchmark", "Time/call");
+
+	Run("DecodeForzaPacket", iterations, [&](uint64_t i) {
+		TelemetryData decoded;
+		DecodeForzaPacket(packets[i & mask], sizeof(HorizonPacket), decoded);
+		return static_cast<double>(decoded.Slip);
+	});
+
+	Run("DecodeCodemastersPacket", iterations, [&](uint64_t i) {
+		TelemetryData decoded;
+		return DecodeCodemastersPacket(codemastersPackets[i & mask], kCodemastersPacketSize, decoded) ? static_cast<double>(decoded.Slip) : 0.0;
+	});
+
+	// Codemasters packets go through the Forza length check first, as on a port that takes every format.
+	Run("DecodeTelemetryPacket", iterations, [&](uint64_t i) {
+		TelemetryData decoded;
+		return DecodeTelemetryPacket(codemastersPackets[i & mask], kCodemastersPacketSize, decoded) ? static_cast<double>(decoded.Slip) : 0.0;
+	});
+
+	Run("FastNorms", iterations, [&](uint64_t i) {
+		const TelemetryData& t = telemetry[i & mask];
+		const float tireSlip[4] = { t.TireSlipRatioFrontLeft, t.TireSlipRatioFrontRight, t.TireSlipRatioRearLeft, t.TireSlipRatioRearRight };
+		FastNormsResult norms = FastNorms(tireSlip, t.AccelerationY, t.AccelerationZ);
+		return static_cast<double>(norms.Slip + norms.Acceleration);
+	});
+
+	Run("FastNormsReference", iterations, [&](uint64_t i) {
+		const TelemetryData& t = telemetry[i & mask];
+		const float tireSlip[4] = { t.TireSlipRatioFrontLeft, t.TireSlipRatioFrontRight, t.TireSlipRatioRearLeft, t.TireSlipRatioRearRight };
+		FastNormsResult norms = FastNormsReference(tireSlip, t.AccelerationY, t.AccelerationZ);
+		return static_cast<double>(norms.Slip + norms.Acceleration);
+	});
+
+	Run("AnalyzeWheelSlip", iterations, [&](uint64_t i) {
+		const TelemetryData& t = telemetry[i & mask];
+		const float tireSlip[4] = { t.TireSlipRatioFrontLeft, t.TireSlipRatioFrontRight, t.TireSlipRatioRearLeft, t.TireSlipRatioRearRight };
+		const float combined[4] = { t.TireCombinedSlipFrontLeft, t.TireCombinedSlipFrontRight, t.TireCombinedSlipRearLeft, t.TireCombinedSlipRearRight };
+		WheelSlipResult wheels = AnalyzeWheelSlip(tireSlip, combined);
+		return static_cast<double>(wheels.Lockup + wheels.Wheelspin);
+	});
+
+	Run("AnalyzeWheelSlipReference", iterations, [&](uint64_t i) {
+		const TelemetryData& t = telemetry[i & mask];
+		const float tireSlip[4] = { t.TireSlipRatioFrontLeft, t.TireSlipRatioFrontRight, t.TireSlipRatioRearLeft, t.TireSlipRatioRearRight };
+		const float combined[4] = { t.TireCombinedSlipFrontLeft, t.TireCombinedSlipFrontRight, t.TireCombinedSlipRearLeft, t.TireCombinedSlipRearRight };
+		WheelSlipResult wheels = AnalyzeWheelSlipReference(tireSlip, combined);
+		return static_cast<double>(wheels.Lockup + wheels.Wheelspin);
+	});
+
+	CollisionDetector collisions;
+	Run("CollisionDetector::update", iterations, [&](uint64_t i) {
+		const TelemetryData& t = telemetry[i & mask];
+		CollisionImpulse impulse = collisions.update(static_cast<uint32_t>(16 * i), t.AccelerationX, t.AccelerationY, t.AccelerationZ);
+		return static_cast<double>(impulse.Strength);
+	});
+
+	TelemetryPredictorOptions prediction;
+	prediction.enabled = true;
+	TelemetryPredictor predictor(prediction);
+	Run("TelemetryPredictor+Predict", iterations, [&](uint64_t i) {
+		TelemetryData t = telemetry[i & mask];
+		t.TimestampMs = static_cast<uint32_t>(16 * i);
+		predictor.update(t);
+		PredictTelemetry(t, 0.01f);
+		return static_cast<double>(t.CurrentEngineRpm + t.Acceleration);
+	});
+
+	HapticsEngine engine;
+	HapticsState hapticsState;
+	hapticsState.Engaged = true;
+	Run("HapticsEngine::compute", iterations, [&](uint64_t i) {
+		HapticsOutput output = engine.compute(&telemetry[i & mask], inputs[i & mask], hapticsState);
+		return output.LeftMotor + output.RightMotor + output.LeftTrigger + output.RightTrigger;
+	});
+
+	// The same effects as the hand-written code had them, against that code: the graph's own cost. It may not cost
+	// more than the code it replaced, so a slower graph fails the run.
+	HapticsEngine classicEngine{ HapticsSettings(), EffectPresets(ClassicEffectProgram()) };
+	HapticsSettings referenceSettings;
+	const double classicRatio = Compare("HapticsEngine classic", [&](uint64_t i) {
+		HapticsOutput output = classicEngine.compute(&telemetry[i & mask], inputs[i & mask], hapticsState);
+		return output.LeftMotor + output.RightMotor + output.LeftTrigger + output.RightTrigger;
+	}, "ComputeHapticsReference", [&](uint64_t i) {
+		HapticsOutput output = ComputeHapticsReference(&telemetry[i & mask], inputs[i & mask], referenceSettings, hapticsState);
+		return output.LeftMotor + output.RightMotor + output.LeftTrigger + output.RightTrigger;
+	}, iterations);
+	if (classicRatio > 0) {
+		std::printf("%-28s %9.3f\n", "classic / reference", classicRatio);
+	}
+	if (classicRatio > 1.0) {
+		std::fprintf(stderr, "HapticsEngine classic is slower than ComputeHapticsReference\n");
+		failed = true;
+	}
+
+	// Every stage on, all eight pads of an output thread tick per call.
+	HapticsFilterOptions smoothing;
+	smoothing.motors = { 5.f, 60.f, 10.f, 8.f };
+	smoothing.triggers = { 0.f, 40.f, 15.f, 4.f };
+	HapticsFilterState filters[8];
+	Run("FilterHaptics 8 pads", iterations, [&](uint64_t i) {
+		HapticsOutput outputs[8];
+		for (size_t pad = 0; pad < 8; ++pad) {
+			const HapticsInput& input = inputs[(i + pad) & mask];
+			outputs[pad] = { input.LeftRumble, input.RightRumble, input.LeftTrigger, input.RightTrigger };
+		}
+		FilterHaptics(ComputeFilterCoefficients(smoothing, 0.004), filters, outputs, 8);
+		return outputs[0].LeftMotor + outputs[7].RightTrigger;
+	});
+
+	Run("FilterHapticsScalar 8 pads", iterations, [&](uint64_t i) {
+		HapticsOutput outputs[8];
+		for (size_t pad = 0; pad < 8; ++pad) {
+			const HapticsInput& input = inputs[(i + pad) & mask];
+			outputs[pad] = { input.LeftRumble, input.RightRumble, input.LeftTrigger, input.RightTrigger };
+		}
+		FilterHapticsScalar(ComputeFilterCoefficients(smoothing, 0.004), filters, outputs, 8);
+		return outputs[0].LeftMotor + outputs[7].RightTrigger;
+	});
+
+	// A minute of a 500 Hz output thread with [Smoothing] on, fed 60 Hz telemetry and a game rumble that stops for a
+	// second out of every four, sent to a mock gamepad raw and through the [Output] coalescing. One call is a tick.
+	struct OutputThread {
+		HapticsState state;
+		HapticsFilterState filter;
+		VibrationCoalescer coalescer;
+		MockGamepad gamepad;
+	};
+	const uint64_t outputTicks = 500 * 60;
+	auto outputTick = [&](OutputThread& thread, const VibrationCoalescerOptions* coalescing, uint64_t tick) {
+		if (tick == 0) {
+			thread.state = HapticsState();
+			thread.filter = HapticsFilterState();
+			thread.coalescer.reset();
+			thread.gamepad = MockGamepad();
+		}
+		bool paused = (tick / 500) % 4 == 3;
+		HapticsInput input = inputs[(tick * 60 / 500) & mask];
+		if (paused) {
+			input.LeftRumble = input.RightRumble = 0.f;
+		}
+		HapticsOutput output = engine.compute(paused ? nullptr : &telemetry[(tick * 60 / 500) & mask], input, thread.state);
+		FilterHaptics(ComputeFilterCoefficients(smoothing, 0.002), &thread.filter, &output, 1);
+		if (coalescing == nullptr || thread.coalescer.update(*coalescing, output, tick * 2000000)) {
+			thread.gamepad.put_Vibration(output);
+		}
+		return thread.gamepad.playing.LeftMotor;
+	};
+
+	const char* outputNames[3] = { "OutputTick raw", "OutputTick coalesced", "OutputTick coalesced 125/s" };
+	VibrationCoalescerOptions coalescing[3];
+	coalescing[2].maxRate = 125;
+	OutputThread outputThreads[3];
+	for (size_t variant = 0; variant < 3; ++variant) {
+		Run(outputNames[variant], outputTicks, [&](uint64_t i) {
+			return outputTick(outputThreads[variant], variant == 0 ? nullptr : &coalescing[variant], i);
+		});
+	}
+	for (size_t variant = 0; variant < 3; ++variant) {
+		if (outputThreads[variant].gamepad.updates > 0) {
+			std::printf("  %-26s %6llu of %llu ticks sent, ends %s\n", outputNames[variant],
+				static_cast<unsigned long long>(outputThreads[variant].gamepad.updates), static_cast<unsigned long long>(outputTicks),
+				outputThreads[variant].gamepad.playing.LeftMotor == 0 ? "silent" : "still playing");
+		}
+	}
+
+	SeqLock<TelemetryData> published;
+	Run("SeqLock store+load", iterations, [&](uint64_t i) {
+		published.store(telemetry[i & mask]);
+		return static_cast<double>(published.load().Speed);
+	});
+
+	Run("TranslateReading", iterations, [&](uint64_t i) {
+		TranslatedGamepad pad;
+		TranslateReading(readings[i & mask], 0.24f, pad);
+		return static_cast<double>(pad.sThumbLX + pad.wButtons);
+	});
+
+	Run("TranslateReadingScalar", iterations, [&](uint64_t i) {
+		TranslatedGamepad pad;
+		TranslateReadingScalar(readings[i & mask], 0.24f, pad);
+		return static_cast<double>(pad.sThumbLX + pad.wButtons);
+	});
+
+	Run("LatencyBucket", iterations, [&](uint64_t i) {
+		return static_cast<double>(LatencyBucket(i * 2654435761u));
+	});
+
+	// A reader on an ephemeral port that never gets a packet: network thread start, bind, then stop() waking the
+	// wait. The readers' messages are muted while it runs.
+	TelemetryReaderOptions readerOptions;
+	readerOptions.port = 0;
+	const uint64_t cycles = 200;
+	std::cout.setstate(std::ios::failbit);
+
+	Run("TelemetryRouter start+stop", cycles, [&](uint64_t) {
+		TelemetryRouter router;
+		TelemetryReader* reader = router.reader(0, readerOptions);
+		while (!reader->isListening()) {
+			std::this_thread::yield();
+		}
+		router.stop();
+		return 0.0;
+	});
+
+	if (benchmarkFilter == nullptr || std::strstr("TelemetryRouter::stop", benchmarkFilter) != nullptr) {
+		// The teardown alone, which should stay well under a millisecond. The worst case is mostly how long the OS
+		// takes to run the woken network thread, so the 99th percentile is printed too.
+		double total = 0;
+		std::vector<double> stops;
+		for (uint64_t cycle = 0; cycle < cycles; ++cycle) {
+			TelemetryRouter router;
+			TelemetryReader* reader = router.reader(0, readerOptions);
+			while (!reader->isListening()) {
+				std::this_thread::yield();
+			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			router.stop();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			total += seconds;
+			stops.push_back(seconds);
+		}
+		std::sort(stops.begin(), stops.end());
+		std::printf("%-28s %9.2f ns\n", "TelemetryRouter::stop", total * 1e9 / cycles);
+		std::printf("%-28s %9.2f ns\n", "TelemetryRouter::stop p99", stops[cycles * 99 / 100] * 1e9);
+		std::printf("%-28s %9.2f ns\n", "TelemetryRouter::stop worst", stops.back() * 1e9);
+	}
+
+	std::cout.clear();
+
+	// One drain pass worth of datagrams to two loopback ports nobody listens on.
+	std::vector<RelayTarget> relayTargets(2);
+	relayTargets[0].endpoint = { 0x7F000001, 9 };
+	relayTargets[1].endpoint = { 0x7F000001, 10 };
+	TelemetryRelay relay;
+	if (relay.open(0, relayTargets)) {
+		DatagramBatch* relayBatch = new DatagramBatch();
+		relayBatch->count = DatagramBatch::kCapacity;
+		for (int i = 0; i < DatagramBatch::kCapacity; ++i) {
+			std::memcpy(relayBatch->data[i], packets[i], sizeof(HorizonPacket));
+			relayBatch->lengths[i] = static_cast<int>(sizeof(HorizonPacket));
+		}
+		Run("TelemetryRelay::send 16x2", 20000, [&](uint64_t) {
+			relay.send(*relayBatch);
+			return static_cast<double>(relay.packetsSent(0));
+		});
+		delete relayBatch;
+	}
+
+	return failed ? 1 : 0;
+}
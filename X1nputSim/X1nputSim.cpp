@@ -0,0 +1,1009 @@
+/*
+	x1nput-sim: the X1nput haptics pipeline without a game or a gamepad.
+
+	Telemetry comes from a capture ([Telemetry] CaptureFile in X1nput.ini) or
+	from a synthetic drive profile. Every packet goes through the same code as in
+	the DLL: DecodeForzaPacket, CollisionDetector, HapticsEngine and
+	FilterHaptics with the strengths, [Effects], [Collision] and [Smoothing] of
+	an X1nput.ini. The motor and trigger values that would have gone to
+	put_Vibration are written out, one frame per packet, so effect curves can be
+	compared and regressions caught by diffing two runs. [Smoothing] steps by the
+	packet timestamps, as if the output followed every packet. The frames are
+	also run through the [Output] VibrationCoalescer, and the summary tells how
+	many of them would have reached the driver. With [Prediction] on, each
+	packet is extrapolated by LeadMs before the effects, as if it was used the
+	moment it arrived.
+
+	--predict-error MS measures the TelemetryPredictor on the packets: each one
+	is extrapolated MS milliseconds ahead and compared with the value the later
+	packets show at that time. The RMS and largest error per value go to
+	stderr, next to those of simply holding the last packet.
+
+	Frames are handled in batches: a batch of packets is decoded, then run
+	through the effects, then formatted into one buffer and written with a
+	single call. Hours of telemetry take seconds.
+
+	The pad behaves like a pad following telemetry ([Routing]): effects are on
+	from the first frame, and the game's rumble is whatever --rumble says. The
+	trigger positions are the pedals from the Dash block (brake on the left,
+	throttle on the right), or released for Sled packets.
+
+	Output formats:
+
+		csv     TimeUs,LeftMotor,RightMotor,LeftTrigger,RightTrigger
+		binary  8 byte magic "X1SIMOUT", uint32_t version, uint32_t record size,
+		        then per frame uint64_t TimeUs and four floats in the order above.
+		        Little-endian, packed.
+
+	TimeUs is the capture timestamp, or the time into the synthetic drive.
+
+	Captures of any game X1nput decodes work (TelemetryDecoders.h). Two modes
+	take the network in, so the receiving side can be tried on one machine:
+
+		--send HOST:PORT  sends the packets of the capture or drive to a port
+		                  at their recorded timing instead of simulating, as
+		                  Forza, Codemasters or generic packets (--send-format)
+		--listen PORTS    simulates live telemetry: the ports (comma separated)
+		                  are read by the DLL's TelemetryRouter for --duration
+		                  seconds and a frame is written whenever the first port
+		                  has a new packet. Per-port counters and the detected
+		                  game go to stderr.
+
+	For example, in two terminals:
+
+		x1nput-sim --listen 9999,20777 --duration 30
+		x1nput-sim --profile lap --send 127.0.0.1:20777 --send-format codemasters
+*/
+
+#include "CollisionDetector.h"
+#include "Config.h"
+#include "ForzaPacket.h"
+#include "HapticsEngine.h"
+#include "HapticsFilter.h"
+#include "IniFile.h"
+#include "TelemetryCapture.h"
+#include "TelemetryDecoders.h"
+#include "TelemetryPredictor.h"
+#include "TelemetryRouter.h"
+#include "UdpSocket.h"
+#include "VibrationCoalescer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t kBatchSize = 4096;
+
+static const char kUsage[] =
+	"Usage: x1nput-sim (--capture FILE | --profile NAME | --listen PORTS) [options]\n"
+	"\n"
+	"  --capture FILE      Replay a telemetry capture\n"
+	"  --profile NAME      Synthetic drive: lap, crash or idle\n"
+	"  --listen PORTS      Live telemetry from these UDP ports, comma separated\n"
+	"  --duration SECONDS  Length of the synthetic drive or of --listen (600)\n"
+	"  --rate HZ           Packets per second of the synthetic drive, polls per second of --listen (60)\n"
+	"  --seed N            Noise seed of the synthetic drive (1)\n"
+	"  --config FILE       X1nput.ini to use (built-in defaults without it)\n"
+	"  --rumble L,R        Game rumble held for the whole run, 0..1 (0,0)\n"
+	"  --format csv|binary Output format (csv)\n"
+	"  --output FILE       Write frames here instead of stdout\n"
+	"  --send HOST:PORT    Send the packets there at their timing instead of simulating\n"
+	"  --send-format F     forza, codemasters or generic (forza: the packets as they are)\n"
+	"  --predict-error MS  Measure how far [Prediction] is off when it looks MS milliseconds ahead\n"
+	"  --quiet             No summary on stderr\n";
+
+// Synthetic drives
+
+enum DriveEvent {
+	DriveEvent_None,
+	DriveEvent_Kerb,     // Vertical bumps while the segment lasts
+	DriveEvent_Wall,     // Hit a wall as the segment starts, most of the speed is lost in one packet
+	DriveEvent_Reverse,  // Reverse gear
+	DriveEvent_Pause,    // Game paused: the engine reads 0 RPM
+};
+
+struct DriveSegment {
+	float seconds;
+	float throttle;   // 0..1
+	float brake;      // 0..1
+	float curvature;  // 1/turn radius in metres, positive turns right
+	DriveEvent event;
+};
+
+struct DriveProfile {
+	const char* name;
+	const DriveSegment* segments;
+	size_t count;
+};
+
+// A race lap: launch, braking zones hard enough for ABS, a kerb and a hairpin.
+static const DriveSegment kLapSegments[] = {
+	{ 14.f, 1.0f, 0.0f,  0.f,          DriveEvent_None },
+	{  3.f, 0.0f, 1.0f,  0.f,          DriveEvent_None },
+	{  6.f, 0.5f, 0.0f,  1.f / 80.f,   DriveEvent_None },
+	{  9.f, 1.0f, 0.0f,  0.f,          DriveEvent_None },
+	{  4.f, 0.7f, 0.0f, -1.f / 50.f,   DriveEvent_Kerb },
+	{  2.f, 0.0f, 0.8f,  0.f,          DriveEvent_None },
+	{  5.f, 0.3f, 0.0f,  1.f / 20.f,   DriveEvent_None },
+	{ 12.f, 1.0f, 0.0f,  0.f,          DriveEvent_None },
+	{  3.f, 0.0f, 1.0f, -1.f / 120.f,  DriveEvent_None },
+	{  6.f, 0.6f, 0.0f, -1.f / 40.f,   DriveEvent_None },
+};
+
+// Wall hits from both sides, backing out in reverse after each.
+static const DriveSegment kCrashSegments[] = {
+	{ 8.f, 1.0f, 0.0f,  0.f,         DriveEvent_None },
+	{ 1.f, 0.3f, 0.0f,  1.f / 30.f,  DriveEvent_Wall },
+	{ 2.f, 0.0f, 1.0f,  0.f,         DriveEvent_None },
+	{ 3.f, 0.4f, 0.0f,  0.f,         DriveEvent_Reverse },
+	{ 8.f, 1.0f, 0.0f,  0.f,         DriveEvent_None },
+	{ 1.f, 0.3f, 0.0f, -1.f / 30.f,  DriveEvent_Wall },
+	{ 2.f, 0.0f, 1.0f,  0.f,         DriveEvent_None },
+	{ 3.f, 0.4f, 0.0f,  0.f,         DriveEvent_Reverse },
+};
+
+// Parked: idling, revving in neutral, and the pause menu.
+static const DriveSegment kIdleSegments[] = {
+	{ 10.f, 0.0f, 1.0f, 0.f, DriveEvent_None },
+	{  2.f, 0.8f, 1.0f, 0.f, DriveEvent_None },
+	{  5.f, 0.0f, 1.0f, 0.f, DriveEvent_None },
+	{  5.f, 0.0f, 0.0f, 0.f, DriveEvent_Pause },
+};
+
+static const DriveProfile kDriveProfiles[] = {
+	{ "lap", kLapSegments, sizeof(kLapSegments) / sizeof(kLapSegments[0]) },
+	{ "crash", kCrashSegments, sizeof(kCrashSegments) / sizeof(kCrashSegments[0]) },
+	{ "idle", kIdleSegments, sizeof(kIdleSegments) / sizeof(kIdleSegments[0]) },
+};
+
+template <ForzaField Field, typename Value>
+static void PutField(char* packet, Value value) {
+	typedef ForzaDecoder<ForzaFormat::Horizon> Encoder;
+	typename ForzaFieldStorage<kForzaFields[Field].type>::type stored = static_cast<typename ForzaFieldStorage<kForzaFields[Field].type>::type>(value);
+	std::memcpy(packet + Encoder::offset<Field>(), &stored, sizeof(stored));
+}
+
+/*
+	Loops over a profile's segments with a point-mass car: a torque curve and six
+	gears forward, drag, brakes, and lateral acceleration from speed and
+	curvature. Slip ratios follow the pedals (wheelspin in low gears, lock-up
+	with ABS under hard braking) with a little deterministic noise and slip
+	angles the cornering, so the slip and RPM effects have something to react
+	to. Packets are FH4/FH5 "Dash".
+*/
+class SyntheticDrive {
+public:
+	SyntheticDrive(const DriveProfile& profile, double seconds, double rate, uint32_t seed)
+		: profile(profile), frameCount(static_cast<uint64_t>(seconds * rate)), frame(0), step(1.0 / rate),
+		segment(0), segmentTime(0), speed(0), gear(1), noise(seed != 0 ? seed : 1) {
+		std::memset(packet, 0, sizeof(packet));
+	}
+
+	bool next(uint64_t& timeUs, const char*& data, size_t& length) {
+		if (frame == frameCount) {
+			return false;
+		}
+		timeUs = static_cast<uint64_t>(frame * step * 1e6 + 0.5);
+		advance();
+		data = packet;
+		length = sizeof(packet);
+		++frame;
+		return true;
+	}
+
+private:
+	static constexpr float kIdleRpm = 900.f;
+	static constexpr float kMaxRpm = 8000.f;
+	static constexpr float kRpmPerMps[7] = { 160.f, 210.f, 140.f, 105.f, 84.f, 70.f, 60.f };  // Reverse, then 1st to 6th
+
+	const DriveProfile& profile;
+	uint64_t frameCount;
+	uint64_t frame;
+	double step;
+
+	size_t segment;
+	double segmentTime;
+	float speed;         // m/s, negative in reverse
+	int gear;            // 0 is reverse
+	uint32_t noise;
+	char packet[ForzaLayout<ForzaFormat::Horizon>::kPacketSize];
+
+	// Uniform in [-1, 1).
+	float random() {
+		noise ^= noise << 13;
+		noise ^= noise >> 17;
+		noise ^= noise << 5;
+		return static_cast<float>(noise) / 2147483648.f - 1.f;
+	}
+
+	void advance() {
+		bool entered = segmentTime == 0;
+		const DriveSegment& drive = profile.segments[segment];
+		const float dt = static_cast<float>(step);
+
+		// Engine and gearbox
+		float rpm = kIdleRpm + std::fabs(speed) * kRpmPerMps[gear];
+		if (drive.event == DriveEvent_Reverse) {
+			gear = 0;
+		}
+		else if (gear == 0) {
+			gear = 1;
+		}
+		else if (rpm > 0.92f * kMaxRpm && gear < 6) {
+			++gear;
+		}
+		else if (rpm < 0.45f * kMaxRpm && gear > 1) {
+			--gear;
+		}
+		rpm = std::fmin(kIdleRpm + std::fabs(speed) * kRpmPerMps[gear], kMaxRpm);
+		if (std::fabs(speed) < 0.5f) {
+			rpm = kIdleRpm + drive.throttle * (kMaxRpm - kIdleRpm) * 0.6f;  // Clutch in, revving in place
+		}
+
+		// Longitudinal: torque falls off past the peak, drag grows with the square of the speed.
+		float torque = 1.f - 0.5f * std::fabs(rpm / kMaxRpm - 0.65f);
+		float push = drive.throttle * torque * 2600.f / kRpmPerMps[gear] * (gear == 0 ? -1.f : 1.f);
+		float direction = speed < 0 ? -1.f : 1.f;
+		float braking = std::fabs(speed) > 0.1f ? drive.brake * 11.f * direction : 0.f;
+		float drag = 0.0004f * speed * std::fabs(speed) * 9.f;
+		float accel = push - braking - drag;
+		if (entered && drive.event == DriveEvent_Wall) {
+			accel = -0.6f * speed / dt;
+		}
+		speed += accel * dt;
+		bool held = drive.brake * 11.f >= std::fabs(push) && std::fabs(speed) < 0.5f;
+		if (held || (drive.event != DriveEvent_Reverse && speed < 0)) {
+			speed = 0;
+			accel = 0;
+		}
+
+		float lateral = speed * speed * drive.curvature;
+		float vertical = random() * 0.3f;
+		if (drive.event == DriveEvent_Kerb) {
+			vertical += (static_cast<uint32_t>(segmentTime * 12) & 1) ? 6.f : -6.f;
+		}
+		if (entered && drive.event == DriveEvent_Wall) {
+			lateral += drive.curvature > 0 ? 90.f : -90.f;
+		}
+
+		// Wheelspin on the driven (rear) wheels, lock-up with ABS cycling on the fronts.
+		float spin = gear <= 2 ? std::fmax(0.f, drive.throttle * torque - 0.55f) * 3.f : 0.f;
+		float lock = std::fabs(speed) > 8.f ? std::fmax(0.f, drive.brake - 0.6f) * 3.f : 0.f;
+		float cycle = 0.5f + 0.5f * std::sin(static_cast<float>(segmentTime) * 40.f);
+		float slipFront = -lock * (0.6f + 0.6f * cycle) + random() * 0.03f;
+		float slipRear = spin * (0.8f + 0.4f * cycle) - lock * 0.3f + random() * 0.03f;
+		float slipLeft = drive.curvature * 4.f;
+		float angleFront = lateral / 12.f;  // Slip angles past the grip from about 12 m/s^2 of cornering, the rear holds a little more
+		float angleRear = lateral / 14.f;
+
+		if (drive.event == DriveEvent_Pause) {
+			rpm = 0;
+			accel = 0;
+			lateral = 0;
+			vertical = 0;
+		}
+
+		const uint32_t timestampMs = static_cast<uint32_t>(static_cast<uint64_t>(frame * step * 1000));
+		const int32_t raceOn = drive.event == DriveEvent_Pause ? 0 : 1;
+		std::memcpy(packet, &raceOn, sizeof(raceOn));
+		PutField<ForzaField_TimestampMs>(packet, timestampMs);
+		PutField<ForzaField_EngineMaxRpm>(packet, kMaxRpm);
+		PutField<ForzaField_EngineIdleRpm>(packet, kIdleRpm);
+		PutField<ForzaField_CurrentEngineRpm>(packet, rpm);
+		PutField<ForzaField_AccelerationX>(packet, lateral);
+		PutField<ForzaField_AccelerationY>(packet, vertical);
+		PutField<ForzaField_AccelerationZ>(packet, accel);
+		PutField<ForzaField_VelocityX>(packet, 0.f);
+		PutField<ForzaField_VelocityY>(packet, 0.f);
+		PutField<ForzaField_VelocityZ>(packet, speed);
+		PutField<ForzaField_TireSlipRatioFrontLeft>(packet, slipFront - slipLeft);
+		PutField<ForzaField_TireSlipRatioFrontRight>(packet, slipFront + slipLeft);
+		PutField<ForzaField_TireSlipRatioRearLeft>(packet, slipRear - slipLeft);
+		PutField<ForzaField_TireSlipRatioRearRight>(packet, slipRear + slipLeft);
+		PutField<ForzaField_TireSlipAngleFrontLeft>(packet, angleFront);
+		PutField<ForzaField_TireSlipAngleFrontRight>(packet, angleFront);
+		PutField<ForzaField_TireSlipAngleRearLeft>(packet, angleRear);
+		PutField<ForzaField_TireSlipAngleRearRight>(packet, angleRear);
+		PutField<ForzaField_TireCombinedSlipFrontLeft>(packet, std::hypot(slipFront - slipLeft, angleFront));
+		PutField<ForzaField_TireCombinedSlipFrontRight>(packet, std::hypot(slipFront + slipLeft, angleFront));
+		PutField<ForzaField_TireCombinedSlipRearLeft>(packet, std::hypot(slipRear - slipLeft, angleRear));
+		PutField<ForzaField_TireCombinedSlipRearRight>(packet, std::hypot(slipRear + slipLeft, angleRear));
+		PutField<ForzaField_Speed>(packet, std::fabs(speed));
+		PutField<ForzaField_Gear>(packet, gear);
+		PutField<ForzaField_Accel>(packet, drive.throttle * 255.f);
+		PutField<ForzaField_Brake>(packet, drive.brake * 255.f);
+
+		segmentTime += step;
+		if (segmentTime >= drive.seconds) {
+			segmentTime = 0;
+			segment = (segment + 1) % profile.count;
+		}
+	}
+};
+
+// Decoding and output
+
+struct SimulatorOptions {
+	std::string capturePath;
+	std::string profileName;
+	double duration = 600;
+	double rate = 60;
+	uint32_t seed = 1;
+	std::string configPath;
+	float leftRumble = 0;
+	float rightRumble = 0;
+	bool binary = false;
+	std::string outputPath;
+	std::vector<uint16_t> listenPorts;
+	std::string sendTarget;
+	TelemetrySource sendFormat = TelemetrySource_Forza;
+	double predictErrorMs = 0;  // 0 for off
+	bool quiet = false;
+};
+
+struct SimulatorFrame {
+	uint64_t timeUs;
+	TelemetryData telemetry;
+	HapticsInput input;
+	HapticsOutput output;
+};
+
+// Pedals as trigger positions, see the top of the file.
+template <ForzaFormat Format>
+static void ReadPedals(const PacketView& packet, HapticsInput& input) {
+	typedef ForzaDecoder<Format> Decoder;
+	if constexpr (ForzaLayout<Format>::kHasDash) {
+		input.LeftTrigger = Decoder::template get<ForzaField_Brake>(packet) / 255.f;
+		input.RightTrigger = Decoder::template get<ForzaField_Accel>(packet) / 255.f;
+	}
+	else {
+		input.LeftTrigger = 0;
+		input.RightTrigger = 0;
+	}
+}
+
+// Same dispatch as the DLL's readers. Returns false for anything no decoder accepts.
+static bool DecodeFrame(const char* data, size_t length, SimulatorFrame& frame) {
+	if (!DecodeTelemetryPacket(data, length, frame.telemetry)) {
+		return false;
+	}
+
+	PacketView packet(data, length);
+	if (frame.telemetry.Source == TelemetrySource_Codemasters) {
+		frame.input.LeftTrigger = CodemastersDecoder::get<CodemastersField_Brake>(packet);
+		frame.input.RightTrigger = CodemastersDecoder::get<CodemastersField_Throttle>(packet);
+		return true;
+	}
+	if (frame.telemetry.Source == TelemetrySource_Generic) {
+		size_t count = GenericDecoder::fieldCount(packet);
+		frame.input.LeftTrigger = GenericDecoder::get(packet, count, GenericField_Brake);
+		frame.input.RightTrigger = GenericDecoder::get(packet, count, GenericField_Throttle);
+		return true;
+	}
+
+	switch (length) {
+	case ForzaLayout<ForzaFormat::Sled>::kPacketSize:
+		ReadPedals<ForzaFormat::Sled>(packet, frame.input);
+		break;
+	case ForzaLayout<ForzaFormat::Horizon>::kPacketSize:
+		ReadPedals<ForzaFormat::Horizon>(packet, frame.input);
+		break;
+	default:
+		ReadPedals<ForzaFormat::Dash>(packet, frame.input);
+		break;
+	}
+	return true;
+}
+
+// --send-format: a decoded frame written back out as another game would send it. Returns the packet length.
+static size_t EncodeCodemasters(const SimulatorFrame& frame, char* packet) {
+	const TelemetryData& t = frame.telemetry;
+	const float kStandardGravity = 9.80665f;
+	float fields[kCodemastersPacketSize / sizeof(float)] = {};
+
+	// The inverse of CodemastersDecoder's slip ratios.
+	float slipScale = std::fmax(std::fabs(t.Speed), 1.f) * kCodemastersPeakSlipRatio;
+	fields[CodemastersField_TotalTime] = t.TimestampMs / 1000.f;
+	fields[CodemastersField_Speed] = t.Speed;
+	fields[CodemastersField_WheelSpeedFrontLeft] = t.Speed + t.TireSlipRatioFrontLeft * slipScale;
+	fields[CodemastersField_WheelSpeedFrontRight] = t.Speed + t.TireSlipRatioFrontRight * slipScale;
+	fields[CodemastersField_WheelSpeedRearLeft] = t.Speed + t.TireSlipRatioRearLeft * slipScale;
+	fields[CodemastersField_WheelSpeedRearRight] = t.Speed + t.TireSlipRatioRearRight * slipScale;
+	fields[CodemastersField_Throttle] = frame.input.RightTrigger;
+	fields[CodemastersField_Brake] = frame.input.LeftTrigger;
+	fields[CodemastersField_Gear] = t.Gear == 0 ? 10.f : t.Gear;
+	fields[CodemastersField_GForceLateral] = t.AccelerationX / kStandardGravity;
+	fields[CodemastersField_GForceLongitudinal] = t.AccelerationZ / kStandardGravity;
+	fields[CodemastersField_EngineRate] = t.CurrentEngineRpm / 10.f;
+	fields[CodemastersField_MaxRpm] = t.EngineMaxRpm / 10.f;
+	fields[CodemastersField_IdleRpm] = t.EngineIdleRpm / 10.f;
+
+	std::memcpy(packet, fields, sizeof(fields));
+	return sizeof(fields);
+}
+
+static size_t EncodeGeneric(const SimulatorFrame& frame, char* packet) {
+	const TelemetryData& t = frame.telemetry;
+	const float fields[GenericField_Count] = {
+		t.Speed, t.CurrentEngineRpm, t.EngineIdleRpm, t.EngineMaxRpm, static_cast<float>(t.Gear),
+		t.AccelerationX, t.AccelerationY, t.AccelerationZ,
+		t.TireSlipRatioFrontLeft, t.TireSlipRatioFrontRight, t.TireSlipRatioRearLeft, t.TireSlipRatioRearRight,
+		t.TireCombinedSlipFrontLeft, t.TireCombinedSlipFrontRight, t.TireCombinedSlipRearLeft, t.TireCombinedSlipRearRight,
+		frame.input.RightTrigger, frame.input.LeftTrigger,
+	};
+	const uint16_t header[2] = { kGenericPacketVersion, GenericField_Count };
+
+	std::memcpy(packet, kGenericPacketMagic, sizeof(kGenericPacketMagic));
+	std::memcpy(packet + 4, header, sizeof(header));
+	std::memcpy(packet + 8, &t.TimestampMs, sizeof(t.TimestampMs));
+	std::memcpy(packet + kGenericHeaderSize, fields, sizeof(fields));
+	return kGenericHeaderSize + sizeof(fields);
+}
+
+class FrameWriter {
+public:
+	FrameWriter(FILE* file, bool binary) : file(file), binary(binary) {
+		buffer.reserve(kBatchSize * 64);
+	}
+
+	void begin() {
+		if (binary) {
+			const char magic[8] = { 'X', '1', 'S', 'I', 'M', 'O', 'U', 'T' };
+			const uint32_t header[2] = { 1, kBinaryRecordSize };
+			append(magic, sizeof(magic));
+			append(header, sizeof(header));
+		}
+		else {
+			static const char kHeader[] = "TimeUs,LeftMotor,RightMotor,LeftTrigger,RightTrigger\n";
+			append(kHeader, sizeof(kHeader) - 1);
+		}
+	}
+
+	void add(const SimulatorFrame& frame) {
+		const HapticsOutput& output = frame.output;
+		if (binary) {
+			const float values[4] = {
+				static_cast<float>(output.LeftMotor), static_cast<float>(output.RightMotor),
+				static_cast<float>(output.LeftTrigger), static_cast<float>(output.RightTrigger),
+			};
+			append(&frame.timeUs, sizeof(frame.timeUs));
+			append(values, sizeof(values));
+			return;
+		}
+
+		char line[128];
+		int length = std::snprintf(line, sizeof(line), "%llu,%.4f,%.4f,%.4f,%.4f\n", static_cast<unsigned long long>(frame.timeUs),
+			output.LeftMotor, output.RightMotor, output.LeftTrigger, output.RightTrigger);
+		append(line, static_cast<size_t>(length));
+	}
+
+	// One write per batch.
+	bool flush() {
+		bool written = buffer.empty() || std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+		buffer.clear();
+		return written;
+	}
+
+private:
+	static const uint32_t kBinaryRecordSize = sizeof(uint64_t) + 4 * sizeof(float);
+
+	FILE* file;
+	bool binary;
+	std::vector<char> buffer;
+
+	void append(const void* data, size_t length) {
+		const char* bytes = static_cast<const char*>(data);
+		buffer.insert(buffer.end(), bytes, bytes + length);
+	}
+};
+
+static bool ParseArguments(int argc, char** argv, SimulatorOptions& options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		bool usesValue = true;
+
+		if (argument == "--quiet") {
+			options.quiet = true;
+			usesValue = false;
+		}
+		else if (value == nullptr) {
+			std::fprintf(stderr, "%s needs a value\n", argument.c_str());
+			return false;
+		}
+		else if (argument == "--capture") {
+			options.capturePath = value;
+		}
+		else if (argument == "--profile") {
+			options.profileName = value;
+		}
+		else if (argument == "--duration") {
+			options.duration = std::atof(value);
+		}
+		else if (argument == "--predict-error") {
+			options.predictErrorMs = std::atof(value);
+			if (options.predictErrorMs <= 0 || options.predictErrorMs > kPredictorMaxGapMs) {
+				std::fprintf(stderr, "--predict-error takes 1 to %u milliseconds\n", kPredictorMaxGapMs);
+				return false;
+			}
+		}
+		else if (argument == "--rate") {
+			options.rate = std::atof(value);
+		}
+		else if (argument == "--seed") {
+			options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if (argument == "--config") {
+			options.configPath = value;
+		}
+		else if (argument == "--rumble") {
+			if (std::sscanf(value, "%f,%f", &options.leftRumble, &options.rightRumble) != 2) {
+				std::fprintf(stderr, "--rumble takes LEFT,RIGHT\n");
+				return false;
+			}
+		}
+		else if (argument == "--format") {
+			options.binary = std::strcmp(value, "binary") == 0;
+			if (!options.binary && std::strcmp(value, "csv") != 0) {
+				std::fprintf(stderr, "Unknown format %s\n", value);
+				return false;
+			}
+		}
+		else if (argument == "--output") {
+			options.outputPath = value;
+		}
+		else if (argument == "--listen") {
+			for (const char* port = value; *port != '\0';) {
+				char* end = nullptr;
+				long number = std::strtol(port, &end, 10);
+				if (end == port || number <= 0 || number > 65535 || options.listenPorts.size() == kMaxTelemetrySources) {
+					std::fprintf(stderr, "--listen takes up to %u ports, comma separated\n", static_cast<unsigned>(kMaxTelemetrySources));
+					return false;
+				}
+				options.listenPorts.push_back(static_cast<uint16_t>(number));
+				port = *end == ',' ? end + 1 : end;
+			}
+		}
+		else if (argument == "--send") {
+			options.sendTarget = value;
+		}
+		else if (argument == "--send-format") {
+			options.sendFormat = TelemetrySource_None;
+			for (uint32_t source = TelemetrySource_None + 1; source < TelemetrySource_Count; ++source) {
+				std::string name = kTelemetrySourceNames[source];
+				for (char& c : name) {
+					c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+				}
+				if (name == value) {
+					options.sendFormat = static_cast<TelemetrySource>(source);
+				}
+			}
+			if (options.sendFormat == TelemetrySource_None) {
+				std::fprintf(stderr, "Unknown send format %s\n", value);
+				return false;
+			}
+		}
+		else {
+			std::fprintf(stderr, "Unknown option %s\n", argument.c_str());
+			return false;
+		}
+
+		if (usesValue) {
+			++i;
+		}
+	}
+
+	int inputs = !options.capturePath.empty() + !options.profileName.empty() + !options.listenPorts.empty();
+	if (inputs != 1) {
+		std::fprintf(stderr, "Pass one of --capture, --profile or --listen\n");
+		return false;
+	}
+	if (!options.sendTarget.empty() && !options.listenPorts.empty()) {
+		std::fprintf(stderr, "--send needs --capture or --profile\n");
+		return false;
+	}
+	if (options.rate <= 0 || options.duration < 0) {
+		std::fprintf(stderr, "--rate must be positive and --duration not negative\n");
+		return false;
+	}
+	return true;
+}
+
+// --predict-error: every packet's extrapolation against the truth, the later packets interpolated at the time it
+// looked ahead to. Packets arrive in game time order, so the predictions waiting for their time form a queue.
+class PredictionErrorMeter {
+public:
+	explicit PredictionErrorMeter(double horizonMs) :
+		horizonMs(horizonMs), clockMs(0), previousMs(0), lastTimestampMs(0), previousGear(0), started(false), count(0), inGearCount(0) {
+		for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+			predictedError[i] = heldError[i] = Error();
+		}
+	}
+
+	// telemetry holds the TelemetryPredictor rates.
+	void add(const TelemetryData& telemetry) {
+		uint32_t stepMs = telemetry.TimestampMs - lastTimestampMs;
+		if (!started || stepMs > kPredictorMaxGapMs) {
+			pending.clear(); // Nothing to interpolate across a gap
+			clockMs = 0;
+		}
+		else {
+			clockMs += stepMs;
+		}
+
+		float values[PredictedChannel_Count];
+		for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+			values[i] = telemetry.*kPredictedValues[i];
+		}
+
+		while (!pending.empty() && pending.front().targetMs <= clockMs && clockMs > previousMs) {
+			const Prediction& prediction = pending.front();
+			float share = static_cast<float>((prediction.targetMs - previousMs) / (clockMs - previousMs));
+			for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+				float truth = previous[i] + (values[i] - previous[i]) * share;
+				predictedError[i].add(prediction.predicted[i] - truth);
+				heldError[i].add(prediction.held[i] - truth);
+			}
+			// A shift steps the RPM; no filter sees one coming, so the RPM is also measured without them.
+			if (prediction.gear == previousGear && prediction.gear == telemetry.Gear) {
+				float truth = previous[PredictedChannel_EngineRpm] + (values[PredictedChannel_EngineRpm] - previous[PredictedChannel_EngineRpm]) * share;
+				predictedInGearError.add(prediction.predicted[PredictedChannel_EngineRpm] - truth);
+				heldInGearError.add(prediction.held[PredictedChannel_EngineRpm] - truth);
+				++inGearCount;
+			}
+			++count;
+			pending.pop_front();
+		}
+
+		Prediction prediction;
+		prediction.targetMs = clockMs + horizonMs;
+		prediction.gear = telemetry.Gear;
+		TelemetryData predicted = telemetry;
+		PredictTelemetry(predicted, static_cast<float>(horizonMs * 1e-3));
+		for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+			prediction.predicted[i] = predicted.*kPredictedValues[i];
+			prediction.held[i] = values[i];
+			previous[i] = values[i];
+		}
+		pending.push_back(prediction);
+
+		previousMs = clockMs;
+		previousGear = telemetry.Gear;
+		lastTimestampMs = telemetry.TimestampMs;
+		started = true;
+	}
+
+	void report(FILE* file) const {
+		std::fprintf(file, "Prediction %.0f ms ahead, %llu packets: RMS and largest error, predicted (held)\n", horizonMs,
+			static_cast<unsigned long long>(count));
+		for (size_t i = 0; i < PredictedChannel_Count; ++i) {
+			std::fprintf(file, "  %-17s %10.3f %10.3f   (%10.3f %10.3f)\n", kPredictedChannelNames[i], predictedError[i].rms(count),
+				predictedError[i].largest, heldError[i].rms(count), heldError[i].largest);
+		}
+		std::fprintf(file, "  %-17s %10.3f %10.3f   (%10.3f %10.3f)  %llu packets without a shift\n", "  in gear",
+			predictedInGearError.rms(inGearCount), predictedInGearError.largest, heldInGearError.rms(inGearCount),
+			heldInGearError.largest, static_cast<unsigned long long>(inGearCount));
+	}
+
+private:
+	struct Prediction {
+		double targetMs;
+		float predicted[PredictedChannel_Count];
+		float held[PredictedChannel_Count];
+		uint8_t gear;
+	};
+
+	struct Error {
+		double squares = 0;
+		double largest = 0;
+
+		void add(double error) {
+			squares += error * error;
+			largest = std::max(largest, std::fabs(error));
+		}
+		double rms(uint64_t samples) const { return samples > 0 ? std::sqrt(squares / samples) : 0.0; }
+	};
+
+	double horizonMs;
+	double clockMs;      // Game time since the last gap
+	double previousMs;
+	uint32_t lastTimestampMs;
+	uint8_t previousGear;
+	bool started;
+	float previous[PredictedChannel_Count];
+	std::deque<Prediction> pending;
+
+	uint64_t count;
+	Error predictedError[PredictedChannel_Count];
+	Error heldError[PredictedChannel_Count];
+	uint64_t inGearCount;
+	Error predictedInGearError;  // CurrentEngineRpm
+	Error heldInGearError;
+};
+
+// --send: every packet goes out at its time, re-encoded unless it is sent as Forza. Nothing is simulated.
+template <typename NextPacket>
+static int SendPackets(const SimulatorOptions& options, NextPacket&& nextPacket) {
+	typedef std::chrono::steady_clock Clock;
+
+	UdpEndpoint target;
+	UdpSocket socket;
+	if (!ParseUdpEndpoint(options.sendTarget, target)) {
+		std::fprintf(stderr, "--send takes an IPv4 HOST:PORT, not %s\n", options.sendTarget.c_str());
+		return 2;
+	}
+	if (!socket.open()) {
+		std::fprintf(stderr, "Cannot create a UDP socket\n");
+		return 1;
+	}
+
+	Clock::time_point start = Clock::now();
+	uint64_t packets = 0;
+	uint64_t sent = 0;
+	uint64_t timeUs;
+	const char* data;
+	size_t length;
+	while (nextPacket(timeUs, data, length)) {
+		++packets;
+		char encoded[DatagramBatch::kDatagramSize];
+		if (options.sendFormat != TelemetrySource_Forza) {
+			SimulatorFrame frame;
+			frame.telemetry = TelemetryData();
+			frame.input = HapticsInput();
+			if (!DecodeFrame(data, length, frame)) {
+				continue;
+			}
+			length = options.sendFormat == TelemetrySource_Codemasters ? EncodeCodemasters(frame, encoded) : EncodeGeneric(frame, encoded);
+			data = encoded;
+		}
+
+		std::this_thread::sleep_until(start + std::chrono::microseconds(timeUs));
+		sent += socket.sendTo(target, data, length) ? 1 : 0;
+	}
+
+	if (!options.quiet) {
+		std::fprintf(stderr, "%llu packets, %llu sent to %s as %s\n", static_cast<unsigned long long>(packets),
+			static_cast<unsigned long long>(sent), options.sendTarget.c_str(), kTelemetrySourceNames[options.sendFormat]);
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	SimulatorOptions options;
+	if (!ParseArguments(argc, argv, options)) {
+		std::fputs(kUsage, stderr);
+		return 2;
+	}
+
+	IniFile ini;
+	if (!options.configPath.empty() && !ini.load(options.configPath)) {
+		std::fprintf(stderr, "Cannot read %s\n", options.configPath.c_str());
+		return 1;
+	}
+	X1nputConfig config = ParseConfig(ini);
+	if (!config.EffectsError.empty()) {
+		std::fprintf(stderr, "Ignoring effects, %s\n", config.EffectsError.c_str());
+	}
+
+	CaptureReader capture;
+	const DriveProfile* profile = nullptr;
+	if (!options.capturePath.empty()) {
+		if (!capture.open(options.capturePath)) {
+			std::fprintf(stderr, "Cannot open capture %s\n", options.capturePath.c_str());
+			return 1;
+		}
+	}
+	else if (!options.profileName.empty()) {
+		for (const DriveProfile& candidate : kDriveProfiles) {
+			if (options.profileName == candidate.name) {
+				profile = &candidate;
+			}
+		}
+		if (profile == nullptr) {
+			std::fprintf(stderr, "Unknown profile %s\n", options.profileName.c_str());
+			return 1;
+		}
+	}
+	SyntheticDrive drive(profile != nullptr ? *profile : kDriveProfiles[0], options.duration, options.rate, options.seed);
+
+	CaptureRecord record;
+	auto nextPacket = [&](uint64_t& timeUs, const char*& data, size_t& length) {
+		if (profile != nullptr) {
+			return drive.next(timeUs, data, length);
+		}
+		if (!capture.next(record)) {
+			return false;
+		}
+		timeUs = record.timestamp;
+		data = record.data;
+		length = record.length;
+		return true;
+	};
+
+	if (!options.sendTarget.empty()) {
+		return SendPackets(options, nextPacket);
+	}
+
+	FILE* file = stdout;
+	if (!options.outputPath.empty()) {
+		file = std::fopen(options.outputPath.c_str(), "wb");
+		if (file == nullptr) {
+			std::fprintf(stderr, "Cannot create %s\n", options.outputPath.c_str());
+			return 1;
+		}
+	}
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	CollisionDetector collisions(config.Telemetry.collision);
+	HapticsState state;
+	state.Engaged = true;
+	HapticsFilterState filter;
+	const bool smoothing = config.Smoothing.enabled();
+	uint64_t filteredUs = 0;
+	bool filterStarted = false;  // The first frame starts the filter from its target, like the DLL's first output
+	VibrationCoalescer coalescer; // Only counts; the frames keep the values before rounding
+	TelemetryPredictor predictor(config.Telemetry.prediction);
+	std::unique_ptr<PredictionErrorMeter> predictionError;
+	if (options.predictErrorMs > 0) {
+		predictionError.reset(new PredictionErrorMeter(options.predictErrorMs));
+	}
+
+	// Live readers run the collision detector and the predictor themselves, and their packets have an age.
+	auto applyEffects = [&](SimulatorFrame& frame, bool live) {
+		frame.input.LeftRumble = options.leftRumble;
+		frame.input.RightRumble = options.rightRumble;
+		if (!live) {
+			collisions.update(frame.telemetry);
+			predictor.update(frame.telemetry);
+		}
+		if (predictionError) {
+			predictionError->add(frame.telemetry);
+		}
+		TelemetryData predicted = frame.telemetry;
+		PredictTelemetry(predicted, PredictionHorizon(config.Telemetry.prediction, predicted, live ? LatencyStats::now() : 0));
+		frame.output = config.Haptics.compute(&predicted, frame.input, state);
+		if (smoothing) {
+			double step = filterStarted ? (frame.timeUs - filteredUs) * 1e-6 : 1e9;
+			FilterHaptics(ComputeFilterCoefficients(config.Smoothing, step), &filter, &frame.output, 1);
+			filteredUs = frame.timeUs;
+			filterStarted = true;
+		}
+		HapticsOutput played = frame.output;
+		coalescer.update(config.Coalescing, played, frame.timeUs * 1000);
+	};
+
+	FrameWriter writer(file, options.binary);
+	writer.begin();
+
+	std::vector<SimulatorFrame> frames(kBatchSize);
+	uint64_t packets = 0;
+	uint64_t malformed = 0;
+	uint64_t emitted = 0;
+	bool written = true;
+	bool more = true;
+
+	if (!options.listenPorts.empty()) {
+		// The readers' messages would end up in the frames on stdout.
+		std::cout.setstate(std::ios::failbit);
+
+		TelemetryReaderOptions readerOptions = config.Telemetry;
+		readerOptions.capturePath.clear();
+		readerOptions.replayPath.clear();
+		readerOptions.stats = nullptr;
+
+		TelemetryRouter router;
+		std::vector<TelemetryReader*> readers;
+		for (uint16_t port : options.listenPorts) {
+			readers.push_back(router.reader(port, readerOptions));
+		}
+
+		const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.rate));
+		const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+		uint64_t seen = 0;
+		for (Clock::time_point deadline = start + period; written && deadline <= end; deadline += period) {
+			std::this_thread::sleep_until(deadline);
+			uint64_t received = readers[0]->packetsReceived();
+			if (received == seen) {
+				continue;
+			}
+			seen = received;
+
+			SimulatorFrame& frame = frames[0];
+			frame.timeUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+			frame.telemetry = readers[0]->snapshot();
+			frame.input = HapticsInput();
+			applyEffects(frame, true);
+			writer.add(frame);
+			written = writer.flush();
+			++emitted;
+		}
+
+		packets = readers[0]->packetsReceived();
+		malformed = readers[0]->packetsMalformed();
+		for (size_t i = 0; i < readers.size() && !options.quiet; ++i) {
+			std::fprintf(stderr, "Port %u: %s, %llu received, %llu dropped, %llu malformed\n", options.listenPorts[i],
+				kTelemetrySourceNames[readers[i]->source()], static_cast<unsigned long long>(readers[i]->packetsReceived()),
+				static_cast<unsigned long long>(readers[i]->packetsDropped()), static_cast<unsigned long long>(readers[i]->packetsMalformed()));
+			const TelemetryRelay& relay = readers[i]->relay();
+			for (size_t target = 0; target < relay.targetCount(); ++target) {
+				std::fprintf(stderr, "  relayed to %s: %llu sent, %llu dropped\n", FormatUdpEndpoint(relay.target(target)).c_str(),
+					static_cast<unsigned long long>(relay.packetsSent(target)), static_cast<unsigned long long>(relay.packetsDropped(target)));
+			}
+		}
+		router.stop();
+		std::cout.clear();
+		more = false;
+	}
+
+	while (more && written) {
+		// Decode
+		size_t count = 0;
+		while (count < kBatchSize) {
+			uint64_t timeUs;
+			const char* data;
+			size_t length;
+			if (!(more = nextPacket(timeUs, data, length))) {
+				break;
+			}
+
+			++packets;
+			SimulatorFrame& frame = frames[count];
+			frame.timeUs = timeUs;
+			frame.telemetry = TelemetryData();
+			if (!DecodeFrame(data, length, frame)) {
+				++malformed;
+				continue;
+			}
+			++count;
+		}
+
+		// Effects, in packet order since collisions and the effects carry state from frame to frame.
+		for (size_t i = 0; i < count; ++i) {
+			applyEffects(frames[i], false);
+		}
+
+		// Output
+		for (size_t i = 0; i < count; ++i) {
+			writer.add(frames[i]);
+		}
+		written = writer.flush();
+		emitted += count;
+	}
+
+	if (file != stdout) {
+		written = std::fclose(file) == 0 && written;
+	}
+	else {
+		written = std::fflush(file) == 0 && written;
+	}
+	if (!written) {
+		std::fprintf(stderr, "Writing the frames failed\n");
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	if (!options.quiet) {
+		std::fprintf(stderr, "%llu packets, %llu malformed, %llu frames in %.3f s (%.0f frames/s)\n",
+			static_cast<unsigned long long>(packets), static_cast<unsigned long long>(malformed),
+			static_cast<unsigned long long>(emitted), seconds, seconds > 0 ? emitted / seconds : 0.0);
+		std::fprintf(stderr, "%llu driver updates, %llu suppressed by [Output]\n", static_cast<unsigned long long>(coalescer.sent()),
+			static_cast<unsigned long long>(coalescer.suppressed()));
+	}
+	if (predictionError) {
+		predictionError->report(stderr);
+	}
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include "CollisionDetector.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+
+/*
+	Traces shaped like x1nput-sim's drives, 60 packets per second: a wall hit is
+	one packet where most of the speed goes (Z) and the car is thrown sideways
+	(X, +-90 m/s^2, see DriveEvent_Wall), a kerb is +-6 m/s^2 of vertical
+	acceleration flipping 12 times a second (DriveEvent_Kerb), both with the
+	sim's +-0.3 m/s^2 of noise on Y.
+*/
+
+struct TraceSample {
+	float X, Y, Z;
+};
+
+class Trace {
+public:
+	explicit Trace(uint32_t seed) : noise(seed) {}
+
+	uint32_t timestampMs = 1000;
+
+	// Feeds one packet 1/60 s after the previous one.
+	CollisionImpulse feed(CollisionDetector& detector, float x, float y, float z) {
+		timestampMs += 16 + (++packets % 3 == 0 ? 1 : 0);
+		return detector.update(timestampMs, x, y + random() * 0.3f, z);
+	}
+
+private:
+	uint32_t noise;
+	uint32_t packets = 0;
+
+	// Uniform in [-1, 1).
+	float random() {
+		noise ^= noise << 13;
+		noise ^= noise >> 17;
+		noise ^= noise << 5;
+		return static_cast<float>(noise) / 2147483648.f - 1.f;
+	}
+};
+
+// Two seconds of cruising in a long corner, the wall, then braking away from it. Returns the envelope at the hit and
+// the strongest one in the second after it.
+static void WallHit(float side, CollisionImpulse& atHit, CollisionImpulse& strongestAfter, float& remaining) {
+	CollisionDetector detector;
+	Trace trace(7);
+	const float cornering = 12.f * side;
+
+	for (int i = 0; i < 120; ++i) {
+		CHECK(trace.feed(detector, cornering, 0, 0.4f).Strength == 0);
+	}
+
+	atHit = trace.feed(detector, cornering + 90.f * side, 0, -0.6f * 40.f * 60.f);
+
+	strongestAfter = CollisionImpulse();
+	for (int i = 0; i < 60; ++i) {
+		CollisionImpulse impulse = trace.feed(detector, 0, 0, -11.f);
+		if (impulse.Strength > strongestAfter.Strength) {
+			strongestAfter = impulse;
+		}
+	}
+	remaining = detector.current().Strength;
+}
+
+X1NPUT_TEST(WallHitOnTheLeft) {
+	CollisionImpulse atHit;
+	CollisionImpulse strongestAfter;
+	float remaining;
+	// Curving right into the wall: the car is pushed to the right (+X), so it was hit on its left.
+	WallHit(1.f, atHit, strongestAfter, remaining);
+
+	CHECK(atHit.Strength == 1);
+	CHECK(atHit.Left == 1);
+	// 90 m/s^2 sideways in one packet is past FullScaleJerk: the far motor gets 1 - SideBias even though most of the
+	// jerk is the car stopping.
+	CHECK_NEAR(atHit.Right, 1 - CollisionDetectorOptions().sideBias, 1e-6);
+	// The spike falling away again is not a second hit: the envelope only decays.
+	CHECK(strongestAfter.Strength <= atHit.Strength);
+	CHECK(remaining == 0);
+}
+
+X1NPUT_TEST(WallHitOnTheRight) {
+	CollisionImpulse atHit;
+	CollisionImpulse strongestAfter;
+	float remaining;
+	WallHit(-1.f, atHit, strongestAfter, remaining);
+
+	CHECK(atHit.Strength == 1);
+	CHECK(atHit.Right == 1);
+	CHECK_NEAR(atHit.Left, 1 - CollisionDetectorOptions().sideBias, 1e-6);
+	CHECK(remaining == 0);
+}
+
+X1NPUT_TEST(HeadOnHitDrivesBothMotors) {
+	CollisionDetector detector;
+	Trace trace(11);
+	for (int i = 0; i < 60; ++i) {
+		trace.feed(detector, 0, 0, 0.4f);
+	}
+	CollisionImpulse impulse = trace.feed(detector, 0, 0, -30.f);
+	CHECK_NEAR(impulse.Strength, 30.f / 0.05f / 1000.f, 0.05);
+	CHECK_NEAR(impulse.Left, impulse.Right, 0.02);
+
+	// The jump stays in the 50 ms jerk window for two more packets and holds the envelope at its peak; 150 ms after
+	// that about 1/e of it is left.
+	for (int i = 0; i < 2; ++i) {
+		impulse = trace.feed(detector, 0, 0, -30.f);
+	}
+	float strength = impulse.Strength;
+	for (int i = 0; i < 9; ++i) {
+		impulse = trace.feed(detector, 0, 0, -30.f);
+	}
+	CHECK_NEAR(impulse.Strength / strength, 0.37, 0.05);
+}
+
+X1NPUT_TEST(KerbsAreNotHits) {
+	CollisionDetector detector;
+	Trace trace(3);
+	float strongest = 0;
+	// Four seconds over a kerb in a left-hand corner, as in the sim's lap.
+	for (int i = 0; i < 240; ++i) {
+		const float vertical = (i / 5) % 2 ? 6.f : -6.f;
+		strongest = std::max(strongest, trace.feed(detector, -18.f, vertical, 0.6f).Strength);
+	}
+	CHECK(strongest == 0);
+}
+
+X1NPUT_TEST(HardBrakingIsNotAHit) {
+	CollisionDetector detector;
+	Trace trace(5);
+	float strongest = 0;
+	for (int i = 0; i < 60; ++i) {
+		strongest = std::max(strongest, trace.feed(detector, 0, 0, 2.f).Strength);
+	}
+	// Squeezing the brake over a fifth of a second, then holding it.
+	for (int i = 0; i < 180; ++i) {
+		const float braking = i < 12 ? 2.f - 13.f * (i + 1) / 12.f : -11.f;
+		strongest = std::max(strongest, trace.feed(detector, 0, 0, braking).Strength);
+	}
+	CHECK(strongest == 0);
+}
@@ -0,0 +1,176 @@
+#include "Config.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+X1NPUT_TEST(IniLookupsFollowGetPrivateProfileString) {
+	IniFile ini;
+	ini.parse(
+		"; comment\n"
+		"[Triggers]\r\n"
+		"  LeftStrength =  0.5  \r\n"
+		"leftstrength=0.9\n"
+		"Name=\"quoted value\"\n"
+		"[ Motors ]\n"
+		"SwapSides=TRUE\n");
+
+	CHECK(ini.getString("triggers", "LEFTSTRENGTH", "") == "0.5");
+	CHECK(ini.getString("Triggers", "Name", "") == "quoted value");
+	CHECK(ini.getString("Triggers", "Missing", "default") == "default");
+	CHECK(ini.getBool("Motors", "SwapSides", "False"));
+	CHECK(ini.getInt("Motors", "Missing", 7) == 7);
+}
+
+X1NPUT_TEST(EmptyFileGivesTheDefaults) {
+	IniFile ini;
+	X1nputConfig config = ParseConfig(ini);
+
+	CHECK(config.EffectsError.empty());
+	CHECK_NEAR(config.Haptics.getSettings().LTriggerStrength, 0.25, 0);
+	CHECK(config.OutputRate == 0);
+	CHECK(config.Telemetry.port == kDefaultTelemetryPort);
+	CHECK(config.Telemetry.formats == kAllTelemetryFormats);
+	CHECK(config.Telemetry.relay.empty());
+	CHECK(!config.Telemetry.prediction.enabled);
+	for (size_t i = 0; i < kMaxPads; ++i) {
+		CHECK(config.Routes[i].TelemetryPort == kDefaultTelemetryPort);
+	}
+}
+
+X1NPUT_TEST(ValuesAreClampedToTheirRanges) {
+	IniFile ini;
+	ini.parse(
+		"[Output]\nUpdateRate=5000\nMaxSendRate=-3\n"
+		"[Collision]\nSideBias=4\nDecayMs=0\n"
+		"[Prediction]\nAlpha=2\nBeta=-1\nRpmAlpha=-1\nRpmBeta=3\nMaxMs=-5\n");
+	X1nputConfig config = ParseConfig(ini);
+
+	CHECK(config.OutputRate == 1000);
+	CHECK(config.Coalescing.maxRate == 0);
+	CHECK_NEAR(config.Telemetry.collision.sideBias, 1, 0);
+	CHECK_NEAR(config.Telemetry.collision.decayMs, 1, 0);
+	CHECK_NEAR(config.Telemetry.prediction.alpha, 1, 0);
+	CHECK_NEAR(config.Telemetry.prediction.beta, 0, 0);
+	CHECK_NEAR(config.Telemetry.prediction.rpmAlpha, 0, 0);
+	CHECK_NEAR(config.Telemetry.prediction.rpmBeta, 1, 0);
+	CHECK_NEAR(config.Telemetry.prediction.maxMs, 0, 0);
+}
+
+X1NPUT_TEST(RoutingFormatsAndRelay) {
+	IniFile ini;
+	ini.parse(
+		"[Telemetry]\nPort=20777\nFormats=codemasters, GENERIC, nonsense\n"
+		"Relay=127.0.0.1:5300, 20777>10.0.0.2:5301, bad, 70000>1.2.3.4:1\n"
+		"[Routing]\nPad2=9999\nPad3=Off\n");
+	X1nputConfig config = ParseConfig(ini);
+
+	CHECK(config.Telemetry.formats == ((1u << TelemetrySource_Codemasters) | (1u << TelemetrySource_Generic)));
+	CHECK(config.Telemetry.relay.size() == 2);
+	if (config.Telemetry.relay.size() == 2) {
+		CHECK(config.Telemetry.relay[0].fromPort == 0);
+		CHECK(config.Telemetry.relay[0].endpoint.port == 5300);
+		CHECK(config.Telemetry.relay[1].fromPort == 20777);
+		CHECK(config.Telemetry.relay[1].endpoint.address == 0x0A000002);
+	}
+	CHECK(config.Routes[0].TelemetryPort == 20777);
+	CHECK(config.Routes[1].TelemetryPort == 9999);
+	CHECK(config.Routes[2].TelemetryPort == 0);
+}
+
+X1NPUT_TEST(InvalidEffectsFallBackToTheBuiltInOnes) {
+	IniFile ini;
+	ini.parse("[Effects]\nOrder=Broken\n[Effect.Broken]\nWhen=NoSuchSignal>1\n");
+	X1nputConfig config = ParseConfig(ini);
+
+	CHECK(config.EffectsError.find("NoSuchSignal") != std::string::npos);
+	CHECK(config.Haptics.getEffects().base().stages.size() == DefaultEffectProgram().stages.size());
+}
+
+X1NPUT_TEST(PublishSwapsTheCurrentVersion) {
+	ConfigStore store;
+	{
+		ConfigStore::Reader first(store);
+		CHECK(first.get() != nullptr);
+		CHECK(first->OutputRate == 0);
+	}
+
+	X1nputConfig config;
+	config.OutputRate = 500;
+	const X1nputConfig* published = store.publish(config);
+
+	ConfigStore::Reader reader(store);
+	CHECK(reader.get() == published);
+	CHECK(reader->OutputRate == 500);
+	CHECK(store.version() == 2);
+	CHECK(store.readerCount() == 1);
+}
+
+X1NPUT_TEST(PublishWaitsForTheReadersOfTheReplacedVersion) {
+	ConfigStore store;
+	X1nputConfig config;
+	config.OutputRate = 1;
+	store.publish(config);
+
+	std::unique_ptr<ConfigStore::Reader> held(new ConfigStore::Reader(store));
+	std::atomic<bool> published{ false };
+	config.OutputRate = 2;
+	std::thread publisher([&] {
+		store.publish(config);
+		published.store(true);
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(!published.load());
+	CHECK((*held)->OutputRate == 1);
+	{
+		// Readers that start now see the new version and do not hold the publish up.
+		ConfigStore::Reader late(store);
+		CHECK(late->OutputRate == 2);
+	}
+	CHECK(!published.load());
+
+	held.reset();
+	publisher.join();
+	CHECK(published.load());
+	CHECK(store.readerCount() == 0);
+}
+
+X1NPUT_TEST(ReadersNeverSeeAFreedVersion) {
+	ConfigStore store;
+	X1nputConfig config;
+	config.ReadingCacheUs = 0;
+	store.publish(config);
+
+	std::atomic<bool> done{ false };
+	std::atomic<int> badReads{ 0 };
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 3; ++i) {
+		readers.emplace_back([&] {
+			while (!done.load()) {
+				ConfigStore::Reader reader(store);
+				// Every published version has a rate in 0..200 and a matching cache window.
+				if (reader->OutputRate > 200 || reader->ReadingCacheUs != static_cast<int>(reader->OutputRate) * 10) {
+					badReads.fetch_add(1);
+				}
+			}
+		});
+	}
+
+	for (unsigned rate = 1; rate <= 200; ++rate) {
+		config.OutputRate = rate;
+		config.ReadingCacheUs = static_cast<int>(rate) * 10;
+		store.publish(config);
+	}
+	done.store(true);
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+
+	CHECK(badReads.load() == 0);
+	CHECK(store.version() == 202);
+	CHECK(store.readerCount() == 0);
+}
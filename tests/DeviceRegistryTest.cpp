@@ -0,0 +1,167 @@
+#include "DeviceRegistry.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Stands in for IGamepad. The registry never dereferences a device, the readers here do: a reader that got a pointer
+// to anything but a live FakeGamepad sees a wrong canary.
+struct FakeGamepad {
+	static const uint32_t kCanary = 0x58314750;
+
+	uint32_t canary = kCanary;
+	uint32_t id = 0;
+};
+
+static const size_t kSlots = 4;
+typedef DeviceRegistry<FakeGamepad, kSlots> FakeRegistry;
+
+X1NPUT_TEST(ReturningDevicesGetTheirSlotBack) {
+	FakeRegistry registry;
+	FakeGamepad pads[6];
+	bool added;
+
+	for (size_t i = 0; i < kSlots; ++i) {
+		CHECK(registry.add(&pads[i], added) == i);
+		CHECK(added);
+	}
+	CHECK(registry.add(&pads[4], added) == FakeRegistry::kNoSlot);
+	CHECK(!added);
+	CHECK(registry.add(&pads[1], added) == 1);
+	CHECK(!added);
+
+	// Player 2 drops out and comes back: same slot, and the slot's generation moved on twice.
+	const uint32_t generation = registry.generation(1);
+	CHECK(registry.remove(&pads[1]) == 1);
+	CHECK(registry.get(1) == nullptr);
+	CHECK(registry.add(&pads[1], added) == 1);
+	CHECK(added);
+	CHECK(registry.get(1) == &pads[1]);
+	CHECK(registry.generation(1) == generation + 2);
+
+	// A new device only takes a reserved slot when nothing else is free.
+	registry.remove(&pads[2]);
+	CHECK(registry.add(&pads[4], added) == 2);
+	CHECK(registry.remove(&pads[2]) == FakeRegistry::kNoSlot);
+	CHECK(registry.add(&pads[2], added) == FakeRegistry::kNoSlot);
+
+	CHECK(registry.get(kSlots) == nullptr);
+	CHECK(registry.remove(nullptr) == FakeRegistry::kNoSlot);
+	CHECK(registry.add(nullptr, added) == FakeRegistry::kNoSlot);
+}
+
+// One thread connecting and disconnecting devices as fast as it can while readers walk the slots the way the exports
+// do: every pointer they get must be a live device, and generations and the version never go back.
+X1NPUT_TEST(ConcurrentReadersDuringConnectChurn) {
+	typedef std::chrono::steady_clock Clock;
+	const size_t kReaders = 3;
+	const size_t kPads = 8;  // Twice the slots, so devices also fight over reserved slots
+	const auto kDuration = std::chrono::milliseconds(500);
+
+	FakeRegistry registry;
+	FakeGamepad pads[kPads];
+	for (uint32_t i = 0; i < kPads; ++i) {
+		pads[i].id = i;
+	}
+
+	std::atomic<bool> done(false);
+	std::atomic<uint64_t> badDevices(0);
+	std::atomic<uint64_t> backwards(0);
+	std::vector<uint64_t> loads(kReaders, 0);
+
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < kReaders; ++r) {
+		readers.emplace_back([&, r]() {
+			uint32_t lastGenerations[kSlots] = {};
+			uint64_t lastVersion = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				const uint64_t version = registry.version();
+				if (version < lastVersion) {
+					backwards.fetch_add(1, std::memory_order_relaxed);
+				}
+				lastVersion = version;
+
+				for (size_t slot = 0; slot < kSlots; ++slot) {
+					const uint32_t generation = registry.generation(slot);
+					if (generation < lastGenerations[slot]) {
+						backwards.fetch_add(1, std::memory_order_relaxed);
+					}
+					lastGenerations[slot] = generation;
+
+					const FakeGamepad* pad = registry.get(slot);
+					if (pad != nullptr && (pad->canary != FakeGamepad::kCanary || pad->id >= kPads || pad != &pads[pad->id])) {
+						badDevices.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+				++loads[r];
+			}
+		});
+	}
+
+	// The writer keeps its own model of where every device is and checks each answer against it.
+	size_t modelSlot[kPads];
+	for (size_t& slot : modelSlot) {
+		slot = FakeRegistry::kNoSlot;
+	}
+	uint64_t changes = 0;
+	uint64_t wrongSlots = 0;
+	uint32_t state = 1;
+
+	Clock::time_point start = Clock::now();
+	while (Clock::now() - start < kDuration) {
+		for (int i = 0; i < 64; ++i) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			const size_t pad = state % kPads;
+
+			if (modelSlot[pad] == FakeRegistry::kNoSlot) {
+				bool added;
+				const size_t slot = registry.add(&pads[pad], added);
+				if (slot != FakeRegistry::kNoSlot) {
+					wrongSlots += !added || registry.get(slot) != &pads[pad];
+					modelSlot[pad] = slot;
+					++changes;
+				}
+			} else {
+				wrongSlots += registry.remove(&pads[pad]) != modelSlot[pad];
+				modelSlot[pad] = FakeRegistry::kNoSlot;
+				++changes;
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	done = true;
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+
+	uint64_t totalLoads = 0;
+	for (uint64_t count : loads) {
+		totalLoads += count;
+	}
+	std::fprintf(stderr, "  %llu connects/disconnects (%.0f/s), %llu slot walks\n", static_cast<unsigned long long>(changes),
+		changes / seconds, static_cast<unsigned long long>(totalLoads));
+
+	CHECK(changes > 10000);
+	CHECK(totalLoads > 0);
+	CHECK(badDevices.load() == 0);
+	CHECK(backwards.load() == 0);
+	CHECK(wrongSlots == 0);
+	CHECK(registry.version() == changes);
+
+	size_t connected = 0;
+	for (size_t pad = 0; pad < kPads; ++pad) {
+		if (modelSlot[pad] != FakeRegistry::kNoSlot) {
+			CHECK(registry.get(modelSlot[pad]) == &pads[pad]);
+			++connected;
+		}
+	}
+	for (size_t slot = 0; slot < kSlots; ++slot) {
+		connected -= registry.get(slot) != nullptr;
+	}
+	CHECK(connected == 0);
+}
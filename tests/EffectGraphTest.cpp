@@ -0,0 +1,251 @@
+#include "EffectGraph.h"
+#include "EffectPresets.h"
+#include "TestHarness.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static EffectProgram Compile(const char* text, std::string& error) {
+	IniFile ini;
+	ini.parse(text);
+	EffectProgram program;
+	CompileEffectGraph(ini, program, error);
+	return program;
+}
+
+// The telemetry registers set in registers are passed through TelemetryData, the way HapticsEngine passes them.
+static double Run(const EffectProgram& program, double registers[kMaxEffectRegisters]) {
+	TelemetryData telemetry = {};
+	for (uint8_t signal = 0; signal < EffectSignal_LeftTrigger; ++signal) {
+		if (signal != EffectSignal_Gear) {
+			telemetry.*EffectSignalField(signal) = static_cast<float>(registers[signal]);
+		}
+	}
+	telemetry.Gear = static_cast<uint8_t>(registers[EffectSignal_Gear]);
+	program.run(registers, telemetry);
+	return registers[EffectSignal_LeftMotor];
+}
+
+X1NPUT_TEST(StepPointsTakeTheirEdgeAsWritten) {
+	std::string error;
+	EffectProgram program = Compile(
+		"[Effects]\n"
+		"Order=Bump\n"
+		"[Effect.Bump]\n"
+		"Source=Acceleration\n"
+		"Curve=Step\n"
+		"Points=10:0.3, 15:0.5, >=30:0.3, 30:0.7\n"
+		"LeftMotor=Bump\n", error);
+	CHECK(error.empty());
+
+	const double accelerations[] = { 0, 10, 10.5, 15, 29.9, 30, 30.1 };
+	const double bumps[] = { 0, 0, 0.3, 0.3, 0.5, 0.3, 0.7 };
+	for (size_t i = 0; i < sizeof(bumps) / sizeof(bumps[0]); ++i) {
+		double registers[kMaxEffectRegisters] = {};
+		registers[EffectSignal_Acceleration] = accelerations[i];
+		CHECK_NEAR(Run(program, registers), bumps[i], 1e-7);
+	}
+
+	Compile("[Effects]\nOrder=A\n[Effect.A]\nSource=Speed\nCurve=Linear\nPoints=>=0:0, 1:1\n", error);
+	CHECK(!error.empty());
+}
+
+X1NPUT_TEST(LinearCurveClampsAndInterpolates) {
+	std::string error;
+	EffectProgram program = Compile(
+		"[Effects]\n"
+		"Order=Ramp\n"
+		"[Effect.Ramp]\n"
+		"Source=Speed\n"
+		"Curve=Linear\n"
+		"Points=10:0.2, 20:0.6, 40:1\n"
+		"LeftMotor=Ramp\n", error);
+	CHECK(error.empty());
+
+	const double speeds[] = { 0, 10, 15, 20, 30, 40, 90 };
+	const double values[] = { 0.2, 0.2, 0.4, 0.6, 0.8, 1, 1 };
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+		double registers[kMaxEffectRegisters] = {};
+		registers[EffectSignal_Speed] = speeds[i];
+		CHECK_NEAR(Run(program, registers), values[i], 1e-7);
+	}
+}
+
+X1NPUT_TEST(LongConditionListsAndSumsAreSplit) {
+	std::string error;
+	EffectProgram program = Compile(
+		"[Effects]\n"
+		"Order=A\n"
+		"[Effect.A]\n"
+		"When=LeftTrigger>0.1, Slip>1, Gear<1, RightTrigger<0.5, Speed>=3\n"
+		"LeftMotor=Speed + 2*Slip + 0.5 + LeftTrigger + RightTrigger - Gear + 0.25*Acceleration\n", error);
+	CHECK(error.empty());
+
+	// Every combination of the five conditions: only all of them together open the gate.
+	for (unsigned mask = 0; mask < 32; ++mask) {
+		double registers[kMaxEffectRegisters] = {};
+		registers[EffectSignal_LeftTrigger] = mask & 1 ? 0.5 : 0;
+		registers[EffectSignal_Slip] = mask & 2 ? 2 : 0;
+		registers[EffectSignal_Gear] = mask & 4 ? 0 : 2;
+		registers[EffectSignal_RightTrigger] = mask & 8 ? 0.25 : 0.75;
+		registers[EffectSignal_Speed] = mask & 16 ? 3 : 2;
+		registers[EffectSignal_Acceleration] = 4;
+		registers[EffectSignal_LeftMotor] = -1;
+		const double expected = mask == 31 ? 3 + 4 + 0.5 + 0.5 + 0.25 - 0 + 1 : -1;
+		CHECK_NEAR(Run(program, registers), expected, 1e-12);
+	}
+
+	Compile("[Effects]\nOrder=A\n[Effect.A]\nLeftMotor=LeftMotor + Speed + Slip + Gear + Acceleration\n", error);
+	CHECK(!error.empty());
+}
+
+X1NPUT_TEST(OnlyTheTelemetryReadIsListed) {
+	const EffectProgram& program = ClassicEffectProgram();
+	bool reads[EffectSignal_LeftTrigger] = {};
+	for (uint8_t signal : program.telemetrySignals) {
+		reads[signal] = true;
+	}
+	CHECK(reads[EffectSignal_Acceleration]);
+	CHECK(reads[EffectSignal_Slip]);
+	CHECK(reads[EffectSignal_NRPM]);
+	CHECK(!reads[EffectSignal_Gear]);
+	CHECK(program.telemetrySignals.size() == 3);
+}
+
+// Motorsport and Horizon number their classes differently; a class name picks the same class in both.
+X1NPUT_TEST(PresetsFollowEachGamesClassNames) {
+	IniFile ini;
+	ini.parse(
+		"[Presets]\n"
+		"S=Race\n"
+		"S1=Race\n"
+		"X=Hypercar\n"
+		"D.RWD=Truck\n"
+		"Class8=Top\n"
+		"[Preset.Race]\nMotorLimit=0.5\n"
+		"[Preset.Hypercar]\nMotorLimit=0.7\n"
+		"[Preset.Truck]\nMotorLimit=0.9\n"
+		"[Preset.Top]\nMotorLimit=0.3\n");
+	EffectPresets presets;
+	std::string error;
+	CHECK(CompileEffectPresets(ini, DefaultEffectProgram(), presets, error));
+	CHECK(error.empty());
+
+	// The program a car runs, by the MotorLimit it was compiled with.
+	auto limit = [&](CarClassScale scale, int32_t carClass, int32_t drivetrain) {
+		return presets.forCar(CarPresetKey(scale, carClass, drivetrain)).MotorLimit;
+	};
+	const double base = presets.base().MotorLimit;
+
+	CHECK(limit(CarClassScale_Motorsport, 5, 1) == 0.5);    // S
+	CHECK(limit(CarClassScale_Horizon, 4, 1) == 0.5);       // S1
+	CHECK(limit(CarClassScale_Horizon, 5, 1) == base);      // S2
+	CHECK(limit(CarClassScale_Motorsport, 8, 2) == 0.7);    // X
+	CHECK(limit(CarClassScale_Horizon, 6, 2) == 0.7);       // X
+	CHECK(limit(CarClassScale_Motorsport, 1, 1) == 0.9);    // D.RWD
+	CHECK(limit(CarClassScale_Horizon, 0, 1) == 0.9);       // D.RWD
+	CHECK(limit(CarClassScale_Motorsport, 0, 1) == base);   // E
+	CHECK(limit(CarClassScale_Horizon, 8, 0) == 0.3);       // Class8, past Horizon's classes
+	CHECK(presets.forCar(kUnknownCarPreset).MotorLimit == base);
+}
+
+// Uniform in [lo, hi), the same sequence every run.
+static double Random(uint32_t& state, double lo, double hi) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return lo + (hi - lo) * (state / 4294967296.0);
+}
+
+// Mostly ordinary values, sometimes one a condition or curve treats specially.
+static double RandomSignal(uint32_t& state) {
+	const double special[] = { 0.0, -0.0, 0.1, 0.3, 0.5, 1.0, 10.0, 30.0, 200.0, -200.0,
+		std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+		std::numeric_limits<double>::quiet_NaN() };
+	const size_t count = sizeof(special) / sizeof(special[0]);
+	if (Random(state, 0, 1) < 0.2) {
+		return special[static_cast<size_t>(Random(state, 0, count))];
+	}
+	return Random(state, -2, 40);
+}
+
+static bool SameRegister(double a, double b) {
+	return std::memcmp(&a, &b, sizeof(a)) == 0 || (std::isnan(a) && std::isnan(b));
+}
+
+// The machine code against interpret() on the same registers and telemetry, every register the program keeps
+// compared bit for bit.
+static bool NativeMatchesInterpreter(const EffectProgram& program, uint32_t seed, int frames) {
+	EffectProgram interpreted = program;
+	interpreted.native = nullptr;
+	uint32_t state = seed;
+	for (int frame = 0; frame < frames; ++frame) {
+		TelemetryData telemetry = {};
+		for (uint8_t signal = 0; signal < EffectSignal_LeftTrigger; ++signal) {
+			if (signal != EffectSignal_Gear) {
+				telemetry.*EffectSignalField(signal) = static_cast<float>(RandomSignal(state));
+			}
+		}
+		telemetry.Gear = static_cast<uint8_t>(Random(state, 0, 8));
+		double native[kMaxEffectRegisters];
+		double expected[kMaxEffectRegisters];
+		for (unsigned index = 0; index < kMaxEffectRegisters; ++index) {
+			native[index] = expected[index] = RandomSignal(state);
+		}
+		expected[EffectSignal_One] = native[EffectSignal_One] = 1;
+		program.run(native, telemetry);
+		interpreted.run(expected, telemetry);
+		for (unsigned index = EffectSignal_LeftTrigger; index < program.registerCount; ++index) {
+			if (!SameRegister(native[index], expected[index])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+X1NPUT_TEST(NativeCodeMatchesTheInterpreter) {
+	CHECK(NativeMatchesInterpreter(DefaultEffectProgram(), 1, 100000));
+	CHECK(NativeMatchesInterpreter(ClassicEffectProgram(), 2, 100000));
+
+	// Every curve and condition form, five-point curves, arguments FastExp hands to std::exp, and more values than
+	// there are xmm registers.
+	std::string error;
+	EffectProgram program = Compile(
+		"[Effects]\n"
+		"Order=A, B, C, D, E, F, G\n"
+		"[Effect.A]\n"
+		"Source=Speed\nCurve=Step\nPoints=0:0.2, >=10:0.4, 20:0.6, 30:0.8, >=40:1\n"
+		"When=LeftTrigger>=0.1, Slip<1\n"
+		"LeftMotor+=A + 0.5*RightRumble\n"
+		"[Effect.B]\n"
+		"Source=Acceleration\nCurve=Linear\nPoints=0:0, 10:0.3, 15:0.5, 20:0.6, 30:1\n"
+		"Plus=A\n"
+		"When=RightTrigger<=0.5\n"
+		"RightMotor=B - LeftMotor\n"
+		"[Effect.C]\n"
+		"Source=AccelerationZ\nCurve=Exp\nScale=0.5\nRate=40\nOffset=-100\n"
+		"When=Gear<1, B<0.5\n"
+		"LeftImpulse=C + 0.25\n"
+		"[Effect.D]\n"
+		"Source=NRPM\nCurve=Linear\nPoints=0:1, 0.5:0.5\n"
+		"Plus=C\n"
+		"When=B>0.1, C<0.9\n"
+		"RightImpulse+=D\n"
+		"[Effect.E]\n"
+		"Source=B\nCurve=Step\nPoints=0.5:1\n"
+		"When=Speed>1\n"
+		"LeftMotor=E + A + B + C\n"
+		"RightMotor+=0.5\n"
+		"[Effect.F]\n"
+		"Source=E\n"
+		"When=Gear>=2, Gear<=4, E>0\n"
+		"LeftImpulse+=2*F - 0.5*A + D\n"
+		"[Effect.G]\n"
+		"Source=TireSlipRatioFL\nCurve=Exp\nRate=-20\n"
+		"Plus=F\n"
+		"RightImpulse=G + TireSlipRatioFR + TireSlipRatioRL + TireSlipRatioRR + LeftRumble\n", error);
+	CHECK(error.empty());
+	CHECK(NativeMatchesInterpreter(program, 3, 100000));
+}
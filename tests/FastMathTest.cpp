@@ -0,0 +1,81 @@
+#include "FastMath.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Uniform in [lo, hi), the same sequence every run.
+static double Random(uint32_t& state, double lo, double hi) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return lo + (hi - lo) * (state / 4294967296.0);
+}
+
+static double RelativeError(double actual, double expected) {
+	return expected == 0 ? std::fabs(actual) : std::fabs(actual - expected) / std::fabs(expected);
+}
+
+static double FastExpError(double lo, double hi, int samples) {
+	double worst = 0;
+	for (int i = 0; i <= samples; ++i) {
+		const double x = lo + (hi - lo) * i / samples;
+		worst = std::max(worst, RelativeError(FastExp(x), std::exp(x)));
+	}
+	return worst;
+}
+
+// The Exp curve of the built-in effects reads 4 * NRPM + 0.01 with NRPM in 0..1; presets can scale it further.
+X1NPUT_TEST(FastExpAccuracy) {
+	CHECK(FastExpError(0, 4.01, 1000000) <= 1.02e-7);
+	CHECK(FastExpError(-50, 50, 1000000) <= 1.02e-7);
+	CHECK(FastExpError(-700, 700, 1000000) <= 1.02e-7);
+}
+
+X1NPUT_TEST(FastExpPassesTheRestToStdExp) {
+	const double infinity = std::numeric_limits<double>::infinity();
+	CHECK(FastExp(800) == std::exp(800.0));
+	CHECK(FastExp(-800) == std::exp(-800.0));
+	CHECK(FastExp(infinity) == infinity);
+	CHECK(FastExp(-infinity) == 0);
+	CHECK(std::isnan(FastExp(std::numeric_limits<double>::quiet_NaN())));
+}
+
+// Against the exact norms in double: tire slip ratios reach a few units when a wheel spins or locks, collision
+// acceleration a few hundred m/s^2.
+X1NPUT_TEST(FastNormsAccuracy) {
+	uint32_t state = 1;
+	double worstSlip = 0;
+	double worstAcceleration = 0;
+	double worstAgainstReference = 0;
+	for (int i = 0; i < 1000000; ++i) {
+		const double range = i % 2 ? 2 : 20;
+		float tireSlip[4];
+		for (float& slip : tireSlip) {
+			slip = static_cast<float>(Random(state, -range, range));
+		}
+		const float y = static_cast<float>(Random(state, -30, 30));
+		const float z = static_cast<float>(Random(state, -300, 300));
+
+		const FastNormsResult fast = FastNorms(tireSlip, y, z);
+		const FastNormsResult reference = FastNormsReference(tireSlip, y, z);
+		double sum = 0;
+		for (float slip : tireSlip) {
+			sum += static_cast<double>(slip) * slip;
+		}
+		worstSlip = std::max(worstSlip, RelativeError(fast.Slip, std::sqrt(sum)));
+		worstAcceleration = std::max(worstAcceleration, RelativeError(fast.Acceleration, std::sqrt(static_cast<double>(y) * y + static_cast<double>(z) * z)));
+		worstAgainstReference = std::max(worstAgainstReference, RelativeError(fast.Slip, reference.Slip));
+		worstAgainstReference = std::max(worstAgainstReference, RelativeError(fast.Acceleration, reference.Acceleration));
+	}
+
+	// Float sums of squares and a float root stay within one float ulp (relative 1.2e-7), see FastMath.h.
+	CHECK(worstSlip <= 1.2e-7);
+	CHECK(worstAcceleration <= 1.2e-7);
+	CHECK(worstAgainstReference <= 1.2e-7);
+
+	const float still[4] = { 0, 0, 0, 0 };
+	CHECK(FastNorms(still, 0, 0).Slip == 0);
+	CHECK(FastNorms(still, 0, 0).Acceleration == 0);
+}
@@ -0,0 +1,96 @@
+#include "FileWatcher.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+// Well past FileWatcher's settle time, so a callback that is coming has come.
+static const auto kQuiet = std::chrono::milliseconds(500);
+
+static void WriteFile(const std::string& path, const char* text, std::ios::openmode mode = std::ios::trunc) {
+	std::ofstream file(path, std::ios::binary | std::ios::out | mode);
+	file << text;
+}
+
+// Waits up to two seconds for count to reach at least one.
+static void WaitForCallback(const std::atomic<int>& count) {
+	for (int i = 0; i < 200 && count.load() == 0; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+X1NPUT_TEST(OneSaveGivesOneCallback) {
+	TempDirectory directory;
+	const std::string path = directory.file("X1nput.ini");
+	const std::string temporary = directory.file("X1nput.ini.tmp");
+	WriteFile(path, "[Triggers]\n");
+
+	std::atomic<int> callbacks{ 0 };
+	FileWatcher watcher;
+	CHECK(watcher.start(path, [&callbacks] { callbacks.fetch_add(1); }));
+	CHECK(watcher.isRunning());
+
+	// What an editor does on one save: write the file, replace it through a rename, touch it again.
+	WriteFile(path, "[Triggers]\nLeftStrength=0.5\n");
+	WriteFile(temporary, "[Triggers]\nLeftStrength=0.6\n");
+	CHECK(std::rename(temporary.c_str(), path.c_str()) == 0);
+	WriteFile(path, "", std::ios::app);
+
+	WaitForCallback(callbacks);
+	std::this_thread::sleep_for(kQuiet);
+	CHECK(callbacks.load() == 1);
+
+	// A later save is a new callback; other files in the directory are not.
+	WriteFile(directory.file("Other.ini"), "x");
+	std::this_thread::sleep_for(kQuiet);
+	CHECK(callbacks.load() == 1);
+
+	WriteFile(path, "[Triggers]\nLeftStrength=0.7\n");
+	WaitForCallback(callbacks);
+	std::this_thread::sleep_for(kQuiet);
+	CHECK(callbacks.load() == 2);
+
+	watcher.stop();
+	CHECK(!watcher.isRunning());
+}
+
+X1NPUT_TEST(StopReturnsPromptly) {
+	TempDirectory directory;
+	const std::string path = directory.file("X1nput.ini");
+
+	std::atomic<int> callbacks{ 0 };
+	FileWatcher watcher;
+	CHECK(watcher.start(path, [&callbacks] { callbacks.fetch_add(1); }));
+
+	// Once idle, with the thread waiting for events, and once with a change still settling.
+	for (int settling = 0; settling < 2; ++settling) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if (settling) {
+			CHECK(watcher.start(path, [&callbacks] { callbacks.fetch_add(1); }));
+			WriteFile(path, "[Triggers]\n");
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		watcher.stop();
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		CHECK(elapsed < std::chrono::milliseconds(250));
+		CHECK(!watcher.isRunning());
+	}
+
+	// Stopping twice, or a watcher that never started, is harmless.
+	watcher.stop();
+	FileWatcher never;
+	never.stop();
+}
+
+X1NPUT_TEST(StartFailsWithoutADirectory) {
+	TempDirectory directory;
+	FileWatcher watcher;
+	CHECK(!watcher.start(directory.file("Missing") + "/X1nput.ini", [] {}));
+	CHECK(!watcher.isRunning());
+	CHECK(!watcher.start(directory.file("X1nput.ini"), FileWatcher::Callback()));
+}
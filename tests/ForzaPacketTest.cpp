@@ -0,0 +1,247 @@
+#include "ForzaPacket.h"
+#include "TelemetryDecoders.h"
+#include "TestHarness.h"
+
+#include <cmath>
+#include <cstring>
+
+/*
+	One packet of each Forza format, byte for byte, laid out field by field
+	from the Data Out documentation rather than from kForzaFields. Every field
+	holds a distinct value, the ones X1nput skips included, so a wrong offset or
+	block start reads a neighbour's value and fails. FM7 Sled (232 bytes), FM7
+	Car Dash (311), FM 2023 (331: the Dash packet plus five more floats) and
+	FH4/FH5 (324: the Sled block, 12 bytes numbered 1..12, the Dash block and a
+	pad byte).
+
+	Values in all of them: 8500/850/6312.5 RPM, acceleration (3.25, -0.5, 7.75),
+	velocity (1.5, 0.25, 42), slip ratios 0.125/-0.25/0.5/1.75, slip angles
+	0.05/0.06/-0.07/0.08, combined slip 0.3/0.35/0.9/1.2, car 2352 class 5 PI 812
+	RWD with 8 cylinders; Dash: speed 43.5 m/s, accel pedal 200, brake 35, gear 4.
+*/
+
+static const unsigned char kSledPacket[232] = {
+	0x01, 0x00, 0x00, 0x00, 0x40, 0xe2, 0x01, 0x00, 0x00, 0xd0, 0x04, 0x46, 0x00, 0x80, 0x54, 0x44,
+	0x00, 0x44, 0xc5, 0x45, 0x00, 0x00, 0x50, 0x40, 0x00, 0x00, 0x00, 0xbf, 0x00, 0x00, 0xf8, 0x40,
+	0x00, 0x00, 0xc0, 0x3f, 0x00, 0x00, 0x80, 0x3e, 0x00, 0x00, 0x28, 0x42, 0x0a, 0xd7, 0x23, 0x3c,
+	0x0a, 0xd7, 0xa3, 0x3c, 0x8f, 0xc2, 0xf5, 0x3c, 0xcd, 0xcc, 0x8c, 0x3f, 0xcd, 0xcc, 0x4c, 0x3d,
+	0x0a, 0xd7, 0xa3, 0xbc, 0xcd, 0xcc, 0xcc, 0x3e, 0x85, 0xeb, 0xd1, 0x3e, 0x3d, 0x0a, 0xd7, 0x3e,
+	0xf6, 0x28, 0xdc, 0x3e, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x80, 0xbe, 0x00, 0x00, 0x00, 0x3f,
+	0x00, 0x00, 0xe0, 0x3f, 0x00, 0x00, 0xf0, 0x42, 0x00, 0x00, 0xf2, 0x42, 0x00, 0x00, 0xf4, 0x42,
+	0x00, 0x00, 0xf6, 0x42, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3e, 0x9a, 0x99, 0x99, 0x3e, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3d, 0x8f, 0xc2, 0x75, 0x3d, 0x29, 0x5c, 0x8f, 0xbd,
+	0x0a, 0xd7, 0xa3, 0x3d, 0x9a, 0x99, 0x99, 0x3e, 0x33, 0x33, 0xb3, 0x3e, 0x66, 0x66, 0x66, 0x3f,
+	0x9a, 0x99, 0x99, 0x3f, 0xcd, 0xcc, 0xcc, 0x3d, 0xae, 0x47, 0xe1, 0x3d, 0x8f, 0xc2, 0xf5, 0x3d,
+	0xb8, 0x1e, 0x05, 0x3e, 0x30, 0x09, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x2c, 0x03, 0x00, 0x00,
+	0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+};
+
+static const unsigned char kDashPacket[311] = {
+	0x01, 0x00, 0x00, 0x00, 0x50, 0xe2, 0x01, 0x00, 0x00, 0xd0, 0x04, 0x46, 0x00, 0x80, 0x54, 0x44,
+	0x00, 0x44, 0xc5, 0x45, 0x00, 0x00, 0x50, 0x40, 0x00, 0x00, 0x00, 0xbf, 0x00, 0x00, 0xf8, 0x40,
+	0x00, 0x00, 0xc0, 0x3f, 0x00, 0x00, 0x80, 0x3e, 0x00, 0x00, 0x28, 0x42, 0x0a, 0xd7, 0x23, 0x3c,
+	0x0a, 0xd7, 0xa3, 0x3c, 0x8f, 0xc2, 0xf5, 0x3c, 0xcd, 0xcc, 0x8c, 0x3f, 0xcd, 0xcc, 0x4c, 0x3d,
+	0x0a, 0xd7, 0xa3, 0xbc, 0xcd, 0xcc, 0xcc, 0x3e, 0x85, 0xeb, 0xd1, 0x3e, 0x3d, 0x0a, 0xd7, 0x3e,
+	0xf6, 0x28, 0xdc, 0x3e, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x80, 0xbe, 0x00, 0x00, 0x00, 0x3f,
+	0x00, 0x00, 0xe0, 0x3f, 0x00, 0x00, 0xf0, 0x42, 0x00, 0x00, 0xf2, 0x42, 0x00, 0x00, 0xf4, 0x42,
+	0x00, 0x00, 0xf6, 0x42, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3e, 0x9a, 0x99, 0x99, 0x3e, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3d, 0x8f, 0xc2, 0x75, 0x3d, 0x29, 0x5c, 0x8f, 0xbd,
+	0x0a, 0xd7, 0xa3, 0x3d, 0x9a, 0x99, 0x99, 0x3e, 0x33, 0x33, 0xb3, 0x3e, 0x66, 0x66, 0x66, 0x3f,
+	0x9a, 0x99, 0x99, 0x3f, 0xcd, 0xcc, 0xcc, 0x3d, 0xae, 0x47, 0xe1, 0x3d, 0x8f, 0xc2, 0xf5, 0x3d,
+	0xb8, 0x1e, 0x05, 0x3e, 0x30, 0x09, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x2c, 0x03, 0x00, 0x00,
+	0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc8, 0x42, 0x00, 0x00, 0xa0, 0x40,
+	0x00, 0x00, 0x96, 0xc3, 0x00, 0x00, 0x2e, 0x42, 0x00, 0x24, 0x74, 0x48, 0x00, 0x00, 0xf0, 0x43,
+	0x00, 0x00, 0xa0, 0x42, 0x00, 0x00, 0xa2, 0x42, 0x00, 0x00, 0xa4, 0x42, 0x00, 0x00, 0xa6, 0x42,
+	0x9a, 0x99, 0x99, 0x3f, 0x00, 0x00, 0x40, 0x3f, 0x00, 0x50, 0x9a, 0x44, 0xcd, 0xcc, 0x74, 0x42,
+	0x33, 0x33, 0x79, 0x42, 0x00, 0x00, 0x40, 0x41, 0x00, 0x00, 0xbf, 0x42, 0x03, 0x00, 0x02, 0xc8,
+	0x23, 0x00, 0x00, 0x04, 0xf4, 0x40, 0x00,
+};
+
+static const unsigned char kMotorsport2023Packet[331] = {
+	0x01, 0x00, 0x00, 0x00, 0x50, 0xe2, 0x01, 0x00, 0x00, 0xd0, 0x04, 0x46, 0x00, 0x80, 0x54, 0x44,
+	0x00, 0x44, 0xc5, 0x45, 0x00, 0x00, 0x50, 0x40, 0x00, 0x00, 0x00, 0xbf, 0x00, 0x00, 0xf8, 0x40,
+	0x00, 0x00, 0xc0, 0x3f, 0x00, 0x00, 0x80, 0x3e, 0x00, 0x00, 0x28, 0x42, 0x0a, 0xd7, 0x23, 0x3c,
+	0x0a, 0xd7, 0xa3, 0x3c, 0x8f, 0xc2, 0xf5, 0x3c, 0xcd, 0xcc, 0x8c, 0x3f, 0xcd, 0xcc, 0x4c, 0x3d,
+	0x0a, 0xd7, 0xa3, 0xbc, 0xcd, 0xcc, 0xcc, 0x3e, 0x85, 0xeb, 0xd1, 0x3e, 0x3d, 0x0a, 0xd7, 0x3e,
+	0xf6, 0x28, 0xdc, 0x3e, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x80, 0xbe, 0x00, 0x00, 0x00, 0x3f,
+	0x00, 0x00, 0xe0, 0x3f, 0x00, 0x00, 0xf0, 0x42, 0x00, 0x00, 0xf2, 0x42, 0x00, 0x00, 0xf4, 0x42,
+	0x00, 0x00, 0xf6, 0x42, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3e, 0x9a, 0x99, 0x99, 0x3e, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3d, 0x8f, 0xc2, 0x75, 0x3d, 0x29, 0x5c, 0x8f, 0xbd,
+	0x0a, 0xd7, 0xa3, 0x3d, 0x9a, 0x99, 0x99, 0x3e, 0x33, 0x33, 0xb3, 0x3e, 0x66, 0x66, 0x66, 0x3f,
+	0x9a, 0x99, 0x99, 0x3f, 0xcd, 0xcc, 0xcc, 0x3d, 0xae, 0x47, 0xe1, 0x3d, 0x8f, 0xc2, 0xf5, 0x3d,
+	0xb8, 0x1e, 0x05, 0x3e, 0x30, 0x09, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x2c, 0x03, 0x00, 0x00,
+	0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc8, 0x42, 0x00, 0x00, 0xa0, 0x40,
+	0x00, 0x00, 0x96, 0xc3, 0x00, 0x00, 0x2e, 0x42, 0x00, 0x24, 0x74, 0x48, 0x00, 0x00, 0xf0, 0x43,
+	0x00, 0x00, 0xa0, 0x42, 0x00, 0x00, 0xa2, 0x42, 0x00, 0x00, 0xa4, 0x42, 0x00, 0x00, 0xa6, 0x42,
+	0x9a, 0x99, 0x99, 0x3f, 0x00, 0x00, 0x40, 0x3f, 0x00, 0x50, 0x9a, 0x44, 0xcd, 0xcc, 0x74, 0x42,
+	0x33, 0x33, 0x79, 0x42, 0x00, 0x00, 0x40, 0x41, 0x00, 0x00, 0xbf, 0x42, 0x03, 0x00, 0x02, 0xc8,
+	0x23, 0x00, 0x00, 0x04, 0xf4, 0x40, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x3f, 0x00,
+	0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0xe0, 0x40,
+};
+
+static const unsigned char kHorizonPacket[324] = {
+	0x01, 0x00, 0x00, 0x00, 0xcd, 0x81, 0x01, 0x00, 0x00, 0xd0, 0x04, 0x46, 0x00, 0x80, 0x54, 0x44,
+	0x00, 0x44, 0xc5, 0x45, 0x00, 0x00, 0x50, 0x40, 0x00, 0x00, 0x00, 0xbf, 0x00, 0x00, 0xf8, 0x40,
+	0x00, 0x00, 0xc0, 0x3f, 0x00, 0x00, 0x80, 0x3e, 0x00, 0x00, 0x28, 0x42, 0x0a, 0xd7, 0x23, 0x3c,
+	0x0a, 0xd7, 0xa3, 0x3c, 0x8f, 0xc2, 0xf5, 0x3c, 0xcd, 0xcc, 0x8c, 0x3f, 0xcd, 0xcc, 0x4c, 0x3d,
+	0x0a, 0xd7, 0xa3, 0xbc, 0xcd, 0xcc, 0xcc, 0x3e, 0x85, 0xeb, 0xd1, 0x3e, 0x3d, 0x0a, 0xd7, 0x3e,
+	0xf6, 0x28, 0xdc, 0x3e, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x80, 0xbe, 0x00, 0x00, 0x00, 0x3f,
+	0x00, 0x00, 0xe0, 0x3f, 0x00, 0x00, 0xf0, 0x42, 0x00, 0x00, 0xf2, 0x42, 0x00, 0x00, 0xf4, 0x42,
+	0x00, 0x00, 0xf6, 0x42, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3e, 0x9a, 0x99, 0x99, 0x3e, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xcd, 0xcc, 0x4c, 0x3d, 0x8f, 0xc2, 0x75, 0x3d, 0x29, 0x5c, 0x8f, 0xbd,
+	0x0a, 0xd7, 0xa3, 0x3d, 0x9a, 0x99, 0x99, 0x3e, 0x33, 0x33, 0xb3, 0x3e, 0x66, 0x66, 0x66, 0x3f,
+	0x9a, 0x99, 0x99, 0x3f, 0xcd, 0xcc, 0xcc, 0x3d, 0xae, 0x47, 0xe1, 0x3d, 0x8f, 0xc2, 0xf5, 0x3d,
+	0xb8, 0x1e, 0x05, 0x3e, 0x30, 0x09, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x2c, 0x03, 0x00, 0x00,
+	0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	0x09, 0x0a, 0x0b, 0x0c, 0x00, 0x00, 0xc8, 0x42, 0x00, 0x00, 0xa0, 0x40, 0x00, 0x00, 0x96, 0xc3,
+	0x00, 0x00, 0x2e, 0x42, 0x00, 0x24, 0x74, 0x48, 0x00, 0x00, 0xf0, 0x43, 0x00, 0x00, 0xa0, 0x42,
+	0x00, 0x00, 0xa2, 0x42, 0x00, 0x00, 0xa4, 0x42, 0x00, 0x00, 0xa6, 0x42, 0x9a, 0x99, 0x99, 0x3f,
+	0x00, 0x00, 0x40, 0x3f, 0x00, 0x50, 0x9a, 0x44, 0xcd, 0xcc, 0x74, 0x42, 0x33, 0x33, 0x79, 0x42,
+	0x00, 0x00, 0x40, 0x41, 0x00, 0x00, 0xbf, 0x42, 0x03, 0x00, 0x02, 0xc8, 0x23, 0x00, 0x00, 0x04,
+	0xf4, 0x40, 0x00, 0x00,
+};
+
+// The fields every format carries.
+static void CheckSledFields(const TelemetryData& telemetry) {
+	CHECK(telemetry.Source == TelemetrySource_Forza);
+	CHECK_NEAR(telemetry.EngineMaxRpm, 8500, 0);
+	CHECK_NEAR(telemetry.EngineIdleRpm, 850, 0);
+	CHECK_NEAR(telemetry.CurrentEngineRpm, 6312.5, 0);
+	CHECK_NEAR(telemetry.AccelerationX, 3.25, 0);
+	CHECK_NEAR(telemetry.AccelerationY, -0.5, 0);
+	CHECK_NEAR(telemetry.AccelerationZ, 7.75, 0);
+	CHECK_NEAR(telemetry.TireSlipRatioFrontLeft, 0.125, 0);
+	CHECK_NEAR(telemetry.TireSlipRatioFrontRight, -0.25, 0);
+	CHECK_NEAR(telemetry.TireSlipRatioRearLeft, 0.5, 0);
+	CHECK_NEAR(telemetry.TireSlipRatioRearRight, 1.75, 0);
+	CHECK_NEAR(telemetry.TireSlipAngleFrontLeft, 0.05f, 0);
+	CHECK_NEAR(telemetry.TireSlipAngleRearLeft, -0.07f, 0);
+	CHECK_NEAR(telemetry.TireCombinedSlipFrontRight, 0.35f, 0);
+	CHECK_NEAR(telemetry.TireCombinedSlipRearRight, 1.2f, 0);
+	CHECK(telemetry.CarOrdinal == 2352);
+	CHECK(telemetry.CarClass == 5);
+	CHECK(telemetry.CarPerformanceIndex == 812);
+	CHECK(telemetry.DrivetrainType == 1);
+	CHECK(telemetry.NumCylinders == 8);
+
+	// Derived values
+	CHECK_NEAR(telemetry.Slip, std::sqrt(0.125 * 0.125 + 0.25 * 0.25 + 0.5 * 0.5 + 1.75 * 1.75), 1e-5);
+	CHECK_NEAR(telemetry.Acceleration, std::sqrt(0.5 * 0.5 + 7.75 * 7.75), 1e-5);
+	CHECK_NEAR(telemetry.NRPM, (6312.5 - 850 + 0.001) / (8500 - 850), 1e-6);
+}
+
+static void CheckDashFields(const TelemetryData& telemetry) {
+	CHECK_NEAR(telemetry.Speed, 43.5, 0);
+	CHECK(telemetry.Gear == 4);
+}
+
+X1NPUT_TEST(DecodesSledPackets) {
+	TelemetryData telemetry = {};
+	CHECK(DecodeForzaPacket(reinterpret_cast<const char*>(kSledPacket), sizeof(kSledPacket), telemetry));
+	CheckSledFields(telemetry);
+	CHECK(telemetry.TimestampMs == 123456);
+	CHECK_NEAR(telemetry.Speed, std::sqrt(1.5 * 1.5 + 0.25 * 0.25 + 42.0 * 42.0), 1e-4);  // From the velocity
+	CHECK(telemetry.Gear == 1);
+	CHECK(telemetry.CarPreset == CarPresetKey(CarClassScale_Motorsport, 5, 1));
+}
+
+X1NPUT_TEST(DecodesDashPackets) {
+	TelemetryData telemetry = {};
+	CHECK(DecodeForzaPacket(reinterpret_cast<const char*>(kDashPacket), sizeof(kDashPacket), telemetry));
+	CheckSledFields(telemetry);
+	CheckDashFields(telemetry);
+	CHECK(telemetry.TimestampMs == 123472);
+	CHECK(telemetry.CarPreset == CarPresetKey(CarClassScale_Motorsport, 5, 1));
+}
+
+X1NPUT_TEST(DecodesMotorsport2023PacketsAsDash) {
+	TelemetryData telemetry = {};
+	CHECK(DecodeForzaPacket(reinterpret_cast<const char*>(kMotorsport2023Packet), sizeof(kMotorsport2023Packet), telemetry));
+	CheckSledFields(telemetry);
+	CheckDashFields(telemetry);
+	CHECK(telemetry.CarPreset == CarPresetKey(CarClassScale_Motorsport, 5, 1));
+}
+
+X1NPUT_TEST(DecodesHorizonPackets) {
+	TelemetryData telemetry = {};
+	CHECK(DecodeForzaPacket(reinterpret_cast<const char*>(kHorizonPacket), sizeof(kHorizonPacket), telemetry));
+	CheckSledFields(telemetry);
+	CheckDashFields(telemetry);
+	CHECK(telemetry.TimestampMs == 98765);
+	// The same class number is S2 in Horizon and S in Motorsport.
+	CHECK(telemetry.CarPreset == CarPresetKey(CarClassScale_Horizon, 5, 1));
+	CHECK(telemetry.CarPreset != CarPresetKey(CarClassScale_Motorsport, 5, 1));
+}
+
+X1NPUT_TEST(PedalsComeFromTheDashBlock) {
+	PacketView dash(reinterpret_cast<const char*>(kDashPacket), sizeof(kDashPacket));
+	PacketView horizon(reinterpret_cast<const char*>(kHorizonPacket), sizeof(kHorizonPacket));
+	CHECK(ForzaDecoder<ForzaFormat::Dash>::get<ForzaField_Accel>(dash) == 200);
+	CHECK(ForzaDecoder<ForzaFormat::Dash>::get<ForzaField_Brake>(dash) == 35);
+	CHECK(ForzaDecoder<ForzaFormat::Horizon>::get<ForzaField_Accel>(horizon) == 200);
+	CHECK(ForzaDecoder<ForzaFormat::Horizon>::get<ForzaField_Brake>(horizon) == 35);
+
+	TelemetryData telemetry = {};
+	DecodeForzaPacket(reinterpret_cast<const char*>(kHorizonPacket), sizeof(kHorizonPacket), telemetry);
+	CHECK_NEAR(telemetry.Throttle, 200 / 255.0, 1e-7);
+	CHECK_NEAR(telemetry.Brake, 35 / 255.0, 1e-7);
+	DecodeForzaPacket(reinterpret_cast<const char*>(kSledPacket), sizeof(kSledPacket), telemetry);
+	CHECK(telemetry.Throttle == 0);
+	CHECK(telemetry.Brake == 0);
+}
+
+X1NPUT_TEST(RejectsOtherLengths) {
+	static const size_t lengths[] = { 0, 1, 231, 233, 310, 312, 323, 325, 330, 332, 1500 };
+	char packet[1500] = {};
+	std::memcpy(packet, kHorizonPacket, sizeof(kHorizonPacket));
+
+	for (size_t length : lengths) {
+		TelemetryData telemetry = {};
+		CHECK(!IsForzaPacket(length));
+		CHECK(!DecodeForzaPacket(packet, length, telemetry));
+		CHECK(telemetry.CurrentEngineRpm == 0);  // Nothing read
+	}
+}
+
+X1NPUT_TEST(DetectedByLength) {
+	CHECK(DetectTelemetrySource(reinterpret_cast<const char*>(kSledPacket), sizeof(kSledPacket)) == TelemetrySource_Forza);
+	CHECK(DetectTelemetrySource(reinterpret_cast<const char*>(kDashPacket), sizeof(kDashPacket)) == TelemetrySource_Forza);
+	CHECK(DetectTelemetrySource(reinterpret_cast<const char*>(kMotorsport2023Packet), sizeof(kMotorsport2023Packet)) == TelemetrySource_Forza);
+	CHECK(DetectTelemetrySource(reinterpret_cast<const char*>(kHorizonPacket), sizeof(kHorizonPacket)) == TelemetrySource_Forza);
+	CHECK(DetectTelemetrySource(reinterpret_cast<const char*>(kHorizonPacket), sizeof(kHorizonPacket), 1u << TelemetrySource_Generic) ==
+		TelemetrySource_None);
+}
+
+// The pedals are the last fields of X1nput's own packet; a sender that stops before them leaves them at 0.
+X1NPUT_TEST(GenericPacketsCarryThePedals) {
+	char packet[kGenericHeaderSize + GenericField_Count * sizeof(float)] = {};
+	std::memcpy(packet, kGenericPacketMagic, sizeof(kGenericPacketMagic));
+	const uint16_t version = kGenericPacketVersion;
+	const uint16_t count = GenericField_Count;
+	const float throttle = 0.75f;
+	const float brake = 0.25f;
+	std::memcpy(packet + 4, &version, sizeof(version));
+	std::memcpy(packet + 6, &count, sizeof(count));
+	std::memcpy(packet + kGenericHeaderSize + GenericField_Throttle * sizeof(float), &throttle, sizeof(throttle));
+	std::memcpy(packet + kGenericHeaderSize + GenericField_Brake * sizeof(float), &brake, sizeof(brake));
+
+	TelemetryData telemetry = {};
+	CHECK(DecodeTelemetryPacket(packet, sizeof(packet), telemetry));
+	CHECK(telemetry.Source == TelemetrySource_Generic);
+	CHECK(telemetry.Throttle == 0.75f);
+	CHECK(telemetry.Brake == 0.25f);
+
+	const uint16_t shorter = GenericField_Throttle;
+	std::memcpy(packet + 6, &shorter, sizeof(shorter));
+	CHECK(DecodeTelemetryPacket(packet, sizeof(packet), telemetry));
+	CHECK(telemetry.Throttle == 0);
+	CHECK(telemetry.Brake == 0);
+}
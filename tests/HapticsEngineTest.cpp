@@ -0,0 +1,115 @@
+#include "HapticsEngine.h"
+#include "TestHarness.h"
+
+// ComputeHapticsReference() is the old XInputSetState math; HapticsEngine runs the same rules as ClassicEffectProgram().
+// The only difference allowed is FastExp's rounding in the RPM curve.
+static const double kTolerance = 1e-7;
+
+static HapticsSettings TestSettings() {
+	HapticsSettings settings;
+	settings.LTriggerStrength = 0.25f;
+	settings.RTriggerStrength = 0.5f;
+	settings.LMotorStrength = 0.8f;
+	settings.RMotorStrength = 1.0f;
+	return settings;
+}
+
+static TelemetryData Drive(float acceleration, float nrpm, float slip, uint8_t gear) {
+	TelemetryData telemetry = TelemetryData();
+	telemetry.CurrentEngineRpm = 5000;
+	telemetry.Acceleration = acceleration;
+	telemetry.NRPM = nrpm;
+	telemetry.Slip = slip;
+	telemetry.Gear = gear;
+	return telemetry;
+}
+
+static void CheckOutput(const HapticsOutput& actual, double leftMotor, double rightMotor, double leftTrigger, double rightTrigger) {
+	CHECK_NEAR(actual.LeftMotor, leftMotor, kTolerance);
+	CHECK_NEAR(actual.RightMotor, rightMotor, kTolerance);
+	CHECK_NEAR(actual.LeftTrigger, leftTrigger, kTolerance);
+	CHECK_NEAR(actual.RightTrigger, rightTrigger, kTolerance);
+}
+
+// Outputs worked out by hand from the old code, one per rule.
+X1NPUT_TEST(GoldenOutputs) {
+	const HapticsEngine engine(TestSettings(), EffectPresets(ClassicEffectProgram()));
+	const HapticsInput released = { 0.f, 0.2f, 0.5f, 0.4f };
+	const HapticsInput braking = { 0.6f, 0.2f, 0.5f, 0.4f };
+	const HapticsInput reversing = { 0.f, 0.6f, 0.5f, 0.4f };
+
+	HapticsState state;
+	CheckOutput(engine.compute(nullptr, released, state), 0.4, 0.4, 0, 0);
+	CHECK(!state.Engaged);
+
+	// Paused (RPM 0): the game's rumble only, and the effects stay off.
+	TelemetryData paused = Drive(12, 0.2f, 0, 3);
+	paused.CurrentEngineRpm = 0;
+	CheckOutput(engine.compute(&paused, released, state), 0.4, 0.4, 0, 0);
+	CHECK(!state.Engaged);
+
+	// Bump 0.3 on both motors; RPM level 0.5 * e^0.81 / 60 + 0.3 on the right trigger, plus a tenth of the rumble.
+	TelemetryData bump = Drive(12, 0.2f, 0, 3);
+	CheckOutput(engine.compute(&bump, released, state), 0.7000000179, 0.7000000179, 0, 0.1793662950);
+	CHECK(state.Engaged);
+
+	// ABS: slip above 1 with the brake pressed; no bump while braking.
+	TelemetryData abs = Drive(20, 0.9f, 1.5f, 3);
+	CheckOutput(engine.compute(&abs, braking, state), 0.7000000060, 0.7000000060, 0.0875, 0.1740252122);
+
+	// Hard bump: 0.7, the motors hit MotorLimit and the right trigger takes the 0.7 step.
+	TelemetryData crash = Drive(31, 0.5f, 0, 3);
+	CheckOutput(engine.compute(&crash, released, state), 0.85, 0.85, 0, 0.35);
+
+	// Acceleration exactly 30 was 0.3 in the old code, not 0.5 or 0.7.
+	TelemetryData edge = Drive(30, 0.2f, 0, 3);
+	CheckOutput(engine.compute(&edge, released, state), 0.7000000179, 0.7000000179, 0, 0.1793662950);
+
+	// Reverse gear with the throttle pressed overrides the rest.
+	TelemetryData reverse = Drive(12, 0.2f, 0, 0);
+	CheckOutput(engine.compute(&reverse, reversing, state), 0.85, 0.85, 0.1, 0.2);
+}
+
+// Every combination of values around each threshold of the old code.
+X1NPUT_TEST(MatchesTheReferenceOnAGrid) {
+	const HapticsSettings settings = TestSettings();
+	const HapticsEngine engine(settings, EffectPresets(ClassicEffectProgram()));
+
+	const float accelerations[] = { 0, 5, 10, 10.5f, 15, 20, 29.99f, 30, 30.01f, 45 };
+	const float nrpms[] = { 0, 0.2f, 0.5f, 0.8f, 1 };
+	const float slips[] = { 0, 1, 1.5f };
+	const uint8_t gears[] = { 0, 3 };
+	const float leftTriggers[] = { 0, 0.05f, 0.1f, 0.5f };
+	const float rightTriggers[] = { 0, 0.3f, 0.6f };
+	const float leftRumbles[] = { 0, 0.05f, 0.5f, 1 };
+	const float rightRumbles[] = { 0, 0.7f };
+	const float rpms[] = { 0, 5000 };
+
+	size_t compared = 0;
+	for (float acceleration : accelerations)
+	for (float nrpm : nrpms)
+	for (float slip : slips)
+	for (uint8_t gear : gears)
+	for (float rpm : rpms) {
+		TelemetryData telemetry = Drive(acceleration, nrpm, slip, gear);
+		telemetry.CurrentEngineRpm = rpm;
+
+		for (float leftTrigger : leftTriggers)
+		for (float rightTrigger : rightTriggers)
+		for (float leftRumble : leftRumbles)
+		for (float rightRumble : rightRumbles)
+		for (int engaged = 0; engaged < 2; ++engaged) {
+			const HapticsInput input = { leftTrigger, rightTrigger, leftRumble, rightRumble };
+			HapticsState engineState;
+			HapticsState referenceState;
+			engineState.Engaged = referenceState.Engaged = engaged != 0;
+
+			HapticsOutput actual = engine.compute(&telemetry, input, engineState);
+			HapticsOutput expected = ComputeHapticsReference(&telemetry, input, settings, referenceState);
+			CheckOutput(actual, expected.LeftMotor, expected.RightMotor, expected.LeftTrigger, expected.RightTrigger);
+			CHECK(engineState.Engaged == referenceState.Engaged);
+			++compared;
+		}
+	}
+	CHECK(compared == 115200);
+}
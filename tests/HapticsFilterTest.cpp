@@ -0,0 +1,115 @@
+#include "HapticsFilter.h"
+#include "TestHarness.h"
+
+#include <cstring>
+#include <limits>
+
+typedef void (*FilterFunction)(const HapticsFilterCoefficients&, HapticsFilterState*, HapticsOutput*, size_t);
+
+// Passes of 4 ms from full scale to silence; returns how many it took to reach exactly 0 on every channel, or 0 if
+// it never did.
+static int PassesToSilence(FilterFunction filter, const HapticsFilterOptions& options) {
+	const HapticsFilterCoefficients coefficients = ComputeFilterCoefficients(options, 0.004);
+	HapticsFilterState state;
+	HapticsOutput full = { 1.0, 1.0, 1.0, 1.0 };
+	filter(ComputeFilterCoefficients(options, 60.0), &state, &full, 1);  // A long first pass catches up at once
+
+	for (int pass = 1; pass <= 100000; ++pass) {
+		HapticsOutput output = { 0.0, 0.0, 0.0, 0.0 };
+		filter(coefficients, &state, &output, 1);
+		if (output.LeftMotor == 0 && output.RightMotor == 0 && output.LeftTrigger == 0 && output.RightTrigger == 0) {
+			return pass;
+		}
+	}
+	return 0;
+}
+
+// The last steps of a slow stage round to 0; they must still move, or the envelope stops short of silence.
+X1NPUT_TEST(SlowStagesDecayToExactlyZero) {
+	const float timeConstants[] = { 100.f, 1000.f, 5000.f, 20000.f };
+	for (float timeConstant : timeConstants) {
+		HapticsFilterOptions release;
+		release.motors.releaseMs = timeConstant;
+		release.triggers.releaseMs = timeConstant;
+		CHECK(PassesToSilence(FilterHapticsScalar, release) > 0);
+		CHECK(PassesToSilence(FilterHaptics, release) == PassesToSilence(FilterHapticsScalar, release));
+
+		HapticsFilterOptions smoothing;
+		smoothing.motors.smoothingMs = timeConstant;
+		smoothing.triggers.smoothingMs = timeConstant;
+		CHECK(PassesToSilence(FilterHapticsScalar, smoothing) > 0);
+		CHECK(PassesToSilence(FilterHaptics, smoothing) == PassesToSilence(FilterHapticsScalar, smoothing));
+	}
+}
+
+// Uniform in [lo, hi), the same sequence every run.
+static double Random(uint32_t& state, double lo, double hi) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return lo + (hi - lo) * (state / 4294967296.0);
+}
+
+// A stage off a quarter of the time, otherwise anything from one pass to a few seconds.
+static float RandomTimeConstant(uint32_t& state) {
+	return Random(state, 0, 1) < 0.25 ? 0.f : static_cast<float>(Random(state, 0.5, 3000));
+}
+
+static HapticsFilterSettings RandomSettings(uint32_t& state) {
+	HapticsFilterSettings settings;
+	settings.attackMs = RandomTimeConstant(state);
+	settings.releaseMs = RandomTimeConstant(state);
+	settings.smoothingMs = RandomTimeConstant(state);
+	settings.slewRate = Random(state, 0, 1) < 0.25 ? 0.f : static_cast<float>(Random(state, 0.1, 50));
+	return settings;
+}
+
+// Mostly in range, some past either end, and NaN and the infinities now and then.
+static double RandomInput(uint32_t& state) {
+	double kind = Random(state, 0, 1);
+	if (kind < 0.02) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	if (kind < 0.03) {
+		return kind < 0.025 ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+	}
+	if (kind < 0.1) {
+		return kind < 0.05 ? 0.0 : 1.0;
+	}
+	return Random(state, -0.2, 1.2);
+}
+
+// Sequences of passes over seven pads (one SIMD register each, so no pad is special) with new settings and time steps
+// every sequence: the SIMD filter must leave the same outputs and the same state as the scalar one, bit for bit.
+X1NPUT_TEST(SimdMatchesScalarOnRandomInputs) {
+	const size_t kPads = 7;
+	uint32_t state = 1;
+	size_t mismatches = 0;
+
+	for (int sequence = 0; sequence < 2000; ++sequence) {
+		HapticsFilterOptions options;
+		options.motors = RandomSettings(state);
+		options.triggers = RandomSettings(state);
+		HapticsFilterState simdStates[kPads];
+		HapticsFilterState scalarStates[kPads];
+
+		for (int pass = 0; pass < 50; ++pass) {
+			// Output thread ticks, a game's frames, and now and then a long pause.
+			double step = pass == 0 || Random(state, 0, 1) < 0.02 ? Random(state, 0.5, 60) : Random(state, 0.0005, 0.05);
+			const HapticsFilterCoefficients coefficients = ComputeFilterCoefficients(options, step);
+
+			HapticsOutput simdOutputs[kPads];
+			for (HapticsOutput& output : simdOutputs) {
+				output = { RandomInput(state), RandomInput(state), RandomInput(state), RandomInput(state) };
+			}
+			HapticsOutput scalarOutputs[kPads];
+			std::memcpy(scalarOutputs, simdOutputs, sizeof(simdOutputs));
+
+			FilterHaptics(coefficients, simdStates, simdOutputs, kPads);
+			FilterHapticsScalar(coefficients, scalarStates, scalarOutputs, kPads);
+			mismatches += std::memcmp(simdOutputs, scalarOutputs, sizeof(simdOutputs)) != 0 ||
+				std::memcmp(simdStates, scalarStates, sizeof(simdStates)) != 0;
+		}
+	}
+	CHECK(mismatches == 0);
+}
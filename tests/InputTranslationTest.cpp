@@ -0,0 +1,83 @@
+#include "InputTranslation.h"
+#include "TestHarness.h"
+
+#include <cmath>
+#include <cstring>
+
+static bool SameGamepad(const TranslatedGamepad& a, const TranslatedGamepad& b) {
+	return a.wButtons == b.wButtons && a.bLeftTrigger == b.bLeftTrigger && a.bRightTrigger == b.bRightTrigger &&
+		a.sThumbLX == b.sThumbLX && a.sThumbLY == b.sThumbLY && a.sThumbRX == b.sThumbRX && a.sThumbRY == b.sThumbRY;
+}
+
+static bool TranslationsAgree(const RawGamepadReading& reading, float deadZoneSize) {
+	TranslatedGamepad fast;
+	TranslatedGamepad scalar;
+	std::memset(&fast, 0xCD, sizeof(fast));
+	std::memset(&scalar, 0xCD, sizeof(scalar));
+	TranslateReading(reading, deadZoneSize, fast);
+	TranslateReadingScalar(reading, deadZoneSize, scalar);
+	return SameGamepad(fast, scalar);
+}
+
+// Uniform in [lo, hi), the same sequence every run.
+static double Random(uint32_t& state, double lo, double hi) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return lo + (hi - lo) * (state / 4294967296.0);
+}
+
+static const float kDeadZones[] = { 0.f, 0.1f, 0.24f, 0.5f, 0.99f };
+
+X1NPUT_TEST(EveryButtonMask) {
+	RawGamepadReading reading = {};
+	for (uint32_t buttons = 0; buttons < 0x10000; ++buttons) {
+		reading.Buttons = buttons;
+		TranslatedGamepad scalar;
+		TranslateReadingScalar(reading, 0.24f, scalar);
+		CHECK(TranslateButtons(buttons) == scalar.wButtons);
+		CHECK(TranslationsAgree(reading, 0.24f));
+	}
+}
+
+// Every axis at the values where the scalar code changes branch: the dead zone edges and the ends, and the floats
+// around them.
+X1NPUT_TEST(AxesAtTheEdges) {
+	for (float deadZone : kDeadZones) {
+		const float edges[] = { 0.f, -0.f, deadZone, -deadZone, 1.f, -1.f, 1.f - deadZone, deadZone - 1.f };
+		for (float edge : edges) {
+			float value = edge;
+			for (int step = 0; step < 4; ++step) {
+				value = std::nextafter(value, -2.f);
+			}
+			for (int step = 0; step < 9; ++step, value = std::nextafter(value, 2.f)) {
+				RawGamepadReading reading = {};
+				reading.LeftThumbstickX = value;
+				reading.LeftThumbstickY = -value;
+				reading.RightThumbstickX = value;
+				reading.RightThumbstickY = value * 0.5f;
+				reading.LeftTrigger = std::fabs(value) <= 1 ? std::fabs(value) : 1;
+				reading.RightTrigger = 1 - reading.LeftTrigger;
+				CHECK(TranslationsAgree(reading, deadZone));
+			}
+		}
+	}
+}
+
+// Doubles are narrowed to float first, so values between two floats must round the same way in both.
+X1NPUT_TEST(RandomReadings) {
+	uint32_t state = 1;
+	size_t mismatches = 0;
+	for (int i = 0; i < 2000000; ++i) {
+		RawGamepadReading reading;
+		reading.Buttons = static_cast<uint32_t>(Random(state, 0, 65536));
+		reading.LeftTrigger = Random(state, 0, 1);
+		reading.RightTrigger = Random(state, 0, 1);
+		reading.LeftThumbstickX = Random(state, -1, 1);
+		reading.LeftThumbstickY = Random(state, -1, 1);
+		reading.RightThumbstickX = Random(state, -1, 1);
+		reading.RightThumbstickY = Random(state, -1, 1);
+		mismatches += !TranslationsAgree(reading, kDeadZones[i % 5]);
+	}
+	CHECK(mismatches == 0);
+}
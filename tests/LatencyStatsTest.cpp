@@ -0,0 +1,191 @@
+#include "LatencyStats.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const uint64_t kSecondNs = 1000000000;
+
+// A block name no other run uses at the same time.
+static std::string BlockName() {
+	std::random_device random;
+	return "X1nputLatencyTest" + std::to_string(random());
+}
+
+X1NPUT_TEST(BucketsHoldTheirValues) {
+	uint64_t previousBucket = 0;
+	for (uint64_t value = 0; value < (uint64_t(1) << 41); value = value < 64 ? value + 1 : value + value / 7) {
+		uint32_t bucket = LatencyBucket(value);
+		CHECK(bucket < kLatencyBucketCount);
+		CHECK(bucket >= previousBucket);
+		previousBucket = bucket;
+		if (value < (uint64_t(1) << (kLatencyMaxExponent + 1))) {
+			uint64_t upper = LatencyBucketUpperBound(bucket);
+			CHECK(value <= upper);
+			CHECK(bucket == 0 || value > LatencyBucketUpperBound(bucket - 1));
+			CHECK(upper - value <= value / 16);  // 6.25%
+		}
+	}
+	CHECK(LatencyBucket(~uint64_t(0)) == kLatencyBucketCount - 1);
+}
+
+// 100 values 1..100 us: the percentiles are the buckets of the 50th, 90th and 99th value, each counted once.
+X1NPUT_TEST(SummaryPercentilesAreNearestRank) {
+	LatencyStats stats;
+	CHECK(stats.open(BlockName().c_str()));
+	if (!stats.isOpen()) {
+		return;
+	}
+
+	const uint64_t startNs = 1000 * kSecondNs;
+	for (uint64_t us = 100; us >= 1; --us) {
+		stats.record(LatencyStage_Total, startNs, startNs + us * 1000);
+	}
+	stats.record(LatencyStage_Decode, startNs, startNs + 5000);
+	stats.record(LatencyStage_Wait, startNs + 10, startNs);  // Clock went backwards: 0
+	stats.refreshSummary(startNs);
+
+	const LatencyStatsBlock* block = stats.data();
+	const LatencySummary& total = block->summary[LatencyStage_Total];
+	CHECK(total.count == 100);
+	CHECK(total.p50Ns == LatencyBucketUpperBound(LatencyBucket(50000)));
+	CHECK(total.p90Ns == LatencyBucketUpperBound(LatencyBucket(90000)));
+	CHECK(total.p99Ns == LatencyBucketUpperBound(LatencyBucket(99000)));
+	CHECK(total.maxNs == LatencyBucketUpperBound(LatencyBucket(100000)));
+
+	// One value is every percentile.
+	const LatencySummary& decode = block->summary[LatencyStage_Decode];
+	CHECK(decode.count == 1);
+	CHECK(decode.p50Ns == LatencyBucketUpperBound(LatencyBucket(5000)));
+	CHECK(decode.p99Ns == decode.p50Ns && decode.maxNs == decode.p50Ns);
+	CHECK(block->summary[LatencyStage_Wait].count == 1);
+	CHECK(block->summary[LatencyStage_Wait].maxNs == 0);
+	CHECK(block->summary[LatencyStage_Output].count == 0);
+
+	// Only once the interval has passed, and then over what was recorded since.
+	uint32_t sequence = block->summarySequence.load();
+	stats.record(LatencyStage_Total, startNs, startNs + 7000);
+	stats.refreshSummary(startNs + kSecondNs / 2);
+	CHECK(block->summarySequence.load() == sequence);
+	CHECK(total.count == 100);
+	stats.refreshSummary(startNs + kSecondNs);
+	CHECK(block->summarySequence.load() == sequence + 2);
+	CHECK(total.count == 1);
+	CHECK(total.p50Ns == LatencyBucketUpperBound(LatencyBucket(7000)));
+
+	stats.refreshSummary(startNs + 2 * kSecondNs);
+	CHECK(total.count == 0 && total.p50Ns == 0 && total.maxNs == 0);
+}
+
+// The summary is rewritten under summarySequence: a reader that follows the protocol never sees two refreshes mixed.
+// Every refresh gives all four stages the same count, so a torn copy shows as counts that differ.
+X1NPUT_TEST(SummarySequenceKeepsCopiesWhole) {
+	LatencyStats stats;
+	CHECK(stats.open(BlockName().c_str()));
+	if (!stats.isOpen()) {
+		return;
+	}
+	const LatencyStatsBlock* block = stats.data();
+
+	std::atomic<bool> done{ false };
+	std::atomic<uint64_t> consistent{ 0 };
+	std::atomic<uint64_t> torn{ 0 };
+	std::thread reader([&] {
+		while (!done.load()) {
+			uint32_t before = block->summarySequence.load(std::memory_order_acquire);
+			if (before & 1) {
+				continue;
+			}
+			LatencySummary copy[LatencyStage_Count];
+			std::memcpy(copy, block->summary, sizeof(copy));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (block->summarySequence.load(std::memory_order_relaxed) != before) {
+				continue;
+			}
+			bool same = true;
+			for (uint32_t stage = 1; stage < LatencyStage_Count; ++stage) {
+				same = same && std::memcmp(&copy[stage], &copy[0], sizeof(LatencySummary)) == 0;
+			}
+			(same ? consistent : torn).fetch_add(1);
+		}
+	});
+
+	uint64_t nowNs = kSecondNs;
+	for (uint64_t refresh = 1; refresh <= 20000; ++refresh) {
+		for (uint64_t value = 0; value < refresh % 7; ++value) {
+			for (uint32_t stage = 0; stage < LatencyStage_Count; ++stage) {
+				stats.record(static_cast<LatencyStage>(stage), 0, (refresh % 5 + 1) * 1000);
+			}
+		}
+		nowNs += kSecondNs;
+		stats.refreshSummary(nowNs);
+	}
+	done.store(true);
+	reader.join();
+
+	CHECK(block->summarySequence.load() == 2 * 20000);
+	CHECK(consistent.load() > 0);
+	CHECK(torn.load() == 0);
+}
+
+X1NPUT_TEST(CountersReachTheBlock) {
+	LatencyStats stats;
+	CHECK(stats.open(BlockName().c_str()));
+	if (!stats.isOpen()) {
+		return;
+	}
+	stats.countReceived(5);
+	stats.countDropped(3);
+	stats.countMalformed(1);
+	stats.countFrame();
+	stats.countSuppressed();
+	const LatencyStatsBlock* block = stats.data();
+	CHECK(block->magic == kLatencyStatsMagic && block->version == kLatencyStatsVersion);
+	CHECK(block->packetsReceived == 5 && block->packetsDropped == 3 && block->packetsMalformed == 1);
+	CHECK(block->framesEmitted == 1 && block->framesSuppressed == 1);
+}
+
+#ifndef _WIN32
+
+static bool BlockExists(const std::string& name) {
+	int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		return false;
+	}
+	close(fd);
+	return true;
+}
+
+// Two processes (here two LatencyStats) on one name share the block, and only the one that created it removes it.
+X1NPUT_TEST(OnlyTheCreatorRemovesTheBlock) {
+	const std::string name = BlockName();
+	LatencyStats creator;
+	LatencyStats second;
+	CHECK(creator.open(name.c_str()));
+	CHECK(second.open(name.c_str()));
+	if (!creator.isOpen() || !second.isOpen()) {
+		return;
+	}
+
+	creator.countFrame();
+	CHECK(second.data()->framesEmitted == 1);
+
+	second.close();
+	CHECK(BlockExists(name));
+	creator.countFrame();
+	CHECK(creator.data()->framesEmitted == 2);
+
+	creator.close();
+	CHECK(!BlockExists(name));
+}
+
+#endif
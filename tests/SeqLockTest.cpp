@@ -0,0 +1,92 @@
+#include "SeqLock.h"
+#include "TelemetryData.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Every word of a store holds the same number, so a copy mixing two stores shows as two different words.
+struct StressPayload {
+	uint32_t words[48];
+};
+
+X1NPUT_TEST(LoadReturnsTheLastStore) {
+	SeqLock<TelemetryData> lock;
+	CHECK(lock.version() == 1);  // The constructor stores a zeroed value
+	CHECK(lock.load().CurrentEngineRpm == 0);
+
+	TelemetryData telemetry = {};
+	telemetry.CurrentEngineRpm = 6500;
+	telemetry.Gear = 4;
+	lock.store(telemetry);
+
+	TelemetryData loaded = lock.load();
+	CHECK(loaded.CurrentEngineRpm == 6500);
+	CHECK(loaded.Gear == 4);
+	CHECK(lock.version() == 2);
+}
+
+// One writer storing as fast as it can (well over the 10k packets/s of the request) while readers check every copy.
+X1NPUT_TEST(ConcurrentReadersNeverSeeTornValues) {
+	typedef std::chrono::steady_clock Clock;
+	const size_t kReaders = 3;
+	const auto kDuration = std::chrono::milliseconds(500);
+
+	SeqLock<StressPayload> lock;
+	std::atomic<bool> done(false);
+	std::atomic<uint64_t> torn(0);
+	std::atomic<uint64_t> backwards(0);
+	std::vector<uint64_t> loads(kReaders, 0);
+
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < kReaders; ++r) {
+		readers.emplace_back([&, r]() {
+			uint32_t last = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				StressPayload payload = lock.load();
+				for (uint32_t word : payload.words) {
+					if (word != payload.words[0]) {
+						torn.fetch_add(1, std::memory_order_relaxed);
+						break;
+					}
+				}
+				if (payload.words[0] < last) {
+					backwards.fetch_add(1, std::memory_order_relaxed);
+				}
+				last = payload.words[0];
+				++loads[r];
+			}
+		});
+	}
+
+	uint32_t stores = 0;
+	Clock::time_point start = Clock::now();
+	while (Clock::now() - start < kDuration) {
+		StressPayload payload;
+		++stores;
+		for (uint32_t& word : payload.words) {
+			word = stores;
+		}
+		lock.store(payload);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	done = true;
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+
+	uint64_t totalLoads = 0;
+	for (uint64_t count : loads) {
+		totalLoads += count;
+	}
+	std::fprintf(stderr, "  %u stores (%.0f/s), %llu loads\n", stores, stores / seconds, static_cast<unsigned long long>(totalLoads));
+
+	CHECK(stores / seconds > 10000);
+	CHECK(totalLoads > 0);
+	CHECK(torn.load() == 0);
+	CHECK(backwards.load() == 0);
+	CHECK(lock.load().words[0] == stores);
+}
@@ -0,0 +1,208 @@
+#include "TelemetryCapture.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+// Record i of the test captures: its length runs through 0..kCaptureMaxPayload and its bytes depend on i.
+static size_t RecordLength(uint64_t i) {
+	return static_cast<size_t>((i * 37) % (kCaptureMaxPayload + 1));
+}
+
+static char RecordByte(uint64_t i, size_t offset) {
+	return static_cast<char>((i * 131 + offset * 7) & 0xFF);
+}
+
+static void AppendRecord(CaptureWriter& writer, uint64_t i) {
+	char payload[kCaptureMaxPayload];
+	size_t length = RecordLength(i);
+	for (size_t offset = 0; offset < length; ++offset) {
+		payload[offset] = RecordByte(i, offset);
+	}
+	writer.append(i * 1000, payload, length);
+}
+
+static bool SameRecord(const CaptureRecord& record, uint64_t i) {
+	if (record.timestamp != i * 1000 || record.length != RecordLength(i)) {
+		return false;
+	}
+	for (size_t offset = 0; offset < record.length; ++offset) {
+		if (record.data[offset] != RecordByte(i, offset)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Reads the capture to its end. Returns how many records matched what AppendRecord() wrote, in order.
+static uint64_t ReadBack(CaptureReader& reader) {
+	CaptureRecord record;
+	uint64_t i = 0;
+	while (reader.next(record) && SameRecord(record, i)) {
+		++i;
+	}
+	return i;
+}
+
+X1NPUT_TEST(RecordsReadBackAsWritten) {
+	TempDirectory directory;
+	const std::string path = directory.file("capture.x1cap");
+
+	CaptureWriter writer;
+	CHECK(writer.open(path));
+	for (uint64_t i = 0; i < 200; ++i) {
+		AppendRecord(writer, i);
+	}
+	writer.append(0, nullptr, kCaptureMaxPayload + 1);  // Too long for a record: skipped
+	writer.close();
+
+	CaptureReader reader;
+	CHECK(reader.open(path));
+	CHECK(ReadBack(reader) == 200);
+
+	reader.rewind();
+	CHECK(ReadBack(reader) == 200);
+}
+
+X1NPUT_TEST(ATruncatedLastRecordEndsTheCapture) {
+	TempDirectory directory;
+	const std::string path = directory.file("capture.x1cap");
+
+	CaptureWriter writer;
+	CHECK(writer.open(path));
+	for (uint64_t i = 0; i < 10; ++i) {
+		AppendRecord(writer, i);
+	}
+	writer.close();
+
+	// A record cut off in its payload, as a capture open when the game crashed would end.
+	{
+		FILE* file = std::fopen(path.c_str(), "ab");
+		const char header[kCaptureRecordHeaderSize] = { 0, 0, 0, 0, 0, 0, 0, 0, 100, 0 };
+		const char payload[40] = {};
+		std::fwrite(header, 1, sizeof(header), file);
+		std::fwrite(payload, 1, sizeof(payload), file);
+		std::fclose(file);
+	}
+	CaptureReader reader;
+	CHECK(reader.open(path));
+	CHECK(ReadBack(reader) == 10);
+	CaptureRecord record;
+	CHECK(!reader.next(record));
+	reader.close();
+
+	// And one cut off in its header.
+	{
+		CHECK(writer.open(path));
+		for (uint64_t i = 0; i < 10; ++i) {
+			AppendRecord(writer, i);
+		}
+		writer.close();
+		FILE* file = std::fopen(path.c_str(), "ab");
+		const char header[5] = {};
+		std::fwrite(header, 1, sizeof(header), file);
+		std::fclose(file);
+	}
+	CHECK(reader.open(path));
+	CHECK(ReadBack(reader) == 10);
+}
+
+X1NPUT_TEST(ACaptureLongerThanTheWindowIsRemapped) {
+	TempDirectory directory;
+	const std::string path = directory.file("capture.x1cap");
+
+	// Records average 760 bytes, so this is past 64 MiB, the MappedWindow size, with records across the boundary.
+	const uint64_t count = 100000;
+	CaptureWriter writer;
+	CHECK(writer.open(path));
+	for (uint64_t i = 0; i < count; ++i) {
+		AppendRecord(writer, i);
+	}
+	writer.close();
+	CHECK(std::filesystem::file_size(path) > (64u << 20));
+
+	CaptureReader reader;
+	CHECK(reader.open(path));
+	CHECK(ReadBack(reader) == count);
+	reader.rewind();
+	CHECK(ReadBack(reader) == count);
+}
+
+X1NPUT_TEST(ReplayKeepsTheRecordedTiming) {
+	typedef std::chrono::steady_clock Clock;
+
+	TempDirectory directory;
+	const std::string path = directory.file("capture.x1cap");
+	const uint64_t timestamps[] = { 0, 20000, 20000, 45000, 60000 };
+	CaptureWriter writer;
+	CHECK(writer.open(path));
+	for (uint64_t timestamp : timestamps) {
+		writer.append(timestamp, reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+	}
+	writer.close();
+
+	CaptureReader reader;
+	CHECK(reader.open(path));
+	std::atomic<bool> running{ true };
+	std::vector<Clock::time_point> waits;
+	std::vector<Clock::time_point> delivered;
+	std::vector<uint64_t> order;
+
+	uint64_t count = ReplayCapture(reader, ReplayPacing::Original, running, [&](const CaptureRecord& record) {
+		delivered.push_back(Clock::now());
+		order.push_back(record.timestamp);
+	}, [&](Clock::time_point time) {
+		waits.push_back(time);
+		std::this_thread::sleep_until(time);
+		return true;
+	});
+
+	CHECK(count == 5);
+	CHECK(waits.size() == 5 && delivered.size() == 5);
+	for (size_t i = 0; i < order.size() && i < waits.size(); ++i) {
+		CHECK(order[i] == timestamps[i]);
+		// Each record waits for its own time, relative to the first, and is only delivered once it has come.
+		auto offset = std::chrono::duration_cast<std::chrono::microseconds>(waits[i] - waits[0]).count();
+		CHECK(offset == static_cast<long long>(timestamps[i]));
+		CHECK(delivered[i] >= waits[i]);
+	}
+
+	// A wait that returns false stops the replay before that record.
+	reader.rewind();
+	order.clear();
+	count = ReplayCapture(reader, ReplayPacing::Original, running, [&](const CaptureRecord& record) {
+		order.push_back(record.timestamp);
+	}, [&](Clock::time_point) { return order.size() < 2; });
+	CHECK(count == 2);
+	CHECK(order.size() == 2);
+
+	// As fast as possible never waits; running false delivers nothing.
+	reader.rewind();
+	int sleeps = 0;
+	count = ReplayCapture(reader, ReplayPacing::AsFastAsPossible, running, [](const CaptureRecord&) {},
+		[&](Clock::time_point) { ++sleeps; return true; });
+	CHECK(count == 5);
+	CHECK(sleeps == 0);
+
+	reader.rewind();
+	running = false;
+	count = ReplayCapture(reader, ReplayPacing::AsFastAsPossible, running, [](const CaptureRecord&) {},
+		[](Clock::time_point) { return true; });
+	CHECK(count == 0);
+}
+
+X1NPUT_TEST(OpenRejectsOtherFiles) {
+	TempDirectory directory;
+	CaptureReader reader;
+	CHECK(!reader.open(directory.file("missing.x1cap")));
+
+	const std::string path = directory.file("other.bin");
+	FILE* file = std::fopen(path.c_str(), "wb");
+	std::fputs("not a capture file", file);
+	std::fclose(file);
+	CHECK(!reader.open(path));
+}
@@ -0,0 +1,68 @@
+#include "TelemetryPredictor.h"
+#include "TestHarness.h"
+
+static TelemetryData Packet(uint32_t timestampMs, float rpm, uint8_t gear) {
+	TelemetryData telemetry = TelemetryData();
+	telemetry.TimestampMs = timestampMs;
+	telemetry.CurrentEngineRpm = rpm;
+	telemetry.EngineIdleRpm = 900;
+	telemetry.EngineMaxRpm = 8000;
+	telemetry.Gear = gear;
+	return telemetry;
+}
+
+// Revving at 3000 RPM/s in third: the rate settles on it, and a shift starts it over instead of reading the drop as
+// the engine slowing down.
+X1NPUT_TEST(ShiftsRestartTheRpmRate) {
+	TelemetryPredictor predictor;
+	TelemetryData telemetry;
+	for (uint32_t i = 0; i <= 60; ++i) {
+		telemetry = Packet(1000 + i * 16, 4000 + 48.f * i, 3);
+		predictor.update(telemetry);
+	}
+	CHECK_NEAR(telemetry.EngineRpmRate, 3000, 1);
+
+	telemetry = Packet(1000 + 61 * 16, 5000, 4);
+	predictor.update(telemetry);
+	CHECK(telemetry.EngineRpmRate == 0);
+
+	telemetry = Packet(1000 + 62 * 16, 5032, 4);
+	predictor.update(telemetry);
+	CHECK(telemetry.EngineRpmRate > 0);
+}
+
+X1NPUT_TEST(ExtrapolatedRpmStaysInRange) {
+	TelemetryData telemetry = Packet(1000, 7900, 5);
+	telemetry.EngineRpmRate = 10000;
+	PredictTelemetry(telemetry, 0.05f);
+	CHECK(telemetry.CurrentEngineRpm == 8000);
+
+	// Falling fast towards a stop: it ends at idle, never at the 0 that reads as a paused game.
+	telemetry = Packet(1000, 1200, 1);
+	telemetry.EngineRpmRate = -50000;
+	PredictTelemetry(telemetry, 0.05f);
+	CHECK(telemetry.CurrentEngineRpm == 900);
+
+	// Below idle already (stalling): no lower than it was.
+	telemetry = Packet(1000, 600, 1);
+	telemetry.EngineRpmRate = -50000;
+	PredictTelemetry(telemetry, 0.05f);
+	CHECK(telemetry.CurrentEngineRpm == 600);
+
+	// A game without the limiter in its packets: no ceiling, and no idle either.
+	telemetry = Packet(1000, 7900, 5);
+	telemetry.EngineMaxRpm = 0;
+	telemetry.EngineIdleRpm = 0;
+	telemetry.EngineRpmRate = 10000;
+	PredictTelemetry(telemetry, 0.05f);
+	CHECK_NEAR(telemetry.CurrentEngineRpm, 8400, 0.01);
+	telemetry.EngineRpmRate = -1e6f;
+	PredictTelemetry(telemetry, 0.05f);
+	CHECK(telemetry.CurrentEngineRpm > 0);
+
+	// A paused game stays paused.
+	telemetry = Packet(1000, 0, 3);
+	telemetry.EngineRpmRate = 5000;
+	PredictTelemetry(telemetry, 0.05f);
+	CHECK(telemetry.CurrentEngineRpm == 0);
+}
@@ -0,0 +1,153 @@
+#include "GenericPacket.h"
+#include "TelemetryReader.h"
+#include "TestHarness.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Ports tried for the reader under test, the first free one is used.
+static const uint16_t kFirstTestPort = 47310;
+static const uint16_t kTestPortCount = 50;
+
+// A reader listening on a free loopback port, and a socket to send to it.
+struct LoopbackReader {
+	UdpPoller poller;
+	std::unique_ptr<TelemetryReader> reader;
+	UdpSocket sender;
+	UdpEndpoint target;
+
+	explicit LoopbackReader(TelemetryReaderOptions options = TelemetryReaderOptions()) {
+		for (uint16_t port = kFirstTestPort; port < kFirstTestPort + kTestPortCount && !reader; ++port) {
+			options.port = port;
+			reader.reset(new TelemetryReader(options));
+			if (!reader->listen(poller, 7)) {
+				reader.reset();
+			}
+		}
+		target.address = 0x7F000001;
+		target.port = options.port;
+		sender.open();
+	}
+
+	void send(const std::vector<char>& datagram) {
+		CHECK(sender.sendTo(target, datagram.data(), datagram.size()));
+	}
+
+	// Waits for the reader's socket to be ready, lets the rest of what was sent arrive, and drains it once.
+	void drain() {
+		size_t ready[kMaxPolledSockets];
+		CHECK(poller.wait(ready, kMaxPolledSockets) == 1);
+		CHECK(ready[0] == 7);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		reader->drain();
+	}
+};
+
+static std::vector<char> GenericPacket(float speed) {
+	std::vector<char> packet(kGenericHeaderSize + GenericField_Count * sizeof(float), 0);
+	std::memcpy(packet.data(), kGenericPacketMagic, sizeof(kGenericPacketMagic));
+	const uint16_t version = kGenericPacketVersion;
+	const uint16_t count = GenericField_Count;
+	std::memcpy(packet.data() + 4, &version, sizeof(version));
+	std::memcpy(packet.data() + 6, &count, sizeof(count));
+	std::memcpy(packet.data() + kGenericHeaderSize + GenericField_Speed * sizeof(float), &speed, sizeof(speed));
+	return packet;
+}
+
+X1NPUT_TEST(DrainPublishesOnlyTheNewestPacket) {
+	LoopbackReader loopback;
+	if (!loopback.reader) {
+		CHECK(loopback.reader != nullptr);
+		return;
+	}
+	CHECK(loopback.reader->isListening());
+
+	// More than one DatagramBatch, so the drain has to go back for the rest.
+	const uint64_t sent = DatagramBatch::kCapacity * 2 + 5;
+	for (uint64_t i = 1; i <= sent; ++i) {
+		loopback.send(GenericPacket(static_cast<float>(i)));
+	}
+	loopback.drain();
+
+	CHECK(loopback.reader->packetsReceived() == sent);
+	CHECK(loopback.reader->packetsDropped() == sent - 1);
+	CHECK(loopback.reader->packetsMalformed() == 0);
+	CHECK(loopback.reader->source() == TelemetrySource_Generic);
+	CHECK_NEAR(loopback.reader->snapshot().Speed, static_cast<double>(sent), 0);
+
+	// Nothing queued: a drain changes nothing.
+	loopback.reader->drain();
+	CHECK(loopback.reader->packetsReceived() == sent);
+}
+
+X1NPUT_TEST(FormatsAreDetectedBySize) {
+	LoopbackReader loopback;
+	if (!loopback.reader) {
+		CHECK(loopback.reader != nullptr);
+		return;
+	}
+
+	loopback.send(std::vector<char>(ForzaLayout<ForzaFormat::Dash>::kPacketSize, 0));
+	loopback.drain();
+	CHECK(loopback.reader->source() == TelemetrySource_Forza);
+
+	loopback.send(std::vector<char>(kCodemastersPacketSize, 0));
+	loopback.drain();
+	CHECK(loopback.reader->source() == TelemetrySource_Codemasters);
+
+	loopback.send(GenericPacket(12.5f));
+	loopback.drain();
+	CHECK(loopback.reader->source() == TelemetrySource_Generic);
+	CHECK_NEAR(loopback.reader->snapshot().Speed, 12.5, 0);
+
+	// No format has this size: counted once as malformed, the last packet stays.
+	loopback.send(std::vector<char>(100, 1));
+	loopback.drain();
+	CHECK(loopback.reader->source() == TelemetrySource_Generic);
+	CHECK(loopback.reader->packetsReceived() == 4);
+	CHECK(loopback.reader->packetsDropped() == 0);
+	CHECK(loopback.reader->packetsMalformed() == 1);
+
+	// A newer malformed datagram does not hide the valid one before it.
+	loopback.send(GenericPacket(20.f));
+	loopback.send(std::vector<char>(100, 1));
+	loopback.drain();
+	CHECK_NEAR(loopback.reader->snapshot().Speed, 20, 0);
+	CHECK(loopback.reader->packetsReceived() == 6);
+	CHECK(loopback.reader->packetsDropped() == 0);
+	CHECK(loopback.reader->packetsMalformed() == 2);
+}
+
+X1NPUT_TEST(DisabledFormatsAreMalformed) {
+	TelemetryReaderOptions options;
+	options.formats = 1u << TelemetrySource_Generic;
+	LoopbackReader loopback(options);
+	if (!loopback.reader) {
+		CHECK(loopback.reader != nullptr);
+		return;
+	}
+
+	loopback.send(std::vector<char>(ForzaLayout<ForzaFormat::Dash>::kPacketSize, 0));
+	loopback.drain();
+	CHECK(loopback.reader->source() == TelemetrySource_None);
+	CHECK(loopback.reader->packetsMalformed() == 1);
+}
+
+X1NPUT_TEST(WakeInterruptsTheWait) {
+	UdpPoller poller;
+	size_t ready[kMaxPolledSockets];
+
+	// Before the wait starts, and from another thread while it waits.
+	poller.wake();
+	CHECK(poller.wait(ready, kMaxPolledSockets) == 0);
+
+	std::thread waker([&poller] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		poller.wake();
+	});
+	CHECK(poller.wait(ready, kMaxPolledSockets) == 0);
+	waker.join();
+}
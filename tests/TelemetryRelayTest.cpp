@@ -0,0 +1,116 @@
+#include "TelemetryRelay.h"
+#include "TestHarness.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+// Ports tried for the receiving sockets, the first free ones are used.
+static const uint16_t kFirstTestPort = 47410;
+static const uint16_t kTestPortCount = 50;
+
+static uint16_t BindFreePort(UdpSocket& socket, uint16_t after) {
+	for (uint16_t port = after + 1; port < kFirstTestPort + kTestPortCount; ++port) {
+		if (socket.bind(port)) {
+			return port;
+		}
+	}
+	return 0;
+}
+
+static UdpEndpoint Loopback(uint16_t port) {
+	UdpEndpoint endpoint;
+	endpoint.address = 0x7F000001;
+	endpoint.port = port;
+	return endpoint;
+}
+
+static void FillBatch(DatagramBatch& batch, int count, int first) {
+	batch.count = count;
+	for (int i = 0; i < count; ++i) {
+		batch.lengths[i] = std::snprintf(batch.data[i], DatagramBatch::kDatagramSize, "datagram %d", first + i);
+	}
+}
+
+// Takes what socket received, waiting a little for it to arrive. Returns how many were datagrams first, first + 1...
+static int ReceiveInOrder(UdpSocket& socket, int first) {
+	DatagramBatch received;
+	int matched = 0;
+	for (int attempt = 0; attempt < 50; ++attempt) {
+		int count = socket.receive(received);
+		if (count <= 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			continue;
+		}
+		for (int i = 0; i < count; ++i) {
+			char expected[32];
+			int length = std::snprintf(expected, sizeof(expected), "datagram %d", first + matched);
+			if (received.lengths[i] == length && std::memcmp(received.data[i], expected, length) == 0) {
+				++matched;
+			}
+		}
+	}
+	return matched;
+}
+
+// Two loopback targets for the port and one that refuses every datagram (port 0): each target has its own counts.
+X1NPUT_TEST(EveryTargetGetsTheBatchAndItsOwnCounts) {
+	UdpSocket first;
+	UdpSocket second;
+	uint16_t firstPort = BindFreePort(first, kFirstTestPort - 1);
+	uint16_t secondPort = BindFreePort(second, firstPort);
+	if (firstPort == 0 || secondPort == 0) {
+		CHECK(firstPort != 0 && secondPort != 0);
+		return;
+	}
+
+	std::vector<RelayTarget> targets(4);
+	targets[0].endpoint = Loopback(firstPort);
+	targets[1].fromPort = 20777;
+	targets[1].endpoint = Loopback(secondPort);
+	targets[2].fromPort = 9999;  // Another port's: left out
+	targets[2].endpoint = Loopback(secondPort);
+	targets[3].endpoint = Loopback(0);
+
+	TelemetryRelay relay;
+	CHECK(relay.open(20777, targets));
+	CHECK(relay.isOpen());
+	CHECK(relay.targetCount() == 3);
+	if (relay.targetCount() != 3) {
+		return;
+	}
+	CHECK(relay.target(0).port == firstPort && relay.target(1).port == secondPort && relay.target(2).port == 0);
+
+	DatagramBatch batch;
+	FillBatch(batch, 5, 0);
+	relay.send(batch);
+	FillBatch(batch, DatagramBatch::kCapacity, 5);
+	relay.send(batch);
+	const int total = 5 + DatagramBatch::kCapacity;
+
+	CHECK(relay.packetsSent(0) == total && relay.packetsDropped(0) == 0);
+	CHECK(relay.packetsSent(1) == total && relay.packetsDropped(1) == 0);
+	CHECK(relay.packetsSent(2) == 0 && relay.packetsDropped(2) == total);
+	CHECK(ReceiveInOrder(first, 0) == total);
+	CHECK(ReceiveInOrder(second, 0) == total);
+
+	// An empty batch sends nothing; reopening starts the counts over.
+	batch.count = 0;
+	relay.send(batch);
+	CHECK(relay.packetsSent(0) == total);
+	CHECK(relay.open(20777, targets));
+	CHECK(relay.packetsSent(0) == 0 && relay.packetsDropped(2) == 0);
+}
+
+X1NPUT_TEST(NoTargetForThePortLeavesTheRelayClosed) {
+	std::vector<RelayTarget> targets(1);
+	targets[0].fromPort = 9999;
+	targets[0].endpoint = Loopback(kFirstTestPort);
+
+	TelemetryRelay relay;
+	CHECK(!relay.open(20777, targets));
+	CHECK(!relay.isOpen());
+	CHECK(relay.targetCount() == 0);
+	CHECK(!relay.open(20777, std::vector<RelayTarget>()));
+}
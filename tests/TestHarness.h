@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+/*
+	The few pieces the tests/ executables need, without a test framework.
+
+		X1NPUT_TEST(DecodesSledPackets) {
+			CHECK(DecodeForzaPacket(packet, sizeof(packet), telemetry));
+			CHECK_NEAR(telemetry.Speed, 31.5f, 1e-6);
+		}
+
+	Every test in an executable runs in the order it was defined (TestMain.cpp).
+	A failed CHECK prints the file, line and expression and the test carries on,
+	so one run shows every failure; the executable then exits with 1, which is
+	what CTest looks at. Pass a name to run only the tests whose name contains it.
+*/
+
+typedef void (*TestBody)();
+
+struct TestCase {
+	const char* name;
+	TestBody body;
+	TestCase* next;
+};
+
+// Adds a test to the list TestMain.cpp runs. Called by the static objects X1NPUT_TEST declares.
+void RegisterTest(TestCase& test);
+// Counts a failure of the running test and prints where it happened.
+void ReportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistration {
+	TestRegistration(const char* name, TestBody body) : test{ name, body, nullptr } {
+		RegisterTest(test);
+	}
+
+	TestCase test;
+};
+
+#define X1NPUT_TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			ReportFailure(__FILE__, __LINE__, #condition); \
+		} \
+	} while (false)
+
+// |actual - expected| <= tolerance, with the values printed when it fails.
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do { \
+		double checkActual = (actual); \
+		double checkExpected = (expected); \
+		if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) { \
+			std::fprintf(stderr, "  %s = %.9g, expected %.9g\n", #actual, checkActual, checkExpected); \
+			ReportFailure(__FILE__, __LINE__, #actual " near " #expected); \
+		} \
+	} while (false)
+
+// A new empty directory under the system's temporary one, removed with everything in it when this goes out of scope.
+class TempDirectory {
+public:
+	TempDirectory();
+	~TempDirectory();
+
+	TempDirectory(const TempDirectory&) = delete;
+	TempDirectory& operator=(const TempDirectory&) = delete;
+
+	// Path of name inside the directory.
+	std::string file(const char* name) const;
+
+private:
+	std::string path;
+};
@@ -0,0 +1,69 @@
+#include "TestHarness.h"
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+static TestCase* firstTest = nullptr;
+static TestCase* lastTest = nullptr;
+static int failures = 0;
+
+void RegisterTest(TestCase& test) {
+	if (lastTest != nullptr) {
+		lastTest->next = &test;
+	}
+	else {
+		firstTest = &test;
+	}
+	lastTest = &test;
+}
+
+void ReportFailure(const char* file, int line, const char* expression) {
+	std::fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expression);
+	++failures;
+}
+
+TempDirectory::TempDirectory() {
+	std::filesystem::path base = std::filesystem::temp_directory_path();
+	std::random_device random;
+	for (;;) {
+		std::filesystem::path candidate = base / ("x1nput-test-" + std::to_string(random()));
+		if (std::filesystem::create_directory(candidate)) {
+			path = candidate.string();
+			return;
+		}
+	}
+}
+
+TempDirectory::~TempDirectory() {
+	std::error_code ignored;
+	std::filesystem::remove_all(path, ignored);
+}
+
+std::string TempDirectory::file(const char* name) const {
+	return (std::filesystem::path(path) / name).string();
+}
+
+int main(int argc, char** argv) {
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	int failedTests = 0;
+	int run = 0;
+
+	for (TestCase* test = firstTest; test != nullptr; test = test->next) {
+		if (filter != nullptr && std::strstr(test->name, filter) == nullptr) {
+			continue;
+		}
+
+		int failuresBefore = failures;
+		std::fprintf(stderr, "%s\n", test->name);
+		test->body();
+		++run;
+		if (failures != failuresBefore) {
+			std::fprintf(stderr, "%s FAILED\n", test->name);
+			++failedTests;
+		}
+	}
+
+	std::fprintf(stderr, "%d tests, %d failed\n", run, failedTests);
+	return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include "TestHarness.h"
+#include "VibrationCoalescer.h"
+
+static const uint64_t kMs = 1000000;
+
+static HapticsOutput Motors(double value) {
+	HapticsOutput output = {};
+	output.LeftMotor = value;
+	output.RightMotor = value;
+	return output;
+}
+
+X1NPUT_TEST(FirstSilentOutputIsAlwaysSent) {
+	VibrationCoalescerOptions options;
+	options.maxRate = 10;
+	VibrationCoalescer coalescer;
+
+	// Nothing sent yet: even silence goes out.
+	HapticsOutput output = Motors(0);
+	CHECK(coalescer.update(options, output, 0));
+
+	output = Motors(0.5);
+	CHECK(coalescer.update(options, output, 200 * kMs));
+
+	// Well inside the rate limit, stopping is sent at once, but only the first time.
+	output = Motors(0);
+	CHECK(coalescer.update(options, output, 201 * kMs));
+	output = Motors(0);
+	CHECK(!coalescer.update(options, output, 500 * kMs));
+
+	CHECK(coalescer.sent() == 3);
+	CHECK(coalescer.suppressed() == 1);
+}
+
+X1NPUT_TEST(RateLimitHoldsAChangeUntilItIsDue) {
+	VibrationCoalescerOptions options;
+	options.maxRate = 10;  // One update per 100 ms
+	VibrationCoalescer coalescer;
+
+	HapticsOutput output = Motors(0.2);
+	CHECK(coalescer.update(options, output, 1000 * kMs));
+
+	output = Motors(0.6);
+	CHECK(!coalescer.update(options, output, 1010 * kMs));
+	output = Motors(0.6);
+	CHECK(!coalescer.update(options, output, 1099 * kMs));
+	output = Motors(0.6);
+	CHECK(coalescer.update(options, output, 1100 * kMs));
+	CHECK_NEAR(output.LeftMotor, 0.6, 1e-12);
+
+	CHECK(coalescer.sent() == 2);
+	CHECK(coalescer.suppressed() == 2);
+}
+
+X1NPUT_TEST(ChangesWithinTheThresholdAreSuppressed) {
+	VibrationCoalescerOptions options;
+	options.threshold = 0.05;
+	VibrationCoalescer coalescer;
+
+	HapticsOutput output = Motors(0.504);
+	CHECK(coalescer.update(options, output, 0));
+	CHECK_NEAR(output.LeftMotor, 0.5, 1e-12);  // Rounded to whole percent
+
+	output = Motors(0.54);
+	CHECK(!coalescer.update(options, output, kMs));
+	output = Motors(0.55);  // Exactly the threshold after rounding
+	CHECK(!coalescer.update(options, output, 2 * kMs));
+	output = Motors(0.56);
+	CHECK(coalescer.update(options, output, 3 * kMs));
+
+	// Any one channel is enough.
+	output = Motors(0.56);
+	output.RightTrigger = 0.1;
+	CHECK(coalescer.update(options, output, 4 * kMs));
+}
+
+X1NPUT_TEST(ResetSendsTheNextOutput) {
+	VibrationCoalescerOptions options;
+	VibrationCoalescer coalescer;
+
+	HapticsOutput output = Motors(0.5);
+	CHECK(coalescer.update(options, output, 0));
+	output = Motors(0.5);
+	CHECK(!coalescer.update(options, output, kMs));
+
+	coalescer.reset();
+	output = Motors(0.5);
+	CHECK(coalescer.update(options, output, 2 * kMs));
+	output = Motors(0.5);
+	CHECK(!coalescer.update(options, output, 3 * kMs));
+
+	CHECK(coalescer.sent() == 2);
+	CHECK(coalescer.suppressed() == 2);
+}
+
+X1NPUT_TEST(WithoutRoundingNearSilenceIsSilence) {
+	VibrationCoalescerOptions options;
+	options.resolution = 0;
+	options.threshold = 0.01;
+	options.maxRate = 10;
+	VibrationCoalescer coalescer;
+
+	HapticsOutput output = Motors(0.5);
+	CHECK(coalescer.update(options, output, 0));
+
+	// Under half the threshold: stopping, sent at once despite the rate limit.
+	output = Motors(0.004);
+	CHECK(coalescer.update(options, output, kMs));
+	CHECK(output.LeftMotor == 0 && output.RightMotor == 0);
+
+	// Above it the value is kept as it is.
+	output = Motors(0.123456);
+	CHECK(coalescer.update(options, output, 200 * kMs));
+	CHECK(output.LeftMotor == 0.123456);
+
+	// With no threshold, half a step of a 16-bit motor speed.
+	options.threshold = 0;
+	output = Motors(0.4 / 65535);
+	CHECK(coalescer.update(options, output, 201 * kMs));
+	CHECK(output.LeftMotor == 0);
+	output = Motors(1.0 / 65535);
+	CHECK(coalescer.update(options, output, 400 * kMs));
+	CHECK(output.LeftMotor == 1.0 / 65535);
+}
@@ -0,0 +1,119 @@
+#include "TestHarness.h"
+#include "WheelSlip.h"
+
+#include <cmath>
+#include <limits>
+
+// Equal values, so a 0 of either sign matches; the results are never NaN.
+static bool SameResult(const WheelSlipResult& a, const WheelSlipResult& b) {
+	return a.LockupFront == b.LockupFront && a.LockupRear == b.LockupRear && a.WheelspinFront == b.WheelspinFront &&
+		a.WheelspinRear == b.WheelspinRear && a.Lockup == b.Lockup && a.Wheelspin == b.Wheelspin;
+}
+
+static bool AnalysesAgree(const float slipRatio[4], const float combinedSlip[4]) {
+	return SameResult(AnalyzeWheelSlip(slipRatio, combinedSlip), AnalyzeWheelSlipReference(slipRatio, combinedSlip));
+}
+
+// Uniform in [lo, hi), the same sequence every run.
+static double Random(uint32_t& state, double lo, double hi) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return lo + (hi - lo) * (state / 4294967296.0);
+}
+
+static const float kNaN = std::numeric_limits<float>::quiet_NaN();
+static const float kInfinity = std::numeric_limits<float>::infinity();
+
+// One wheel at a time, locked and then spinning: only its axle reports it, and the worse axle is the one it is on.
+X1NPUT_TEST(EachWheelCountsForItsAxle) {
+	for (int wheel = 0; wheel < 4; ++wheel) {
+		for (float ratio : { -2.f, 2.f }) {
+			float slipRatio[4] = {};
+			float combinedSlip[4] = {};
+			slipRatio[wheel] = ratio;
+			combinedSlip[wheel] = 2.f;
+
+			WheelSlipResult result = AnalyzeWheelSlip(slipRatio, combinedSlip);
+			bool front = wheel < 2;
+			float lockup = ratio < 0 ? 1.f : 0.f;
+			float wheelspin = 1.f - lockup;
+			CHECK(result.LockupFront == (front ? lockup : 0.f));
+			CHECK(result.LockupRear == (front ? 0.f : lockup));
+			CHECK(result.WheelspinFront == (front ? wheelspin : 0.f));
+			CHECK(result.WheelspinRear == (front ? 0.f : wheelspin));
+			CHECK(result.Lockup == lockup);
+			CHECK(result.Wheelspin == wheelspin);
+			CHECK(AnalysesAgree(slipRatio, combinedSlip));
+		}
+	}
+
+	// Each axle takes its worse wheel, and the result the worse axle, whichever side and end it is on.
+	const float slipRatio[4] = { -0.9f, -1.2f, 1.5f, 1.1f };
+	const float combinedSlip[4] = { 1.f, 1.3f, 1.6f, 1.2f };
+	WheelSlipResult result = AnalyzeWheelSlip(slipRatio, combinedSlip);
+	WheelSlipResult reference = AnalyzeWheelSlipReference(slipRatio, combinedSlip);
+	CHECK(SameResult(result, reference));
+	CHECK(result.LockupFront > 0 && result.LockupRear == 0 && result.WheelspinFront == 0 && result.WheelspinRear > 0);
+	CHECK_NEAR(result.LockupFront, (1.3 - kWheelSlipStart) / (kWheelSlipFull - kWheelSlipStart) * (1.2 / 1.3), 1e-6);
+	CHECK(result.Lockup == result.LockupFront);
+	CHECK(result.Wheelspin == result.WheelspinRear);
+}
+
+X1NPUT_TEST(NoSlipIsNothing) {
+	const float zero[4] = {};
+	const float negativeZero[4] = { -0.f, -0.f, -0.f, -0.f };
+	const float nan[4] = { kNaN, kNaN, kNaN, kNaN };
+	const float* inputs[] = { zero, negativeZero, nan };
+	for (const float* slipRatio : inputs) {
+		for (const float* combinedSlip : inputs) {
+			WheelSlipResult result = AnalyzeWheelSlip(slipRatio, combinedSlip);
+			CHECK(result.Lockup == 0 && result.Wheelspin == 0);
+			CHECK(result.LockupFront == 0 && result.LockupRear == 0 && result.WheelspinFront == 0 && result.WheelspinRear == 0);
+			CHECK(AnalysesAgree(slipRatio, combinedSlip));
+		}
+	}
+}
+
+// Every pair of the values where the reference changes branch, NaN and the infinities among them, on each wheel.
+X1NPUT_TEST(EdgeValuesMatchTheReference) {
+	const float values[] = {
+		kNaN, -kNaN, kInfinity, -kInfinity, 0.f, -0.f, 1e-7f, -1e-7f, 1e-6f,
+		std::nextafter(kWheelSlipStart, 0.f), kWheelSlipStart, std::nextafter(kWheelSlipStart, 2.f), -kWheelSlipStart,
+		std::nextafter(kWheelSlipFull, 0.f), kWheelSlipFull, std::nextafter(kWheelSlipFull, 2.f), -kWheelSlipFull,
+		1.f, -1.f, 1e30f, -1e30f,
+	};
+	size_t mismatches = 0;
+	for (int wheel = 0; wheel < 4; ++wheel) {
+		for (float ratio : values) {
+			for (float combined : values) {
+				float slipRatio[4] = { 0.3f, -0.4f, 0.9f, -1.f };
+				float combinedSlip[4] = { 0.5f, 0.f, 1.f, 1.1f };
+				slipRatio[wheel] = ratio;
+				combinedSlip[wheel] = combined;
+				mismatches += !AnalysesAgree(slipRatio, combinedSlip);
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+// Slips around the grip limit, with games that leave the combined slip at 0 and NaN sprinkled in.
+X1NPUT_TEST(RandomSlipsMatchTheReference) {
+	uint32_t state = 1;
+	size_t mismatches = 0;
+	for (int i = 0; i < 1000000; ++i) {
+		float slipRatio[4];
+		float combinedSlip[4];
+		for (int wheel = 0; wheel < 4; ++wheel) {
+			slipRatio[wheel] = static_cast<float>(Random(state, -3, 3));
+			double kind = Random(state, 0, 1);
+			combinedSlip[wheel] = kind < 0.1 ? 0.f : kind < 0.15 ? kNaN : static_cast<float>(Random(state, 0, 3));
+			if (Random(state, 0, 1) < 0.05) {
+				slipRatio[wheel] = kNaN;
+			}
+		}
+		mismatches += !AnalysesAgree(slipRatio, combinedSlip);
+	}
+	CHECK(mismatches == 0);
+}